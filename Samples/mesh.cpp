@@ -63,23 +63,29 @@ namespace Mirage
         glBindVertexArray(0);
         glDeleteBuffers(1, & mVertexBuffer);
         glDeleteBuffers(1, & mElementBuffer);
+
+        // Build Uniform Names Once Using Texture Type (Omit ID for 0th Texture)
+        unsigned int diffuse = 0, specular = 0;
+        for (auto &i : mTextures)
+        {   std::string uniform = i.second;
+                 if (i.second == "diffuse")  uniform += (diffuse++  > 0) ? std::to_string(diffuse)  : "";
+            else if (i.second == "specular") uniform += (specular++ > 0) ? std::to_string(specular) : "";
+            mUniforms.push_back(uniform);
+        }
     }
 
     void Mesh::draw(GLuint shader)
     {
-        unsigned int unit = 0, diffuse = 0, specular = 0;
+        unsigned int unit = 0;
         for (auto &i : mSubMeshes) i->draw(shader);
+        auto uniform = mUniforms.begin();
         for (auto &i : mTextures)
-        {   // Set Correct Uniform Names Using Texture Type (Omit ID for 0th Texture)
-            std::string uniform = i.second;
-                 if (i.second == "diffuse")  uniform += (diffuse++  > 0) ? std::to_string(diffuse)  : "";
-            else if (i.second == "specular") uniform += (specular++ > 0) ? std::to_string(specular) : "";
-
-            // Bind Correct Textures and Vertex Array Before Drawing
+        {   // Bind Correct Textures and Vertex Array Before Drawing
             glActiveTexture(GL_TEXTURE0 + unit);
             glBindTexture(GL_TEXTURE_2D, i.first);
-            glUniform1f(glGetUniformLocation(shader, uniform.c_str()), ++unit);
-        }   glBindVertexArray(mVertexArray);
+            glUniform1f(glGetUniformLocation(shader, (uniform++)->c_str()), ++unit);
+        }   if (!mVertexArray) return;
+            glBindVertexArray(mVertexArray);
             glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0);
     }
 
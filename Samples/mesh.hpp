@@ -26,9 +26,9 @@ namespace Mirage
     {
     public:
 
-        // Implement Default Constructor and Destructor
-         Mesh() { glGenVertexArrays(1, & mVertexArray); }
-        ~Mesh() { glDeleteVertexArrays(1, & mVertexArray); }
+        // Implement Default Constructor and Destructor (Only Leaf Meshes Own a Vertex Array)
+         Mesh() : mVertexArray(0) {}
+        ~Mesh() { if (mVertexArray) glDeleteVertexArrays(1, & mVertexArray); }
 
         // Implement Custom Constructors
         Mesh(std::string const & filename);
@@ -57,6 +57,7 @@ namespace Mirage
         std::vector<GLuint> mIndices;
         std::vector<Vertex> mVertices;
         std::map<GLuint, std::string> mTextures;
+        std::vector<std::string> mUniforms;
 
         // Private Member Variables
         GLuint mVertexArray;
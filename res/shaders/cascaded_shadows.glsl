@@ -0,0 +1,42 @@
+// 级联阴影，配合utils::CascadedShadowMap使用：#include "cascaded_shadows.glsl"
+
+uniform sampler2DArrayShadow shadowMap;
+uniform int cascadeCount;
+uniform mat4 cascadeMatrices[4];
+// 每个级联覆盖的最远观察深度
+uniform vec4 cascadeSplits;
+// 每个级联一个纹素在世界空间中的大小，用于沿法线偏移
+uniform vec4 cascadeTexelSizes;
+
+int ShadowCascade(float viewDepth) {
+    for (int i = 0; i < cascadeCount; i++) {
+        if (viewDepth <= cascadeSplits[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 返回受光比例，1为完全照亮。viewDepth为观察空间中到相机平面的正距离
+float ShadowFactor(vec3 worldPos, vec3 normal, float viewDepth) {
+    int cascade = ShadowCascade(viewDepth);
+    if (cascade < 0) {
+        return 1.0;
+    }
+    vec3 offsetPos = worldPos + normal * cascadeTexelSizes[cascade] * 1.5;
+    vec4 lightPos = cascadeMatrices[cascade] * vec4(offsetPos, 1.0);
+    vec3 coord = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    if (any(lessThan(coord, vec3(0.0))) || any(greaterThan(coord, vec3(1.0)))) {
+        return 1.0;
+    }
+
+    // 3x3 PCF，每次采样由硬件比较并双线性过滤
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+        }
+    }
+    return lit / 9.0;
+}
@@ -0,0 +1,53 @@
+// 分簇光照，配合utils::ClusteredLighting使用：#include "clustered_lighting.glsl"
+// 只遍历片段所在簇的光源列表，光源的分配在CPU上完成（utils::LightClusterer）
+
+// 每个光源3个纹素：位置和范围；颜色乘强度和内锥角余弦；朝向和外锥角余弦（点光源为-2）
+uniform samplerBuffer clusterLights;
+// 每个簇在clusterIndices中的起始位置和数量
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer clusterIndices;
+
+uniform vec3 clusterGridSize;
+uniform vec2 clusterTileScale;
+// z切片 = floor(log(viewDepth) * x - y)
+uniform vec2 clusterZParams;
+
+int ClusterIndex(vec2 fragCoord, float viewDepth) {
+    ivec3 size = ivec3(clusterGridSize);
+    ivec2 tile = clamp(ivec2(fragCoord * clusterTileScale), ivec2(0), size.xy - 1);
+    int slice = clamp(int(floor(log(viewDepth) * clusterZParams.x - clusterZParams.y)), 0, size.z - 1);
+    return (slice * size.y + tile.y) * size.x + tile.x;
+}
+
+// 距离衰减在range处平滑降到0
+float LightFalloff(float distance, float range) {
+    float ratio = distance / range;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window / (distance * distance + 1.0);
+}
+
+// viewDepth为观察空间中到相机平面的正距离，返回漫反射光照（不含环境光）
+vec3 ClusteredLighting(vec3 worldPos, vec3 normal, vec3 albedo, float viewDepth) {
+    uvec2 range = texelFetch(clusterRanges, ClusterIndex(gl_FragCoord.xy, viewDepth)).xy;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x) * 3;
+        vec4 positionRange = texelFetch(clusterLights, light);
+        vec4 colorInner = texelFetch(clusterLights, light + 1);
+        vec4 directionOuter = texelFetch(clusterLights, light + 2);
+
+        vec3 toLight = positionRange.xyz - worldPos;
+        float distance = length(toLight);
+        if (distance >= positionRange.w) {
+            continue;
+        }
+        vec3 lightDir = toLight / max(distance, 1e-4);
+        float attenuation = LightFalloff(distance, positionRange.w);
+        if (directionOuter.w > -1.5) {
+            float cosAngle = dot(-lightDir, directionOuter.xyz);
+            attenuation *= smoothstep(directionOuter.w, colorInner.w, cosAngle);
+        }
+        result += albedo * colorInner.rgb * max(dot(normal, lightDir), 0.0) * attenuation;
+    }
+    return result;
+}
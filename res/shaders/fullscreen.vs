@@ -0,0 +1,11 @@
+#version 330 core
+// 覆盖全屏的三角形，不需要顶点缓冲
+
+out vec2 TexCoord;
+
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    TexCoord = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
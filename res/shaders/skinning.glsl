@@ -0,0 +1,23 @@
+// GPU蒙皮，配合utils::SkinningBuffer使用：#include "skinning.glsl"
+
+// 每个矩阵3个纹素，依次是仿射矩阵的前三行
+uniform samplerBuffer skinMatrices;
+// 每个实例的关节数，实例i的矩阵从i * jointCount开始
+uniform int jointCount;
+
+mat4 SkinMatrix(int index) {
+    vec4 row0 = texelFetch(skinMatrices, index * 3);
+    vec4 row1 = texelFetch(skinMatrices, index * 3 + 1);
+    vec4 row2 = texelFetch(skinMatrices, index * 3 + 2);
+    return transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+// joints和weights是SkinnedVertex的关节下标和权重，权重之和为1
+mat4 InstanceSkinMatrix(int instance, uvec4 joints, vec4 weights) {
+    int base = instance * jointCount;
+    mat4 skin = SkinMatrix(base + int(joints.x)) * weights.x;
+    skin += SkinMatrix(base + int(joints.y)) * weights.y;
+    skin += SkinMatrix(base + int(joints.z)) * weights.z;
+    skin += SkinMatrix(base + int(joints.w)) * weights.w;
+    return skin;
+}
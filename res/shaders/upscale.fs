@@ -0,0 +1,43 @@
+#version 330 core
+// Catmull-Rom双三次放大：4x4个纹素的权重合并成9次双线性采样
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D source;
+uniform vec2 sourceSize;
+
+void main()
+{
+    vec2 samplePos = TexCoord * sourceSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // 中间两个纹素的权重都为正，用一次双线性采样取得
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 texPos0 = (texPos1 - 1.0) / sourceSize;
+    vec2 texPos3 = (texPos1 + 2.0) / sourceSize;
+    vec2 texPos12 = (texPos1 + offset12) / sourceSize;
+
+    vec4 result = vec4(0.0);
+    result += texture(source, vec2(texPos0.x, texPos0.y)) * w0.x * w0.y;
+    result += texture(source, vec2(texPos12.x, texPos0.y)) * w12.x * w0.y;
+    result += texture(source, vec2(texPos3.x, texPos0.y)) * w3.x * w0.y;
+
+    result += texture(source, vec2(texPos0.x, texPos12.y)) * w0.x * w12.y;
+    result += texture(source, vec2(texPos12.x, texPos12.y)) * w12.x * w12.y;
+    result += texture(source, vec2(texPos3.x, texPos12.y)) * w3.x * w12.y;
+
+    result += texture(source, vec2(texPos0.x, texPos3.y)) * w0.x * w3.y;
+    result += texture(source, vec2(texPos12.x, texPos3.y)) * w12.x * w3.y;
+    result += texture(source, vec2(texPos3.x, texPos3.y)) * w3.x * w3.y;
+
+    FragColor = vec4(max(result.rgb, 0.0), 1.0);
+}
@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/animation_clip.h"
+#include "utils/skeleton.h"
+#include "utils/skinning.h"
+#include "utils/thread_pool.h"
+
+// 用法：animation_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查压缩误差、权重量化和多线程更新的结果，出错时返回1；再计时压缩、采样和整群角色的更新。
+
+static constexpr size_t kJointCount = 64;
+static constexpr int kClipCount = 4;
+static constexpr float kClipDuration = 3.0f;
+// 导入的动画通常每个tick一个关键帧
+static constexpr float kRawKeyRate = 60.0f;
+static constexpr size_t kCharacterCount = 1000;
+static constexpr int kFrames = 60;
+static constexpr float kFrameTime = 1.0f / 60.0f;
+static constexpr float kMaxRotationError = 0.01f;
+static constexpr float kMaxTranslationError = 0.01f;
+
+static glm::mat4 ToMat4(const utils::Matrix3x4& m) {
+  return glm::transpose(glm::mat4(m.rows[0], m.rows[1], m.rows[2], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+}
+
+static utils::Matrix3x4 ToMatrix3x4(const glm::mat4& m) {
+  glm::mat4 rows = glm::transpose(m);
+  return { { rows[0], rows[1], rows[2] } };
+}
+
+// 前8个关节是脊柱链，其余随机挂在之前的关节上
+static utils::Skeleton BuildSkeleton(std::mt19937* rng) {
+  std::uniform_real_distribution<float> offset(-0.1f, 0.1f);
+  std::uniform_real_distribution<float> angle(-0.3f, 0.3f);
+  utils::Skeleton skeleton;
+  skeleton.bind_pose.Resize(kJointCount);
+  for (size_t i = 0; i < kJointCount; i++) {
+    int parent = -1;
+    if (i > 0 && i < 8) {
+      parent = static_cast<int>(i) - 1;
+    } else if (i >= 8) {
+      parent = std::uniform_int_distribution<int>(0, static_cast<int>(i) - 1)(*rng);
+    }
+    skeleton.joint_names.push_back("joint" + std::to_string(i));
+    skeleton.parents.push_back(static_cast<int16_t>(parent));
+    glm::quat rotation = glm::angleAxis(angle(*rng), glm::normalize(glm::vec3(offset(*rng), 1.0f, offset(*rng))));
+    skeleton.bind_pose.Set(i, glm::vec3(offset(*rng), 0.2f, offset(*rng)), rotation, glm::vec3(1.0f));
+  }
+
+  // 绑定姿势下蒙皮矩阵为单位矩阵
+  utils::Matrix3x4 identity = ToMatrix3x4(glm::mat4(1.0f));
+  skeleton.inverse_bind.assign(kJointCount, identity);
+  std::vector<utils::Matrix3x4> models(kJointCount);
+  std::vector<utils::Matrix3x4> skinning(kJointCount);
+  utils::ComputeSkinningMatrices(skeleton, skeleton.bind_pose, models.data(), skinning.data());
+  for (size_t i = 0; i < kJointCount; i++) {
+    skeleton.inverse_bind[i] = ToMatrix3x4(glm::inverse(ToMat4(models[i])));
+  }
+  return skeleton;
+}
+
+struct JointMotion {
+  bool animated;
+  glm::vec3 axis;
+  float amplitude;
+  float frequency;
+  float phase;
+};
+
+// 动画的解析形式，用来检查压缩误差
+struct ClipMotion {
+  std::vector<JointMotion> joints;
+  float root_speed;
+};
+
+static glm::quat MotionRotation(const utils::Skeleton& skeleton, const JointMotion& motion, size_t joint, float t) {
+  const utils::TrsArrays& bind = skeleton.bind_pose;
+  glm::quat rotation(bind.rotation_w[joint], bind.rotation_x[joint], bind.rotation_y[joint], bind.rotation_z[joint]);
+  if (!motion.animated) {
+    return rotation;
+  }
+  float angle = motion.amplitude * std::sin(6.2831853f * motion.frequency * t + motion.phase);
+  return glm::angleAxis(angle, motion.axis) * rotation;
+}
+
+static glm::vec3 MotionTranslation(const utils::Skeleton& skeleton, const ClipMotion& clip, size_t joint, float t) {
+  const utils::TrsArrays& bind = skeleton.bind_pose;
+  glm::vec3 translation(bind.position_x[joint], bind.position_y[joint], bind.position_z[joint]);
+  if (joint == 0) {
+    translation += glm::vec3(clip.root_speed * t, 0.05f * std::sin(6.2831853f * 2.0f * t), 0.0f);
+  }
+  return translation;
+}
+
+// 四分之一的关节不动，没有轨道；只有根关节有平移；没有缩放
+static utils::RawAnimation BuildRawAnimation(const utils::Skeleton& skeleton, int index, ClipMotion* motion,
+                                             std::mt19937* rng) {
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> amplitude(0.1f, 0.8f);
+  std::uniform_real_distribution<float> frequency(0.3f, 2.0f);
+  motion->root_speed = 0.5f + index * 0.5f;
+  motion->joints.clear();
+  for (size_t joint = 0; joint < kJointCount; joint++) {
+    JointMotion joint_motion;
+    joint_motion.animated = joint % 4 != 3;
+    joint_motion.axis = glm::normalize(glm::vec3(unit(*rng), unit(*rng), unit(*rng)) + glm::vec3(0.0f, 0.0f, 0.1f));
+    joint_motion.amplitude = amplitude(*rng);
+    // 整数个周期，循环时首尾相接
+    joint_motion.frequency = std::round(frequency(*rng) * kClipDuration) / kClipDuration;
+    joint_motion.phase = unit(*rng) * 3.14159265f;
+    motion->joints.push_back(joint_motion);
+  }
+
+  utils::RawAnimation raw;
+  raw.name = "clip" + std::to_string(index);
+  raw.duration = kClipDuration;
+  raw.tracks.resize(kJointCount);
+  int key_count = static_cast<int>(kClipDuration * kRawKeyRate) + 1;
+  for (size_t joint = 0; joint < kJointCount; joint++) {
+    utils::RawJointTrack& track = raw.tracks[joint];
+    for (int k = 0; k < key_count && motion->joints[joint].animated; k++) {
+      float t = k / kRawKeyRate;
+      track.rotation_times.push_back(t);
+      track.rotations.push_back(MotionRotation(skeleton, motion->joints[joint], joint, t));
+    }
+    for (int k = 0; k < key_count && joint == 0; k++) {
+      float t = k / kRawKeyRate;
+      track.translation_times.push_back(t);
+      track.translations.push_back(MotionTranslation(skeleton, *motion, joint, t));
+    }
+  }
+  return raw;
+}
+
+static bool CheckError(const utils::Skeleton& skeleton, const utils::AnimationClip& clip, const ClipMotion& motion,
+                       float* max_rotation, float* max_translation) {
+  utils::TrsArrays pose;
+  *max_rotation = 0.0f;
+  *max_translation = 0.0f;
+  const int kSamples = 997;
+  for (int s = 0; s < kSamples; s++) {
+    float t = kClipDuration * s / kSamples;
+    clip.Sample(t, &pose);
+    for (size_t joint = 0; joint < kJointCount; joint++) {
+      glm::quat expected = MotionRotation(skeleton, motion.joints[joint], joint, t);
+      glm::quat actual(pose.rotation_w[joint], pose.rotation_x[joint], pose.rotation_y[joint], pose.rotation_z[joint]);
+      float dot = std::min(1.0f, std::abs(glm::dot(expected, actual)));
+      *max_rotation = std::max(*max_rotation, 2.0f * std::acos(dot));
+      glm::vec3 translation(pose.position_x[joint], pose.position_y[joint], pose.position_z[joint]);
+      *max_translation =
+        std::max(*max_translation, glm::length(translation - MotionTranslation(skeleton, motion, joint, t)));
+      *max_translation = std::max(*max_translation, std::abs(pose.scale_x[joint] - 1.0f));
+    }
+  }
+  return *max_rotation <= kMaxRotationError && *max_translation <= kMaxTranslationError;
+}
+
+static bool CheckWeights() {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+  for (int i = 0; i < 1000; i++) {
+    uint32_t joints[6] = { 0, 1, 2, 3, 4, 5 };
+    float weights[6];
+    for (float& w : weights) {
+      w = weight(rng);
+    }
+    utils::SkinnedVertex vertex;
+    utils::QuantizeWeights(joints, weights, 6, &vertex);
+    int sum = 0;
+    for (int k = 0; k < utils::kMaxJointInfluences; k++) {
+      sum += vertex.weights[k];
+      // 丢掉的两个影响都不比保留的大
+      for (int j = 0; j < 6; j++) {
+        bool kept = std::find(vertex.joints, vertex.joints + 4, joints[j]) != vertex.joints + 4;
+        if (!kept && weights[j] > weights[vertex.joints[k]]) {
+          std::cout << "quantized weights dropped a larger influence" << std::endl;
+          return false;
+        }
+      }
+    }
+    if (sum != 255) {
+      std::cout << "quantized weights sum to " << sum << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<utils::AnimationInstance> BuildCrowd() {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> time(0.0f, kClipDuration);
+  std::vector<utils::AnimationInstance> instances(kCharacterCount);
+  for (size_t i = 0; i < kCharacterCount; i++) {
+    instances[i].clip = static_cast<int>(i % kClipCount);
+    instances[i].time = time(rng);
+    instances[i].blend_clip = static_cast<int>((i + 1) % kClipCount);
+    instances[i].blend_time = time(rng);
+    instances[i].blend_weight = 0.3f;
+  }
+  return instances;
+}
+
+static void AdvanceCrowd(std::vector<utils::AnimationInstance>* instances) {
+  for (utils::AnimationInstance& instance : *instances) {
+    instance.time += kFrameTime;
+    instance.blend_time += kFrameTime;
+  }
+}
+
+static bool CheckCrowd(const utils::Skeleton& skeleton, const std::vector<utils::AnimationClip>& clips,
+                       utils::ThreadPool* pool) {
+  std::vector<utils::AnimationInstance> instances = BuildCrowd();
+  std::vector<utils::AnimationInstance> initial = instances;
+  std::vector<utils::Matrix3x4> serial(kCharacterCount * kJointCount);
+  std::vector<utils::Matrix3x4> parallel(kCharacterCount * kJointCount);
+  utils::CrowdAnimator animator;
+
+  for (int frame = 0; frame < kFrames; frame++) {
+    animator.Update(skeleton, clips, instances.data(), kCharacterCount, nullptr, serial.data());
+    AdvanceCrowd(&instances);
+  }
+  instances = initial;
+  for (int frame = 0; frame < kFrames; frame++) {
+    animator.Update(skeleton, clips, instances.data(), kCharacterCount, pool, parallel.data());
+    AdvanceCrowd(&instances);
+  }
+
+  std::cout << kCharacterCount << " characters x " << kJointCount << " joints, skinning matrices "
+            << serial.size() * sizeof(utils::Matrix3x4) / 1024 << " KB/frame" << std::endl;
+
+  bool ok = true;
+  if (memcmp(serial.data(), parallel.data(), serial.size() * sizeof(utils::Matrix3x4)) != 0) {
+    std::cout << "parallel skinning matrices differ from single-threaded" << std::endl;
+    ok = false;
+  }
+
+  // 没有动画的角色停在绑定姿势，蒙皮矩阵为单位矩阵
+  utils::AnimationInstance rest;
+  rest.clip = -1;
+  animator.Update(skeleton, clips, &rest, 1, nullptr, serial.data());
+  for (size_t joint = 0; joint < kJointCount; joint++) {
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 4; c++) {
+        float expected = r == c ? 1.0f : 0.0f;
+        if (std::abs(serial[joint].rows[r][c] - expected) > 1e-4f) {
+          std::cout << "bind pose skinning matrix " << joint << " is not identity" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(7);
+  utils::Skeleton skeleton = BuildSkeleton(&rng);
+  // 按导入的关键帧频率重采样，精度只受容差和量化的影响
+  utils::AnimationCompressionOptions options;
+  options.sample_rate = kRawKeyRate;
+  std::vector<utils::RawAnimation> raws(kClipCount);
+  std::vector<utils::AnimationClip> clips(kClipCount);
+  bool ok = CheckWeights();
+
+  size_t total_raw = 0;
+  size_t total_compressed = 0;
+  for (int i = 0; i < kClipCount; i++) {
+    ClipMotion motion;
+    utils::RawAnimation& raw = raws[i];
+    raw = BuildRawAnimation(skeleton, i, &motion, &rng);
+    if (!utils::CompressAnimation(raw, skeleton, options, &clips[i])) {
+      return 1;
+    }
+    float max_rotation = 0.0f;
+    float max_translation = 0.0f;
+    if (!CheckError(skeleton, clips[i], motion, &max_rotation, &max_translation)) {
+      std::cout << raw.name << " error too large" << std::endl;
+      ok = false;
+    }
+    size_t raw_bytes = raw.memory_bytes();
+    size_t resampled_bytes = utils::ResampledAnimationBytes(raw, skeleton, options);
+    size_t compressed_bytes = clips[i].memory_bytes();
+    total_raw += raw_bytes;
+    total_compressed += compressed_bytes;
+    std::cout << raw.name << ": raw " << raw_bytes / 1024.0 << " KB, resampled " << resampled_bytes / 1024.0
+              << " KB, compressed " << compressed_bytes / 1024.0 << " KB (" << clips[i].key_count() << " keys, "
+              << static_cast<double>(raw_bytes) / compressed_bytes << "x), max error " << max_rotation
+              << " rad / " << max_translation << std::endl;
+  }
+  std::cout << "memory per clip: raw " << total_raw / kClipCount / 1024.0 << " KB, compressed "
+            << total_compressed / kClipCount / 1024.0 << " KB" << std::endl;
+
+  utils::ThreadPool pool;
+  ok = CheckCrowd(skeleton, clips, &pool) && ok;
+  std::cout << (ok ? "all animation checks passed" : "MISMATCH") << std::endl;
+
+  bench::Runner runner;
+  runner.Add("Animation/Compress/" + raws[0].name, [&](bench::State& state) {
+    utils::AnimationClip clip;
+    while (state.KeepRunning()) {
+      bench::DoNotOptimize(utils::CompressAnimation(raws[0], skeleton, options, &clip));
+    }
+  });
+  // 每次迭代为一帧：每个角色采样一个片段
+  runner.Add("Animation/SampleClip/characters:" + std::to_string(kCharacterCount), [&](bench::State& state) {
+    std::vector<utils::AnimationInstance> instances = BuildCrowd();
+    utils::TrsArrays pose;
+    while (state.KeepRunning()) {
+      for (const utils::AnimationInstance& instance : instances) {
+        clips[instance.clip].Sample(instance.time, &pose);
+      }
+      AdvanceCrowd(&instances);
+      bench::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kCharacterCount));
+  });
+  // 每次迭代为一帧：采样两个片段、混合并计算蒙皮矩阵
+  for (utils::ThreadPool* update_pool : {static_cast<utils::ThreadPool*>(nullptr), &pool}) {
+    std::string name = "Animation/CrowdUpdate/characters:" + std::to_string(kCharacterCount) +
+                       (update_pool != nullptr ? "/pool:" + std::to_string(pool.thread_count()) : "/serial");
+    runner.Add(name, [&, update_pool](bench::State& state) {
+      std::vector<utils::AnimationInstance> instances = BuildCrowd();
+      std::vector<utils::Matrix3x4> skinning(kCharacterCount * kJointCount);
+      utils::CrowdAnimator animator;
+      while (state.KeepRunning()) {
+        animator.Update(skeleton, clips, instances.data(), kCharacterCount, update_pool, skinning.data());
+        AdvanceCrowd(&instances);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kCharacterCount));
+    });
+  }
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include "benchmarks/bench_harness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+#include "utils/file_util.h"
+
+namespace bench {
+
+namespace {
+
+constexpr uint64_t kMaxIterations = 1000000000;
+
+const char* FlagValue(const char* arg, const char* flag) {
+  size_t length = strlen(flag);
+  if (strncmp(arg, flag, length) == 0 && arg[length] == '=') {
+    return arg + length + 1;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+void Runner::Add(const std::string& name, Function function) {
+  benchmarks_.push_back({ name, std::move(function) });
+}
+
+BenchmarkResult Runner::RunBenchmark(const Benchmark& benchmark) const {
+  BenchmarkResult result;
+  result.name = benchmark.name;
+
+  // 倍增迭代次数，直到一次运行足够长
+  uint64_t iterations = 1;
+  double min_ns = min_time_ * 1e9;
+  while (true) {
+    State state(iterations);
+    benchmark.function(state);
+    if (!state.error().empty()) {
+      result.error = state.error();
+      return result;
+    }
+    double elapsed = state.elapsed_ns();
+    if (elapsed >= min_ns || iterations >= kMaxIterations) {
+      break;
+    }
+    double scale = elapsed > 0.0 ? min_ns * 1.2 / elapsed : 100.0;
+    uint64_t next = static_cast<uint64_t>(static_cast<double>(iterations) * std::min(scale, 100.0));
+    iterations = std::min(std::max(next, iterations * 2), kMaxIterations);
+  }
+
+  std::vector<double> times;
+  double items = 0.0;
+  double bytes = 0.0;
+  for (int repetition = 0; repetition < repetitions_; repetition++) {
+    State state(iterations);
+    benchmark.function(state);
+    if (!state.error().empty()) {
+      result.error = state.error();
+      return result;
+    }
+    double seconds = state.elapsed_ns() / 1e9;
+    times.push_back(state.elapsed_ns() / static_cast<double>(state.iterations()));
+    if (seconds > 0.0) {
+      items += static_cast<double>(state.items_processed()) / seconds;
+      bytes += static_cast<double>(state.bytes_processed()) / seconds;
+    }
+  }
+
+  std::vector<double> sorted = times;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.0;
+  for (double t : times) {
+    sum += t;
+  }
+  double mean = sum / static_cast<double>(times.size());
+  double variance = 0.0;
+  for (double t : times) {
+    variance += (t - mean) * (t - mean);
+  }
+
+  result.iterations = iterations;
+  result.repetitions = repetitions_;
+  result.median_ns = sorted[sorted.size() / 2];
+  result.mean_ns = mean;
+  result.min_ns = sorted.front();
+  result.stddev_ns = times.size() > 1 ? std::sqrt(variance / static_cast<double>(times.size() - 1)) : 0.0;
+  result.items_per_second = items / static_cast<double>(times.size());
+  result.bytes_per_second = bytes / static_cast<double>(times.size());
+  return result;
+}
+
+int Runner::Run(int argc, char** argv) {
+  std::string filter;
+  std::string json_path;
+  for (int i = 1; i < argc; i++) {
+    if (const char* value = FlagValue(argv[i], "--filter")) {
+      filter = value;
+    } else if (const char* value = FlagValue(argv[i], "--json")) {
+      json_path = value;
+    } else if (const char* value = FlagValue(argv[i], "--min-time")) {
+      min_time_ = std::max(atof(value), 0.0);
+    } else if (const char* value = FlagValue(argv[i], "--repetitions")) {
+      repetitions_ = std::max(atoi(value), 1);
+    }
+  }
+
+  results_.clear();
+  char line[256];
+  snprintf(line, sizeof(line), "%-44s %14s %14s %12s %8s", "Benchmark", "Time (ns)", "Min (ns)", "Iterations", "CV");
+  std::cout << line << std::endl;
+  for (const Benchmark& benchmark : benchmarks_) {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    BenchmarkResult result = RunBenchmark(benchmark);
+    if (!result.error.empty()) {
+      snprintf(line, sizeof(line), "%-44s skipped: %s", result.name.c_str(), result.error.c_str());
+    } else {
+      double cv = result.mean_ns > 0.0 ? result.stddev_ns / result.mean_ns * 100.0 : 0.0;
+      snprintf(line, sizeof(line), "%-44s %14.1f %14.1f %12llu %7.1f%%", result.name.c_str(), result.median_ns,
+               result.min_ns, static_cast<unsigned long long>(result.iterations), cv);
+    }
+    std::cout << line << std::endl;
+    results_.push_back(result);
+  }
+
+  if (!json_path.empty() && !WriteJson(json_path, argc > 0 ? argv[0] : "", results_)) {
+    return 1;
+  }
+  return 0;
+}
+
+bool Runner::WriteJson(const std::string& path, const std::string& executable,
+                       const std::vector<BenchmarkResult>& results) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+
+  char date[64] = { 0 };
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+  fprintf(file, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": ", date);
+  utils::WriteJsonString(file, executable);
+  fprintf(file, ",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+  fprintf(file, "    \"library_build_type\": \"release\"\n  },\n");
+#else
+  fprintf(file, "    \"library_build_type\": \"debug\"\n  },\n");
+#endif
+  fprintf(file, "  \"benchmarks\": [\n");
+  bool first = true;
+  for (const BenchmarkResult& result : results) {
+    if (!result.error.empty()) {
+      continue;
+    }
+    fprintf(file, "%s    {\n      \"name\": ", first ? "" : ",\n");
+    utils::WriteJsonString(file, result.name);
+    fprintf(file, ",\n      \"run_name\": ");
+    utils::WriteJsonString(file, result.name);
+    fprintf(file,
+            ",\n      \"run_type\": \"iteration\",\n      \"repetitions\": %d,\n      \"iterations\": %llu,\n"
+            "      \"real_time\": %.6g,\n      \"cpu_time\": %.6g,\n      \"time_unit\": \"ns\",\n"
+            "      \"min_time\": %.6g,\n      \"mean_time\": %.6g,\n      \"stddev_time\": %.6g",
+            result.repetitions, static_cast<unsigned long long>(result.iterations), result.median_ns, result.median_ns,
+            result.min_ns, result.mean_ns, result.stddev_ns);
+    if (result.items_per_second > 0.0) {
+      fprintf(file, ",\n      \"items_per_second\": %.6g", result.items_per_second);
+    }
+    if (result.bytes_per_second > 0.0) {
+      fprintf(file, ",\n      \"bytes_per_second\": %.6g", result.bytes_per_second);
+    }
+    fprintf(file, "\n    }");
+    first = false;
+  }
+  fprintf(file, "\n  ]\n}\n");
+
+  bool ok = ferror(file) == 0;
+  fclose(file);
+  return ok;
+}
+
+}  // namespace bench
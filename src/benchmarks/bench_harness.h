@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// 阻止编译器把只为计时而计算的结果优化掉
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+// 一次运行的状态，基准函数的写法：
+//   while (state.KeepRunning()) { ... }
+class State {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit State(uint64_t max_iterations) : max_iterations_(max_iterations) {}
+
+  bool KeepRunning() {
+    if (iterations_ == 0) {
+      start_ = Clock::now();
+    }
+    if (iterations_ < max_iterations_ && error_.empty()) {
+      iterations_++;
+      return true;
+    }
+    if (running_) {
+      elapsed_ns_ += std::chrono::duration<double, std::nano>(Clock::now() - start_).count();
+      running_ = false;
+    }
+    return false;
+  }
+
+  // 暂停期间的时间不计入（有额外开销，只用于较重的准备工作）
+  void PauseTiming() {
+    elapsed_ns_ += std::chrono::duration<double, std::nano>(Clock::now() - start_).count();
+    running_ = false;
+  }
+
+  void ResumeTiming() {
+    start_ = Clock::now();
+    running_ = true;
+  }
+
+  void SetItemsProcessed(int64_t items) {
+    items_processed_ = items;
+  }
+
+  void SetBytesProcessed(int64_t bytes) {
+    bytes_processed_ = bytes;
+  }
+
+  // 跳过这个基准，例如没有GL上下文时
+  void SkipWithError(const std::string& error) {
+    error_ = error;
+  }
+
+  uint64_t iterations() const {
+    return iterations_;
+  }
+
+  uint64_t max_iterations() const {
+    return max_iterations_;
+  }
+
+  double elapsed_ns() const {
+    return elapsed_ns_;
+  }
+
+  int64_t items_processed() const {
+    return items_processed_;
+  }
+
+  int64_t bytes_processed() const {
+    return bytes_processed_;
+  }
+
+  const std::string& error() const {
+    return error_;
+  }
+
+private:
+  uint64_t max_iterations_;
+  uint64_t iterations_ = 0;
+  bool running_ = true;
+  Clock::time_point start_;
+  double elapsed_ns_ = 0.0;
+  int64_t items_processed_ = 0;
+  int64_t bytes_processed_ = 0;
+  std::string error_;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  uint64_t iterations = 0;
+  int repetitions = 0;
+  // 每次迭代的时间（纳秒），取各次重复的中位数
+  double median_ns = 0.0;
+  double mean_ns = 0.0;
+  double min_ns = 0.0;
+  double stddev_ns = 0.0;
+  double items_per_second = 0.0;
+  double bytes_per_second = 0.0;
+  std::string error;
+};
+
+// 微基准框架，接口仿照Google Benchmark。先倍增迭代次数直到一次运行超过min_time，
+// 再用这个次数重复运行若干次。JSON输出与Google Benchmark的格式兼容，可以直接用它的compare.py比较。
+class Runner {
+public:
+  using Function = std::function<void(State&)>;
+
+  void Add(const std::string& name, Function function);
+
+  // 参数：--filter=子串 --json=路径 --min-time=秒 --repetitions=N
+  // 返回进程退出码
+  int Run(int argc, char** argv);
+
+  const std::vector<BenchmarkResult>& results() const {
+    return results_;
+  }
+
+  static bool WriteJson(const std::string& path, const std::string& executable,
+                        const std::vector<BenchmarkResult>& results);
+
+private:
+  struct Benchmark {
+    std::string name;
+    Function function;
+  };
+
+  BenchmarkResult RunBenchmark(const Benchmark& benchmark) const;
+
+private:
+  std::vector<Benchmark> benchmarks_;
+  std::vector<BenchmarkResult> results_;
+  double min_time_ = 0.2;
+  int repetitions_ = 3;
+};
+
+}  // namespace bench
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/bvh.h"
+
+// 用法：bvh_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查两种BVH的视锥和射线查询与暴力结果一致（动态BVH在更新前后各查一次），不一致时返回1；再计时构建、查询和更新。
+
+static constexpr size_t kObjectCount = 1000000;
+static constexpr float kWorldSize = 1000.0f;
+
+static std::vector<utils::Aabb> RandomBounds(std::mt19937& rng, size_t count) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  std::uniform_real_distribution<float> size(0.2f, 2.0f);
+  std::vector<utils::Aabb> bounds(count);
+  for (auto& aabb : bounds) {
+    glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+    glm::vec3 extent(size(rng), size(rng), size(rng));
+    aabb = utils::Aabb(center - extent, center + extent);
+  }
+  return bounds;
+}
+
+static std::vector<utils::Frustum> RandomFrustums(std::mt19937& rng, size_t count) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+  std::vector<utils::Frustum> frustums;
+  for (size_t i = 0; i < count; i++) {
+    glm::vec3 eye(position(rng), 10.0f, position(rng));
+    float yaw = angle(rng);
+    glm::vec3 front(std::cos(yaw), -0.1f, std::sin(yaw));
+    glm::mat4 view = glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f));
+    frustums.push_back(utils::Frustum::FromMatrix(projection * view));
+  }
+  return frustums;
+}
+
+static std::vector<utils::Ray> RandomRays(std::mt19937& rng, size_t count) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+  std::vector<utils::Ray> rays(count);
+  for (auto& ray : rays) {
+    ray.origin = glm::vec3(position(rng), 5.0f, position(rng));
+    ray.direction = glm::normalize(glm::vec3(direction(rng), direction(rng) * 0.1f, direction(rng)));
+  }
+  return rays;
+}
+
+static std::vector<uint32_t> BruteForceFrustum(const std::vector<utils::Aabb>& bounds, const utils::Frustum& frustum) {
+  std::vector<uint32_t> result;
+  for (size_t i = 0; i < bounds.size(); i++) {
+    if (frustum.Intersects(bounds[i])) {
+      result.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  return result;
+}
+
+static bool BruteForceRay(const std::vector<utils::Aabb>& bounds, const utils::Ray& ray, float max_distance,
+                          utils::RayHit* hit) {
+  glm::vec3 inv_direction(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+  bool found = false;
+  float best = max_distance;
+  for (size_t i = 0; i < bounds.size(); i++) {
+    float t = 0.0f;
+    if (utils::IntersectRayAabb(ray, inv_direction, bounds[i], best, &t) && t <= best) {
+      best = t;
+      hit->object = static_cast<uint32_t>(i);
+      hit->distance = t;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// 比较结果集合，返回不一致的数量
+static size_t CompareSets(std::vector<uint32_t> a, std::vector<uint32_t> b) {
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint32_t> diff;
+  std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(diff));
+  return diff.size();
+}
+
+template <typename Bvh>
+static size_t Verify(const char* name, const Bvh& bvh, const std::vector<utils::Aabb>& bounds,
+                     const std::vector<utils::Frustum>& frustums, const std::vector<utils::Ray>& rays) {
+  size_t mismatches = 0;
+  for (const auto& frustum : frustums) {
+    std::vector<uint32_t> result;
+    bvh.QueryFrustum(frustum, &result);
+    mismatches += CompareSets(result, BruteForceFrustum(bounds, frustum));
+  }
+
+  std::vector<std::vector<uint32_t>> batch(frustums.size());
+  bvh.QueryFrustums(frustums.data(), static_cast<uint32_t>(frustums.size()), batch.data());
+  for (size_t i = 0; i < frustums.size(); i++) {
+    mismatches += CompareSets(batch[i], BruteForceFrustum(bounds, frustums[i]));
+  }
+
+  for (const auto& ray : rays) {
+    utils::RayHit expected;
+    utils::RayHit actual;
+    bool expected_hit = BruteForceRay(bounds, ray, 1e30f, &expected);
+    bool actual_hit = bvh.Raycast(ray, 1e30f, &actual);
+    if (expected_hit != actual_hit || (expected_hit && std::abs(expected.distance - actual.distance) > 1e-4f)) {
+      mismatches++;
+    }
+  }
+
+  std::cout << name << " vs brute force: " << mismatches << " mismatches" << std::endl;
+  return mismatches;
+}
+
+// 10%的物体小幅移动：增量更新，返回重新插入的数量
+static size_t MoveTenth(std::mt19937& rng, const std::vector<uint32_t>& proxies, std::vector<utils::Aabb>* bounds,
+                        utils::DynamicBvh* bvh) {
+  std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+  size_t reinserted = 0;
+  for (size_t i = 0; i < kObjectCount; i += 10) {
+    glm::vec3 offset(jitter(rng), jitter(rng), jitter(rng));
+    (*bounds)[i] = utils::Aabb((*bounds)[i].min + offset, (*bounds)[i].max + offset);
+    reinserted += bvh->MoveProxy(proxies[i], (*bounds)[i]) ? 1 : 0;
+  }
+  return reinserted;
+}
+
+// 所有物体小幅移动：只更新包围盒再整体refit
+static void JitterAllAndRefit(std::mt19937& rng, const std::vector<uint32_t>& proxies,
+                              std::vector<utils::Aabb>* bounds, utils::DynamicBvh* bvh) {
+  std::uniform_real_distribution<float> jitter(-0.03f, 0.03f);
+  for (size_t i = 0; i < kObjectCount; i++) {
+    glm::vec3 offset(jitter(rng));
+    (*bounds)[i] = utils::Aabb((*bounds)[i].min + offset, (*bounds)[i].max + offset);
+    bvh->SetBounds(proxies[i], (*bounds)[i]);
+  }
+  bvh->Refit();
+}
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(7);
+  const std::vector<utils::Aabb> initial_bounds = RandomBounds(rng, kObjectCount);
+  std::vector<utils::Frustum> frustums = RandomFrustums(rng, 8);
+  std::vector<utils::Ray> rays = RandomRays(rng, 1000);
+
+  utils::StaticBvh static_bvh;
+  static_bvh.Build(initial_bounds);
+  std::cout << "StaticBvh: " << static_bvh.node_count() << " nodes" << std::endl;
+
+  utils::DynamicBvh dynamic_bvh;
+  std::vector<uint32_t> proxies(kObjectCount);
+  for (size_t i = 0; i < kObjectCount; i++) {
+    proxies[i] = dynamic_bvh.CreateProxy(initial_bounds[i], static_cast<uint32_t>(i));
+  }
+  std::cout << "DynamicBvh: height " << dynamic_bvh.height() << std::endl;
+
+  size_t mismatches = Verify("StaticBvh", static_bvh, initial_bounds, frustums, rays);
+  mismatches += Verify("DynamicBvh", dynamic_bvh, initial_bounds, frustums, rays);
+
+  std::vector<utils::Aabb> bounds = initial_bounds;
+  size_t reinserted = MoveTenth(rng, proxies, &bounds, &dynamic_bvh);
+  std::cout << "DynamicBvh move 100k: " << reinserted << " reinserted" << std::endl;
+  JitterAllAndRefit(rng, proxies, &bounds, &dynamic_bvh);
+  mismatches += Verify("DynamicBvh after updates", dynamic_bvh, bounds, frustums, rays);
+
+  bench::Runner runner;
+  runner.Add("Bvh/Static/Build", [&initial_bounds](bench::State& state) {
+    utils::StaticBvh bvh;
+    while (state.KeepRunning()) {
+      bvh.Build(initial_bounds);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+  // 每次迭代插入到新的树，销毁旧树不计入
+  runner.Add("Bvh/Dynamic/Insert", [&initial_bounds](bench::State& state) {
+    std::unique_ptr<utils::DynamicBvh> bvh;
+    while (state.KeepRunning()) {
+      state.PauseTiming();
+      bvh.reset(new utils::DynamicBvh());
+      state.ResumeTiming();
+      for (size_t i = 0; i < kObjectCount; i++) {
+        bvh->CreateProxy(initial_bounds[i], static_cast<uint32_t>(i));
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+
+  // 查询类用例每次迭代处理所有视锥或射线，条目数按视锥/射线计
+  runner.Add("Bvh/Static/QueryFrustum", [&](bench::State& state) {
+    std::vector<uint32_t> visible;
+    visible.reserve(kObjectCount);
+    while (state.KeepRunning()) {
+      for (const auto& frustum : frustums) {
+        visible.clear();
+        static_bvh.QueryFrustum(frustum, &visible);
+      }
+      bench::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frustums.size()));
+  });
+  runner.Add("Bvh/BruteForce/QueryFrustum", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      for (const auto& frustum : frustums) {
+        bench::DoNotOptimize(BruteForceFrustum(initial_bounds, frustum).size());
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frustums.size()));
+  });
+  runner.Add("Bvh/Static/QueryFrustums", [&](bench::State& state) {
+    std::vector<std::vector<uint32_t>> batch(frustums.size());
+    while (state.KeepRunning()) {
+      static_bvh.QueryFrustums(frustums.data(), static_cast<uint32_t>(frustums.size()), batch.data());
+      bench::DoNotOptimize(batch.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frustums.size()));
+  });
+  runner.Add("Bvh/Static/Raycast", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      for (const auto& ray : rays) {
+        utils::RayHit hit;
+        bench::DoNotOptimize(static_bvh.Raycast(ray, 1e30f, &hit));
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rays.size()));
+  });
+  runner.Add("Bvh/Dynamic/Raycast", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      for (const auto& ray : rays) {
+        utils::RayHit hit;
+        bench::DoNotOptimize(dynamic_bvh.Raycast(ray, 1e30f, &hit));
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rays.size()));
+  });
+
+  runner.Add("Bvh/Dynamic/MoveProxy", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      bench::DoNotOptimize(MoveTenth(rng, proxies, &bounds, &dynamic_bvh));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount / 10));
+  });
+  runner.Add("Bvh/Dynamic/SetBoundsRefit", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      JitterAllAndRefit(rng, proxies, &bounds, &dynamic_bvh);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+
+  int result = runner.Run(argc, argv);
+  return mismatches == 0 && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// 替换全局operator new/delete，让utils::AllocationCount()计数。只编进需要检查堆分配的程序：
+//   add_executable(foo_bench foo_bench.cpp count_allocations.cpp)
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "utils/allocation_counter.h"
+
+namespace {
+
+const bool counting_enabled = (utils::EnableAllocationCounting(), true);
+
+void* CountedAlloc(size_t size, size_t alignment) {
+  utils::RecordAllocation(size);
+  if (size == 0) {
+    size = 1;
+  }
+  if (alignment <= alignof(std::max_align_t)) {
+    return malloc(size);
+  }
+#ifdef _MSC_VER
+  // MSVC没有aligned_alloc，对应的释放必须用_aligned_free
+  return _aligned_malloc(size, alignment);
+#else
+  // aligned_alloc要求大小是对齐的整数倍
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void* CountedAllocOrThrow(size_t size, size_t alignment) {
+  void* p = CountedAlloc(size, alignment);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+// 与CountedAlloc的分支对应
+void AlignedFree(void* p, std::align_val_t alignment) {
+#ifdef _MSC_VER
+  if (static_cast<size_t>(alignment) > alignof(std::max_align_t)) {
+    _aligned_free(p);
+    return;
+  }
+#endif
+  (void)alignment;
+  free(p);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAllocOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size) {
+  return CountedAllocOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return CountedAllocOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return CountedAllocOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+  AlignedFree(p, alignment);
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+  AlignedFree(p, alignment);
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept {
+  AlignedFree(p, alignment);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept {
+  AlignedFree(p, alignment);
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  AlignedFree(p, alignment);
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  AlignedFree(p, alignment);
+}
@@ -0,0 +1,267 @@
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/ecs.h"
+#include "utils/thread_pool.h"
+
+// 用法：ecs_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查各种遍历的结果、组件搬移和调度阶段，出错时返回1；再计时创建、遍历、组件增删和调度。
+
+static constexpr size_t kEntityCount = 1000000;
+static constexpr float kDt = 1.0f / 60.0f;
+// x超过这个值的实体被cull系统删除。初始x为下标，一步只移动kDt，第一次运行删除最后10个
+static constexpr float kCullX = 999989.5f;
+
+struct Position {
+  glm::vec3 value;
+};
+
+struct Velocity {
+  glm::vec3 value;
+};
+
+struct Lifetime {
+  float seconds;
+};
+
+struct Tint {
+  glm::vec4 color;
+};
+
+static void CreateEntities(utils::ecs::World* world, std::vector<utils::ecs::Entity>* entities) {
+  for (size_t i = 0; i < kEntityCount; i++) {
+    float x = static_cast<float>(i);
+    utils::ecs::Entity entity = world->CreateEntity(Position{ glm::vec3(x, 0.0f, 0.0f) },
+                                                    Velocity{ glm::vec3(1.0f, 2.0f, 3.0f) }, Lifetime{ 10.0f });
+    if (entities != nullptr) {
+      entities->push_back(entity);
+    }
+  }
+}
+
+// 系统调度：movement和lifetime互不冲突，可以在同一阶段执行；cull读取Position，必须等movement完成
+static void AddSystems(utils::ecs::SystemScheduler* scheduler) {
+  using namespace utils::ecs;
+  scheduler->AddSystem("movement", MaskOf<Velocity>(), MaskOf<Position>(), [](World& w, CommandBuffer&) {
+    w.ForEach<Position, const Velocity>([](Position& p, const Velocity& v) { p.value += v.value * kDt; });
+  });
+  scheduler->AddSystem("lifetime", 0, MaskOf<Lifetime>(), [](World& w, CommandBuffer&) {
+    w.ForEach<Lifetime>([](Lifetime& l) { l.seconds -= kDt; });
+  });
+  scheduler->AddSystem("cull", MaskOf<Position>(), 0, [](World& w, CommandBuffer& cmds) {
+    w.ForEachChunk<const Position>([&cmds](uint32_t count, const Entity* e, const Position* p) {
+      for (uint32_t i = 0; i < count; i++) {
+        if (p[i].value.x > kCullX) {
+          cmds.DestroyEntity(e[i]);
+        }
+      }
+    });
+  });
+}
+
+// 三种遍历各推进一步后，每个实体移动了3 * kDt * velocity
+static bool CheckIteration(utils::ThreadPool* pool) {
+  using namespace utils::ecs;
+  World world;
+  CreateEntities(&world, nullptr);
+  world.ForEach<Position, const Velocity>([](Position& p, const Velocity& v) { p.value += v.value * kDt; });
+  world.ForEachChunk<Position, const Velocity>(
+      [](uint32_t count, const Entity*, Position* positions, const Velocity* velocities) {
+        for (uint32_t i = 0; i < count; i++) {
+          positions[i].value += velocities[i].value * kDt;
+        }
+      });
+  world.ParallelForEach<Position, const Velocity>(pool, [](Position& p, const Velocity& v) {
+    p.value += v.value * kDt;
+  });
+
+  size_t wrong = 0;
+  size_t visited = 0;
+  world.ForEach<const Position>([&](const Position& p) {
+    // x的初始值是下标，只检查y和z
+    if (std::abs(p.value.y - 6.0f * kDt) > 1e-5f || std::abs(p.value.z - 9.0f * kDt) > 1e-5f) {
+      wrong++;
+    }
+    visited++;
+  });
+  if (wrong != 0 || visited != kEntityCount) {
+    std::cout << "iteration: " << wrong << " wrong positions, " << visited << " entities visited" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckStructuralChanges(utils::ThreadPool* pool) {
+  using namespace utils::ecs;
+  bool ok = true;
+  World world;
+  std::vector<Entity> entities;
+  CreateEntities(&world, &entities);
+
+  // 增加组件后实体搬到新的archetype，原有组件保持不变
+  for (size_t i = 0; i < kEntityCount; i += 10) {
+    world.AddComponent(entities[i], Tint{ glm::vec4(1.0f) });
+  }
+  size_t tinted = 0;
+  world.ForEach<const Position, const Tint>([&tinted](const Position&, const Tint&) { tinted++; });
+  for (size_t i = 0; i < kEntityCount; i += 10) {
+    world.RemoveComponent<Tint>(entities[i]);
+  }
+  size_t remaining = 0;
+  world.ForEach<const Tint>([&remaining](const Tint&) { remaining++; });
+  if (tinted != kEntityCount / 10 || remaining != 0 || world.entity_count() != kEntityCount) {
+    std::cout << "add/remove component: " << tinted << " tinted, " << remaining << " left" << std::endl;
+    ok = false;
+  }
+
+  SystemScheduler scheduler;
+  AddSystems(&scheduler);
+  const auto& phases = scheduler.phases();
+  for (size_t i = 0; i < phases.size(); i++) {
+    std::cout << "Phase " << i << ":";
+    for (size_t system : phases[i]) {
+      std::cout << " " << scheduler.system_name(system);
+    }
+    std::cout << std::endl;
+  }
+  if (phases.size() != 2) {
+    std::cout << "scheduler: expected 2 phases, got " << phases.size() << std::endl;
+    ok = false;
+  }
+  scheduler.Run(&world, pool);
+  if (world.entity_count() != kEntityCount - 10) {
+    std::cout << "scheduler: " << world.entity_count() << " entities after cull" << std::endl;
+    ok = false;
+  }
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  using namespace utils::ecs;
+
+  utils::ThreadPool pool;
+  std::cout << "Threads: " << pool.thread_count() << std::endl;
+  bool ok = CheckIteration(&pool);
+  ok &= CheckStructuralChanges(&pool);
+
+  bench::Runner runner;
+  const std::string pool_suffix = "/pool:" + std::to_string(pool.thread_count());
+
+  // 每次迭代用新的World，销毁旧World不计入
+  runner.Add("ECS/Create/Direct", [](bench::State& state) {
+    std::unique_ptr<World> world;
+    while (state.KeepRunning()) {
+      state.PauseTiming();
+      world.reset(new World());
+      state.ResumeTiming();
+      CreateEntities(world.get(), nullptr);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+  runner.Add("ECS/Create/Record", [](bench::State& state) {
+    CommandBuffer commands;
+    while (state.KeepRunning()) {
+      state.PauseTiming();
+      commands.Clear();
+      state.ResumeTiming();
+      for (size_t i = 0; i < kEntityCount; i++) {
+        commands.CreateEntity(Position{ glm::vec3(0.0f) }, Velocity{ glm::vec3(1.0f) });
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+  runner.Add("ECS/Create/Playback", [](bench::State& state) {
+    std::unique_ptr<World> world;
+    CommandBuffer commands;
+    while (state.KeepRunning()) {
+      state.PauseTiming();
+      world.reset(new World());
+      for (size_t i = 0; i < kEntityCount; i++) {
+        commands.CreateEntity(Position{ glm::vec3(0.0f) }, Velocity{ glm::vec3(1.0f) });
+      }
+      state.ResumeTiming();
+      commands.Playback(world.get());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+
+  World world;
+  std::vector<Entity> entities;
+  entities.reserve(kEntityCount);
+  CreateEntities(&world, &entities);
+
+  runner.Add("ECS/ForEach", [&world](bench::State& state) {
+    while (state.KeepRunning()) {
+      world.ForEach<Position, const Velocity>([](Position& p, const Velocity& v) { p.value += v.value * kDt; });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+  runner.Add("ECS/ForEachChunk", [&world](bench::State& state) {
+    while (state.KeepRunning()) {
+      world.ForEachChunk<Position, const Velocity>(
+          [](uint32_t count, const Entity*, Position* positions, const Velocity* velocities) {
+            for (uint32_t i = 0; i < count; i++) {
+              positions[i].value += velocities[i].value * kDt;
+            }
+          });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+  runner.Add("ECS/ParallelForEach" + pool_suffix, [&world, &pool](bench::State& state) {
+    while (state.KeepRunning()) {
+      world.ParallelForEach<Position, const Velocity>(&pool, [](Position& p, const Velocity& v) {
+        p.value += v.value * kDt;
+      });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+
+  // 对照：同样数据的AoS数组
+  runner.Add("ECS/BaselineAoS", [](bench::State& state) {
+    struct Particle {
+      glm::vec3 position;
+      glm::vec3 velocity;
+      float lifetime;
+    };
+    std::vector<Particle> particles(kEntityCount, Particle{ glm::vec3(0.0f), glm::vec3(1.0f), 10.0f });
+    while (state.KeepRunning()) {
+      for (Particle& particle : particles) {
+        particle.position += particle.velocity * kDt;
+      }
+      bench::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+
+  // 10%的实体增加再删除组件，测试archetype之间的搬移
+  runner.Add("ECS/AddRemoveComponent", [&world, &entities](bench::State& state) {
+    while (state.KeepRunning()) {
+      for (size_t i = 0; i < kEntityCount; i += 10) {
+        world.AddComponent(entities[i], Tint{ glm::vec4(1.0f) });
+      }
+      for (size_t i = 0; i < kEntityCount; i += 10) {
+        world.RemoveComponent<Tint>(entities[i]);
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount / 10));
+  });
+
+  // 放在最后：cull会删除实体，之后的用例看到的实体数会变少
+  SystemScheduler scheduler;
+  AddSystems(&scheduler);
+  runner.Add("ECS/Scheduler" + pool_suffix, [&world, &scheduler, &pool](bench::State& state) {
+    while (state.KeepRunning()) {
+      scheduler.Run(&world, &pool);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEntityCount));
+  });
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/allocation_counter.h"
+#include "utils/frame_arena.h"
+#include "utils/thread_pool.h"
+
+// 用法：frame_arena_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先逐帧比较两种写法的命令列表并统计堆分配次数，稳定后FrameArena版本仍有分配或结果不同时返回1；再分别计时一帧。
+
+static constexpr size_t kObjectCount = 50000;
+static constexpr size_t kGrain = 4096;
+static constexpr size_t kChunkCount = (kObjectCount + kGrain - 1) / kGrain;
+static constexpr int kFrames = 200;
+static constexpr int kWarmupFrames = 3;
+// 工作线程第一次拿到任务时才创建自己的分配器，之后的帧必须完全不分配
+static constexpr int kSteadyFrames = kFrames / 2;
+
+// 相机绕竖直轴转动，每帧的可见集合不同
+static void FrameCamera(int frame, glm::vec3* eye, glm::vec3* forward) {
+  float angle = static_cast<float>(frame) * 0.05f;
+  *eye = glm::vec3(0.0f, 2.0f, 0.0f);
+  *forward = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+}
+
+struct Object {
+  glm::vec3 center;
+  float radius;
+  uint32_t mesh;
+  uint32_t material;
+};
+
+struct DrawCommand {
+  uint32_t object;
+  uint32_t mesh;
+  uint32_t material;
+};
+
+// 排序键：材质、网格、离相机的距离（量化为16位），物体下标放在低位保证排序结果唯一
+static uint64_t SortKey(const Object& object, uint32_t index, const glm::vec3& eye) {
+  float distance = std::min(glm::length(object.center - eye), 1023.0f);
+  auto depth = static_cast<uint64_t>(distance * 64.0f);
+  return static_cast<uint64_t>(object.material) << 56 | static_cast<uint64_t>(object.mesh) << 48 | depth << 32 |
+         index;
+}
+
+static bool Visible(const Object& object, const glm::vec3& eye, const glm::vec3& forward) {
+  return glm::dot(object.center - eye, forward) > -object.radius;
+}
+
+static uint64_t Checksum(const DrawCommand* commands, size_t count) {
+  uint64_t hash = 1469598103934665603ull;
+  for (size_t i = 0; i < count; i++) {
+    hash = (hash ^ commands[i].object) * 1099511628211ull;
+  }
+  return hash ^ count;
+}
+
+// 一帧的临时数据：各线程剔除一段物体，合并后排序，生成绘制命令
+// 堆版本：每帧新建std::vector，和常见的写法一样
+static uint64_t HeapFrame(utils::ThreadPool* pool, const std::vector<Object>& objects, const glm::vec3& eye,
+                          const glm::vec3& forward) {
+  std::vector<std::vector<uint32_t>> chunk_visible(kChunkCount);
+  pool->ParallelFor(objects.size(), kGrain, [&](size_t begin, size_t end) {
+    std::vector<uint32_t>& visible = chunk_visible[begin / kGrain];
+    for (size_t i = begin; i < end; i++) {
+      if (Visible(objects[i], eye, forward)) {
+        visible.push_back(static_cast<uint32_t>(i));
+      }
+    }
+  });
+  std::vector<uint64_t> keys;
+  for (const std::vector<uint32_t>& visible : chunk_visible) {
+    for (uint32_t index : visible) {
+      keys.push_back(SortKey(objects[index], index, eye));
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  std::vector<DrawCommand> commands;
+  for (uint64_t key : keys) {
+    auto index = static_cast<uint32_t>(key);
+    commands.push_back({ index, objects[index].mesh, objects[index].material });
+  }
+  return Checksum(commands.data(), commands.size());
+}
+
+struct ChunkResult {
+  const uint32_t* visible = nullptr;
+  size_t count = 0;
+};
+
+// 分配器版本：各线程的结果在自己的FrameArena中，合并和命令列表在调用线程的FrameArena中
+class ArenaFrame {
+public:
+  ArenaFrame(utils::ThreadPool* pool, const std::vector<Object>& objects)
+      : pool_(pool), objects_(objects), chunks_(kChunkCount),
+        cull_([this](size_t begin, size_t end) { Cull(begin, end); }) {}
+
+  uint64_t Run(const glm::vec3& eye, const glm::vec3& forward) {
+    eye_ = eye;
+    forward_ = forward;
+    // RangeFunc在构造时创建，每帧传引用，不产生std::function的分配
+    pool_->ParallelFor(objects_.size(), kGrain, cull_);
+
+    utils::FrameArena& arena = utils::FrameArena::ForThread();
+    size_t total = 0;
+    for (const ChunkResult& chunk : chunks_) {
+      total += chunk.count;
+    }
+    utils::ArenaVector<uint64_t> keys{ utils::ArenaAllocator<uint64_t>(&arena) };
+    keys.reserve(total);
+    for (const ChunkResult& chunk : chunks_) {
+      for (size_t i = 0; i < chunk.count; i++) {
+        uint32_t index = chunk.visible[i];
+        keys.push_back(SortKey(objects_[index], index, eye_));
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+    utils::ArenaVector<DrawCommand> commands{ utils::ArenaAllocator<DrawCommand>(&arena) };
+    commands.reserve(keys.size());
+    for (uint64_t key : keys) {
+      auto index = static_cast<uint32_t>(key);
+      commands.push_back({ index, objects_[index].mesh, objects_[index].material });
+    }
+    return Checksum(commands.data(), commands.size());
+  }
+
+private:
+  void Cull(size_t begin, size_t end) {
+    utils::FrameArena& arena = utils::FrameArena::ForThread();
+    auto* visible = arena.AllocateArray<uint32_t>(end - begin);
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++) {
+      if (Visible(objects_[i], eye_, forward_)) {
+        visible[count++] = static_cast<uint32_t>(i);
+      }
+    }
+    chunks_[begin / kGrain] = { visible, count };
+  }
+
+private:
+  utils::ThreadPool* pool_;
+  const std::vector<Object>& objects_;
+  std::vector<ChunkResult> chunks_;
+  utils::ThreadPool::RangeFunc cull_;
+  glm::vec3 eye_ = glm::vec3(0.0f);
+  glm::vec3 forward_ = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+static bool CheckArenaBasics() {
+  bool ok = true;
+  {
+    utils::FrameArena arena(1024, true);
+    auto* bytes = static_cast<uint8_t*>(arena.Allocate(100));
+    memset(bytes, 0x11, 100);
+    arena.Reset();
+    for (int i = 0; i < 100; i++) {
+      if (bytes[i] != utils::FrameArena::kPoisonByte) {
+        std::cout << "poison missing at byte " << i << std::endl;
+        ok = false;
+        break;
+      }
+    }
+  }
+  {
+    utils::FrameArena arena(1024);
+    arena.Allocate(3);
+    void* p = arena.Allocate(16, 64);
+    if (reinterpret_cast<uintptr_t>(p) % 64 != 0) {
+      std::cout << "alignment not respected" << std::endl;
+      ok = false;
+    }
+  }
+  {
+    // 第一帧超出块大小，Reset后合并成一个块，之后相同的帧不再分配
+    utils::FrameArena arena(1024);
+    uint64_t blocks = 0;
+    for (int frame = 0; frame < 3; frame++) {
+      for (int i = 0; i < 10; i++) {
+        arena.Allocate(500);
+      }
+      if (frame == 1) {
+        blocks = arena.block_allocations();
+      }
+      arena.Reset();
+    }
+    if (arena.block_allocations() != blocks || arena.high_water_mark() < 5000) {
+      std::cout << "arena did not settle: " << arena.block_allocations() << " blocks, high water "
+                << arena.high_water_mark() << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  if (!utils::AllocationCountingEnabled()) {
+    std::cout << "built without count_allocations.cpp, heap allocations cannot be counted" << std::endl;
+    return 1;
+  }
+  bool ok = CheckArenaBasics();
+
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+  std::uniform_int_distribution<uint32_t> mesh(0, 63);
+  std::uniform_int_distribution<uint32_t> material(0, 15);
+  std::vector<Object> objects(kObjectCount);
+  for (Object& object : objects) {
+    object = { glm::vec3(position(rng), position(rng) * 0.1f, position(rng)), radius(rng), mesh(rng), material(rng) };
+  }
+
+  utils::ThreadPool pool;
+  ArenaFrame arena_frame(&pool, objects);
+  uint64_t heap_allocations = 0;
+  uint64_t arena_allocations = 0;
+  for (int frame = 0; frame < kFrames; frame++) {
+    glm::vec3 eye;
+    glm::vec3 forward;
+    FrameCamera(frame, &eye, &forward);
+    bool steady = frame >= kWarmupFrames;
+
+    uint64_t allocations = utils::AllocationCount();
+    uint64_t expected = HeapFrame(&pool, objects, eye, forward);
+    if (steady) {
+      heap_allocations += utils::AllocationCount() - allocations;
+    }
+
+    allocations = utils::AllocationCount();
+    uint64_t actual = arena_frame.Run(eye, forward);
+    utils::FrameArena::ResetThreadArenas();
+    if (steady) {
+      uint64_t frame_allocations = utils::AllocationCount() - allocations;
+      arena_allocations += frame_allocations;
+      if (frame >= kSteadyFrames && frame_allocations != 0) {
+        std::cout << "frame " << frame << ": " << frame_allocations << " heap allocations with FrameArena"
+                  << std::endl;
+        ok = false;
+      }
+    }
+    if (actual != expected) {
+      std::cout << "frame " << frame << ": command lists differ" << std::endl;
+      ok = false;
+    }
+  }
+
+  int steady_frames = kFrames - kWarmupFrames;
+  std::cout << "threads: " << pool.thread_count() << ", objects: " << kObjectCount << std::endl;
+  std::cout << "std::vector: " << static_cast<double>(heap_allocations) / steady_frames << " allocations per frame"
+            << std::endl;
+  std::cout << "FrameArena:  " << static_cast<double>(arena_allocations) / steady_frames
+            << " allocations per frame, high water " << utils::FrameArena::ForThread().high_water_mark() / 1024
+            << " KB on the main thread" << std::endl;
+  std::cout << (ok ? "steady-state frames allocation free" : "MISMATCH") << std::endl;
+
+  bench::Runner runner;
+  runner.Add("FrameArena/Frame/std::vector", [&](bench::State& state) {
+    int frame = 0;
+    glm::vec3 eye;
+    glm::vec3 forward;
+    while (state.KeepRunning()) {
+      FrameCamera(frame++, &eye, &forward);
+      bench::DoNotOptimize(HeapFrame(&pool, objects, eye, forward));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+  runner.Add("FrameArena/Frame/FrameArena", [&](bench::State& state) {
+    int frame = 0;
+    glm::vec3 eye;
+    glm::vec3 forward;
+    while (state.KeepRunning()) {
+      FrameCamera(frame++, &eye, &forward);
+      bench::DoNotOptimize(arena_frame.Run(eye, forward));
+      utils::FrameArena::ResetThreadArenas();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/frustum_cull.h"
+
+// 用法：frustum_cull_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查各剔除内核的结果与逐个调用Frustum::Intersects一致，不一致时返回1；再计时glm标量版本和各内核。
+
+static constexpr size_t kObjectCount = 1000003;
+
+static bool SameResult(const std::vector<uint32_t>& expected, const std::vector<uint32_t>& actual, size_t count) {
+  if (expected.size() != count) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (expected[i] != actual[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> size(0.1f, 3.0f);
+
+  std::vector<utils::Sphere> spheres(kObjectCount);
+  std::vector<utils::Aabb> aabbs(kObjectCount);
+  utils::SphereArrays sphere_arrays;
+  utils::AabbArrays aabb_arrays;
+  sphere_arrays.Resize(kObjectCount);
+  aabb_arrays.Resize(kObjectCount);
+  for (size_t i = 0; i < kObjectCount; i++) {
+    glm::vec3 center(position(rng), position(rng) * 0.2f, position(rng));
+    glm::vec3 extent(size(rng), size(rng), size(rng));
+    spheres[i].center = center;
+    spheres[i].radius = glm::length(extent);
+    aabbs[i] = utils::Aabb(center - extent, center + extent);
+    sphere_arrays.Set(i, spheres[i]);
+    aabb_arrays.Set(i, aabbs[i]);
+  }
+
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 150.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 4.9f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f));
+  utils::Frustum frustum = utils::Frustum::FromMatrix(projection * view);
+
+  std::cout << "best kernel: " << utils::CullKernelName(utils::BestCullKernel()) << std::endl;
+
+  // glm标量基准：AoS数据逐个调用Frustum::Intersects，同时作为期望结果
+  auto cull_spheres_glm = [&](std::vector<uint32_t>* result) {
+    result->clear();
+    for (size_t i = 0; i < kObjectCount; i++) {
+      if (frustum.Intersects(spheres[i])) {
+        result->push_back(static_cast<uint32_t>(i));
+      }
+    }
+  };
+  auto cull_aabbs_glm = [&](std::vector<uint32_t>* result) {
+    result->clear();
+    for (size_t i = 0; i < kObjectCount; i++) {
+      if (frustum.Intersects(aabbs[i])) {
+        result->push_back(static_cast<uint32_t>(i));
+      }
+    }
+  };
+
+  std::vector<uint32_t> expected_spheres;
+  std::vector<uint32_t> expected_aabbs;
+  expected_spheres.reserve(kObjectCount);
+  expected_aabbs.reserve(kObjectCount);
+  cull_spheres_glm(&expected_spheres);
+  cull_aabbs_glm(&expected_aabbs);
+  std::cout << expected_spheres.size() << " spheres, " << expected_aabbs.size() << " aabbs visible" << std::endl;
+
+  bool ok = true;
+  bench::Runner runner;
+  runner.Add("FrustumCull/Spheres/glm", [&](bench::State& state) {
+    std::vector<uint32_t> visible;
+    visible.reserve(kObjectCount);
+    while (state.KeepRunning()) {
+      cull_spheres_glm(&visible);
+      bench::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+  runner.Add("FrustumCull/Aabbs/glm", [&](bench::State& state) {
+    std::vector<uint32_t> visible;
+    visible.reserve(kObjectCount);
+    while (state.KeepRunning()) {
+      cull_aabbs_glm(&visible);
+      bench::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+  });
+
+  std::vector<uint32_t> visible(kObjectCount);
+  for (utils::CullKernel kernel : {utils::CullKernel::kScalar, utils::CullKernel::kSse, utils::CullKernel::kAvx2}) {
+    if (kernel == utils::CullKernel::kAvx2 && utils::BestCullKernel() != utils::CullKernel::kAvx2) {
+      continue;
+    }
+
+    std::string name = utils::CullKernelName(kernel);
+    size_t count = utils::CullSpheres(frustum, sphere_arrays, visible.data(), kernel);
+    if (!SameResult(expected_spheres, visible, count)) {
+      std::cout << name << " spheres mismatch" << std::endl;
+      ok = false;
+    }
+    count = utils::CullAabbs(frustum, aabb_arrays, visible.data(), kernel);
+    if (!SameResult(expected_aabbs, visible, count)) {
+      std::cout << name << " aabbs mismatch" << std::endl;
+      ok = false;
+    }
+
+    runner.Add("FrustumCull/Spheres/" + name, [&, kernel](bench::State& state) {
+      std::vector<uint32_t> output(kObjectCount);
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(utils::CullSpheres(frustum, sphere_arrays, output.data(), kernel));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+    });
+    runner.Add("FrustumCull/Aabbs/" + name, [&, kernel](bench::State& state) {
+      std::vector<uint32_t> output(kObjectCount);
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(utils::CullAabbs(frustum, aabb_arrays, output.data(), kernel));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kObjectCount));
+    });
+  }
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
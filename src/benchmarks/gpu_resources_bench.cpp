@@ -0,0 +1,153 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/bench_harness.h"
+#include "utils/gl_context.h"
+#include "utils/gpu_resources.h"
+
+// 用法：gpu_resources_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 计时句柄查找和直接读GLuint的差别；延迟销毁、槽位复用和Release的检查失败时返回1。
+
+static constexpr int kTextures = 4096;
+static constexpr int kLookups = 4 * 1024 * 1024;
+
+// 按随机顺序查找，和绘制时按材质取纹理的访问方式相近
+static std::vector<uint32_t> LookupOrder(size_t count) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<size_t> dist(0, count - 1);
+  std::vector<uint32_t> order(kLookups);
+  for (uint32_t& index : order) {
+    index = static_cast<uint32_t>(dist(rng));
+  }
+  return order;
+}
+
+static uint64_t SumRaw(const std::vector<GLuint>& names, const std::vector<uint32_t>& order) {
+  uint64_t sum = 0;
+  for (uint32_t index : order) {
+    sum += names[index];
+  }
+  return sum;
+}
+
+static uint64_t SumHandles(const utils::GpuResources& resources, const std::vector<utils::TextureHandle>& handles,
+                           const std::vector<uint32_t>& order) {
+  uint64_t sum = 0;
+  for (uint32_t index : order) {
+    sum += resources.Get(handles[index]);
+  }
+  return sum;
+}
+
+static bool RunChecks(utils::GpuResources* resources, std::vector<utils::TextureHandle>* handles) {
+  bool ok = true;
+  size_t half = handles->size() / 2;
+
+  // 在其它线程登记销毁，句柄到EndFrame才失效
+  std::thread destroyer([&]() {
+    for (size_t i = 0; i < half; i++) {
+      resources->Destroy((*handles)[i]);
+    }
+  });
+  destroyer.join();
+  if (resources->Get((*handles)[0]) == 0) {
+    std::cout << "handle invalidated before EndFrame" << std::endl;
+    ok = false;
+  }
+  resources->EndFrame();
+  if (resources->Get((*handles)[0]) != 0 || resources->Get((*handles)[half]) == 0) {
+    std::cout << "wrong handles invalidated after EndFrame" << std::endl;
+    ok = false;
+  }
+  utils::GpuResourceStats stats = resources->stats();
+  if (stats.pending_deletes != half || stats.deleted != 0) {
+    std::cout << "objects deleted before the safe frame" << std::endl;
+    ok = false;
+  }
+  for (uint64_t i = 0; i < utils::GpuResources::kDeleteDelayFrames; i++) {
+    resources->EndFrame();
+  }
+  stats = resources->stats();
+  if (stats.pending_deletes != 0 || stats.deleted != half) {
+    std::cout << "deferred deletes not flushed: " << stats.pending_deletes << " pending" << std::endl;
+    ok = false;
+  }
+
+  // 复用的槽位代数不同，旧句柄查不到新对象
+  utils::TextureHandle reused = resources->CreateTexture("reused");
+  bool slot_reused = false;
+  for (size_t i = 0; i < half; i++) {
+    if ((*handles)[i].index == reused.index) {
+      slot_reused = true;
+      ok = ok && resources->Get((*handles)[i]) == 0 && resources->Get(reused) != 0;
+    }
+  }
+  if (!slot_reused) {
+    std::cout << "freed slot was not reused" << std::endl;
+    ok = false;
+  }
+  handles->push_back(reused);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.mode = utils::ContextMode::kHeadless;
+  options.width = 64;
+  options.height = 64;
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return 1;
+  }
+
+  bool ok = true;
+  int result = 0;
+  {
+    utils::GpuResources resources;
+    std::vector<utils::TextureHandle> handles;
+    std::vector<GLuint> names;
+    for (int i = 0; i < kTextures; i++) {
+      handles.push_back(resources.CreateTexture("texture " + std::to_string(i)));
+      names.push_back(resources.Get(handles.back()));
+    }
+    std::vector<uint32_t> order = LookupOrder(handles.size());
+    if (SumRaw(names, order) != SumHandles(resources, handles, order)) {
+      std::cout << "handle lookups resolved to different names" << std::endl;
+      ok = false;
+    }
+
+    // 计时在销毁检查之前，此时所有句柄都有效
+    bench::Runner runner;
+    runner.Add("GpuResources/Lookup/GLuint", [&](bench::State& state) {
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(SumRaw(names, order));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLookups));
+    });
+    runner.Add("GpuResources/Lookup/TextureHandle", [&](bench::State& state) {
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(SumHandles(resources, handles, order));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLookups));
+    });
+    result = runner.Run(argc, argv);
+
+    ok = RunChecks(&resources, &handles) && ok;
+
+    // 剩下的对象没有销毁，Release时逐个报告
+    size_t live = resources.stats().live[static_cast<size_t>(utils::GpuResourceType::kTexture)];
+    std::cout << "releasing with " << live << " live textures (reported as leaks)" << std::endl;
+    resources.Release();
+    if (resources.stats().live[static_cast<size_t>(utils::GpuResourceType::kTexture)] != 0 ||
+        resources.Get(handles.back()) != 0) {
+      std::cout << "Release left live objects" << std::endl;
+      ok = false;
+    }
+  }
+
+  std::cout << (ok ? "all handle checks passed" : "MISMATCH") << std::endl;
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/bench_harness.h"
+#include "utils/job_system.h"
+
+// 用法：job_system_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 每种线程数先检查结果和依赖顺序，出错时返回1；再计时均匀负载、不均匀负载的两种切分和大量小任务。
+
+static constexpr size_t kUniformCount = 1 << 20;
+static constexpr int kUniformWork = 16;
+static constexpr size_t kSkewedCount = 1 << 14;
+// 第i个元素的工作量约为i / kSkewDivisor，后半段远比前半段重
+static constexpr size_t kSkewDivisor = 64;
+static constexpr int kSpawners = 100;
+static constexpr int kJobsPerSpawner = 1000;
+static constexpr int kChainLength = 1000;
+
+static uint32_t Work(uint32_t value, size_t iterations) {
+  for (size_t i = 0; i < iterations; i++) {
+    value = value * 1664525u + 1013904223u;
+    value ^= value >> 16;
+  }
+  return value;
+}
+
+// 每个下标恰好处理一次，结果和串行一致
+static bool CheckRange(const char* name, const std::vector<uint32_t>& actual, const std::vector<uint32_t>& expected,
+                       const std::vector<uint8_t>& visits) {
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (visits[i] != 1 || actual[i] != expected[i]) {
+      std::cout << name << ": index " << i << " visited " << static_cast<int>(visits[i]) << " times" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// 计时和检查共用的负载，visits记录每个下标被处理的次数
+struct RangeBuffers {
+  std::vector<uint32_t> output;
+  std::vector<uint8_t> visits;
+
+  explicit RangeBuffers(size_t count) : output(count), visits(count) {}
+};
+
+static void RunUniform(utils::JobSystem* jobs, RangeBuffers* buffers) {
+  std::fill(buffers->visits.begin(), buffers->visits.end(), 0);
+  jobs->ParallelFor(kUniformCount, 1024, [buffers](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      buffers->output[i] = Work(static_cast<uint32_t>(i), kUniformWork);
+      buffers->visits[i]++;
+    }
+  });
+}
+
+// 负载不均：fixed为true时静态划分每线程一块，否则自适应切分
+static void RunSkewed(utils::JobSystem* jobs, bool fixed, RangeBuffers* buffers) {
+  std::fill(buffers->visits.begin(), buffers->visits.end(), 0);
+  auto skewed = [buffers](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      buffers->output[i] = Work(static_cast<uint32_t>(i), i / kSkewDivisor);
+      buffers->visits[i]++;
+    }
+  };
+  if (fixed) {
+    size_t threads = jobs->thread_count();
+    jobs->ParallelForFixed(kSkewedCount, (kSkewedCount + threads - 1) / threads, skewed);
+  } else {
+    jobs->ParallelFor(kSkewedCount, 16, skewed);
+  }
+}
+
+// 大量小任务：每个生成任务再提交kJobsPerSpawner个子任务到同一个计数，返回所有值的和
+static uint64_t RunTinyJobs(utils::JobSystem* jobs) {
+  std::atomic<uint64_t> sum{ 0 };
+  utils::JobCounter counter;
+  for (int s = 0; s < kSpawners; s++) {
+    jobs->Run(
+        [jobs, &sum, &counter, s] {
+          for (int j = 0; j < kJobsPerSpawner; j++) {
+            uint64_t value = static_cast<uint64_t>(s) * kJobsPerSpawner + j;
+            jobs->Run([&sum, value] { sum.fetch_add(value, std::memory_order_relaxed); }, &counter);
+          }
+        },
+        &counter);
+  }
+  jobs->Wait(&counter);
+  return sum.load();
+}
+
+static bool CheckJobs(utils::JobSystem* jobs, utils::JobSystemStats* adaptive_stats) {
+  bool ok = true;
+
+  std::vector<uint32_t> expected(kUniformCount);
+  for (size_t i = 0; i < kUniformCount; i++) {
+    expected[i] = Work(static_cast<uint32_t>(i), kUniformWork);
+  }
+  RangeBuffers uniform(kUniformCount);
+  RunUniform(jobs, &uniform);
+  ok &= CheckRange("uniform", uniform.output, expected, uniform.visits);
+
+  expected.resize(kSkewedCount);
+  for (size_t i = 0; i < kSkewedCount; i++) {
+    expected[i] = Work(static_cast<uint32_t>(i), i / kSkewDivisor);
+  }
+  RangeBuffers skewed(kSkewedCount);
+  RunSkewed(jobs, true, &skewed);
+  ok &= CheckRange("static", skewed.output, expected, skewed.visits);
+  jobs->ResetStats();
+  RunSkewed(jobs, false, &skewed);
+  *adaptive_stats = jobs->stats();
+  ok &= CheckRange("adaptive", skewed.output, expected, skewed.visits);
+
+  uint64_t total = static_cast<uint64_t>(kSpawners) * kJobsPerSpawner;
+  uint64_t sum = RunTinyJobs(jobs);
+  if (sum != total * (total - 1) / 2) {
+    std::cout << "tiny jobs: sum " << sum << std::endl;
+    ok = false;
+  }
+
+  // 依赖链：第i个任务等第i-1个完成，执行顺序必须严格递增
+  std::unique_ptr<utils::JobCounter[]> chain(new utils::JobCounter[kChainLength]);
+  std::atomic<int> next{ 0 };
+  std::atomic<int> order_errors{ 0 };
+  for (int i = 0; i < kChainLength; i++) {
+    jobs->Run(
+        [&next, &order_errors, i] {
+          if (next.fetch_add(1) != i) {
+            order_errors.fetch_add(1);
+          }
+        },
+        &chain[i], i > 0 ? &chain[i - 1] : nullptr);
+  }
+  jobs->Wait(&chain[kChainLength - 1]);
+  if (order_errors.load() != 0 || next.load() != kChainLength) {
+    std::cout << "dependency chain: " << order_errors.load() << " jobs ran out of order" << std::endl;
+    ok = false;
+  }
+
+  // 扇出再汇合：B组等A组全部完成，C等B组
+  constexpr int kFanOut = 64;
+  std::atomic<int> a_done{ 0 };
+  std::atomic<int> b_done{ 0 };
+  std::atomic<int> early{ 0 };
+  utils::JobCounter a;
+  utils::JobCounter b;
+  utils::JobCounter c;
+  for (int i = 0; i < kFanOut; i++) {
+    jobs->Run([&a_done] { a_done.fetch_add(1); }, &a);
+  }
+  for (int i = 0; i < kFanOut; i++) {
+    jobs->Run(
+        [&] {
+          early.fetch_add(a_done.load() != kFanOut ? 1 : 0);
+          b_done.fetch_add(1);
+        },
+        &b, &a);
+  }
+  jobs->Run([&] { early.fetch_add(b_done.load() != kFanOut ? 1 : 0); }, &c, &b);
+  jobs->Wait(&c);
+  if (early.load() != 0) {
+    std::cout << "fan-in: " << early.load() << " jobs started before their dependency" << std::endl;
+    ok = false;
+  }
+
+  // 任务内部嵌套ParallelFor
+  constexpr size_t kOuter = 64;
+  constexpr size_t kInner = 4096;
+  std::vector<uint64_t> nested(kOuter);
+  jobs->ParallelFor(kOuter, 1, [&](size_t begin, size_t end) {
+    for (size_t o = begin; o < end; o++) {
+      std::atomic<uint64_t> inner_sum{ 0 };
+      jobs->ParallelFor(kInner, 256, [&](size_t inner_begin, size_t inner_end) {
+        uint64_t local = 0;
+        for (size_t i = inner_begin; i < inner_end; i++) {
+          local += o * kInner + i;
+        }
+        inner_sum.fetch_add(local, std::memory_order_relaxed);
+      });
+      nested[o] = inner_sum.load();
+    }
+  });
+  for (size_t o = 0; o < kOuter; o++) {
+    uint64_t first = o * kInner;
+    if (nested[o] != first * kInner + kInner * (kInner - 1) / 2) {
+      std::cout << "nested parallel for: wrong sum for item " << o << std::endl;
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+static void PrintStats(const utils::JobSystemStats& stats) {
+  std::cout << "  worker   executed   steal attempts   steals   success   conflicts   sleeps" << std::endl;
+  for (size_t i = 0; i < stats.workers.size(); i++) {
+    const utils::JobWorkerStats& worker = stats.workers[i];
+    double rate = worker.steal_attempts > 0 ? 100.0 * static_cast<double>(worker.steals) / worker.steal_attempts : 0.0;
+    std::cout << "  " << std::setw(6) << i << std::setw(11) << worker.executed << std::setw(17) << worker.steal_attempts
+              << std::setw(9) << worker.steals << std::setw(9) << std::fixed << std::setprecision(1) << rate << "%"
+              << std::setw(12) << worker.steal_conflicts << std::setw(9) << worker.sleeps << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> thread_counts = { 1, 2, 4, hardware };
+  std::sort(thread_counts.begin(), thread_counts.end());
+  thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+  std::cout << "hardware threads: " << hardware << std::endl;
+
+  bool ok = true;
+  bench::Runner runner;
+  // 构造JobSystem会让当前线程成为它的0号工作线程，而线程只能属于一个系统，
+  // 所以每个系统只在自己的检查和用例里存在，不能同时创建好几个，否则主线程只属于最后一个
+  for (unsigned threads : thread_counts) {
+    {
+      utils::JobSystem jobs(threads);
+      utils::JobSystemStats adaptive_stats;
+      ok &= CheckJobs(&jobs, &adaptive_stats);
+      if (jobs.thread_count() > 1) {
+        std::cout << "skewed adaptive, " << jobs.thread_count() << " threads:" << std::endl;
+        PrintStats(adaptive_stats);
+      }
+    }
+
+    const std::string suffix = "/threads:" + std::to_string(threads);
+    runner.Add("JobSystem/Uniform/ParallelFor" + suffix, [threads](bench::State& state) {
+      utils::JobSystem jobs(threads);
+      RangeBuffers buffers(kUniformCount);
+      while (state.KeepRunning()) {
+        RunUniform(&jobs, &buffers);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kUniformCount));
+    });
+    runner.Add("JobSystem/Skewed/ParallelForFixed" + suffix, [threads](bench::State& state) {
+      utils::JobSystem jobs(threads);
+      RangeBuffers buffers(kSkewedCount);
+      while (state.KeepRunning()) {
+        RunSkewed(&jobs, true, &buffers);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kSkewedCount));
+    });
+    runner.Add("JobSystem/Skewed/ParallelFor" + suffix, [threads](bench::State& state) {
+      utils::JobSystem jobs(threads);
+      RangeBuffers buffers(kSkewedCount);
+      while (state.KeepRunning()) {
+        RunSkewed(&jobs, false, &buffers);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kSkewedCount));
+    });
+    runner.Add("JobSystem/TinyJobs" + suffix, [threads](bench::State& state) {
+      utils::JobSystem jobs(threads);
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(RunTinyJobs(&jobs));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kSpawners * kJobsPerSpawner));
+    });
+  }
+  std::cout << (ok ? "all job system checks passed" : "FAILED") << std::endl;
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/light_clusters.h"
+#include "utils/thread_pool.h"
+
+// 用法：light_cluster_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查各实现的分配结果与暴力分配一致，不一致时返回1；再计时每次Assign。
+
+static constexpr size_t kLightCount = 10000;
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> range(1.0f, 6.0f);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> cone(0.5f, 0.95f);
+
+  std::vector<utils::Light> lights(kLightCount);
+  for (size_t i = 0; i < kLightCount; i++) {
+    utils::Light& light = lights[i];
+    light.position = glm::vec3(position(rng), position(rng) * 0.1f + 5.0f, position(rng));
+    light.range = range(rng);
+    if (i % 4 == 0) {
+      light.type = utils::LightType::kSpot;
+      light.direction = glm::normalize(glm::vec3(unit(rng), unit(rng) - 1.5f, unit(rng)));
+      light.cos_outer = cone(rng);
+      light.cos_inner = std::min(light.cos_outer + 0.05f, 1.0f);
+    }
+  }
+
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 9.5f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f));
+  utils::LightClusterer clusterer;
+  clusterer.SetProjection(45.0f, 1920.0f / 1080.0f, 0.1f, 200.0f);
+  clusterer.Assign(view, lights);
+
+  std::vector<uint32_t> expected_clusters;
+  std::vector<uint32_t> expected_indices;
+  AssignLightsBruteForce(clusterer, &expected_clusters, &expected_indices);
+  std::cout << "best kernel: " << utils::CullKernelName(utils::BestCullKernel()) << ", " << expected_indices.size()
+            << " indices" << std::endl;
+
+  bool ok = true;
+  utils::ThreadPool pool;
+  bench::Runner runner;
+  runner.Add("LightClusters/BruteForce", [&](bench::State& state) {
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> indices;
+    while (state.KeepRunning()) {
+      AssignLightsBruteForce(clusterer, &clusters, &indices);
+      bench::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLightCount));
+  });
+
+  for (utils::CullKernel kernel : {utils::CullKernel::kScalar, utils::CullKernel::kSse, utils::CullKernel::kAvx2}) {
+    if (kernel == utils::CullKernel::kAvx2 && utils::BestCullKernel() != utils::CullKernel::kAvx2) {
+      continue;
+    }
+    for (utils::ThreadPool* assign_pool : {static_cast<utils::ThreadPool*>(nullptr), &pool}) {
+      std::string name = std::string("LightClusters/Assign/") + utils::CullKernelName(kernel) +
+                         (assign_pool != nullptr ? "/pool:" + std::to_string(pool.thread_count()) : "/serial");
+      clusterer.set_kernel(kernel);
+      clusterer.Assign(view, lights, assign_pool);
+      if (clusterer.clusters() != expected_clusters || clusterer.light_indices() != expected_indices) {
+        std::cout << name << " mismatch" << std::endl;
+        ok = false;
+      }
+
+      runner.Add(name, [&, kernel, assign_pool](bench::State& state) {
+        clusterer.set_kernel(kernel);
+        while (state.KeepRunning()) {
+          clusterer.Assign(view, lights, assign_pool);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLightCount));
+      });
+    }
+  }
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
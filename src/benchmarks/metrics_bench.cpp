@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/bench_harness.h"
+#include "utils/allocation_counter.h"
+#include "utils/metrics.h"
+
+// 用法：metrics_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查注册、计数、直方图、EndFrame不分配内存和导出，出错时返回1；再计时多线程计数和EndFrame。
+
+static constexpr uint64_t kAddsPerThread = 1 << 20;
+static constexpr int kEndFrames = 1000;
+
+// threads个线程各加kAddsPerThread次。state不为空时线程创建的时间不计入
+template <typename Func>
+static void RunAdds(unsigned threads, Func&& add, bench::State* state = nullptr) {
+  if (state != nullptr) {
+    state->PauseTiming();
+  }
+  std::vector<std::thread> workers;
+  std::atomic<unsigned> ready{ 0 };
+  std::atomic<bool> go{ false };
+  for (unsigned t = 0; t < threads; t++) {
+    workers.emplace_back([&] {
+      ready.fetch_add(1);
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (uint64_t i = 0; i < kAddsPerThread; i++) {
+        add();
+      }
+    });
+  }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+  if (state != nullptr) {
+    state->ResumeTiming();
+  }
+  go.store(true);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+static const utils::MetricSample* FindSample(const utils::MetricsRegistry& registry, const std::string& name) {
+  for (size_t i = 0; i < registry.metric_count(); i++) {
+    if (registry.metric(i).name == name) {
+      return &registry.metric(i);
+    }
+  }
+  return nullptr;
+}
+
+static std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+static bool Check(bool condition, const char* what) {
+  if (!condition) {
+    std::cout << "check failed: " << what << std::endl;
+  }
+  return condition;
+}
+
+int main(int argc, char** argv) {
+  if (!utils::AllocationCountingEnabled()) {
+    std::cout << "built without count_allocations.cpp, heap allocations cannot be counted" << std::endl;
+    return 1;
+  }
+  utils::MetricsRegistry& registry = utils::MetricsRegistry::Instance();
+  bool ok = true;
+
+  // 注册：重复注册返回同一个指标，名字非法或类型冲突时返回无效指标
+  utils::Counter counter = registry.RegisterCounter("bench_adds_total", "Counter::Add calls from the benchmark");
+  utils::Counter same = registry.RegisterCounter("bench_adds_total", "");
+  utils::Gauge gauge = registry.RegisterGauge("bench_live_objects", "Gauge set by the benchmark");
+  utils::Histogram histogram =
+      registry.RegisterHistogram("bench_latency_ms", "Observed latencies", { 1.0, 10.0, 100.0 });
+  ok &= Check(counter.valid() && same.valid() && gauge.valid() && histogram.valid(), "registration");
+  ok &= Check(!registry.RegisterGauge("bench_adds_total", "").valid(), "type conflict is rejected");
+  ok &= Check(!registry.RegisterCounter("1bad-name", "").valid(), "invalid name is rejected");
+  ok &= Check(!registry.RegisterHistogram("bench_unsorted", "", { 2.0, 1.0 }).valid(), "unsorted bounds are rejected");
+  registry.EndFrame();
+
+  unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> thread_counts = { 1, 2, 4, hardware };
+  std::sort(thread_counts.begin(), thread_counts.end());
+  thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+  uint64_t expected = 0;
+  for (unsigned threads : thread_counts) {
+    RunAdds(threads, [&counter] { counter.Add(); });
+    std::atomic<uint64_t> shared{ 0 };
+    RunAdds(threads, [&shared] { shared.fetch_add(1, std::memory_order_relaxed); });
+
+    // 退出的线程的计数仍然保留
+    uint64_t added = static_cast<uint64_t>(threads) * kAddsPerThread;
+    expected += added;
+    registry.EndFrame();
+    const utils::MetricSample* sample = FindSample(registry, "bench_adds_total");
+    ok &= Check(sample != nullptr && sample->value == static_cast<double>(expected), "counter total");
+    ok &= Check(sample != nullptr && sample->frame_value == static_cast<double>(added), "counter frame delta");
+    ok &= Check(shared.load() == added, "shared atomic total");
+  }
+
+  // 直方图：桶为累积计数，最后一个为+Inf
+  gauge.Set(40);
+  gauge.Add(2);
+  const double observations[] = { 0.5, 1.0, 3.0, 50.0, 500.0, 2000.0 };
+  double observed_sum = 0.0;
+  for (double value : observations) {
+    histogram.Observe(value);
+    observed_sum += value;
+  }
+  registry.EndFrame();
+  const utils::MetricSample* latency = FindSample(registry, "bench_latency_ms");
+  ok &= Check(latency != nullptr && latency->cumulative == std::vector<uint64_t>({ 2, 3, 4, 6 }), "histogram buckets");
+  ok &= Check(latency != nullptr && std::abs(latency->sum - observed_sum) < 1e-9, "histogram sum");
+  ok &= Check(latency != nullptr && latency->frame_value == 6.0, "histogram frame delta");
+  const utils::MetricSample* live = FindSample(registry, "bench_live_objects");
+  ok &= Check(live != nullptr && live->value == 42.0, "gauge value");
+
+  // 稳定状态下EndFrame不分配内存
+  uint64_t allocations = utils::AllocationCount();
+  for (int frame = 0; frame < kEndFrames; frame++) {
+    counter.Add(static_cast<uint64_t>(frame));
+    registry.EndFrame();
+  }
+  uint64_t end_frame_allocations = utils::AllocationCount() - allocations;
+  ok &= Check(end_frame_allocations == 0, "EndFrame does not allocate");
+  std::cout << registry.metric_count() << " metrics, " << end_frame_allocations << " allocations in " << kEndFrames
+            << " frames" << std::endl;
+
+  // 导出
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+  std::filesystem::path prometheus_path = directory / "metrics_bench.prom";
+  std::filesystem::path json_path = directory / "metrics_bench.json";
+  ok &= Check(utils::WriteMetricsPrometheus(registry, prometheus_path.string()), "write Prometheus text");
+  ok &= Check(utils::WriteMetricsJson(registry, json_path.string()), "write JSON");
+  std::string prometheus = ReadFile(prometheus_path);
+  std::string json = ReadFile(json_path);
+  ok &= Check(prometheus.find("# TYPE bench_adds_total counter\n") != std::string::npos, "Prometheus TYPE line");
+  ok &= Check(prometheus.find("bench_latency_ms_bucket{le=\"10\"} 3\n") != std::string::npos, "Prometheus bucket");
+  ok &= Check(prometheus.find("bench_latency_ms_bucket{le=\"+Inf\"} 6\n") != std::string::npos, "Prometheus +Inf");
+  ok &= Check(prometheus.find("bench_live_objects 42\n") != std::string::npos, "Prometheus gauge");
+  ok &= Check(json.find("\"name\": \"bench_adds_total\", \"type\": \"counter\"") != std::string::npos, "JSON metric");
+  ok &= Check(!std::filesystem::exists(prometheus_path.string() + ".tmp"), "temporary file is renamed");
+  std::cout << "exported to " << prometheus_path.string() << " and " << json_path.string() << std::endl;
+
+  std::cout << (ok ? "all metrics checks passed" : "FAILED") << std::endl;
+
+  // 每次迭代为每个线程加kAddsPerThread次，items为总加法次数
+  bench::Runner runner;
+  for (unsigned threads : thread_counts) {
+    const std::string suffix = "/threads:" + std::to_string(threads);
+    runner.Add("Metrics/Counter::Add" + suffix, [&counter, threads](bench::State& state) {
+      while (state.KeepRunning()) {
+        RunAdds(threads, [&counter] { counter.Add(); }, &state);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * threads * kAddsPerThread));
+    });
+    runner.Add("Metrics/SharedFetchAdd" + suffix, [threads](bench::State& state) {
+      std::atomic<uint64_t> shared{ 0 };
+      while (state.KeepRunning()) {
+        RunAdds(threads, [&shared] { shared.fetch_add(1, std::memory_order_relaxed); }, &state);
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * threads * kAddsPerThread));
+    });
+  }
+  runner.Add("Metrics/EndFrame", [&registry, &counter](bench::State& state) {
+    while (state.KeepRunning()) {
+      counter.Add();
+      registry.EndFrame();
+    }
+  });
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
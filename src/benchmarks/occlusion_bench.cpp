@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/frustum_cull.h"
+#include "utils/occlusion_culler.h"
+
+// 用法：occlusion_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先用每种配置剔除一帧，检查Hi-Z比逐像素比较保守、误剔除足够少，出错时返回1；再计时每帧的光栅化和测试。
+
+static constexpr size_t kObjectCount = 200000;
+
+// 每个面细分为subdivisions x subdivisions的单位立方体，逆时针为外侧
+static utils::OccluderMesh MakeBox(int subdivisions) {
+  utils::OccluderMesh mesh;
+  for (int axis = 0; axis < 3; axis++) {
+    for (int side = -1; side <= 1; side += 2) {
+      glm::vec3 normal(0.0f);
+      normal[axis] = static_cast<float>(side);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = 1.0f;
+      if (side < 0) {
+        std::swap(u, v);
+      }
+
+      uint32_t base = static_cast<uint32_t>(mesh.positions.size());
+      for (int j = 0; j <= subdivisions; j++) {
+        for (int i = 0; i <= subdivisions; i++) {
+          float s = static_cast<float>(i) / subdivisions * 2.0f - 1.0f;
+          float t = static_cast<float>(j) / subdivisions * 2.0f - 1.0f;
+          mesh.positions.push_back(normal + u * s + v * t);
+        }
+      }
+      for (int j = 0; j < subdivisions; j++) {
+        for (int i = 0; i < subdivisions; i++) {
+          uint32_t a = base + j * (subdivisions + 1) + i;
+          uint32_t b = a + 1;
+          uint32_t c = a + subdivisions + 1;
+          uint32_t d = c + 1;
+          mesh.indices.insert(mesh.indices.end(), {a, b, d, a, d, c});
+        }
+      }
+    }
+  }
+  return mesh;
+}
+
+// 用解析射线检查被剔除的物体：采样点中只要有一个能直接看到就算误剔除
+static bool SampleVisible(const glm::vec3& eye, const glm::vec3& point, const std::vector<utils::Aabb>& buildings,
+                          const utils::Frustum& frustum) {
+  utils::Sphere sphere;
+  sphere.center = point;
+  if (!frustum.Intersects(sphere)) {
+    return false;
+  }
+  utils::Ray ray;
+  ray.origin = eye;
+  ray.direction = point - eye;
+  float distance = glm::length(ray.direction);
+  ray.direction /= distance;
+  glm::vec3 inv_direction = 1.0f / ray.direction;
+  for (const utils::Aabb& building : buildings) {
+    float t = 0.0f;
+    if (utils::IntersectRayAabb(ray, inv_direction, building, distance, &t) && t < distance * 0.999f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 一帧的遮挡剔除：光栅化所有遮挡体后测试视锥内的物体，返回可见数量
+static size_t CullFrame(utils::OcclusionCuller* culler, const glm::mat4& view_projection,
+                        const utils::OccluderMesh& mesh, const std::vector<glm::mat4>& building_models,
+                        const std::vector<utils::Aabb>& objects, const std::vector<uint32_t>& in_frustum,
+                        size_t frustum_count, std::vector<uint32_t>* visible, utils::ThreadPool* pool) {
+  culler->BeginFrame(view_projection);
+  for (const glm::mat4& model : building_models) {
+    culler->AddOccluder(mesh, model);
+  }
+  culler->Rasterize(pool);
+  return culler->FilterVisible(objects.data(), in_frustum.data(), frustum_count, visible->data(), pool);
+}
+
+// 比较逐像素深度和解析射线，返回Hi-Z比逐像素比较更激进的次数和误剔除的数量
+static void CheckCulled(const utils::OcclusionCuller& culler, const glm::mat4& view_projection, const glm::vec3& eye,
+                        const utils::Frustum& frustum, const std::vector<utils::Aabb>& buildings,
+                        const std::vector<utils::Aabb>& objects, const std::vector<uint32_t>& in_frustum,
+                        size_t frustum_count, const std::vector<uint32_t>& visible, size_t visible_count,
+                        size_t* hierarchy_errors_out, size_t* false_culls_out) {
+  const std::vector<float>& depth = culler.depth(0);
+  size_t hierarchy_errors = 0;
+  size_t false_culls = 0;
+  std::vector<bool> is_visible(kObjectCount, false);
+  for (size_t i = 0; i < visible_count; i++) {
+    is_visible[visible[i]] = true;
+  }
+  for (size_t i = 0; i < frustum_count; i++) {
+    uint32_t object = in_frustum[i];
+    if (is_visible[object]) {
+      continue;
+    }
+
+    const utils::Aabb& bounds = objects[object];
+    float min_x = FLT_MAX;
+    float min_y = FLT_MAX;
+    float max_x = -FLT_MAX;
+    float max_y = -FLT_MAX;
+    float min_z = FLT_MAX;
+    for (int c = 0; c < 8; c++) {
+      glm::vec3 corner((c & 1) ? bounds.max.x : bounds.min.x, (c & 2) ? bounds.max.y : bounds.min.y,
+                       (c & 4) ? bounds.max.z : bounds.min.z);
+      glm::vec4 clip = view_projection * glm::vec4(corner, 1.0f);
+      min_x = std::min(min_x, clip.x / clip.w);
+      max_x = std::max(max_x, clip.x / clip.w);
+      min_y = std::min(min_y, clip.y / clip.w);
+      max_y = std::max(max_y, clip.y / clip.w);
+      min_z = std::min(min_z, clip.z / clip.w);
+    }
+    int x0 = std::max(0, static_cast<int>(std::floor((min_x * 0.5f + 0.5f) * culler.width())));
+    int x1 = std::min(culler.width() - 1, static_cast<int>(std::floor((max_x * 0.5f + 0.5f) * culler.width())));
+    int y0 = std::max(0, static_cast<int>(std::floor((min_y * 0.5f + 0.5f) * culler.height())));
+    int y1 = std::min(culler.height() - 1, static_cast<int>(std::floor((max_y * 0.5f + 0.5f) * culler.height())));
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        if (min_z * 0.5f + 0.5f <= depth[y * culler.width() + x]) {
+          hierarchy_errors++;
+        }
+      }
+    }
+
+    glm::vec3 center = bounds.center();
+    bool sample_visible = SampleVisible(eye, center, buildings, frustum);
+    for (int c = 0; c < 8 && !sample_visible; c++) {
+      glm::vec3 corner((c & 1) ? bounds.max.x : bounds.min.x, (c & 2) ? bounds.max.y : bounds.min.y,
+                       (c & 4) ? bounds.max.z : bounds.min.z);
+      sample_visible = SampleVisible(eye, glm::mix(corner, center, 0.01f), buildings, frustum);
+    }
+    false_culls += sample_visible ? 1 : 0;
+  }
+
+  *hierarchy_errors_out = hierarchy_errors;
+  *false_culls_out = false_culls;
+}
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(5);
+
+  // 街区：建筑之间留出街道，相机在街道上
+  utils::OccluderMesh box = MakeBox(16);
+  utils::OccluderMesh box_lod = utils::SimplifyOccluder(box, 0.5f);
+  std::vector<glm::mat4> building_models;
+  std::vector<utils::Aabb> buildings;
+  std::uniform_real_distribution<float> height(6.0f, 30.0f);
+  for (int gx = -6; gx < 6; gx++) {
+    for (int gz = -6; gz < 6; gz++) {
+      glm::vec3 center(gx * 30.0f + 15.0f, 0.0f, gz * 30.0f + 15.0f);
+      glm::vec3 half(11.0f, height(rng), 11.0f);
+      building_models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), center), half));
+      buildings.push_back(utils::Aabb(center - half, center + half));
+    }
+  }
+
+  std::uniform_real_distribution<float> position(-180.0f, 180.0f);
+  std::uniform_real_distribution<float> size(0.2f, 1.5f);
+  std::vector<utils::Aabb> objects(kObjectCount);
+  utils::AabbArrays object_arrays;
+  object_arrays.Resize(kObjectCount);
+  for (size_t i = 0; i < kObjectCount; i++) {
+    glm::vec3 center(position(rng), 0.0f, position(rng));
+    glm::vec3 extent(size(rng));
+    center.y = extent.y;
+    objects[i] = utils::Aabb(center - extent, center + extent);
+    object_arrays.Set(i, objects[i]);
+  }
+
+  glm::vec3 eye(0.0f, 1.7f, 2.0f);
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+  glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(1.0f, -0.02f, 0.35f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 view_projection = projection * view;
+  utils::Frustum frustum = utils::Frustum::FromMatrix(view_projection);
+
+  std::vector<uint32_t> in_frustum(kObjectCount);
+  std::vector<uint32_t> visible(kObjectCount);
+  size_t frustum_count = utils::CullAabbs(frustum, object_arrays, in_frustum.data());
+
+  std::cout << "occluder triangles: " << box.triangle_count() * buildings.size() << " full, "
+            << box_lod.triangle_count() * buildings.size() << " lod" << std::endl;
+  std::cout << "objects: " << kObjectCount << ", in frustum: " << frustum_count << std::endl;
+
+  utils::ThreadPool pool;
+  utils::OcclusionCuller culler(320, 180);
+  bool ok = true;
+  bench::Runner runner;
+
+  struct Config {
+    std::string name;
+    const utils::OccluderMesh* mesh;
+    utils::ThreadPool* pool;
+  };
+  const std::string pool_suffix = "/pool:" + std::to_string(pool.thread_count());
+  const Config configs[] = {
+      {"Occlusion/FullMesh/serial", &box, nullptr},
+      {"Occlusion/FullMesh" + pool_suffix, &box, &pool},
+      {"Occlusion/Lod/serial", &box_lod, nullptr},
+      {"Occlusion/Lod" + pool_suffix, &box_lod, &pool},
+  };
+
+  for (const Config& config : configs) {
+    size_t visible_count = CullFrame(&culler, view_projection, *config.mesh, building_models, objects, in_frustum,
+                                     frustum_count, &visible, config.pool);
+    const utils::OcclusionStats& stats = culler.stats();
+    size_t occluded = frustum_count - visible_count;
+    std::cout << config.name << ": " << 100.0 * occluded / frustum_count << "% of frustum-visible culled (transform "
+              << stats.transform_ms << " ms, raster " << stats.raster_ms << " ms, test " << stats.test_ms << " ms), "
+              << stats.rasterized_triangles << " triangles rasterized" << std::endl;
+
+    size_t hierarchy_errors = 0;
+    size_t false_culls = 0;
+    CheckCulled(culler, view_projection, eye, frustum, buildings, objects, in_frustum, frustum_count, visible,
+                visible_count, &hierarchy_errors, &false_culls);
+    std::cout << "  hierarchy errors: " << hierarchy_errors << ", false culls (ray samples): " << false_culls
+              << std::endl;
+    // 低分辨率只在像素中心采样，轮廓边缘允许极少量误差
+    if (hierarchy_errors != 0 || false_culls * 1000 > occluded) {
+      ok = false;
+    }
+
+    runner.Add(config.name, [&, config](bench::State& state) {
+      std::vector<uint32_t> output(kObjectCount);
+      while (state.KeepRunning()) {
+        bench::DoNotOptimize(CullFrame(&culler, view_projection, *config.mesh, building_models, objects, in_frustum,
+                                       frustum_count, &output, config.pool));
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frustum_count));
+    });
+  }
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
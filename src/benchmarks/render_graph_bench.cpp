@@ -0,0 +1,224 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmarks/bench_harness.h"
+#include "utils/render_graph.h"
+
+// 用法：render_graph_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先对kGraphs个随机图检查剔除、顺序和别名的正确性，出错时返回1；再计时构建和编译。
+
+static constexpr int kGraphs = 200;
+static constexpr int kPasses = 64;
+static constexpr int kTextures = 24;
+
+// 随机生成的图，同时记录每个版本的写入者，用于独立计算期望的剔除结果和顺序约束
+struct RandomGraph {
+  std::vector<std::vector<int>> writers;
+  std::vector<std::vector<utils::RenderGraphTexture>> reads;
+  std::vector<std::vector<utils::RenderGraphTexture>> writes;
+  std::vector<bool> imported;
+  std::vector<bool> side_effect;
+};
+
+static RandomGraph BuildGraph(std::mt19937* rng, utils::RenderGraph* graph) {
+  const utils::RenderGraphTextureDesc descs[] = {
+    {1920, 1080, GL_RGBA16F},
+    {1920, 1080, GL_DEPTH24_STENCIL8},
+    {960, 540, GL_RGBA8},
+    {2048, 2048, GL_DEPTH_COMPONENT32F},
+  };
+  std::uniform_int_distribution<int> texture_dist(0, kTextures - 1);
+  std::uniform_int_distribution<int> desc_dist(0, 3);
+  std::uniform_int_distribution<int> count_dist(0, 3);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  RandomGraph random;
+  graph->Reset();
+  std::vector<utils::RenderGraphTexture> latest;
+  for (int i = 0; i < kTextures; i++) {
+    bool imported = i == 0 || unit(*rng) < 0.05f;
+    const utils::RenderGraphTextureDesc& desc = descs[desc_dist(*rng)];
+    std::string name = "t" + std::to_string(i);
+    latest.push_back(imported ? graph->ImportTexture(name, desc, 0) : graph->CreateTexture(name, desc));
+    random.writers.push_back({-1});
+    random.imported.push_back(imported);
+  }
+  for (int pass = 0; pass < kPasses; pass++) {
+    graph->AddPass("p" + std::to_string(pass), nullptr);
+    random.reads.emplace_back();
+    random.writes.emplace_back();
+    random.side_effect.push_back(unit(*rng) < 0.03f);
+    if (random.side_effect.back()) {
+      graph->SetSideEffect(pass);
+    }
+    for (int i = count_dist(*rng); i > 0; i--) {
+      utils::RenderGraphTexture texture = latest[texture_dist(*rng)];
+      graph->Read(pass, texture);
+      random.reads.back().push_back(texture);
+    }
+    for (int i = count_dist(*rng) / 2 + 1; i > 0; i--) {
+      int index = texture_dist(*rng);
+      // 同一个pass对同一纹理只写一次
+      if (random.writers[index].back() == pass) {
+        continue;
+      }
+      latest[index] = graph->Write(pass, latest[index]);
+      random.writers[index].push_back(pass);
+      random.writes.back().push_back(latest[index]);
+    }
+  }
+  return random;
+}
+
+static bool Verify(const RandomGraph& random, const utils::RenderGraph& graph) {
+  // 期望的剔除结果：从根反向遍历数据依赖
+  std::vector<std::vector<int>> producers(kPasses);
+  for (int pass = 0; pass < kPasses; pass++) {
+    for (const utils::RenderGraphTexture& read : random.reads[pass]) {
+      producers[pass].push_back(random.writers[read.resource][read.version]);
+    }
+    for (const utils::RenderGraphTexture& write : random.writes[pass]) {
+      producers[pass].push_back(random.writers[write.resource][write.version - 1]);
+    }
+  }
+  std::vector<bool> alive(kPasses, false);
+  for (int pass = kPasses - 1; pass >= 0; pass--) {
+    bool root = random.side_effect[pass];
+    for (const utils::RenderGraphTexture& write : random.writes[pass]) {
+      root = root || random.imported[write.resource];
+    }
+    alive[pass] = alive[pass] || root;
+    if (alive[pass]) {
+      for (int producer : producers[pass]) {
+        if (producer >= 0) {
+          alive[producer] = true;
+        }
+      }
+    }
+  }
+  std::vector<int> position(kPasses, -1);
+  for (size_t i = 0; i < graph.order().size(); i++) {
+    position[graph.order()[i]] = static_cast<int>(i);
+  }
+  for (int pass = 0; pass < kPasses; pass++) {
+    if (graph.culled(pass) == alive[pass] || (position[pass] >= 0) != alive[pass]) {
+      std::cout << "pass " << pass << " culling mismatch" << std::endl;
+      return false;
+    }
+  }
+
+  // 顺序：依赖在前；读取旧版本的pass在下一版本的写入者之前
+  for (int pass = 0; pass < kPasses; pass++) {
+    if (!alive[pass]) {
+      continue;
+    }
+    for (int producer : producers[pass]) {
+      if (producer >= 0 && producer != pass && position[producer] > position[pass]) {
+        std::cout << "pass " << pass << " runs before its producer " << producer << std::endl;
+        return false;
+      }
+    }
+    for (const utils::RenderGraphTexture& read : random.reads[pass]) {
+      const std::vector<int>& writers = random.writers[read.resource];
+      if (read.version + 1 < writers.size()) {
+        int next = writers[read.version + 1];
+        if (next != pass && alive[next] && position[next] < position[pass]) {
+          std::cout << "pass " << pass << " reads a version overwritten by " << next << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  // 共用同一实际纹理的临时纹理生命周期不能重叠
+  for (uint32_t a = 0; a < graph.resource_count(); a++) {
+    for (uint32_t b = a + 1; b < graph.resource_count(); b++) {
+      if (graph.physical_index(a) >= 0 && graph.physical_index(a) == graph.physical_index(b) &&
+          graph.first_use(a) <= graph.last_use(b) && graph.first_use(b) <= graph.last_use(a)) {
+        std::cout << "textures " << a << " and " << b << " overlap" << std::endl;
+        return false;
+      }
+    }
+  }
+  const utils::RenderGraphStats& stats = graph.stats();
+  if (stats.bytes_with_aliasing > stats.bytes_without_aliasing || stats.bytes_with_aliasing < stats.peak_live_bytes) {
+    std::cout << "memory stats out of bounds" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  bool ok = true;
+
+  // 环：a读b的输出，b读a的输出
+  {
+    utils::RenderGraph graph;
+    utils::RenderGraphTexture x = graph.CreateTexture("x", {64, 64, GL_RGBA8});
+    utils::RenderGraphTexture y = graph.CreateTexture("y", {64, 64, GL_RGBA8});
+    int a = graph.AddPass("a", nullptr);
+    int b = graph.AddPass("b", nullptr);
+    x = graph.Write(a, x);
+    y = graph.Write(b, y);
+    graph.Read(a, y);
+    graph.Read(b, x);
+    graph.SetSideEffect(a);
+    if (graph.Compile()) {
+      std::cout << "cycle not detected" << std::endl;
+      ok = false;
+    }
+  }
+
+  std::mt19937 rng(11);
+  size_t without_aliasing = 0;
+  size_t with_aliasing = 0;
+  size_t peak = 0;
+  size_t culled = 0;
+  utils::RenderGraph graph;
+  for (int i = 0; i < kGraphs && ok; i++) {
+    RandomGraph random = BuildGraph(&rng, &graph);
+    if (!graph.Compile()) {
+      std::cout << "graph " << i << " failed to compile" << std::endl;
+      ok = false;
+      break;
+    }
+    ok = Verify(random, graph);
+    without_aliasing += graph.stats().bytes_without_aliasing;
+    with_aliasing += graph.stats().bytes_with_aliasing;
+    peak += graph.stats().peak_live_bytes;
+    culled += graph.stats().culled_passes;
+  }
+
+  std::cout << "culled: " << static_cast<double>(culled) / kGraphs << " passes per graph" << std::endl;
+  std::cout << "transient memory: " << without_aliasing / kGraphs / (1024 * 1024) << " MB without aliasing, "
+            << with_aliasing / kGraphs / (1024 * 1024) << " MB with aliasing, peak live "
+            << peak / kGraphs / (1024 * 1024) << " MB" << std::endl;
+  std::cout << (ok ? "all graphs valid" : "MISMATCH") << std::endl;
+
+  const std::string suffix = "/passes:" + std::to_string(kPasses);
+  bench::Runner runner;
+  runner.Add("RenderGraph/Compile" + suffix, [](bench::State& state) {
+    std::mt19937 rng(11);
+    utils::RenderGraph graph;
+    BuildGraph(&rng, &graph);
+    while (state.KeepRunning()) {
+      bench::DoNotOptimize(graph.Compile());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kPasses));
+  });
+  // 每帧的实际用法：Reset后重新声明所有pass和纹理，再编译
+  runner.Add("RenderGraph/BuildAndCompile" + suffix, [](bench::State& state) {
+    std::mt19937 rng(11);
+    utils::RenderGraph graph;
+    while (state.KeepRunning()) {
+      BuildGraph(&rng, &graph);
+      bench::DoNotOptimize(graph.Compile());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kPasses));
+  });
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/bounds.h"
+#include "utils/transform_batch.h"
+
+// 用法：transform_batch_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查各实现与glm和标量实现的结果一致，不一致时返回1；再按规模计时glm写法和各实现。
+
+static constexpr size_t kObjectCounts[] = { 10000, 100000, 1000000 };
+static constexpr utils::TransformKernel kKernels[] = {
+  utils::TransformKernel::kScalar,
+  utils::TransformKernel::kSse,
+  utils::TransformKernel::kAvx2,
+};
+
+// 1.3fps_camera的写法：每个物体用角度和未归一化的轴调用translate、rotate、scale
+struct GlmObjects {
+  std::vector<glm::vec3> positions;
+  std::vector<float> angles;
+  std::vector<glm::vec3> axes;
+  std::vector<glm::vec3> scales;
+};
+
+// 同一组物体的两种表示
+struct Scene {
+  size_t count = 0;
+  GlmObjects objects;
+  utils::TrsArrays trs;
+  utils::AabbArrays local;
+  glm::mat4 view_projection = glm::mat4(1.0f);
+};
+
+static bool Close(float expected, float actual) {
+  return std::abs(expected - actual) <= 1e-4f * (1.0f + std::abs(expected));
+}
+
+static bool CloseMatrices(const glm::mat4* expected, const glm::mat4* actual, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++) {
+        if (!Close(expected[i][c][r], actual[i][c][r])) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool SameBounds(const utils::AabbArrays& a, const utils::AabbArrays& b) {
+  size_t bytes = a.size() * sizeof(float);
+  return a.size() == b.size() && memcmp(a.center_x.data(), b.center_x.data(), bytes) == 0 &&
+         memcmp(a.center_y.data(), b.center_y.data(), bytes) == 0 &&
+         memcmp(a.center_z.data(), b.center_z.data(), bytes) == 0 &&
+         memcmp(a.extent_x.data(), b.extent_x.data(), bytes) == 0 &&
+         memcmp(a.extent_y.data(), b.extent_y.data(), bytes) == 0 &&
+         memcmp(a.extent_z.data(), b.extent_z.data(), bytes) == 0;
+}
+
+static std::shared_ptr<Scene> BuildScene(size_t count) {
+  std::mt19937 rng(static_cast<uint32_t>(count));
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+  auto scene = std::make_shared<Scene>();
+  scene->count = count;
+  GlmObjects& objects = scene->objects;
+  scene->trs.Resize(count);
+  scene->local.Resize(count);
+  for (size_t i = 0; i < count; i++) {
+    objects.positions.emplace_back(position(rng), position(rng), position(rng));
+    objects.angles.push_back(angle(rng));
+    objects.axes.emplace_back(unit(rng), unit(rng), unit(rng) + 2.0f);
+    objects.scales.emplace_back(scale(rng), scale(rng), scale(rng));
+    glm::quat rotation = glm::angleAxis(glm::radians(objects.angles[i]), glm::normalize(objects.axes[i]));
+    scene->trs.Set(i, objects.positions[i], rotation, objects.scales[i]);
+    scene->local.Set(i, utils::Aabb(glm::vec3(-0.5f), glm::vec3(0.5f)));
+  }
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  scene->view_projection = projection * view;
+  return scene;
+}
+
+static void GlmModels(const GlmObjects& objects, glm::mat4* models) {
+  for (size_t i = 0; i < objects.positions.size(); i++) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), objects.positions[i]);
+    model = glm::rotate(model, glm::radians(objects.angles[i]), objects.axes[i]);
+    models[i] = glm::scale(model, objects.scales[i]);
+  }
+}
+
+static void GlmMvps(const GlmObjects& objects, const glm::mat4& view_projection, glm::mat4* mvps) {
+  for (size_t i = 0; i < objects.positions.size(); i++) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), objects.positions[i]);
+    model = glm::rotate(model, glm::radians(objects.angles[i]), objects.axes[i]);
+    mvps[i] = view_projection * glm::scale(model, objects.scales[i]);
+  }
+}
+
+static void GlmBounds(const std::vector<glm::mat4>& models, utils::Aabb* bounds) {
+  for (size_t i = 0; i < models.size(); i++) {
+    bounds[i] = utils::TransformAabb(utils::Aabb(glm::vec3(-0.5f), glm::vec3(0.5f)), models[i]);
+  }
+}
+
+static bool CheckScene(const Scene& scene) {
+  size_t count = scene.count;
+  std::vector<glm::mat4> glm_models(count);
+  std::vector<glm::mat4> glm_mvps(count);
+  std::vector<utils::Aabb> glm_bounds(count);
+  GlmModels(scene.objects, glm_models.data());
+  GlmMvps(scene.objects, scene.view_projection, glm_mvps.data());
+  GlmBounds(glm_models, glm_bounds.data());
+
+  bool ok = true;
+  std::vector<glm::mat4> expected_models(count);
+  std::vector<utils::Matrix3x4> expected_3x4(count);
+  std::vector<glm::mat4> expected_mvps(count);
+  utils::AabbArrays expected_bounds;
+  std::vector<glm::mat4> models(count);
+  std::vector<utils::Matrix3x4> models_3x4(count);
+  std::vector<glm::mat4> mvps(count);
+  utils::AabbArrays bounds;
+  for (utils::TransformKernel kernel : kKernels) {
+    if (kernel > utils::BestTransformKernel()) {
+      continue;
+    }
+    const char* name = utils::TransformKernelName(kernel);
+    utils::ComposeModelMatrices(scene.trs, models.data(), kernel);
+    utils::ComposeModelMatrices(scene.trs, models_3x4.data(), kernel);
+    utils::ComposeMvpMatrices(scene.trs, scene.view_projection, mvps.data(), kernel);
+    utils::TransformBounds(scene.trs, scene.local, &bounds, kernel);
+
+    // 标量实现与glm的结果只在舍入上不同，SIMD实现与标量实现逐位一致
+    if (kernel == utils::TransformKernel::kScalar) {
+      expected_models = models;
+      expected_3x4 = models_3x4;
+      expected_mvps = mvps;
+      expected_bounds = bounds;
+      if (!CloseMatrices(glm_models.data(), models.data(), count) ||
+          !CloseMatrices(glm_mvps.data(), mvps.data(), count)) {
+        std::cout << "scalar matrices differ from glm" << std::endl;
+        ok = false;
+      }
+      for (size_t i = 0; i < count; i++) {
+        glm::vec3 center = glm_bounds[i].center();
+        glm::vec3 extent = glm_bounds[i].extent();
+        if (!Close(center.x, bounds.center_x[i]) || !Close(center.y, bounds.center_y[i]) ||
+            !Close(center.z, bounds.center_z[i]) || !Close(extent.x, bounds.extent_x[i]) ||
+            !Close(extent.y, bounds.extent_y[i]) || !Close(extent.z, bounds.extent_z[i])) {
+          std::cout << "scalar bounds differ from TransformAabb at " << i << std::endl;
+          ok = false;
+          break;
+        }
+      }
+      for (size_t i = 0; i < count; i++) {
+        for (int r = 0; r < 3; r++) {
+          for (int c = 0; c < 4; c++) {
+            ok = ok && models_3x4[i].rows[r][c] == models[i][c][r];
+          }
+        }
+      }
+      continue;
+    }
+    if (memcmp(models.data(), expected_models.data(), count * sizeof(glm::mat4)) != 0 ||
+        memcmp(models_3x4.data(), expected_3x4.data(), count * sizeof(utils::Matrix3x4)) != 0 ||
+        memcmp(mvps.data(), expected_mvps.data(), count * sizeof(glm::mat4)) != 0 ||
+        !SameBounds(bounds, expected_bounds)) {
+      std::cout << name << " results differ from " << count << "-object scalar results" << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+static void RegisterScene(bench::Runner* runner, std::shared_ptr<Scene> scene) {
+  const std::string suffix = "/" + std::to_string(scene->count);
+  auto items = [scene](bench::State& state) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * scene->count));
+  };
+
+  runner->Add("TransformBatch/Model/glm" + suffix, [scene, items](bench::State& state) {
+    std::vector<glm::mat4> models(scene->count);
+    while (state.KeepRunning()) {
+      GlmModels(scene->objects, models.data());
+      bench::ClobberMemory();
+    }
+    items(state);
+  });
+  runner->Add("TransformBatch/Mvp/glm" + suffix, [scene, items](bench::State& state) {
+    std::vector<glm::mat4> mvps(scene->count);
+    while (state.KeepRunning()) {
+      GlmMvps(scene->objects, scene->view_projection, mvps.data());
+      bench::ClobberMemory();
+    }
+    items(state);
+  });
+  runner->Add("TransformBatch/Bounds/glm" + suffix, [scene, items](bench::State& state) {
+    std::vector<glm::mat4> models(scene->count);
+    std::vector<utils::Aabb> bounds(scene->count);
+    GlmModels(scene->objects, models.data());
+    while (state.KeepRunning()) {
+      GlmBounds(models, bounds.data());
+      bench::ClobberMemory();
+    }
+    items(state);
+  });
+
+  for (utils::TransformKernel kernel : kKernels) {
+    if (kernel > utils::BestTransformKernel()) {
+      continue;
+    }
+    const std::string name = std::string("/") + utils::TransformKernelName(kernel) + suffix;
+    runner->Add("TransformBatch/Model" + name, [scene, items, kernel](bench::State& state) {
+      std::vector<glm::mat4> models(scene->count);
+      while (state.KeepRunning()) {
+        utils::ComposeModelMatrices(scene->trs, models.data(), kernel);
+        bench::ClobberMemory();
+      }
+      items(state);
+    });
+    runner->Add("TransformBatch/Model3x4" + name, [scene, items, kernel](bench::State& state) {
+      std::vector<utils::Matrix3x4> models(scene->count);
+      while (state.KeepRunning()) {
+        utils::ComposeModelMatrices(scene->trs, models.data(), kernel);
+        bench::ClobberMemory();
+      }
+      items(state);
+    });
+    runner->Add("TransformBatch/Mvp" + name, [scene, items, kernel](bench::State& state) {
+      std::vector<glm::mat4> mvps(scene->count);
+      while (state.KeepRunning()) {
+        utils::ComposeMvpMatrices(scene->trs, scene->view_projection, mvps.data(), kernel);
+        bench::ClobberMemory();
+      }
+      items(state);
+    });
+    runner->Add("TransformBatch/Bounds" + name, [scene, items, kernel](bench::State& state) {
+      utils::AabbArrays bounds;
+      while (state.KeepRunning()) {
+        utils::TransformBounds(scene->trs, scene->local, &bounds, kernel);
+        bench::ClobberMemory();
+      }
+      items(state);
+    });
+  }
+}
+
+int main(int argc, char** argv) {
+  std::cout << "best kernel: " << utils::TransformKernelName(utils::BestTransformKernel()) << std::endl;
+  bool ok = true;
+  bench::Runner runner;
+  for (size_t count : kObjectCounts) {
+    std::shared_ptr<Scene> scene = BuildScene(count);
+    ok = CheckScene(*scene) && ok;
+    RegisterScene(&runner, scene);
+  }
+  // 不是4和8的倍数时尾部走标量实现，只检查结果
+  ok = CheckScene(*BuildScene(1003)) && ok;
+  std::cout << (ok ? "all kernels match" : "MISMATCH") << std::endl;
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "benchmarks/bench_harness.h"
+#include "utils/thread_pool.h"
+#include "utils/transform_hierarchy.h"
+
+// 用法：transform_hierarchy_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// 先检查世界矩阵与逐节点glm计算一致，误差过大时返回1；再计时不同脏节点分布下的Update。
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kNodeCount = 1000000;
+static constexpr size_t kRootCount = 1024;
+
+static glm::quat RandomRotation(std::mt19937& rng) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  glm::vec3 axis(dist(rng), dist(rng), dist(rng) + 2.0f);
+  return glm::angleAxis(dist(rng) * 3.14159f, glm::normalize(axis));
+}
+
+static double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+  std::uniform_real_distribution<float> scale(0.9f, 1.1f);
+
+  // 4叉树按层序添加，Update时会先重排成深度优先顺序
+  utils::TransformHierarchy hierarchy;
+  hierarchy.Reserve(kNodeCount);
+  std::vector<utils::TransformHierarchy::NodeId> parents(kNodeCount, utils::TransformHierarchy::kInvalidNode);
+  for (size_t i = 0; i < kNodeCount; i++) {
+    if (i >= kRootCount) {
+      parents[i] = static_cast<utils::TransformHierarchy::NodeId>((i - kRootCount) / 4);
+    }
+    hierarchy.AddNode(parents[i], glm::vec3(offset(rng), offset(rng), offset(rng)), RandomRotation(rng),
+                      glm::vec3(scale(rng)));
+  }
+
+  auto start = Clock::now();
+  hierarchy.Update();
+  std::cout << "Initial reorder + update: " << ElapsedMs(start) << " ms" << std::endl;
+
+  // 与逐节点glm计算的结果比较
+  std::vector<glm::mat4> reference(kNodeCount);
+  float max_error = 0.0f;
+  for (size_t i = 0; i < kNodeCount; i++) {
+    auto node = static_cast<utils::TransformHierarchy::NodeId>(i);
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), hierarchy.translation(node)) *
+                      glm::mat4_cast(hierarchy.rotation(node)) * glm::scale(glm::mat4(1.0f), hierarchy.scale(node));
+    reference[i] = parents[i] == utils::TransformHierarchy::kInvalidNode ? local : reference[parents[i]] * local;
+
+    const glm::mat4& world = hierarchy.world_matrix(node);
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++) {
+        float error = std::abs(world[c][r] - reference[i][c][r]) / std::max(1.0f, std::abs(reference[i][c][r]));
+        max_error = std::max(max_error, error);
+      }
+    }
+  }
+  std::cout << "Max relative error vs glm: " << max_error << std::endl;
+  bool ok = max_error < 1e-3f;
+
+  utils::ThreadPool pool;
+  std::cout << "Threads: " << pool.thread_count() << std::endl;
+
+  auto dirty_all = [&] {
+    for (size_t i = 0; i < kNodeCount; i++) {
+      auto node = static_cast<utils::TransformHierarchy::NodeId>(i);
+      hierarchy.SetTranslation(node, hierarchy.translation(node));
+    }
+  };
+
+  auto dirty_roots = [&] {
+    for (size_t i = 0; i < kRootCount; i++) {
+      auto node = static_cast<utils::TransformHierarchy::NodeId>(i);
+      hierarchy.SetRotation(node, RandomRotation(rng));
+    }
+  };
+
+  std::uniform_int_distribution<size_t> pick(0, kNodeCount - 1);
+  auto dirty_sparse = [&] {
+    for (size_t i = 0; i < kNodeCount / 100; i++) {
+      auto node = static_cast<utils::TransformHierarchy::NodeId>(pick(rng));
+      hierarchy.SetRotation(node, RandomRotation(rng));
+    }
+  };
+
+  bench::Runner runner;
+  struct Case {
+    const char* name;
+    std::function<void()> mark_dirty;
+  };
+  const Case cases[] = {
+    { "AllDirty", dirty_all },
+    { "RootsDirty", dirty_roots },
+    { "SparseDirty", dirty_sparse },
+  };
+  for (const Case& c : cases) {
+    for (utils::ThreadPool* update_pool : { static_cast<utils::ThreadPool*>(nullptr), &pool }) {
+      std::string name = std::string("TransformHierarchy/Update/") + c.name +
+                         (update_pool != nullptr ? "/pool:" + std::to_string(pool.thread_count()) : "/serial");
+      // 标记脏节点不计入，只计时Update
+      runner.Add(name, [&hierarchy, mark_dirty = c.mark_dirty, update_pool](bench::State& state) {
+        while (state.KeepRunning()) {
+          state.PauseTiming();
+          mark_dirty();
+          state.ResumeTiming();
+          hierarchy.Update(update_pool);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kNodeCount));
+      });
+    }
+  }
+  // 没有脏节点时Update只做一次检查，暂停计时的开销会盖过它，单独注册
+  runner.Add("TransformHierarchy/Update/NothingDirty", [&](bench::State& state) {
+    while (state.KeepRunning()) {
+      hierarchy.Update(&pool);
+    }
+  });
+
+  int result = runner.Run(argc, argv);
+  return ok && result == 0 ? 0 : 1;
+}
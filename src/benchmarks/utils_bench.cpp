@@ -0,0 +1,471 @@
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "spdlog/spdlog.h"
+// 实现已经编译在utils的gl_util.cpp中，这里只要声明
+#undef STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+#include "benchmarks/bench_harness.h"
+#include "config/globals.h"
+#include "utils/file_util.h"
+#include "utils/fps_camera.h"
+#include "utils/gl_context.h"
+#include "utils/animation_import.h"
+#include "utils/gl_util.h"
+#include "utils/shader.h"
+#include "utils/skinning.h"
+
+// 用法：utils_bench [--filter=子串] [--json=结果.json] [--min-time=秒] [--repetitions=N]
+// GL相关的用例在无窗口EGL上下文中运行，没有EGL时跳过。
+
+static const char* kVertexShader = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 offset;
+void main() {
+  gl_Position = projection * view * model * vec4(aPos + offset, 1.0);
+}
+)";
+
+static const char* kFragmentShader = R"(#version 330 core
+out vec4 FragColor;
+uniform vec4 color;
+uniform float mix_value;
+uniform int use_color;
+void main() {
+  FragColor = use_color != 0 ? color * mix_value : vec4(mix_value);
+}
+)";
+
+// 1.3fps_camera中的立方体位置
+static const glm::vec3 kCubePositions[] = {
+  glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f), glm::vec3(-1.5f, -2.2f, -2.5f),
+  glm::vec3(-3.8f, -2.0f, -12.3f), glm::vec3(2.4f, -0.4f, -3.5f), glm::vec3(-1.7f, 3.0f, -7.5f),
+  glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),  glm::vec3(1.5f, 0.2f, -1.5f),
+  glm::vec3(-1.3f, 1.0f, -1.5f),
+};
+
+static constexpr int kCubeCount = sizeof(kCubePositions) / sizeof(kCubePositions[0]);
+
+static std::filesystem::path TempDir() {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "utils_bench";
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+static std::string WriteTempFile(const std::string& name, const std::string& content) {
+  std::filesystem::path path = TempDir() / name;
+  FILE* file = fopen(path.string().c_str(), "wb");
+  if (file != nullptr) {
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+  }
+  return path.string();
+}
+
+static std::string TexturePath(const char* name) {
+  return std::filesystem::path(RESOURCE_DIR).append("textures").append(name).string();
+}
+
+// 所有GL用例共用一个无窗口上下文，第一次用到时创建
+static utils::GlContext* GetGlContext() {
+  static std::unique_ptr<utils::GlContext> context;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    utils::ContextOptions options;
+    options.mode = utils::ContextMode::kHeadless;
+    options.width = 64;
+    options.height = 64;
+    context = std::make_unique<utils::GlContext>();
+    if (!context->Init(options)) {
+      context.reset();
+    }
+  }
+  return context.get();
+}
+
+static utils::Shader* GetShader() {
+  static std::unique_ptr<utils::Shader> shader;
+  if (shader == nullptr && GetGlContext() != nullptr) {
+    shader = std::make_unique<utils::Shader>();
+    std::string vertex_path = WriteTempFile("bench.vs", kVertexShader);
+    std::string fragment_path = WriteTempFile("bench.fs", kFragmentShader);
+    if (!shader->Compile(vertex_path, fragment_path)) {
+      shader.reset();
+      return nullptr;
+    }
+  }
+  return shader.get();
+}
+
+static void RegisterFileBenchmarks(bench::Runner* runner) {
+  for (size_t size : { size_t(4) << 10, size_t(256) << 10 }) {
+    std::string name = "ReadFile/" + std::to_string(size >> 10) + "KB";
+    runner->Add(name, [size](bench::State& state) {
+      std::string path = WriteTempFile("read_file_" + std::to_string(size) + ".txt", std::string(size, 'x'));
+      while (state.KeepRunning()) {
+        std::string content = utils::ReadFile(path);
+        bench::DoNotOptimize(content.data());
+      }
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+    });
+  }
+}
+
+static void RegisterTextureBenchmarks(bench::Runner* runner) {
+  for (const char* file : { "container.jpg", "awesomeface.png" }) {
+    std::string path = TexturePath(file);
+
+    // 只解码，不含读文件
+    runner->Add(std::string("Texture/Decode/") + file, [path](bench::State& state) {
+      std::string bytes = utils::ReadFile(path);
+      if (bytes.empty()) {
+        state.SkipWithError("missing " + path);
+        return;
+      }
+      int width = 0;
+      int height = 0;
+      int channels = 0;
+      while (state.KeepRunning()) {
+        unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(bytes.data()),
+                                                    static_cast<int>(bytes.size()), &width, &height, &channels, 0);
+        if (data == nullptr) {
+          state.SkipWithError("failed to decode " + path);
+        }
+        bench::DoNotOptimize(data);
+        stbi_image_free(data);
+      }
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * width * height * channels);
+    });
+
+    // 只上传和生成mipmap，glFinish保证计入GPU端（llvmpipe上即CPU）的工作
+    runner->Add(std::string("Texture/Upload/") + file, [path](bench::State& state) {
+      if (GetGlContext() == nullptr) {
+        state.SkipWithError("no GL context");
+        return;
+      }
+      int width = 0;
+      int height = 0;
+      int channels = 0;
+      unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+      if (data == nullptr) {
+        state.SkipWithError("missing " + path);
+        return;
+      }
+      GLenum format = channels == 4 ? GL_RGBA : GL_RGB;
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      while (state.KeepRunning()) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        glDeleteTextures(1, &texture);
+      }
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      stbi_image_free(data);
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * width * height * channels);
+    });
+
+    // 完整的LoadTexture：读文件、解码、上传
+    runner->Add(std::string("Texture/LoadTexture/") + file, [path](bench::State& state) {
+      if (GetGlContext() == nullptr) {
+        state.SkipWithError("no GL context");
+        return;
+      }
+      bool png = path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+      GLenum format = png ? GL_RGBA : GL_RGB;
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      GLuint first = utils::LoadTexture(path, static_cast<GLint>(format), format, true);
+      if (first == 0) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        state.SkipWithError("failed to load " + path);
+        return;
+      }
+      glDeleteTextures(1, &first);
+      while (state.KeepRunning()) {
+        GLuint texture = utils::LoadTexture(path, static_cast<GLint>(format), format, true);
+        glFinish();
+        glDeleteTextures(1, &texture);
+      }
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    });
+  }
+}
+
+// n x n个四边形的OBJ网格，带法线和纹理坐标，用于模型导入和转换
+static std::string WriteGridObj(int n) {
+  std::string text;
+  char line[96];
+  for (int z = 0; z <= n; z++) {
+    for (int x = 0; x <= n; x++) {
+      float u = static_cast<float>(x) / n;
+      float v = static_cast<float>(z) / n;
+      snprintf(line, sizeof(line), "v %f 0 %f\nvt %f %f\n", u * 2.0f - 1.0f, v * 2.0f - 1.0f, u, v);
+      text += line;
+    }
+  }
+  text += "vn 0 1 0\n";
+  for (int z = 0; z < n; z++) {
+    for (int x = 0; x < n; x++) {
+      int a = z * (n + 1) + x + 1;
+      int b = a + n + 1;
+      snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, b + 1, b + 1, a + 1, a + 1);
+      text += line;
+    }
+  }
+  return WriteTempFile("grid_" + std::to_string(n) + ".obj", text);
+}
+
+// Samples/里的Mirage::Mesh不参与构建，这里测utils实际使用的Assimp路径：导入并转换为SkinnedMeshData，
+// 以及把结果上传为顶点和索引缓冲
+static void RegisterMeshBenchmarks(bench::Runner* runner) {
+  for (int n : { 16, 128 }) {
+    std::string suffix = "/grid_" + std::to_string(n);
+    runner->Add("Mesh/Import" + suffix, [n](bench::State& state) {
+      std::string path = WriteGridObj(n);
+      utils::SkinnedMeshData mesh;
+      utils::Skeleton skeleton;
+      // 每次导入都有一行INFO日志
+      spdlog::level::level_enum level = spdlog::get_level();
+      spdlog::set_level(spdlog::level::warn);
+      while (state.KeepRunning()) {
+        if (!utils::ImportSkinnedModel(path, &mesh, &skeleton, nullptr)) {
+          state.SkipWithError("failed to import " + path);
+        }
+        bench::DoNotOptimize(mesh.vertices.data());
+      }
+      spdlog::set_level(level);
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * mesh.vertices.size()));
+    });
+
+    runner->Add("Mesh/Upload" + suffix, [n](bench::State& state) {
+      if (GetGlContext() == nullptr) {
+        state.SkipWithError("no GL context");
+        return;
+      }
+      utils::SkinnedMeshData mesh;
+      utils::Skeleton skeleton;
+      if (!utils::ImportSkinnedModel(WriteGridObj(n), &mesh, &skeleton, nullptr)) {
+        state.SkipWithError("failed to import grid");
+        return;
+      }
+      size_t bytes = mesh.vertices.size() * sizeof(utils::SkinnedVertex) + mesh.indices.size() * sizeof(uint32_t);
+      while (state.KeepRunning()) {
+        utils::SkinnedMesh gpu_mesh;
+        gpu_mesh.Init(mesh);
+        glFinish();
+      }
+      state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    });
+  }
+}
+
+static void RegisterShaderBenchmarks(bench::Runner* runner) {
+  // 每个setter都会按名字查一次uniform位置，这里测的正是这部分开销
+  runner->Add("Shader/SetInt", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    int i = 0;
+    while (state.KeepRunning()) {
+      shader->SetInt("use_color", i++ & 1);
+    }
+  });
+
+  runner->Add("Shader/SetFloat", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    float value = 0.0f;
+    while (state.KeepRunning()) {
+      shader->SetFloat("mix_value", value);
+      value += 0.001f;
+    }
+  });
+
+  runner->Add("Shader/SetVec3", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    glm::vec3 value(0.0f);
+    while (state.KeepRunning()) {
+      shader->SetVec3("offset", value);
+      value.x += 0.001f;
+    }
+  });
+
+  runner->Add("Shader/SetVec4", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    glm::vec4 value(1.0f);
+    while (state.KeepRunning()) {
+      shader->SetVec4("color", value);
+      value.x += 0.001f;
+    }
+  });
+
+  runner->Add("Shader/SetMat4", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    glm::mat4 value(1.0f);
+    while (state.KeepRunning()) {
+      shader->SetMat4("model", value);
+      value[3][0] += 0.001f;
+    }
+  });
+
+  // 1.3fps_camera一帧的uniform设置：projection、view和每个立方体的model
+  runner->Add("Shader/FrameUniforms", [](bench::State& state) {
+    utils::Shader* shader = GetShader();
+    if (shader == nullptr) {
+      state.SkipWithError("no GL context");
+      return;
+    }
+    shader->Use();
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 models[kCubeCount];
+    for (int i = 0; i < kCubeCount; i++) {
+      models[i] = glm::translate(glm::mat4(1.0f), kCubePositions[i]);
+    }
+    while (state.KeepRunning()) {
+      shader->SetMat4("projection", projection);
+      shader->SetMat4("view", view);
+      for (const glm::mat4& model : models) {
+        shader->SetMat4("model", model);
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (kCubeCount + 2));
+  });
+}
+
+static void RegisterCameraBenchmarks(bench::Runner* runner) {
+  // 鼠标移动后重新计算朝向和视图矩阵
+  runner->Add("FpsCamera/MouseMoveAndView", [](bench::State& state) {
+    utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    float offset = 1.0f;
+    while (state.KeepRunning()) {
+      camera.ProcessMouseMovement(offset, 0.5f * offset);
+      offset = -offset;
+      bench::DoNotOptimize(camera.GetViewMatrix());
+    }
+  });
+
+  runner->Add("FpsCamera/KeyboardAndViewProjection", [](bench::State& state) {
+    utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    float delta = 0.016f;
+    while (state.KeepRunning()) {
+      camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta);
+      delta = -delta;
+      bench::DoNotOptimize(camera.GetViewProjectionMatrix());
+    }
+  });
+
+  runner->Add("FpsCamera/FrustumAfterMove", [](bench::State& state) {
+    utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    float offset = 1.0f;
+    while (state.KeepRunning()) {
+      camera.ProcessMouseMovement(offset, 0.0f);
+      offset = -offset;
+      bench::DoNotOptimize(camera.GetFrustum());
+    }
+  });
+
+  // 相机没有变化时只返回缓存的矩阵
+  runner->Add("FpsCamera/CachedView", [](bench::State& state) {
+    utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    while (state.KeepRunning()) {
+      bench::DoNotOptimize(camera.GetViewMatrix());
+    }
+  });
+}
+
+static void RegisterMathBenchmarks(bench::Runner* runner) {
+  // 绘制循环中每个立方体的模型矩阵：平移加绕轴旋转
+  runner->Add("Math/CubeModelMatrices", [](bench::State& state) {
+    float time = 0.0f;
+    while (state.KeepRunning()) {
+      for (int i = 0; i < kCubeCount; i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), kCubePositions[i]);
+        model = glm::rotate(model, time + glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+        bench::DoNotOptimize(model);
+      }
+      time += 0.001f;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kCubeCount);
+  });
+
+  runner->Add("Math/ModelViewProjection", [](bench::State& state) {
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 models[kCubeCount];
+    for (int i = 0; i < kCubeCount; i++) {
+      models[i] = glm::translate(glm::mat4(1.0f), kCubePositions[i]);
+    }
+    while (state.KeepRunning()) {
+      bench::ClobberMemory();
+      for (const glm::mat4& model : models) {
+        bench::DoNotOptimize(projection * view * model);
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kCubeCount);
+  });
+
+  runner->Add("Math/LookAtPerspective", [](bench::State& state) {
+    glm::vec3 eye(0.0f, 0.0f, 3.0f);
+    while (state.KeepRunning()) {
+      glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+      glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+      bench::DoNotOptimize(projection * view);
+      eye.x += 0.001f;
+    }
+  });
+
+  runner->Add("Math/Inverse", [](bench::State& state) {
+    glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), 0.5f,
+                                  glm::vec3(0.0f, 1.0f, 0.0f));
+    while (state.KeepRunning()) {
+      bench::ClobberMemory();
+      bench::DoNotOptimize(glm::inverse(model));
+    }
+  });
+}
+
+int main(int argc, char** argv) {
+  bench::Runner runner;
+  RegisterFileBenchmarks(&runner);
+  RegisterTextureBenchmarks(&runner);
+  RegisterShaderBenchmarks(&runner);
+  RegisterMeshBenchmarks(&runner);
+  RegisterCameraBenchmarks(&runner);
+  RegisterMathBenchmarks(&runner);
+  return runner.Run(argc, argv);
+}
@@ -0,0 +1,262 @@
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/dynamic_resolution.h"
+#include "utils/fps_camera.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/shader.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+static std::tuple<std::string, std::string> GetUpscaleShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 10.0f, 40.0f));
+static float delta_time = 0.0f;
+
+static constexpr int kColumns = 16;
+static constexpr float kSpacing = 4.0f;
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Dynamic Resolution";
+  utils::DynamicResolutionOptions resolution_options;
+  // 场景复杂度每spike_period秒在workload和workload * spike_factor之间切换
+  int workload = 16;
+  int spike_factor = 4;
+  float spike_period = 2.0f;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--target-ms" && i + 1 < argc) {
+      resolution_options.target_ms = std::stod(argv[++i]);
+    } else if (arg == "--min-scale" && i + 1 < argc) {
+      resolution_options.min_scale = std::stof(argv[++i]);
+    } else if (arg == "--workload" && i + 1 < argc) {
+      workload = std::stoi(argv[++i]);
+    } else if (arg == "--spike-factor" && i + 1 < argc) {
+      spike_factor = std::stoi(argv[++i]);
+    } else if (arg == "--spike-period" && i + 1 < argc) {
+      spike_period = std::stof(argv[++i]);
+    } else if (arg == "--fixed-scale") {
+      resolution_options.enabled = false;
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  utils::DynamicResolution resolution;
+  auto [upscale_vertex_path, upscale_fragment_path] = GetUpscaleShaderPaths();
+  if (!resolution.Init(resolution_options, upscale_vertex_path, upscale_fragment_path)) {
+    return -1;
+  }
+
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<glm::vec3> instances;
+  for (int x = 0; x < kColumns; x++) {
+    for (int z = 0; z < kColumns; z++) {
+      float height = 1.0f + unit(rng) * 5.0f;
+      instances.push_back(glm::vec3((x - kColumns / 2 + 0.5f) * kSpacing, height * 0.5f,
+                                    (z - kColumns / 2 + 0.5f) * kSpacing));
+      instances.push_back(glm::vec3(2.5f, height, 2.5f));
+    }
+  }
+  auto instance_count = static_cast<GLsizei>(instances.size() / 2);
+
+  std::vector<float> vertices;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      normal[axis] = side;
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+      for (int index : {0, 1, 2, 0, 2, 3}) {
+        glm::vec3 p = corners[index] * 0.5f;
+        vertices.insert(vertices.end(), {p.x, p.y, p.z, normal.x, normal.y, normal.z});
+      }
+    }
+  }
+
+  GLuint buffers[2] = {0, 0};
+  glGenBuffers(2, buffers);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_STATIC_DRAW);
+
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  for (int attribute = 0; attribute < 2; attribute++) {
+    glVertexAttribPointer(2 + attribute, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3),
+                          (void*)(attribute * sizeof(glm::vec3)));
+    glEnableVertexAttribArray(2 + attribute);
+    glVertexAttribDivisor(2 + attribute, 1);
+  }
+  glBindVertexArray(0);
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 200.0f);
+
+  std::vector<double> gpu_ms;
+  std::vector<double> scales;
+  int over_budget = 0;
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 100.0f, 0.0f);
+    }
+
+    bool spike = static_cast<int>(current_time / spike_period) % 2 == 1;
+    int frame_workload = spike ? workload * spike_factor : workload;
+
+    // 渲染目标的尺寸由控制器决定，输出尺寸仍跟随窗口
+    resolution.BeginFrame(context.width(), context.height());
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.2, 0.3, 0.4, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+    shader.SetInt("workload", frame_workload);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instance_count);
+    resolution.EndFrame();
+
+    context.EndFrame();
+
+    if (resolution.gpu_ms() > 0.0) {
+      gpu_ms.push_back(resolution.gpu_ms());
+      over_budget += resolution.gpu_ms() > resolution_options.target_ms ? 1 : 0;
+    }
+    scales.push_back(static_cast<double>(resolution.render_width()) / context.width());
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = "Dynamic Resolution - " + std::to_string(resolution.render_width()) + "x" +
+                          std::to_string(resolution.render_height()) + ", GPU " +
+                          std::to_string(resolution.gpu_ms()) + " ms";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  utils::PercentileSummary gpu = utils::Summarize(gpu_ms);
+  auto [min_scale, max_scale] = std::minmax_element(scales.begin(), scales.end());
+  const utils::RenderTargetPoolStats& pool = resolution.pool().stats();
+  std::cout << "gpu avg/p50/p99: " << gpu.avg_ms << " / " << gpu.p50_ms << " / " << gpu.p99_ms << " ms, "
+            << over_budget << "/" << gpu_ms.size() << " frames over " << resolution_options.target_ms << " ms"
+            << std::endl;
+  if (!scales.empty()) {
+    std::cout << "scale min/max: " << *min_scale << " / " << *max_scale << std::endl;
+  }
+  std::cout << "render targets: " << pool.created << " created, " << pool.reused << " reused, " << pool.evicted
+            << " evicted, " << pool.live << " live (" << pool.bytes / 1024 << " KB)" << std::endl;
+
+  resolution.Release();
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(2, buffers);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.10dynamic_resolution.vs").string(),
+    path.parent_path().append("1.10dynamic_resolution.fs").string(),
+  };
+}
+
+static std::tuple<std::string, std::string> GetUpscaleShaderPaths() {
+  return {
+    std::filesystem::path(RESOURCE_DIR).append("shaders").append("fullscreen.vs").string(),
+    std::filesystem::path(RESOURCE_DIR).append("shaders").append("upscale.fs").string(),
+  };
+}
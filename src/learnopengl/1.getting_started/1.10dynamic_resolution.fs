@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 WorldPos;
+in vec3 Normal;
+
+// 每个片段的额外计算量，模拟场景复杂度
+uniform int workload;
+
+void main()
+{
+    // 程序化花纹，迭代有界，不会发散
+    vec2 start = WorldPos.xz * 0.2 + WorldPos.y * 0.1;
+    vec2 p = start;
+    vec3 pattern = vec3(0.0);
+    for (int i = 0; i < workload; i++) {
+        p = vec2(sin(p.x * 1.3 + p.y), cos(p.y * 1.7 - p.x)) * 2.0 + start;
+        pattern += 0.5 + 0.5 * cos(vec3(0.0, 2.0, 4.0) + length(p));
+    }
+    pattern = workload > 0 ? pattern / float(workload) : vec3(0.8);
+    float light = max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0) * 0.7 + 0.3;
+    FragColor = vec4(pattern * light, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 实例属性：立方体的位置和缩放
+layout (location = 2) in vec3 aOffset;
+layout (location = 3) in vec3 aScale;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 WorldPos;
+out vec3 Normal;
+
+void main()
+{
+    WorldPos = aPos * aScale + aOffset;
+    Normal = aNormal;
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
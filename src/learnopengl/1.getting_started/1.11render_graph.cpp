@@ -0,0 +1,385 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/fps_camera.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/render_graph.h"
+#include "utils/shader.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+static std::tuple<std::string, std::string, std::string, std::string, std::string> GetShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 15.0f, 50.0f));
+static float delta_time = 0.0f;
+static bool show_depth = false;
+
+static constexpr int kColumns = 24;
+static constexpr float kSpacing = 5.0f;
+static constexpr float kGroundSize = 80.0f;
+static constexpr int kShadowSize = 2048;
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Render Graph";
+  bool aliasing = true;
+  // 泛光的模糊次数，每次一个水平pass和一个竖直pass，中间结果都是独立声明的临时纹理
+  int blur_passes = 3;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--no-aliasing") {
+      aliasing = false;
+    } else if (arg == "--blur-passes" && i + 1 < argc) {
+      blur_passes = std::stoi(argv[++i]);
+    } else if (arg == "--show-depth") {
+      show_depth = true;
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+    glfwSetKeyCallback(window, KeyCallback);
+  }
+
+  utils::Shader shader;
+  utils::Shader depth_shader;
+  utils::Shader post_shader;
+  auto [vertex_shader_path, fragment_shader_path, depth_fragment_path, post_vertex_path, post_fragment_path] =
+      GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path) ||
+      !depth_shader.Compile(vertex_shader_path, depth_fragment_path) ||
+      !post_shader.Compile(post_vertex_path, post_fragment_path)) {
+    return -1;
+  }
+
+  // 立方体排成网格，少数立方体自发光，作为泛光的来源
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<glm::vec3> instances;
+  for (int x = 0; x < kColumns; x++) {
+    for (int z = 0; z < kColumns; z++) {
+      float height = 1.0f + unit(rng) * 6.0f;
+      instances.push_back(glm::vec3((x - kColumns / 2 + 0.5f) * kSpacing, height * 0.5f,
+                                    (z - kColumns / 2 + 0.5f) * kSpacing));
+      instances.push_back(glm::vec3(2.0f, height, 2.0f));
+    }
+  }
+  std::vector<glm::vec3> emissive_instances;
+  for (int i = 0; i < 16; i++) {
+    emissive_instances.push_back(glm::vec3((unit(rng) - 0.5f) * kColumns * kSpacing, 9.0f + unit(rng) * 4.0f,
+                                           (unit(rng) - 0.5f) * kColumns * kSpacing));
+    emissive_instances.push_back(glm::vec3(1.0f));
+  }
+  auto instance_count = static_cast<GLsizei>(instances.size() / 2);
+  auto emissive_count = static_cast<GLsizei>(emissive_instances.size() / 2);
+
+  std::vector<float> vertices;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      normal[axis] = side;
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+      for (int index : {0, 1, 2, 0, 2, 3}) {
+        glm::vec3 p = corners[index] * 0.5f;
+        vertices.insert(vertices.end(), {p.x, p.y, p.z, normal.x, normal.y, normal.z});
+      }
+    }
+  }
+
+  GLuint buffers[3] = {0, 0, 0};
+  glGenBuffers(3, buffers);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+  glBufferData(GL_ARRAY_BUFFER, emissive_instances.size() * sizeof(glm::vec3), emissive_instances.data(),
+               GL_STATIC_DRAW);
+
+  // 三个VAO共用立方体顶点：普通和自发光立方体各有实例缓冲，地面用常量属性值；最后一个VAO给全屏三角形
+  GLuint vaos[4] = {0, 0, 0, 0};
+  glGenVertexArrays(4, vaos);
+  for (int i = 0; i < 3; i++) {
+    glBindVertexArray(vaos[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    if (i == 2) {
+      continue;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[1 + i]);
+    for (int attribute = 0; attribute < 2; attribute++) {
+      glVertexAttribPointer(2 + attribute, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3),
+                            (void*)(attribute * sizeof(glm::vec3)));
+      glEnableVertexAttribArray(2 + attribute);
+      glVertexAttribDivisor(2 + attribute, 1);
+    }
+  }
+  glBindVertexArray(0);
+
+  auto draw_scene = [&](utils::Shader& scene_shader) {
+    scene_shader.SetVec3("color", glm::vec3(0.6f, 0.6f, 0.55f));
+    scene_shader.SetVec3("emission", glm::vec3(0.0f));
+    glBindVertexArray(vaos[2]);
+    glVertexAttrib3f(2, 0.0f, -0.5f, 0.0f);
+    glVertexAttrib3f(3, kGroundSize * 2.0f, 1.0f, kGroundSize * 2.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    scene_shader.SetVec3("color", glm::vec3(0.8f));
+    glBindVertexArray(vaos[0]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instance_count);
+    scene_shader.SetVec3("emission", glm::vec3(8.0f, 4.0f, 1.5f));
+    glBindVertexArray(vaos[1]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, emissive_count);
+  };
+  auto draw_fullscreen = [&](int mode) {
+    post_shader.Use();
+    post_shader.SetInt("mode", mode);
+    glBindVertexArray(vaos[3]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  };
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 200.0f);
+
+  utils::RenderGraph graph;
+  graph.set_aliasing(aliasing);
+  std::vector<double> compile_ms;
+  bool described = false;
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 100.0f, 0.0f);
+    }
+    camera.SetAspect((float)context.width() / (float)context.height());
+
+    float sun_angle = glm::radians(30.0f + 10.0f * current_time);
+    glm::vec3 light_direction = glm::normalize(glm::vec3(std::cos(sun_angle), -1.5f, std::sin(sun_angle)));
+    glm::mat4 light_view = glm::lookAt(-light_direction * 100.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 light_projection = glm::ortho(-kGroundSize, kGroundSize, -kGroundSize, kGroundSize, 1.0f, 250.0f);
+    glm::mat4 light_view_projection = light_projection * light_view;
+
+    // 每帧重新声明图，编译只涉及几十个整数，纹理和帧缓冲在图内部跨帧复用
+    int width = context.width();
+    int height = context.height();
+    graph.Reset();
+    utils::RenderGraphTexture backbuffer = graph.ImportTexture("backbuffer", {width, height, GL_RGBA8}, 0);
+    utils::RenderGraphTexture shadow_map =
+        graph.CreateTexture("shadow_map", {kShadowSize, kShadowSize, GL_DEPTH_COMPONENT32F});
+    utils::RenderGraphTexture hdr = graph.CreateTexture("hdr", {width, height, GL_RGBA16F});
+    utils::RenderGraphTexture depth = graph.CreateTexture("depth", {width, height, GL_DEPTH24_STENCIL8});
+
+    int shadow_pass = graph.AddPass("shadow", [&](const utils::RenderPassContext&) {
+      glEnable(GL_DEPTH_TEST);
+      glEnable(GL_CULL_FACE);
+      glClear(GL_DEPTH_BUFFER_BIT);
+      depth_shader.Use();
+      depth_shader.SetMat4("projection", light_projection);
+      depth_shader.SetMat4("view", light_view);
+      depth_shader.SetMat4("lightViewProjection", light_view_projection);
+      draw_scene(depth_shader);
+    });
+    shadow_map = graph.Write(shadow_pass, shadow_map);
+
+    int scene_pass = graph.AddPass("scene", [&, shadow_map](const utils::RenderPassContext& pass) {
+      glEnable(GL_DEPTH_TEST);
+      glEnable(GL_CULL_FACE);
+      glClearColor(0.5, 0.6, 0.7, 1.0);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      shader.Use();
+      shader.SetMat4("projection", camera.GetProjectionMatrix());
+      shader.SetMat4("view", camera.GetViewMatrix());
+      shader.SetMat4("lightViewProjection", light_view_projection);
+      shader.SetVec3("lightDirection", light_direction);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, pass.texture(shadow_map));
+      shader.SetInt("shadowMap", 0);
+      draw_scene(shader);
+    });
+    graph.Read(scene_pass, shadow_map);
+    hdr = graph.Write(scene_pass, hdr);
+    depth = graph.Write(scene_pass, depth);
+
+    // 后处理的pass都是全屏三角形，读一张纹理写一张纹理
+    auto add_post_pass = [&](const std::string& name, utils::RenderGraphTexture source,
+                             utils::RenderGraphTexture target, int mode, glm::vec2 direction) {
+      int pass = graph.AddPass(name, [&, source, mode, direction](const utils::RenderPassContext& resources) {
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, resources.texture(source));
+        post_shader.Use();
+        post_shader.SetInt("source", 0);
+        post_shader.SetVec2("direction", direction.x, direction.y);
+        post_shader.SetFloat("threshold", 1.0f);
+        draw_fullscreen(mode);
+      });
+      graph.Read(pass, source);
+      return graph.Write(pass, target);
+    };
+
+    utils::RenderGraphTextureDesc half{std::max(width / 2, 1), std::max(height / 2, 1), GL_RGBA16F};
+    utils::RenderGraphTexture bloom =
+        add_post_pass("bright", hdr, graph.CreateTexture("bright", half), 0, glm::vec2(0.0f));
+    for (int i = 0; i < blur_passes; i++) {
+      std::string suffix = std::to_string(i);
+      bloom = add_post_pass("blur_h" + suffix, bloom, graph.CreateTexture("blur_h" + suffix, half), 1,
+                            glm::vec2(1.0f, 0.0f));
+      bloom = add_post_pass("blur_v" + suffix, bloom, graph.CreateTexture("blur_v" + suffix, half), 1,
+                            glm::vec2(0.0f, 1.0f));
+    }
+
+    // 深度可视化只有在--show-depth时被合成读取，否则整个pass和它的输出都被剔除
+    utils::RenderGraphTexture depth_view =
+        add_post_pass("depth_view", depth, graph.CreateTexture("depth_view", {width, height, GL_RGBA8}), 3,
+                      glm::vec2(0.0f));
+
+    int composite_pass = graph.AddPass("composite", [&, hdr, bloom, depth_view](const utils::RenderPassContext& pass) {
+      glDisable(GL_DEPTH_TEST);
+      glDisable(GL_CULL_FACE);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, pass.texture(show_depth ? depth_view : hdr));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, pass.texture(bloom));
+      post_shader.Use();
+      post_shader.SetInt("source", 0);
+      post_shader.SetInt("bloom", 1);
+      draw_fullscreen(show_depth ? 4 : 2);
+      glActiveTexture(GL_TEXTURE0);
+    });
+    graph.Read(composite_pass, show_depth ? depth_view : hdr);
+    graph.Read(composite_pass, bloom);
+    graph.Write(composite_pass, backbuffer);
+
+    auto compile_start = std::chrono::steady_clock::now();
+    bool compiled = graph.Compile();
+    compile_ms.push_back(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compile_start).count());
+    if (!compiled) {
+      return -1;
+    }
+    if (!described) {
+      std::cout << graph.Describe() << std::endl;
+      described = true;
+    }
+    graph.Execute();
+
+    context.EndFrame();
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      const utils::RenderGraphStats& stats = graph.stats();
+      std::string title = "Render Graph - transient " + std::to_string(stats.bytes_with_aliasing / (1024 * 1024)) +
+                          " MB (" + std::to_string(stats.bytes_without_aliasing / (1024 * 1024)) +
+                          " MB without aliasing)";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  const utils::RenderGraphStats& stats = graph.stats();
+  utils::PercentileSummary compile = utils::Summarize(compile_ms);
+  std::cout << "compile avg/p99: " << compile.avg_ms << " / " << compile.p99_ms << " ms, " << stats.pass_count
+            << " passes, " << stats.culled_passes << " culled" << std::endl;
+  std::cout << "transient memory: " << stats.bytes_without_aliasing / 1024 << " KB without aliasing, "
+            << stats.bytes_with_aliasing / 1024 << " KB with aliasing, peak live " << stats.peak_live_bytes / 1024
+            << " KB (" << stats.transient_textures << " textures -> " << stats.physical_textures << ")" << std::endl;
+
+  graph.ReleaseTextures();
+  glDeleteVertexArrays(4, vaos);
+  glDeleteBuffers(3, buffers);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+// Z键切换深度显示，显示时深度可视化的pass不再被剔除，初始值来自--show-depth
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+    show_depth = !show_depth;
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string, std::string, std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.11render_graph.vs").string(),
+    path.parent_path().append("1.11render_graph.fs").string(),
+    path.parent_path().append("1.11render_graph_depth.fs").string(),
+    std::filesystem::path(RESOURCE_DIR).append("shaders").append("fullscreen.vs").string(),
+    path.parent_path().append("1.11render_graph_post.fs").string(),
+  };
+}
@@ -0,0 +1,39 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 WorldPos;
+in vec3 Normal;
+in vec4 LightSpacePos;
+
+uniform vec3 color;
+uniform vec3 emission;
+uniform vec3 lightDirection;
+uniform sampler2D shadowMap;
+
+// 3x3 PCF，深度比较在着色器里做
+float ShadowFactor(vec3 normal)
+{
+    vec3 coord = LightSpacePos.xyz / LightSpacePos.w * 0.5 + 0.5;
+    if (coord.z > 1.0) {
+        return 1.0;
+    }
+    float bias = max(0.002 * (1.0 - dot(normal, -lightDirection)), 0.0005);
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            float depth = texture(shadowMap, coord.xy + vec2(x, y) * texel).r;
+            lit += coord.z - bias > depth ? 0.0 : 1.0;
+        }
+    }
+    return lit / 9.0;
+}
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    float diffuse = max(dot(normal, -lightDirection), 0.0);
+    // 输出HDR颜色，太阳的亮度大于1，亮的部分由后处理提取做泛光
+    vec3 lighting = color * (0.15 + 2.5 * diffuse * ShadowFactor(normal));
+    FragColor = vec4(lighting + emission, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+// 后处理：0提取亮部，1高斯模糊，2合成并色调映射，3线性化深度，4复制
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform int mode;
+uniform sampler2D source;
+uniform sampler2D bloom;
+uniform vec2 direction;
+uniform float threshold;
+
+void main()
+{
+    if (mode == 0) {
+        vec3 color = texture(source, TexCoord).rgb;
+        float brightness = max(max(color.r, color.g), color.b);
+        FragColor = vec4(color * max(brightness - threshold, 0.0) / max(brightness, 1e-4), 1.0);
+    } else if (mode == 1) {
+        const float weights[5] = float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+        vec2 step = direction / vec2(textureSize(source, 0));
+        vec3 result = texture(source, TexCoord).rgb * weights[0];
+        for (int i = 1; i < 5; i++) {
+            result += texture(source, TexCoord + step * float(i)).rgb * weights[i];
+            result += texture(source, TexCoord - step * float(i)).rgb * weights[i];
+        }
+        FragColor = vec4(result, 1.0);
+    } else if (mode == 2) {
+        vec3 color = texture(source, TexCoord).rgb + texture(bloom, TexCoord).rgb;
+        color = color / (color + 1.0);
+        FragColor = vec4(pow(color, vec3(1.0 / 2.2)), 1.0);
+    } else if (mode == 3) {
+        float depth = texture(source, TexCoord).r * 2.0 - 1.0;
+        float linear = 2.0 * 0.1 * 200.0 / (200.0 + 0.1 - depth * (200.0 - 0.1));
+        FragColor = vec4(vec3(linear / 200.0), 1.0);
+    } else {
+        FragColor = vec4(texture(source, TexCoord).rgb, 1.0);
+    }
+}
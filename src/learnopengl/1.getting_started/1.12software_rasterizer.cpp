@@ -0,0 +1,376 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/fps_camera.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/gl_util.h"
+#include "utils/shader.h"
+#include "utils/soft_rasterizer.h"
+#include "utils/thread_pool.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+static std::tuple<std::string, std::string> GetTexturePaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+static float delta_time = 0.0f;
+static bool show_software = false;
+
+using Clock = std::chrono::steady_clock;
+
+// 与GL比较时通道差超过这个值的像素算作不同，双线性权重的精度和边上的填充差异都在这之内
+static constexpr int kChannelTolerance = 8;
+
+// 用GL和软件光栅化渲染1.3fps_camera的场景，逐帧比较结果并统计两边的耗时。
+// --cubes N 在原场景的10个立方体之外随机摆放更多立方体；--threads N 软件光栅化的线程数（0为硬件线程数）；
+// --kernel scalar|avx2；--show-software 显示软件光栅化的结果；--max-diff F 不同像素的比例超过F时返回非0
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Software Rasterizer";
+  int cube_count = 10;
+  unsigned thread_count = 0;
+  utils::RasterKernel kernel = utils::BestRasterKernel();
+  double max_diff = 0.01;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--cubes" && i + 1 < argc) {
+      cube_count = std::max(std::stoi(argv[++i]), 1);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      thread_count = static_cast<unsigned>(std::stoi(argv[++i]));
+    } else if (arg == "--kernel" && i + 1 < argc) {
+      kernel = std::string(argv[++i]) == "scalar" ? utils::RasterKernel::kScalar : utils::RasterKernel::kAvx2;
+    } else if (arg == "--show-software") {
+      show_software = true;
+    } else if (arg == "--max-diff" && i + 1 < argc) {
+      max_diff = std::stod(argv[++i]);
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+    glfwSetKeyCallback(window, KeyCallback);
+  }
+
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  // 1.3fps_camera的立方体顶点，去掉重复的(位置, 纹理坐标)后得到索引
+  float cube[] = {
+    -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,  0.5f, -0.5f, -0.5f, 1.0f, 0.0f,  0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,  -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,  -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,  0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 1.0f,  -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,  -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,  -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,  -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,  -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,  0.5f,  0.5f, -0.5f, 1.0f, 1.0f,  0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  0.5f, -0.5f,  0.5f, 0.0f, 0.0f,  0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  0.5f, -0.5f, -0.5f, 1.0f, 1.0f,  0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f, -0.5f,  0.5f, 1.0f, 0.0f,  -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,  -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,  0.5f,  0.5f, -0.5f, 1.0f, 1.0f,  0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,  -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,  -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+  };
+  std::vector<utils::SoftVertex> vertices;
+  std::vector<uint32_t> indices;
+  std::map<std::vector<float>, uint32_t> unique_vertices;
+  for (size_t i = 0; i < sizeof(cube) / sizeof(float); i += 5) {
+    std::vector<float> key(cube + i, cube + i + 5);
+    auto [it, inserted] = unique_vertices.emplace(key, static_cast<uint32_t>(vertices.size()));
+    if (inserted) {
+      vertices.push_back({glm::vec3(key[0], key[1], key[2]), glm::vec2(key[3], key[4])});
+    }
+    indices.push_back(it->second);
+  }
+
+  std::vector<glm::vec3> cube_positions = {
+    glm::vec3(0.0f, 0.0f, 0.0f),
+    glm::vec3(2.0f, 5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f, 3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f, 2.0f, -2.5f),
+    glm::vec3( 1.5f, 0.2f, -1.5f),
+    glm::vec3(-1.3f, 1.0f, -1.5f)
+  };
+  std::vector<glm::mat4> cube_models;
+  std::mt19937 rng(12);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  for (int i = 0; i < cube_count; i++) {
+    glm::vec3 position = i < static_cast<int>(cube_positions.size())
+                             ? cube_positions[i]
+                             : glm::vec3(unit(rng) * 12.0f, unit(rng) * 8.0f, -22.0f + unit(rng) * 18.0f);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+    model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+    cube_models.push_back(model);
+  }
+
+  GLuint vao = 0;
+  GLuint buffers[2] = {0, 0};
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(2, buffers);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(utils::SoftVertex), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(utils::SoftVertex), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(utils::SoftVertex),
+                        (void*)offsetof(utils::SoftVertex, tex_coord));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+
+  auto [container_path, face_path] = GetTexturePaths();
+  GLuint texture1 = utils::LoadTexture(container_path, GL_RGB, GL_RGB, true);
+  GLuint texture2 = utils::LoadTexture(face_path, GL_RGBA, GL_RGBA, true);
+  // 软件光栅化只有双线性过滤，GL也不用多级渐远纹理，结果才能逐像素比较
+  for (GLuint texture : {texture1, texture2}) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  }
+  utils::SoftTexture soft_texture1;
+  utils::SoftTexture soft_texture2;
+  if (!utils::LoadSoftTexture(container_path, true, &soft_texture1) ||
+      !utils::LoadSoftTexture(face_path, true, &soft_texture2)) {
+    return -1;
+  }
+  utils::SoftMaterial material;
+  material.texture1 = &soft_texture1;
+  material.texture2 = &soft_texture2;
+
+  utils::ThreadPool pool(thread_count);
+  utils::SoftRasterizer rasterizer;
+  rasterizer.set_kernel(kernel);
+  if (!rasterizer.Init(context.width(), context.height(), &pool)) {
+    return -1;
+  }
+
+  // 显示软件光栅化的结果时上传到纹理，再blit到输出帧缓冲
+  GLuint software_texture = 0;
+  GLuint software_framebuffer = 0;
+  glGenTextures(1, &software_texture);
+  glBindTexture(GL_TEXTURE_2D, software_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rasterizer.width(), rasterizer.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               nullptr);
+  glGenFramebuffers(1, &software_framebuffer);
+  GLint output_framebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, software_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, software_texture, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output_framebuffer));
+
+  glEnable(GL_DEPTH_TEST);
+  glm::vec4 clear_color(0.2f, 0.3f, 0.4f, 1.0f);
+
+  std::vector<double> gl_ms;
+  std::vector<double> software_ms;
+  std::vector<double> raster_ms;
+  std::vector<uint8_t> gl_pixels;
+  std::vector<uint8_t> software_pixels;
+  double worst_diff = 0.0;
+  double error_sum = 0.0;
+  size_t compared = 0;
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头左右摆动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(std::sin(current_time) * delta_time * 200.0f, 0.0f);
+    }
+    camera.SetAspect((float)context.width() / (float)context.height());
+    glm::mat4 view_projection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+    // GL的时间包括等待llvmpipe画完
+    glFinish();
+    auto gl_start = Clock::now();
+    glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    shader.Use();
+    shader.SetInt("texture1", 0);
+    shader.SetInt("texture2", 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, texture2);
+    glActiveTexture(GL_TEXTURE0);
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+    glBindVertexArray(vao);
+    for (const glm::mat4& model : cube_models) {
+      shader.SetMat4("model", model);
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+    }
+    glFinish();
+    gl_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - gl_start).count());
+
+    auto software_start = Clock::now();
+    rasterizer.BeginFrame(clear_color);
+    for (const glm::mat4& model : cube_models) {
+      rasterizer.Draw(vertices, indices, view_projection * model, material);
+    }
+    rasterizer.EndFrame();
+    software_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - software_start).count());
+    raster_ms.push_back(rasterizer.stats().raster_ms);
+
+    gl_pixels.resize(static_cast<size_t>(rasterizer.width()) * rasterizer.height() * 4);
+    glReadPixels(0, 0, rasterizer.width(), rasterizer.height(), GL_RGBA, GL_UNSIGNED_BYTE, gl_pixels.data());
+    rasterizer.ReadPixels(&software_pixels);
+    size_t different = 0;
+    for (size_t i = 0; i < gl_pixels.size(); i += 4) {
+      int max_delta = 0;
+      for (size_t c = 0; c < 3; c++) {
+        int delta = std::abs(static_cast<int>(gl_pixels[i + c]) - static_cast<int>(software_pixels[i + c]));
+        max_delta = std::max(max_delta, delta);
+        error_sum += delta;
+      }
+      different += max_delta > kChannelTolerance ? 1 : 0;
+    }
+    compared += gl_pixels.size() / 4 * 3;
+    worst_diff = std::max(worst_diff, static_cast<double>(different) / (gl_pixels.size() / 4));
+
+    if (show_software) {
+      glBindTexture(GL_TEXTURE_2D, software_texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rasterizer.width(), rasterizer.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                      software_pixels.data());
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output_framebuffer);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, software_framebuffer);
+      glBlitFramebuffer(0, 0, rasterizer.width(), rasterizer.height(), 0, 0, context.width(), context.height(),
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+      glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output_framebuffer));
+    }
+
+    context.EndFrame();
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = std::string("Software Rasterizer - ") + (show_software ? "software " : "GL ") +
+                          std::to_string(software_ms.back()) + " ms vs GL " + std::to_string(gl_ms.back()) + " ms";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  utils::PercentileSummary gl = utils::Summarize(gl_ms);
+  utils::PercentileSummary software = utils::Summarize(software_ms);
+  utils::PercentileSummary raster = utils::Summarize(raster_ms);
+  const utils::SoftRasterStats& stats = rasterizer.stats();
+  std::cout << "software (" << utils::RasterKernelName(kernel) << ", " << pool.thread_count()
+            << " threads) avg/p50/p99: " << software.avg_ms << " / " << software.p50_ms << " / " << software.p99_ms
+            << " ms, raster avg " << raster.avg_ms << " ms" << std::endl;
+  std::cout << "gl avg/p50/p99: " << gl.avg_ms << " / " << gl.p50_ms << " / " << gl.p99_ms << " ms" << std::endl;
+  std::cout << "last frame: " << stats.triangles << " triangles (" << stats.clipped_triangles << " clipped), "
+            << stats.bin_entries << " bin entries" << std::endl;
+  std::cout << "difference: worst frame " << worst_diff * 100.0 << "% pixels off by more than " << kChannelTolerance
+            << ", mean channel error " << (compared > 0 ? error_sum / compared : 0.0) << std::endl;
+
+  glDeleteFramebuffers(1, &software_framebuffer);
+  glDeleteTextures(1, &software_texture);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(2, buffers);
+  glDeleteTextures(1, &texture1);
+  glDeleteTextures(1, &texture2);
+  if (worst_diff > max_diff) {
+    std::cerr << "Software output differs from GL in more than " << max_diff * 100.0 << "% of pixels" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time);
+  }
+}
+
+// 空格键在GL和软件光栅化的结果之间切换，初始值来自--show-software
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+    show_software = !show_software;
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  // 与1.3fps_camera使用相同的着色器
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.3fps_camera.vs").string(),
+    path.parent_path().append("1.3fps_camera.fs").string(),
+  };
+}
+
+static std::tuple<std::string, std::string> GetTexturePaths() {
+  return {
+    std::filesystem::path(RESOURCE_DIR).append("textures").append("container.jpg").string(),
+    std::filesystem::path(RESOURCE_DIR).append("textures").append("awesomeface.png").string(),
+  };
+}
@@ -0,0 +1,361 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/batch_renderer.h"
+#include "utils/bvh.h"
+#include "utils/camera_recorder.h"
+#include "utils/fps_camera.h"
+#include "utils/gl_context.h"
+#include "utils/gl_util.h"
+#include "utils/shader.h"
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+static std::tuple<std::string, std::string> GetTexturePaths();
+static std::vector<utils::CameraPose> OrbitPoses(int count);
+
+using Clock = std::chrono::steady_clock;
+
+// 加载一次1.3fps_camera的场景，按视角列表批量渲染缩略图。
+// --poses FILE 视角列表（每行"x y z yaw pitch zoom"），没有时用 --views N 生成环绕场景的视角，--save-poses FILE 保存；
+// --mode sequential|layered，--batch N 纹理数组的层数，--thumb WxH 缩略图大小；
+// --out DIR 每个视角写一张PNG，--raw FILE 把所有图片按顺序写成一个自上而下的RGBA8流（可以是管道），都没有时只渲染；
+// --per-process N 再以每个进程渲染一张图的方式启动自身N次，对比每秒图片数；--only I 只渲染第I个视角（子进程使用）。
+// 例如：1.13batch_render --headless --views 256 --out previews --per-process 16
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Batch Render";
+  utils::BatchRenderOptions batch_options;
+  std::string poses_path;
+  std::string save_poses_path;
+  std::string out_dir;
+  std::string raw_path;
+  int view_count = 64;
+  int per_process = 0;
+  int only = -1;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--poses" && i + 1 < argc) {
+      poses_path = argv[++i];
+    } else if (arg == "--save-poses" && i + 1 < argc) {
+      save_poses_path = argv[++i];
+    } else if (arg == "--views" && i + 1 < argc) {
+      view_count = std::max(std::stoi(argv[++i]), 1);
+    } else if (arg == "--mode" && i + 1 < argc) {
+      batch_options.mode = std::string(argv[++i]) == "sequential" ? utils::BatchTargetMode::kSequential
+                                                                  : utils::BatchTargetMode::kLayered;
+    } else if (arg == "--batch" && i + 1 < argc) {
+      batch_options.batch_size = std::stoi(argv[++i]);
+    } else if (arg == "--thumb" && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &batch_options.width, &batch_options.height) != 2) {
+        std::cerr << "Invalid --thumb value, expected WxH" << std::endl;
+        return -1;
+      }
+    } else if (arg == "--out" && i + 1 < argc) {
+      out_dir = argv[++i];
+    } else if (arg == "--raw" && i + 1 < argc) {
+      raw_path = argv[++i];
+    } else if (arg == "--per-process" && i + 1 < argc) {
+      per_process = std::max(std::stoi(argv[++i]), 0);
+    } else if (arg == "--only" && i + 1 < argc) {
+      only = std::stoi(argv[++i]);
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  std::vector<utils::CameraPose> poses;
+  if (!poses_path.empty()) {
+    if (!utils::LoadCameraPoses(poses_path, &poses)) {
+      return -1;
+    }
+  } else {
+    poses = OrbitPoses(view_count);
+  }
+  if (!save_poses_path.empty() && !utils::SaveCameraPoses(save_poses_path, poses)) {
+    return -1;
+  }
+  if (only >= 0) {
+    if (only >= static_cast<int>(poses.size())) {
+      std::cerr << "--only " << only << " out of range, " << poses.size() << " poses" << std::endl;
+      return -1;
+    }
+    poses = { poses[only] };
+  }
+  if (poses.empty()) {
+    std::cerr << "No camera poses to render" << std::endl;
+    return -1;
+  }
+  if (!out_dir.empty()) {
+    std::filesystem::create_directories(out_dir);
+  }
+
+  // 进程启动之后的所有工作都计入单张图的耗时：创建上下文、编译着色器、加载纹理
+  auto start = Clock::now();
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  float vertices[] = {
+    -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+    0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+    0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+    0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+    0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, 0.0f, 1.0f
+  };
+
+  std::vector<glm::vec3> cube_positions = {
+    glm::vec3(0.0f, 0.0f, 0.0f),
+    glm::vec3(2.0f, 5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f, 3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f, 2.0f, -2.5f),
+    glm::vec3( 1.5f, 0.2f, -1.5f),
+    glm::vec3(-1.3f, 1.0f, -1.5f)
+  };
+
+  std::vector<glm::mat4> cube_models;
+  std::vector<utils::Aabb> cube_bounds;
+  for (int i = 0; i < cube_positions.size(); i++) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, cube_positions[i]);
+    model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+    cube_models.push_back(model);
+    cube_bounds.push_back(utils::TransformAabb(utils::Aabb(glm::vec3(-0.5f), glm::vec3(0.5f)), model));
+  }
+
+  utils::StaticBvh cube_bvh;
+  cube_bvh.Build(cube_bounds);
+  std::vector<uint32_t> visible_cubes;
+
+  glEnable(GL_DEPTH_TEST);
+
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  GLuint vbo = 0;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  auto [container_path, face_path] = GetTexturePaths();
+  GLuint texture1 = utils::LoadTexture(container_path, GL_RGB, GL_RGB, true);
+  GLuint texture2 = utils::LoadTexture(face_path, GL_RGBA, GL_RGBA, true);
+
+  utils::BatchRenderer renderer;
+  if (!renderer.Init(batch_options)) {
+    return -1;
+  }
+
+  // 所有视角共用的状态只设置一次，每个视角只更新相机矩阵
+  shader.Use();
+  shader.SetInt("texture1", 0);
+  shader.SetInt("texture2", 1);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture1);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, texture2);
+  glBindVertexArray(vao);
+
+  auto draw = [&](utils::FpsCamera* camera) {
+    shader.SetMat4("projection", camera->GetProjectionMatrix());
+    shader.SetMat4("view", camera->GetViewMatrix());
+    visible_cubes.clear();
+    cube_bvh.QueryFrustum(camera->GetFrustum(), &visible_cubes);
+    for (uint32_t i : visible_cubes) {
+      shader.SetMat4("model", cube_models[i]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+  };
+
+  FILE* raw_file = nullptr;
+  if (!raw_path.empty()) {
+    raw_file = fopen(raw_path.c_str(), "wb");
+    if (raw_file == nullptr) {
+      std::cerr << "Failed to open " << raw_path << std::endl;
+      return -1;
+    }
+  }
+  size_t row_bytes = static_cast<size_t>(renderer.width()) * 4;
+  auto sink = [&](size_t index, const std::vector<uint8_t>& rgba) {
+    size_t view = only >= 0 ? static_cast<size_t>(only) : index;
+    if (!out_dir.empty()) {
+      char name[32];
+      snprintf(name, sizeof(name), "view_%05zu.png", view);
+      std::string path = (std::filesystem::path(out_dir) / name).string();
+      if (!utils::WriteImagePng(path, renderer.width(), renderer.height(), rgba.data())) {
+        return false;
+      }
+    }
+    if (raw_file != nullptr) {
+      // 流中的图片自上而下，可以直接交给其他工具，如 ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i FILE
+      for (int y = renderer.height() - 1; y >= 0; y--) {
+        if (fwrite(rgba.data() + y * row_bytes, 1, row_bytes, raw_file) != row_bytes) {
+          std::cerr << "Failed to write " << raw_path << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  double setup_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  bool ok = renderer.Render(poses, draw, sink);
+  if (raw_file != nullptr) {
+    fclose(raw_file);
+  }
+
+  renderer.Release();
+  glBindVertexArray(0);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteTextures(1, &texture1);
+  glDeleteTextures(1, &texture2);
+  if (!ok) {
+    return 1;
+  }
+  if (only >= 0) {
+    return 0;
+  }
+
+  const utils::BatchRenderStats& stats = renderer.stats();
+  const char* mode = batch_options.mode == utils::BatchTargetMode::kSequential ? "sequential" : "layered";
+  std::cout << "batch (" << mode << ", " << renderer.width() << "x" << renderer.height() << "): " << stats.images
+            << " images in " << stats.batches << " batches, setup " << setup_ms << " ms, total " << stats.total_ms
+            << " ms, " << stats.images_per_second() << " images/s" << std::endl;
+  std::cout << "  render " << stats.render_ms << " ms, readback " << stats.readback_ms << " ms, queue wait "
+            << stats.queue_wait_ms << " ms, writer " << stats.write_ms << " ms" << std::endl;
+
+  if (per_process == 0) {
+    return 0;
+  }
+
+  // 每个子进程做完整的一次启动：创建上下文、加载场景、渲染并写出一张图。视角列表通过文件传给子进程
+  std::string child_poses = (std::filesystem::temp_directory_path() / "batch_render_poses.txt").string();
+  if (!utils::SaveCameraPoses(child_poses, poses)) {
+    return -1;
+  }
+  std::string command = "\"" + std::string(argv[0]) + "\" --poses \"" + child_poses + "\" --thumb " +
+                        std::to_string(renderer.width()) + "x" + std::to_string(renderer.height());
+  if (context.headless()) {
+    command += " --headless";
+  }
+  if (!out_dir.empty()) {
+    command += " --out \"" + out_dir + "\"";
+  }
+  int process_count = std::min(per_process, static_cast<int>(poses.size()));
+  auto process_start = Clock::now();
+  for (int i = 0; i < process_count; i++) {
+    if (std::system((command + " --only " + std::to_string(i)).c_str()) != 0) {
+      std::cerr << "Child process failed for view " << i << std::endl;
+      return 1;
+    }
+  }
+  double process_ms = std::chrono::duration<double, std::milli>(Clock::now() - process_start).count();
+  double process_rate = process_count * 1000.0 / process_ms;
+  // 批量的速率也算上一次性的启动开销
+  double batch_rate = stats.images * 1000.0 / (setup_ms + stats.total_ms);
+  std::cout << "per-process: " << process_count << " images in " << process_ms << " ms, " << process_rate
+            << " images/s; batch including setup " << batch_rate << " images/s, " << batch_rate / process_rate
+            << "x faster" << std::endl;
+  return 0;
+}
+
+// 环绕场景中心的视角，高度、距离和视野依次变化，都朝向中心
+static std::vector<utils::CameraPose> OrbitPoses(int count) {
+  const glm::vec3 center(0.0f, 0.0f, -5.0f);
+  std::vector<utils::CameraPose> poses;
+  for (int i = 0; i < count; i++) {
+    float angle = glm::radians(360.0f * static_cast<float>(i) / static_cast<float>(count));
+    float radius = 9.0f + 3.0f * std::sin(angle * 3.0f);
+    utils::CameraPose pose;
+    pose.position = center + glm::vec3(radius * std::cos(angle), 4.0f * std::sin(angle * 2.0f),
+                                       radius * std::sin(angle));
+    glm::vec3 direction = glm::normalize(center - pose.position);
+    pose.yaw = glm::degrees(std::atan2(direction.z, direction.x));
+    pose.pitch = glm::degrees(std::asin(direction.y));
+    pose.zoom = 35.0f + 10.0f * std::cos(angle * 5.0f);
+    poses.push_back(pose);
+  }
+  return poses;
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.3fps_camera.vs").string(),
+    path.parent_path().append("1.3fps_camera.fs").string(),
+  };
+}
+
+static std::tuple<std::string, std::string> GetTexturePaths() {
+  return {
+    std::filesystem::path(RESOURCE_DIR).append("textures").append("container.jpg").string(),
+    std::filesystem::path(RESOURCE_DIR).append("textures").append("awesomeface.png").string(),
+  };
+}
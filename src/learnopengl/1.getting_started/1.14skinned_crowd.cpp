@@ -0,0 +1,312 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/animation_clip.h"
+#include "utils/animation_import.h"
+#include "utils/fps_camera.h"
+#include "utils/gl_context.h"
+#include "utils/shader.h"
+#include "utils/skeleton.h"
+#include "utils/skinning.h"
+#include "utils/thread_pool.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+
+using Clock = std::chrono::steady_clock;
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 18.0f, 48.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -25.0f);
+static float delta_time = 0.0f;
+
+static constexpr int kTentacleJoints = 6;
+static constexpr float kSegmentLength = 0.5f;
+static constexpr int kRingsPerSegment = 4;
+static constexpr int kSides = 12;
+static constexpr float kSpacing = 1.5f;
+static constexpr GLuint kSkinningUnit = 0;
+
+// 一串关节竖直排列的触手：关节i在y = i * kSegmentLength，每个顶点由相邻的两个关节按高度线性混合
+static void BuildTentacle(utils::Skeleton* skeleton, utils::SkinnedMeshData* mesh) {
+  skeleton->bind_pose.Resize(kTentacleJoints);
+  for (int i = 0; i < kTentacleJoints; i++) {
+    skeleton->joint_names.push_back("segment" + std::to_string(i));
+    skeleton->parents.push_back(static_cast<int16_t>(i - 1));
+    float y = i == 0 ? 0.0f : kSegmentLength;
+    skeleton->bind_pose.Set(i, glm::vec3(0.0f, y, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+    utils::Matrix3x4 inverse_bind = { { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+                                        glm::vec4(0.0f, 1.0f, 0.0f, -i * kSegmentLength),
+                                        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) } };
+    skeleton->inverse_bind.push_back(inverse_bind);
+  }
+
+  int rings = kTentacleJoints * kRingsPerSegment + 1;
+  float height = kTentacleJoints * kSegmentLength;
+  for (int ring = 0; ring < rings; ring++) {
+    float y = height * ring / (rings - 1);
+    float radius = 0.35f * (1.0f - 0.8f * y / height);
+    float segment = std::min(y / kSegmentLength, kTentacleJoints - 1.0f);
+    auto lower = static_cast<uint32_t>(segment);
+    uint32_t joints[2] = { lower, std::min<uint32_t>(lower + 1, kTentacleJoints - 1) };
+    float weights[2] = { 1.0f - (segment - lower), segment - lower };
+    for (int side = 0; side <= kSides; side++) {
+      float angle = 6.2831853f * side / kSides;
+      utils::SkinnedVertex vertex;
+      vertex.normal = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+      vertex.position = glm::vec3(0.0f, y, 0.0f) + vertex.normal * radius;
+      vertex.uv = glm::vec2(static_cast<float>(side) / kSides, y / height);
+      utils::QuantizeWeights(joints, weights, 2, &vertex);
+      mesh->vertices.push_back(vertex);
+    }
+  }
+  for (int ring = 0; ring + 1 < rings; ring++) {
+    for (int side = 0; side < kSides; side++) {
+      uint32_t a = ring * (kSides + 1) + side;
+      uint32_t b = a + kSides + 1;
+      mesh->indices.insert(mesh->indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+    }
+  }
+}
+
+// 每个关节绕axis摆动，相邻关节错开相位，形成沿触手传播的波。时长为周期的整数倍，循环时首尾相接
+static utils::RawAnimation BuildWave(const std::string& name, const glm::vec3& axis, float amplitude, float period,
+                                     float duration) {
+  constexpr float kKeyRate = 30.0f;
+  utils::RawAnimation raw;
+  raw.name = name;
+  raw.duration = duration;
+  raw.tracks.resize(kTentacleJoints);
+  auto key_count = static_cast<int>(duration * kKeyRate) + 1;
+  for (int joint = 1; joint < kTentacleJoints; joint++) {
+    utils::RawJointTrack& track = raw.tracks[joint];
+    for (int k = 0; k < key_count; k++) {
+      float t = k / kKeyRate;
+      float angle = amplitude * std::sin(6.2831853f * t / period - joint * 0.7f);
+      track.rotation_times.push_back(t);
+      track.rotations.push_back(glm::angleAxis(angle, axis));
+    }
+  }
+  return raw;
+}
+
+// 默认画--count个程序生成的触手，每个在两段动画之间混合；--model PATH 用Assimp读取带骨骼的模型及其动画，
+// --model-scale S 缩放模型。例如：1.14skinned_crowd --headless --frames 300 --fixed-dt --count 1000
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Skinned Crowd";
+  int count = 1000;
+  std::string model_path;
+  float model_scale = 1.0f;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--count" && i + 1 < argc) {
+      count = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--model" && i + 1 < argc) {
+      model_path = argv[++i];
+    } else if (arg == "--model-scale" && i + 1 < argc) {
+      model_scale = std::stof(argv[++i]);
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  utils::Shader::AddIncludeDirectory(std::filesystem::path(RESOURCE_DIR).append("shaders").string());
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  utils::Skeleton skeleton;
+  utils::SkinnedMeshData mesh_data;
+  std::vector<utils::RawAnimation> raw_animations;
+  if (model_path.empty()) {
+    BuildTentacle(&skeleton, &mesh_data);
+    raw_animations.push_back(BuildWave("sway", glm::vec3(0.0f, 0.0f, 1.0f), 0.35f, 2.0f, 2.0f));
+    raw_animations.push_back(BuildWave("curl", glm::normalize(glm::vec3(1.0f, 0.0f, 0.5f)), 0.5f, 1.5f, 3.0f));
+  } else if (!utils::ImportSkinnedModel(model_path, &mesh_data, &skeleton, &raw_animations)) {
+    return -1;
+  }
+
+  utils::AnimationCompressionOptions compression;
+  std::vector<utils::AnimationClip> clips(raw_animations.size());
+  for (size_t i = 0; i < clips.size(); i++) {
+    if (!utils::CompressAnimation(raw_animations[i], skeleton, compression, &clips[i])) {
+      return -1;
+    }
+    std::cout << "clip " << clips[i].name() << ": " << clips[i].duration() << " s, " << clips[i].key_count()
+              << " keys, " << raw_animations[i].memory_bytes() << " -> " << clips[i].memory_bytes() << " bytes"
+              << std::endl;
+  }
+
+  utils::SkinnedMesh mesh;
+  utils::SkinningBuffer skinning_buffer;
+  size_t joint_count = skeleton.joint_count();
+  if (!mesh.Init(mesh_data) || !skinning_buffer.Init(count * joint_count)) {
+    return -1;
+  }
+
+  // 角色排成方阵，各自的播放进度、混合相位和颜色不同
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  auto columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+  std::vector<glm::vec4> instance_data(count);
+  std::vector<utils::AnimationInstance> instances(count);
+  std::vector<float> blend_phases(count);
+  int clip_count = static_cast<int>(clips.size());
+  for (int i = 0; i < count; i++) {
+    float x = (i % columns - columns * 0.5f + 0.5f) * kSpacing;
+    float z = (i / columns - columns * 0.5f + 0.5f) * kSpacing;
+    instance_data[i] = glm::vec4(x, 0.0f, z, unit(rng));
+    utils::AnimationInstance& instance = instances[i];
+    instance.clip = clip_count > 0 ? i % clip_count : -1;
+    instance.blend_clip = clip_count > 1 ? (i + 1) % clip_count : -1;
+    instance.time = unit(rng) * 10.0f;
+    instance.blend_time = unit(rng) * 10.0f;
+    blend_phases[i] = unit(rng) * 6.2831853f;
+  }
+
+  GLuint instance_buffer = 0;
+  glGenBuffers(1, &instance_buffer);
+  glBindVertexArray(mesh.vao());
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+  glBufferData(GL_ARRAY_BUFFER, instance_data.size() * sizeof(glm::vec4), instance_data.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(utils::SkinnedMesh::kFirstInstanceAttribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4),
+                        (void*)0);
+  glEnableVertexAttribArray(utils::SkinnedMesh::kFirstInstanceAttribute);
+  glVertexAttribDivisor(utils::SkinnedMesh::kFirstInstanceAttribute, 1);
+  glBindVertexArray(0);
+
+  glEnable(GL_DEPTH_TEST);
+
+  std::vector<utils::Matrix3x4> skinning(count * joint_count);
+  utils::CrowdAnimator animator;
+  utils::ThreadPool pool;
+  double animate_ms = 0.0;
+  double upload_ms = 0.0;
+  int frames = 0;
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 300.0f);
+
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    }
+
+    auto start = Clock::now();
+    for (int i = 0; i < count; i++) {
+      utils::AnimationInstance& instance = instances[i];
+      instance.time += delta_time;
+      instance.blend_time += delta_time;
+      instance.blend_weight = 0.5f + 0.5f * std::sin(current_time * 0.7f + blend_phases[i]);
+    }
+    animator.Update(skeleton, clips, instances.data(), instances.size(), &pool, skinning.data());
+    auto animated = Clock::now();
+    skinning_buffer.Upload(skinning.data(), skinning.size());
+    animate_ms += std::chrono::duration<double, std::milli>(animated - start).count();
+    upload_ms += std::chrono::duration<double, std::milli>(Clock::now() - animated).count();
+    frames++;
+
+    glClearColor(0.5, 0.6, 0.7, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+    shader.SetVec3("lightDirection", glm::normalize(glm::vec3(0.4f, -1.0f, -0.3f)));
+    shader.SetFloat("modelScale", model_scale);
+    shader.SetInt("jointCount", static_cast<int>(joint_count));
+    shader.SetInt("skinMatrices", kSkinningUnit);
+    skinning_buffer.Bind(kSkinningUnit);
+    mesh.DrawInstanced(count);
+
+    context.EndFrame();
+  }
+  context.LogTimingStats();
+  if (frames > 0) {
+    std::cout << count << " characters x " << joint_count << " joints (" << pool.thread_count()
+              << " threads): animation " << animate_ms / frames << " ms/frame, upload " << upload_ms / frames
+              << " ms/frame" << std::endl;
+  }
+
+  glDeleteBuffers(1, &instance_buffer);
+  mesh.Release();
+  skinning_buffer.Release();
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.14skinned_crowd.vs").string(),
+    path.parent_path().append("1.14skinned_crowd.fs").string(),
+  };
+}
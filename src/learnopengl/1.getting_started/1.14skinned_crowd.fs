@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 Color;
+
+uniform vec3 lightDirection;
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    float diffuse = max(dot(normal, -lightDirection), 0.0);
+    FragColor = vec4(Color * (0.3 + 0.7 * diffuse), 1.0);
+}
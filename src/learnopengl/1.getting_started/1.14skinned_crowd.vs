@@ -0,0 +1,26 @@
+#version 330 core
+#include "skinning.glsl"
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uvec4 aJoints;
+layout (location = 4) in vec4 aWeights;
+// 实例属性：xz为角色在地面上的位置，w为颜色的色相
+layout (location = 5) in vec4 aInstance;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float modelScale;
+
+out vec3 Normal;
+out vec3 Color;
+
+void main()
+{
+    mat4 skin = InstanceSkinMatrix(gl_InstanceID, aJoints, aWeights);
+    vec3 pos = (skin * vec4(aPos, 1.0)).xyz * modelScale + vec3(aInstance.x, 0.0, aInstance.z);
+    Normal = mat3(skin) * aNormal;
+    Color = clamp(abs(fract(aInstance.w + vec3(0.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0) - 1.0, 0.0, 1.0) * 0.6 + 0.3;
+    gl_Position = projection * view * vec4(pos, 1.0);
+}
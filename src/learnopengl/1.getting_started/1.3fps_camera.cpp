@@ -1,5 +1,8 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -11,50 +14,79 @@
 #include "utils/shader.h"
 #include "utils/gl_util.h"
 #include "utils/fps_camera.h"
+#include "utils/bvh.h"
+#include "utils/camera_recorder.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/gpu_resources.h"
+#include "utils/transform_batch.h"
 
 static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
-static void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
 static void ProcessInput(GLFWwindow *window);
 static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
 
 static std::tuple<std::string, std::string> GetShaderPaths();
 static std::tuple<std::string, std::string> GetTexturePaths();
 
-static int window_width = 800;
-static int window_height = 600;
+struct ReplayOptions {
+  std::string record_path;
+  std::string replay_path;
+  std::string baseline_path;
+  bool write_baseline = false;
+  double threshold = 0.1;
+  double min_delta_ms = 0.05;
+  int warmup_frames = 5;
+};
+
+static bool ParseReplayOptions(int argc, char** argv, ReplayOptions* options);
 
 static utils::FpsCamera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+static utils::CameraRecorder recorder;
+static bool recording = false;
 static float delta_time = 0.0f;
-static float last_time = 0.0f;
-
-int main() {
-  glfwInit();
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-#ifdef __APPLE__
-  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
-
-  GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Hello Window", nullptr, nullptr);
-  if (window == nullptr) {
-    std::cerr << "Failed to create window" << std::endl;
-    glfwTerminate();
+
+// --record FILE 记录相机输入；--replay FILE 按记录的输入和帧间隔重放，输出帧时间的p50/p95/p99，
+// 配合 --baseline FILE 与基线比较（超出 --threshold 时返回非0），或 --write-baseline 写入新基线。
+// 例如：1.3fps_camera --headless --replay path.crec --baseline path.baseline
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "FPS Camera";
+  ReplayOptions replay_options;
+  if (!utils::ParseContextOptions(argc, argv, &options) || !ParseReplayOptions(argc, argv, &replay_options)) {
     return -1;
   }
 
-  glfwMakeContextCurrent(window);
-  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
-  glfwSetScrollCallback(window, ScrollCallback);
-  glfwSetCursorPosCallback(window, MouseCallback);
-  if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) == GL_FALSE) {
-    std::cerr << "Failed to create load GL" << std::endl;
-    glfwTerminate();
-    return -2;
+  utils::CameraReplay replay;
+  bool replaying = !replay_options.replay_path.empty();
+  if (replaying) {
+    if (!replay.Load(replay_options.replay_path)) {
+      return -1;
+    }
+    if (options.frame_count == 0 || options.frame_count > static_cast<int>(replay.frame_count())) {
+      options.frame_count = static_cast<int>(replay.frame_count());
+    }
+    replay.Reset(&camera);
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
   }
 
-  utils::Shader shader;
+  GLFWwindow* window = context.window();
+  if (window != nullptr && !replaying) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  recording = !replay_options.record_path.empty() && !replaying;
+  if (recording) {
+    recorder.Start(camera);
+  }
+
+  // GL对象都交给上下文的资源池，退出时没有销毁的对象会被报告
+  utils::GpuResources* resources = context.resources();
+  utils::Shader shader(resources);
   auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
   if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
     return -1;
@@ -118,15 +150,33 @@ int main() {
     glm::vec3(-1.3f, 1.0f, -1.5f)
   };
 
+  // 立方体不会移动，预先批量算好模型矩阵和包围盒，建立静态BVH做视锥体剔除
+  utils::TrsArrays cube_trs;
+  cube_trs.Resize(cube_positions.size());
+  glm::vec3 cube_axis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+  for (size_t i = 0; i < cube_positions.size(); i++) {
+    glm::quat rotation = glm::angleAxis(glm::radians(20.0f * i), cube_axis);
+    cube_trs.Set(i, cube_positions[i], rotation, glm::vec3(1.0f));
+  }
+  std::vector<glm::mat4> cube_models(cube_positions.size());
+  utils::ComposeModelMatrices(cube_trs, cube_models.data());
+
+  std::vector<utils::Aabb> cube_bounds;
+  for (const glm::mat4& model : cube_models) {
+    cube_bounds.push_back(utils::TransformAabb(utils::Aabb(glm::vec3(-0.5f), glm::vec3(0.5f)), model));
+  }
+
+  utils::StaticBvh cube_bvh;
+  cube_bvh.Build(cube_bounds);
+  std::vector<uint32_t> visible_cubes;
+
   glEnable(GL_DEPTH_TEST);
 
-  GLuint vao = 0;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+  utils::VertexArrayHandle vao = resources->CreateVertexArray("cube vao");
+  glBindVertexArray(resources->Get(vao));
 
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  utils::BufferHandle vbo = resources->CreateBuffer("cube vertices");
+  glBindBuffer(GL_ARRAY_BUFFER, resources->Get(vbo));
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
   // position attribute
@@ -142,20 +192,26 @@ int main() {
   auto [container_path, face_path] = GetTexturePaths();
 
   // OpenGL要求y轴0.0坐标是在图片的底部的，但是图片的y轴0.0坐标通常在顶部。stb_image.h能够在图像加载时翻转y轴
-  GLuint texture1 = utils::LoadTexture(container_path, GL_RGB, GL_RGB, true);
-  GLuint texture2 = utils::LoadTexture(face_path, GL_RGBA, GL_RGBA, true);
+  utils::TextureHandle texture1 = resources->LoadTexture(container_path, GL_RGB, GL_RGB, true);
+  utils::TextureHandle texture2 = resources->LoadTexture(face_path, GL_RGBA, GL_RGBA, true);
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
-  while (glfwWindowShouldClose(window) == GL_FALSE) {
-    glfwPollEvents();
-
-    auto current_time = static_cast<float>(glfwGetTime());
-    delta_time = current_time - last_time;
-    last_time = current_time;
-
-    ProcessInput(window);
+  utils::FrameTimeRecorder frame_times(replay_options.warmup_frames);
+  while (context.BeginFrame()) {
+    frame_times.BeginFrame();
+    if (replaying) {
+      delta_time = replay.ApplyFrame(context.frame_index(), &camera);
+    } else {
+      delta_time = static_cast<float>(context.delta_time());
+      if (window != nullptr) {
+        ProcessInput(window);
+      }
+      if (recording) {
+        recorder.EndFrame(delta_time);
+      }
+    }
 
     glClearColor(0.2, 0.3, 0.4, 1.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -168,56 +224,149 @@ int main() {
 
     // 根据纹理单元绑定纹理
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
+    glBindTexture(GL_TEXTURE_2D, resources->Get(texture1));
 
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
+    glBindTexture(GL_TEXTURE_2D, resources->Get(texture2));
 
-    glm::mat4 projection = glm::perspective(glm::radians(camera.zoom()), (float)window_width / (float)window_height,
-                                            0.1f, 100.0f);
+    camera.SetAspect((float)context.width() / (float)context.height());
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
 
-    shader.SetMat4("projection", projection);
+    visible_cubes.clear();
+    cube_bvh.QueryFrustum(camera.GetFrustum(), &visible_cubes);
 
-    glm::mat4 view = camera.GetViewMatrix();
-    shader.SetMat4("view", view);
-
-    glBindVertexArray(vao);
-    for (int i = 0; i < cube_positions.size(); i++) {
-      glm::mat4 model = glm::mat4(1.0f);
-      model = glm::translate(model, cube_positions[i]);
-      model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
-      shader.SetMat4("model", model);
+    glBindVertexArray(resources->Get(vao));
+    for (uint32_t i : visible_cubes) {
+      shader.SetMat4("model", cube_models[i]);
       glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
-    glfwSwapBuffers(window);
+    frame_times.EndFrame();
+    context.EndFrame();
   }
+  frame_times.Flush();
+  context.LogTimingStats();
+
+  resources->Destroy(vao);
+  resources->Destroy(vbo);
+  resources->Destroy(texture1);
+  resources->Destroy(texture2);
 
-  glDeleteVertexArrays(1, &vao);
-  glDeleteBuffers(1, &vbo);
-  glDeleteTextures(1, &texture1);
-  glDeleteTextures(1, &texture2);
+  if (recording && !recorder.Save(replay_options.record_path, camera)) {
+    return -1;
+  }
+  if (!replaying) {
+    return 0;
+  }
 
-  glfwTerminate();
+  utils::FrameTimeSummary summary = frame_times.Summary();
+  std::cout << "frames: " << replay.frame_count() << ", cpu p50/p95/p99: " << summary.cpu.p50_ms << " / "
+            << summary.cpu.p95_ms << " / " << summary.cpu.p99_ms << " ms";
+  if (summary.gpu.samples > 0) {
+    std::cout << ", gpu p50/p95/p99: " << summary.gpu.p50_ms << " / " << summary.gpu.p95_ms << " / "
+              << summary.gpu.p99_ms << " ms";
+  }
+  std::cout << std::endl;
+
+  // 重放的输入和帧间隔都来自记录，相机的最终位置必须与录制时一致
+  if (static_cast<size_t>(context.frame_index()) == replay.frame_count() && !replay.Verify(camera)) {
+    std::cerr << "Replay diverged: final camera pose differs from the recording" << std::endl;
+    return 1;
+  }
+
+  if (replay_options.baseline_path.empty()) {
+    return 0;
+  }
+  if (replay_options.write_baseline) {
+    return utils::SaveBaseline(replay_options.baseline_path, summary) ? 0 : -1;
+  }
+  utils::FrameTimeSummary baseline;
+  if (!utils::LoadBaseline(replay_options.baseline_path, &baseline)) {
+    return -1;
+  }
+  std::string report;
+  bool passed = utils::CheckRegression(summary, baseline, replay_options.threshold, replay_options.min_delta_ms,
+                                       &report);
+  std::cout << report;
+  if (!passed) {
+    std::cerr << "Frame time regression against " << replay_options.baseline_path << std::endl;
+    return 1;
+  }
   return 0;
 }
 
+static bool ParseReplayOptions(int argc, char** argv, ReplayOptions* options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--write-baseline") == 0) {
+      options->write_baseline = true;
+      continue;
+    }
+    bool has_value = strcmp(arg, "--record") == 0 || strcmp(arg, "--replay") == 0 ||
+                     strcmp(arg, "--baseline") == 0 || strcmp(arg, "--threshold") == 0 ||
+                     strcmp(arg, "--min-delta") == 0 || strcmp(arg, "--warmup") == 0;
+    if (!has_value) {
+      continue;
+    }
+    if (value == nullptr) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    i++;
+    if (strcmp(arg, "--record") == 0) {
+      options->record_path = value;
+    } else if (strcmp(arg, "--replay") == 0) {
+      options->replay_path = value;
+    } else if (strcmp(arg, "--baseline") == 0) {
+      options->baseline_path = value;
+    } else if (strcmp(arg, "--threshold") == 0) {
+      options->threshold = strtod(value, nullptr);
+    } else if (strcmp(arg, "--min-delta") == 0) {
+      options->min_delta_ms = strtod(value, nullptr);
+    } else {
+      options->warmup_frames = atoi(value);
+    }
+  }
+  if (options->write_baseline && (options->baseline_path.empty() || options->replay_path.empty())) {
+    std::cerr << "--write-baseline requires --replay and --baseline" << std::endl;
+    return false;
+  }
+  return true;
+}
+
 static void ProcessInput(GLFWwindow *window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, true);
   } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
     camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time);
+    if (recording) {
+      recorder.RecordKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time);
+    }
   } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
     camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time);
+    if (recording) {
+      recorder.RecordKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time);
+    }
   } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
     camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time);
+    if (recording) {
+      recorder.RecordKeyboard(utils::FpsCamera::Movement::LEFT, delta_time);
+    }
   } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
     camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time);
+    if (recording) {
+      recorder.RecordKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time);
+    }
   }
 }
 
 static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
   camera.ProcessMouseScroll(static_cast<float>(y_offset));
+  if (recording) {
+    recorder.RecordMouseScroll(static_cast<float>(y_offset));
+  }
 }
 
 static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
@@ -238,12 +387,9 @@ static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
   last_y = y_pos;
 
   camera.ProcessMouseMovement(x_offset, y_offset);
-}
-
-static void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
-  window_width = width;
-  window_height = height;
-  glViewport(0, 0, width, height);
+  if (recording) {
+    recorder.RecordMouseMovement(x_offset, y_offset);
+  }
 }
 
 static std::tuple<std::string, std::string> GetShaderPaths() {
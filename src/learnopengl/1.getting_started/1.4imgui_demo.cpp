@@ -6,6 +6,11 @@
 #include "glad/glad.h"
 #include "GLFW//glfw3.h"
 
+#include "utils/metrics.h"
+#include "utils/metrics_overlay.h"
+#include "utils/profiler.h"
+#include "utils/profiler_overlay.h"
+
 static void ProcessInput(GLFWwindow* window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, true);
@@ -131,11 +136,18 @@ int main() {
   ImGui_ImplOpenGL3_Init("#version 330 core");
 
   bool show_demo = false;
+  bool show_profiler = true;
+  bool show_metrics = false;
+  const utils::RenderMetrics& metrics = utils::RenderMetrics::Get();
   int counter = 0;
 
   while (glfwWindowShouldClose(window) == GL_FALSE) {
-    glfwPollEvents();
-    ProcessInput(window);
+    PROFILE_BEGIN_FRAME();
+    {
+      PROFILE_SCOPE("PollEvents");
+      glfwPollEvents();
+      ProcessInput(window);
+    }
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
@@ -151,6 +163,8 @@ int main() {
     ImGui::Begin("Demo");
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::Checkbox("Demo Window", &show_demo);
+    ImGui::Checkbox("Profiler", &show_profiler);
+    ImGui::Checkbox("Metrics", &show_metrics);
 
     ImGui::SliderFloat3("A", vertices, -1.0f, 1.0f);
     ImGui::SliderFloat3("B", vertices + 3, -1.0f, 1.0f);
@@ -164,22 +178,43 @@ int main() {
     ImGui::Text("counter = %d", counter);
     ImGui::End();
 
+    if (show_profiler) {
+      utils::DrawProfilerWindow(utils::Profiler::Instance(), "imgui_demo_trace.json", &show_profiler);
+    }
+    if (show_metrics) {
+      utils::DrawMetricsWindow(utils::MetricsRegistry::Instance(), &show_metrics);
+    }
+
     // Rendering
     ImGui::Render();
 
-    glClearColor(0.2, 0.3, 0.4, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(shader_program);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      GPU_PROFILE_SCOPE("Triangle");
+      glClearColor(0.2, 0.3, 0.4, 1.0);
+      glClear(GL_COLOR_BUFFER_BIT);
+      glUseProgram(shader_program);
+      glBindVertexArray(vao);
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+      metrics.buffer_upload_bytes.Add(sizeof(vertices));
+
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      metrics.draw_calls.Add();
+    }
+    {
+      GPU_PROFILE_SCOPE("ImGui");
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
-    glfwSwapBuffers(window);
+    {
+      PROFILE_SCOPE("SwapBuffers");
+      glfwSwapBuffers(window);
+    }
+    PROFILE_END_FRAME();
+    utils::MetricsRegistry::Instance().EndFrame();
   }
 
+  utils::Profiler::Instance().ReleaseGpu();
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,271 @@
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/shader.h"
+#include "utils/fps_camera.h"
+#include "utils/gl_context.h"
+#include "utils/gpu_culling.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+static std::tuple<std::string, std::string> GetCullShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 2.0f, 0.0f));
+static float delta_time = 0.0f;
+static float last_time = 0.0f;
+static bool use_hiz = true;
+
+// 城市状的场景：大块建筑作为遮挡体，之间散落大量小物体
+static constexpr int kGridSize = 16;
+static constexpr int kSmallObjectCount = 50000;
+
+int main(int argc, char** argv) {
+  // --headless --frames N 可以在没有显示器的机器上跑固定帧数并输出帧时间统计
+  utils::ContextOptions options;
+  options.title = "GPU Culling";
+  options.gl_major = 4;
+  options.gl_minor = 3;
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+    glfwSetKeyCallback(window, KeyCallback);
+  }
+
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  utils::GpuCuller culler;
+  auto [cull_shader_path, pyramid_shader_path] = GetCullShaderPaths();
+  if (!culler.Init(cull_shader_path, pyramid_shader_path)) {
+    return -1;
+  }
+
+  // 两个网格共用顶点和索引缓冲：立方体和四棱锥，顶点为位置加法线
+  std::vector<float> vertices;
+  std::vector<GLuint> indices;
+  auto add_face = [&vertices, &indices](const std::vector<glm::vec3>& corners, const glm::vec3& normal,
+                                        GLuint base_vertex) {
+    GLuint first = static_cast<GLuint>(vertices.size() / 6) - base_vertex;
+    for (const glm::vec3& corner : corners) {
+      vertices.insert(vertices.end(), {corner.x, corner.y, corner.z, normal.x, normal.y, normal.z});
+    }
+    for (GLuint i = 1; i + 1 < corners.size(); i++) {
+      indices.insert(indices.end(), {first, first + i, first + i + 1});
+    }
+  };
+
+  std::vector<utils::GpuMeshRange> meshes(2);
+  meshes[0].first_index = 0;
+  meshes[0].base_vertex = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      normal[axis] = side;
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      add_face({normal - u - v, normal + u - v, normal + u + v, normal - u + v}, normal, 0);
+    }
+  }
+  meshes[0].index_count = static_cast<GLuint>(indices.size());
+
+  meshes[1].first_index = static_cast<GLuint>(indices.size());
+  meshes[1].base_vertex = static_cast<GLint>(vertices.size() / 6);
+  glm::vec3 apex(0.0f, 1.0f, 0.0f);
+  glm::vec3 base[4] = {{-1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, 1.0f}, {-1.0f, -1.0f, 1.0f}};
+  add_face({base[0], base[1], base[2], base[3]}, glm::vec3(0.0f, -1.0f, 0.0f), meshes[1].base_vertex);
+  for (int i = 0; i < 4; i++) {
+    glm::vec3 a = base[(i + 1) % 4];
+    glm::vec3 b = base[i];
+    add_face({a, b, apex}, glm::normalize(glm::cross(b - a, apex - a)), meshes[1].base_vertex);
+  }
+  meshes[1].index_count = static_cast<GLuint>(indices.size()) - meshes[1].first_index;
+
+  std::vector<utils::Aabb> bounds;
+  std::vector<uint32_t> object_meshes;
+  std::vector<glm::mat4> models;
+  auto add_object = [&](uint32_t mesh, const glm::vec3& center, const glm::vec3& half_size) {
+    models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), center), half_size));
+    bounds.push_back(utils::Aabb(center - half_size, center + half_size));
+    object_meshes.push_back(mesh);
+  };
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> height(5.0f, 25.0f);
+  for (int x = 0; x < kGridSize; x++) {
+    for (int z = 0; z < kGridSize; z++) {
+      glm::vec3 half_size(8.0f, height(rng), 8.0f);
+      add_object(0, glm::vec3((x - kGridSize / 2) * 24.0f, half_size.y, (z - kGridSize / 2) * 24.0f), half_size);
+    }
+  }
+  std::uniform_real_distribution<float> position(-kGridSize * 12.0f, kGridSize * 12.0f);
+  std::uniform_real_distribution<float> size(0.2f, 0.8f);
+  for (int i = 0; i < kSmallObjectCount; i++) {
+    float s = size(rng);
+    add_object(i % 2, glm::vec3(position(rng), s, position(rng)), glm::vec3(s));
+  }
+
+  culler.Upload(meshes, bounds, object_meshes, models);
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  GLuint vbo = 0;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+  GLuint ebo = 0;
+  glGenBuffers(1, &ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  culler.BindInstanceAttribute(2);
+
+  glBindVertexArray(0);
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 500.0f);
+
+  float title_time = 0.0f;
+  int frames = 0;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 200.0f, 0.0f);
+    }
+
+    glClearColor(0.2, 0.3, 0.4, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    culler.Cull(camera.GetViewProjectionMatrix(), use_hiz);
+
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+    glBindVertexArray(vao);
+    culler.Draw(0);
+
+    // 这一帧的深度给下一帧做Hi-Z
+    culler.UpdateDepthPyramid(context.width(), context.height());
+
+    // 每秒读回一次可见数量（会等待GPU）
+    frames++;
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = "GPU Culling - " + std::to_string(frames) + " fps, " +
+                          std::to_string(culler.ReadDrawCount()) + "/" + std::to_string(culler.object_count()) +
+                          " drawn, Hi-Z " + (use_hiz ? "on" : "off") + " (H)";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+      frames = 0;
+    }
+
+    context.EndFrame();
+  }
+  context.LogTimingStats();
+
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ebo);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 10.0f;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+    use_hiz = !use_hiz;
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.5gpu_culling.vs").string(),
+    path.parent_path().append("1.5gpu_culling.fs").string(),
+  };
+}
+
+static std::tuple<std::string, std::string> GetCullShaderPaths() {
+  return {
+    std::filesystem::path(RESOURCE_DIR).append("shaders").append("gpu_cull.comp").string(),
+    std::filesystem::path(RESOURCE_DIR).append("shaders").append("depth_pyramid.comp").string(),
+  };
+}
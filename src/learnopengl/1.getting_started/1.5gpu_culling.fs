@@ -0,0 +1,13 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec3 Normal;
+flat in uint Object;
+
+void main()
+{
+    // 按物体下标给一个固定颜色，再加简单的方向光
+    vec3 color = vec3(float(Object % 7u) / 7.0, float(Object % 11u) / 11.0, float(Object % 13u) / 13.0) * 0.6 + 0.4;
+    float light = max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0) * 0.7 + 0.3;
+    FragColor = vec4(color * light, 1.0);
+}
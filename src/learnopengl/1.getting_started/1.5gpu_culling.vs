@@ -0,0 +1,23 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 实例属性，值为物体下标（间接绘制命令的baseInstance）
+layout (location = 2) in uint aObject;
+
+layout (std430, binding = 0) readonly buffer Models {
+    mat4 models[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+flat out uint Object;
+
+void main()
+{
+    mat4 model = models[aObject];
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Normal = mat3(model) * aNormal;
+    Object = aObject;
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/glm.hpp"
+
+#include "utils/application.h"
+#include "utils/camera_recorder.h"
+#include "utils/fps_camera.h"
+#include "utils/shader.h"
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+
+// 渲染需要的全部状态：相机姿态和每个粒子的位置与大小
+struct ParticleSnapshot {
+  utils::CameraPose camera;
+  std::vector<glm::vec4> particles;
+};
+
+// 粒子在旋涡力场中运动并与盒子碰撞。模拟在工作线程上按固定步长推进，
+// GL线程在两步之间插值绘制（插值放在顶点着色器里）。
+// --serial 关闭流水线对比帧时间，--particles N 调整模拟开销
+class ParticleApp : public utils::Application<ParticleSnapshot> {
+public:
+  ParticleApp(const utils::ApplicationOptions& options, int particle_count)
+      : Application(options), particle_count_(particle_count), camera_(glm::vec3(0.0f, 15.0f, 60.0f)) {}
+
+protected:
+  bool Init() override {
+    auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+    if (!shader_.Compile(vertex_shader_path, fragment_shader_path)) {
+      return false;
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-kBoxSize, kBoxSize);
+    std::uniform_real_distribution<float> size(0.1f, 0.3f);
+    positions_.resize(particle_count_);
+    velocities_.assign(particle_count_, glm::vec3(0.0f));
+    sizes_.resize(particle_count_);
+    for (int i = 0; i < particle_count_; i++) {
+      positions_[i] = glm::vec3(position(rng), position(rng) + kBoxSize, position(rng));
+      sizes_[i] = size(rng);
+    }
+
+    // 立方体，位置加法线
+    std::vector<float> vertices;
+    for (int axis = 0; axis < 3; axis++) {
+      for (float side : {-1.0f, 1.0f}) {
+        glm::vec3 normal(0.0f);
+        glm::vec3 u(0.0f);
+        glm::vec3 v(0.0f);
+        normal[axis] = side;
+        u[(axis + 1) % 3] = 1.0f;
+        v[(axis + 2) % 3] = side;
+        glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+        for (int index : {0, 1, 2, 0, 2, 3}) {
+          vertices.insert(vertices.end(), {corners[index].x, corners[index].y, corners[index].z});
+          vertices.insert(vertices.end(), {normal.x, normal.y, normal.z});
+        }
+      }
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // 实例缓冲前半段为上一步、后半段为最新一步
+    glGenBuffers(1, &instance_vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, 2 * particle_count_ * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4),
+                          (void*)(particle_count_ * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
+    return true;
+  }
+
+  void Shutdown() override {
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &vbo_);
+    glDeleteBuffers(1, &instance_vbo_);
+  }
+
+  void HandleInput(const utils::InputState& input) override {
+    input_ = input;
+    look_pending_ = true;
+  }
+
+  void Simulate(double step) override {
+    auto dt = static_cast<float>(step);
+    UpdateCamera(dt);
+
+    const glm::vec3 gravity(0.0f, -9.8f, 0.0f);
+    for (int i = 0; i < particle_count_; i++) {
+      glm::vec3& p = positions_[i];
+      glm::vec3& v = velocities_[i];
+      // 绕y轴的旋涡加上指向中心的吸引，靠近地面时向上托起
+      glm::vec3 swirl(-p.z, 0.0f, p.x);
+      glm::vec3 pull(-p.x, 0.0f, -p.z);
+      float lift = p.y < 2.0f ? 30.0f : 0.0f;
+      v += (gravity + swirl * 0.5f + pull * 0.2f + glm::vec3(0.0f, lift, 0.0f)) * dt;
+      v *= 1.0f - 0.3f * dt;
+      p += v * dt;
+      for (int axis = 0; axis < 3; axis++) {
+        float low = axis == 1 ? 0.0f : -kBoxSize;
+        float high = axis == 1 ? 2.0f * kBoxSize : kBoxSize;
+        if (p[axis] < low || p[axis] > high) {
+          p[axis] = glm::clamp(p[axis], low, high);
+          v[axis] *= -0.8f;
+        }
+      }
+    }
+  }
+
+  void Publish(ParticleSnapshot* snapshot) override {
+    snapshot->camera = utils::CameraPose::FromCamera(camera_);
+    snapshot->particles.resize(particle_count_);
+    for (int i = 0; i < particle_count_; i++) {
+      snapshot->particles[i] = glm::vec4(positions_[i], sizes_[i]);
+    }
+  }
+
+  void Render(const ParticleSnapshot& previous, const ParticleSnapshot& current, float alpha) override {
+    // 渲染用的相机只在GL线程使用
+    render_camera_.SetPose(glm::mix(previous.camera.position, current.camera.position, alpha),
+                           glm::mix(previous.camera.yaw, current.camera.yaw, alpha),
+                           glm::mix(previous.camera.pitch, current.camera.pitch, alpha),
+                           glm::mix(previous.camera.zoom, current.camera.zoom, alpha));
+    render_camera_.SetPerspective((float)context().width() / (float)context().height(), 0.1f, 500.0f);
+
+    glClearColor(0.2, 0.3, 0.4, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    GLsizeiptr size = particle_count_ * sizeof(glm::vec4);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, 2 * size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, previous.particles.data());
+    glBufferSubData(GL_ARRAY_BUFFER, size, size, current.particles.data());
+
+    shader_.Use();
+    shader_.SetMat4("projection", render_camera_.GetProjectionMatrix());
+    shader_.SetMat4("view", render_camera_.GetViewMatrix());
+    shader_.SetFloat("alpha", alpha);
+    glBindVertexArray(vao_);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, particle_count_);
+  }
+
+private:
+  void UpdateCamera(float dt) {
+    if (context().headless()) {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera_.ProcessMouseMovement(dt * 30.0f, 0.0f);
+      return;
+    }
+    // 鼠标和滚轮是这段时间的累计量，只在一次任务的第一步使用
+    if (look_pending_) {
+      camera_.ProcessMouseMovement(input_.mouse_dx, input_.mouse_dy);
+      camera_.ProcessMouseScroll(input_.scroll);
+      look_pending_ = false;
+    }
+    float speed = 20.0f * dt;
+    if (input_.down(GLFW_KEY_W)) {
+      camera_.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, speed);
+    }
+    if (input_.down(GLFW_KEY_S)) {
+      camera_.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, speed);
+    }
+    if (input_.down(GLFW_KEY_A)) {
+      camera_.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, speed);
+    }
+    if (input_.down(GLFW_KEY_D)) {
+      camera_.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, speed);
+    }
+  }
+
+private:
+  static constexpr float kBoxSize = 20.0f;
+
+  int particle_count_;
+
+  // 模拟状态，只在模拟一侧访问
+  utils::FpsCamera camera_;
+  utils::InputState input_;
+  bool look_pending_ = false;
+  std::vector<glm::vec3> positions_;
+  std::vector<glm::vec3> velocities_;
+  std::vector<float> sizes_;
+
+  // GL状态
+  utils::FpsCamera render_camera_{ glm::vec3(0.0f) };
+  utils::Shader shader_;
+  GLuint vao_ = 0;
+  GLuint vbo_ = 0;
+  GLuint instance_vbo_ = 0;
+};
+
+int main(int argc, char** argv) {
+  utils::ApplicationOptions options;
+  options.context.title = "Pipelined Application";
+  if (!utils::ParseApplicationOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  int particle_count = 50000;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--particles") == 0) {
+      particle_count = std::max(1, atoi(argv[i + 1]));
+    }
+  }
+
+  ParticleApp app(options, particle_count);
+  return app.Run();
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.6pipelined_app.vs").string(),
+    path.parent_path().append("1.6pipelined_app.fs").string(),
+  };
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 Color;
+
+void main()
+{
+    float light = max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0) * 0.7 + 0.3;
+    FragColor = vec4(Color * light, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 实例属性：上一步和最新一步的位置（xyz）与大小（w）
+layout (location = 2) in vec4 aPrevious;
+layout (location = 3) in vec4 aCurrent;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float alpha;
+
+out vec3 Normal;
+out vec3 Color;
+
+void main()
+{
+    vec4 particle = mix(aPrevious, aCurrent, alpha);
+    gl_Position = projection * view * vec4(aPos * particle.w + particle.xyz, 1.0);
+    Normal = aNormal;
+    Color = vec3(0.4) + 0.6 * fract(vec3(gl_InstanceID) * vec3(0.137, 0.291, 0.419));
+}
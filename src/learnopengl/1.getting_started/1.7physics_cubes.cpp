@@ -0,0 +1,256 @@
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "utils/fps_camera.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/mapped_ring_buffer.h"
+#include "utils/physics_world.h"
+#include "utils/shader.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 20.0f, 70.0f));
+static float delta_time = 0.0f;
+
+// 20x20根柱子，每根25个立方体，共1万个
+static constexpr int kColumns = 20;
+static constexpr int kLayers = 25;
+static constexpr float kGroundSize = 60.0f;
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Physics Cubes";
+  options.gl_major = 4;
+  options.gl_minor = 2;
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  // 地面是静态刚体，立方体从空中错开落下
+  utils::PhysicsWorld physics;
+  glm::vec3 ground_half_extents(kGroundSize, 1.0f, kGroundSize);
+  physics.AddBox(ground_half_extents, 0.0f, glm::vec3(0.0f, -1.0f, 0.0f));
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+  for (int layer = 0; layer < kLayers; layer++) {
+    for (int x = 0; x < kColumns; x++) {
+      for (int z = 0; z < kColumns; z++) {
+        glm::vec3 position((x - kColumns / 2) * 2.5f + jitter(rng), 2.0f + layer * 2.2f,
+                           (z - kColumns / 2) * 2.5f + jitter(rng));
+        glm::quat rotation = glm::angleAxis(jitter(rng) * 5.0f, glm::normalize(glm::vec3(1.0f, 0.5f, 0.3f)));
+        physics.AddBox(glm::vec3(0.5f), 1.0f, position, rotation);
+      }
+    }
+  }
+  if (!physics.Start()) {
+    return -1;
+  }
+  auto instance_count = static_cast<GLsizei>(physics.instance_count());
+
+  // 每块存放全部立方体的模型矩阵，物理线程直接写入
+  utils::MappedRingBuffer transforms;
+  if (!transforms.Init(GL_ARRAY_BUFFER, instance_count * sizeof(glm::mat4))) {
+    return -1;
+  }
+
+  std::vector<float> vertices;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      normal[axis] = side;
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+      for (int index : {0, 1, 2, 0, 2, 3}) {
+        glm::vec3 p = corners[index] * 0.5f;
+        vertices.insert(vertices.end(), {p.x, p.y, p.z, normal.x, normal.y, normal.z});
+      }
+    }
+  }
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  GLuint vbo = 0;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+  // 两个VAO共用立方体顶点：立方体的模型矩阵来自实例缓冲，地面的模型矩阵用常量属性值
+  GLuint vaos[2] = {0, 0};
+  glGenVertexArrays(2, vaos);
+  for (GLuint vao : vaos) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+  }
+  glBindVertexArray(vaos[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, transforms.buffer());
+  for (int column = 0; column < 4; column++) {
+    glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          (void*)(column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(2 + column);
+    glVertexAttribDivisor(2 + column, 1);
+  }
+  glBindVertexArray(0);
+  glm::mat4 ground_model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
+                                      ground_half_extents * 2.0f);
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 500.0f);
+
+  // 先同步写一块初始变换，之后每帧物理推进下一块的同时渲染上一块
+  int current = transforms.Acquire();
+  physics.Step(0.0, static_cast<float*>(transforms.data(current)));
+  physics.Wait();
+  transforms.Commit(current);
+
+  std::vector<double> step_ms;
+  std::vector<double> sync_ms;
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    int next = transforms.Acquire();
+    physics.Step(delta_time, static_cast<float*>(transforms.data(next)));
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 100.0f, 0.0f);
+    }
+
+    glClearColor(0.2, 0.3, 0.4, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+
+    glBindVertexArray(vaos[1]);
+    for (int column = 0; column < 4; column++) {
+      glVertexAttrib4fv(2 + column, &ground_model[column][0]);
+    }
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+
+    // baseInstance让实例属性从这一块的开头读取
+    glBindVertexArray(vaos[0]);
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 36, instance_count,
+                                      static_cast<GLuint>(current * instance_count));
+    transforms.Fence(current);
+
+    context.EndFrame();
+
+    physics.Wait();
+    transforms.Commit(next);
+    current = next;
+    step_ms.push_back(physics.stats().step_ms);
+    sync_ms.push_back(physics.stats().sync_ms);
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = "Physics Cubes - step " + std::to_string(physics.stats().step_ms) + " ms, sync " +
+                          std::to_string(physics.stats().sync_ms) + " ms";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  utils::PercentileSummary step = utils::Summarize(step_ms);
+  utils::PercentileSummary sync = utils::Summarize(sync_ms);
+  std::cout << instance_count << " bodies, " << physics.solver_threads() << " solver threads" << std::endl;
+  std::cout << "step avg/p50/p99: " << step.avg_ms << " / " << step.p50_ms << " / " << step.p99_ms << " ms"
+            << std::endl;
+  std::cout << "sync avg/p50/p99: " << sync.avg_ms << " / " << sync.p50_ms << " / " << sync.p99_ms << " ms"
+            << std::endl;
+
+  physics.Stop();
+  transforms.Release();
+  glDeleteVertexArrays(2, vaos);
+  glDeleteBuffers(1, &vbo);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.7physics_cubes.vs").string(),
+    path.parent_path().append("1.7physics_cubes.fs").string(),
+  };
+}
@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 实例属性：物理线程写入的模型矩阵，占2~5四个位置
+layout (location = 2) in mat4 aModel;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec3 Color;
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+    Normal = mat3(aModel) * aNormal;
+    Color = vec3(0.4) + 0.6 * fract(vec3(gl_InstanceID) * vec3(0.137, 0.291, 0.419));
+}
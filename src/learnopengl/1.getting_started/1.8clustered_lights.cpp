@@ -0,0 +1,285 @@
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/clustered_lighting.h"
+#include "utils/fps_camera.h"
+#include "utils/frame_stats.h"
+#include "utils/gl_context.h"
+#include "utils/light_clusters.h"
+#include "utils/shader.h"
+#include "utils/thread_pool.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string> GetShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 15.0f, 60.0f));
+static float delta_time = 0.0f;
+static bool show_heatmap = false;
+
+static constexpr int kColumns = 24;
+static constexpr float kSpacing = 5.0f;
+static constexpr float kGroundSize = 80.0f;
+
+// 光源绕各自的中心转圈
+struct LightMotion {
+  glm::vec3 center;
+  float radius;
+  float speed;
+  float phase;
+};
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Clustered Lights";
+  int light_count = 10000;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--lights" && i + 1 < argc) {
+      light_count = std::max(std::stoi(argv[++i]), 0);
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  utils::Shader::AddIncludeDirectory(std::filesystem::path(RESOURCE_DIR).append("shaders").string());
+  utils::Shader shader;
+  auto [vertex_shader_path, fragment_shader_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path)) {
+    return -1;
+  }
+
+  utils::ClusteredLighting lighting;
+  if (!lighting.Init()) {
+    return -1;
+  }
+
+  // 地面上整齐排列的立方体，高度随机
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<glm::vec3> instances;
+  for (int x = 0; x < kColumns; x++) {
+    for (int z = 0; z < kColumns; z++) {
+      float height = 1.0f + unit(rng) * 6.0f;
+      glm::vec3 offset((x - kColumns / 2 + 0.5f) * kSpacing, height * 0.5f, (z - kColumns / 2 + 0.5f) * kSpacing);
+      instances.push_back(offset);
+      instances.push_back(glm::vec3(2.0f, height, 2.0f));
+    }
+  }
+  auto instance_count = static_cast<GLsizei>(instances.size() / 2);
+
+  std::vector<utils::Light> lights(light_count);
+  std::vector<LightMotion> motions(light_count);
+  for (int i = 0; i < light_count; i++) {
+    utils::Light& light = lights[i];
+    LightMotion& motion = motions[i];
+    motion.center = glm::vec3((unit(rng) * 2.0f - 1.0f) * kGroundSize, 0.5f + unit(rng) * 6.0f,
+                              (unit(rng) * 2.0f - 1.0f) * kGroundSize);
+    motion.radius = 1.0f + unit(rng) * 4.0f;
+    motion.speed = 0.2f + unit(rng) * 1.5f;
+    motion.phase = unit(rng) * 6.2831853f;
+    light.range = 2.0f + unit(rng) * 4.0f;
+    light.color = glm::vec3(0.2f) + 0.8f * glm::vec3(unit(rng), unit(rng), unit(rng));
+    light.intensity = 2.0f;
+    // 四分之一是朝下的聚光灯
+    if (i % 4 == 0) {
+      light.type = utils::LightType::kSpot;
+      light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+      light.range *= 2.0f;
+      light.cos_outer = 0.7f + unit(rng) * 0.2f;
+      light.cos_inner = light.cos_outer + 0.05f;
+    }
+  }
+
+  std::vector<float> vertices;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      normal[axis] = side;
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+      for (int index : {0, 1, 2, 0, 2, 3}) {
+        glm::vec3 p = corners[index] * 0.5f;
+        vertices.insert(vertices.end(), {p.x, p.y, p.z, normal.x, normal.y, normal.z});
+      }
+    }
+  }
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  GLuint buffers[2] = {0, 0};
+  glGenBuffers(2, buffers);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_STATIC_DRAW);
+
+  // 两个VAO共用立方体顶点：立方体的位置和缩放来自实例缓冲，地面用常量属性值
+  GLuint vaos[2] = {0, 0};
+  glGenVertexArrays(2, vaos);
+  for (GLuint vao : vaos) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+  }
+  glBindVertexArray(vaos[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  for (int attribute = 0; attribute < 2; attribute++) {
+    glVertexAttribPointer(2 + attribute, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3),
+                          (void*)(attribute * sizeof(glm::vec3)));
+    glEnableVertexAttribArray(2 + attribute);
+    glVertexAttribDivisor(2 + attribute, 1);
+  }
+  glBindVertexArray(0);
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 300.0f);
+
+  utils::ThreadPool pool;
+  utils::LightClusterer clusterer;
+  std::vector<double> assign_ms;
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 100.0f, 0.0f);
+    }
+
+    for (int i = 0; i < light_count; i++) {
+      const LightMotion& motion = motions[i];
+      float angle = motion.phase + current_time * motion.speed;
+      lights[i].position = motion.center + motion.radius * glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+    }
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    glm::mat4 view = camera.GetViewMatrix();
+    auto assign_start = std::chrono::steady_clock::now();
+    clusterer.SetProjection(camera);
+    clusterer.Assign(view, lights, &pool);
+    assign_ms.push_back(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - assign_start).count());
+    lighting.Upload(clusterer, lights);
+
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", view);
+    shader.SetBool("showHeatmap", show_heatmap);
+    lighting.Bind(shader, 0, context.width(), context.height());
+
+    glBindVertexArray(vaos[1]);
+    glVertexAttrib3f(2, 0.0f, -0.5f, 0.0f);
+    glVertexAttrib3f(3, kGroundSize * 2.0f, 1.0f, kGroundSize * 2.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+
+    glBindVertexArray(vaos[0]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instance_count);
+
+    context.EndFrame();
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = "Clustered Lights - " + std::to_string(light_count) + " lights, assign " +
+                          std::to_string(assign_ms.back()) + " ms";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  utils::PercentileSummary assign = utils::Summarize(assign_ms);
+  std::cout << light_count << " lights, " << clusterer.size().count() << " clusters, " << pool.thread_count()
+            << " threads, " << utils::CullKernelName(utils::BestCullKernel()) << std::endl;
+  std::cout << "assign avg/p50/p99: " << assign.avg_ms << " / " << assign.p50_ms << " / " << assign.p99_ms << " ms"
+            << std::endl;
+
+  lighting.Release();
+  glDeleteVertexArrays(2, vaos);
+  glDeleteBuffers(2, buffers);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  // H键按住时显示每个簇的光源数量
+  show_heatmap = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.8clustered_lights.vs").string(),
+    path.parent_path().append("1.8clustered_lights.fs").string(),
+  };
+}
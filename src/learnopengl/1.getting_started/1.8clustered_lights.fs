@@ -0,0 +1,24 @@
+#version 330 core
+#include "clustered_lighting.glsl"
+
+out vec4 FragColor;
+
+in vec3 WorldPos;
+in vec3 Normal;
+in float ViewDepth;
+
+uniform bool showHeatmap;
+
+void main()
+{
+    vec3 albedo = vec3(0.8);
+    if (showHeatmap) {
+        // 每个簇的光源数量，32个以上为红色
+        uint count = texelFetch(clusterRanges, ClusterIndex(gl_FragCoord.xy, ViewDepth)).y;
+        float heat = min(float(count) / 32.0, 1.0);
+        FragColor = vec4(heat, 1.0 - abs(heat * 2.0 - 1.0), 1.0 - heat, 1.0);
+        return;
+    }
+    vec3 color = albedo * 0.03 + ClusteredLighting(WorldPos, normalize(Normal), albedo, ViewDepth);
+    FragColor = vec4(color, 1.0);
+}
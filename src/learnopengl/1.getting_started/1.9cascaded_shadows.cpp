@@ -0,0 +1,297 @@
+#include <iostream>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW//glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "config/globals.h"
+#include "utils/cascaded_shadows.h"
+#include "utils/fps_camera.h"
+#include "utils/gl_context.h"
+#include "utils/shader.h"
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+static void ProcessInput(GLFWwindow *window);
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos);
+
+static std::tuple<std::string, std::string, std::string, std::string> GetShaderPaths();
+
+static utils::FpsCamera camera(glm::vec3(0.0f, 12.0f, 60.0f));
+static float delta_time = 0.0f;
+static bool show_cascades = false;
+
+static constexpr int kColumns = 40;
+static constexpr float kSpacing = 6.0f;
+static constexpr float kGroundSize = 150.0f;
+static constexpr int kDynamicCubes = 64;
+
+int main(int argc, char** argv) {
+  utils::ContextOptions options;
+  options.title = "Cascaded Shadows";
+  utils::CascadeOptions cascade_options;
+  // 光源方向绕y轴转动的速度（度/秒），为0时静态阴影只在级联移动时重画
+  float sun_speed = 0.0f;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--cascades" && i + 1 < argc) {
+      cascade_options.cascade_count = std::stoi(argv[++i]);
+    } else if (arg == "--shadow-size" && i + 1 < argc) {
+      cascade_options.resolution = std::stoi(argv[++i]);
+    } else if (arg == "--sun-speed" && i + 1 < argc) {
+      sun_speed = std::stof(argv[++i]);
+    } else if (arg == "--no-cache") {
+      cascade_options.cache_static = false;
+    }
+  }
+  if (!utils::ParseContextOptions(argc, argv, &options)) {
+    return -1;
+  }
+
+  utils::GlContext context;
+  if (!context.Init(options)) {
+    return -1;
+  }
+
+  GLFWwindow* window = context.window();
+  if (window != nullptr) {
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetCursorPosCallback(window, MouseCallback);
+  }
+
+  utils::Shader::AddIncludeDirectory(std::filesystem::path(RESOURCE_DIR).append("shaders").string());
+  utils::Shader shader;
+  utils::Shader depth_shader;
+  auto [vertex_shader_path, fragment_shader_path, depth_vertex_path, depth_fragment_path] = GetShaderPaths();
+  if (!shader.Compile(vertex_shader_path, fragment_shader_path) ||
+      !depth_shader.Compile(depth_vertex_path, depth_fragment_path)) {
+    return -1;
+  }
+
+  utils::CascadedShadowMap shadows;
+  if (!shadows.Init(cascade_options)) {
+    return -1;
+  }
+
+  // 静态的立方体排成网格，动态的立方体在上空绕圈
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<glm::vec3> static_instances;
+  for (int x = 0; x < kColumns; x++) {
+    for (int z = 0; z < kColumns; z++) {
+      float height = 1.0f + unit(rng) * 8.0f;
+      static_instances.push_back(glm::vec3((x - kColumns / 2 + 0.5f) * kSpacing, height * 0.5f,
+                                           (z - kColumns / 2 + 0.5f) * kSpacing));
+      static_instances.push_back(glm::vec3(2.0f, height, 2.0f));
+    }
+  }
+  std::vector<glm::vec3> dynamic_instances(kDynamicCubes * 2, glm::vec3(1.5f));
+  std::vector<glm::vec4> dynamic_motion(kDynamicCubes);
+  for (glm::vec4& motion : dynamic_motion) {
+    // 轨道半径、高度、角速度、相位
+    motion = glm::vec4(5.0f + unit(rng) * 60.0f, 10.0f + unit(rng) * 6.0f, 0.2f + unit(rng), unit(rng) * 6.2831853f);
+  }
+
+  std::vector<float> vertices;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      glm::vec3 u(0.0f);
+      glm::vec3 v(0.0f);
+      normal[axis] = side;
+      u[(axis + 1) % 3] = 1.0f;
+      v[(axis + 2) % 3] = side;
+      glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+      for (int index : {0, 1, 2, 0, 2, 3}) {
+        glm::vec3 p = corners[index] * 0.5f;
+        vertices.insert(vertices.end(), {p.x, p.y, p.z, normal.x, normal.y, normal.z});
+      }
+    }
+  }
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  GLuint buffers[3] = {0, 0, 0};
+  glGenBuffers(3, buffers);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, static_instances.size() * sizeof(glm::vec3), static_instances.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+  glBufferData(GL_ARRAY_BUFFER, dynamic_instances.size() * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+
+  // 三个VAO共用立方体顶点：静态和动态立方体各有实例缓冲，地面用常量属性值
+  GLuint vaos[3] = {0, 0, 0};
+  glGenVertexArrays(3, vaos);
+  for (int i = 0; i < 3; i++) {
+    glBindVertexArray(vaos[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    if (i == 2) {
+      continue;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[1 + i]);
+    for (int attribute = 0; attribute < 2; attribute++) {
+      glVertexAttribPointer(2 + attribute, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3),
+                            (void*)(attribute * sizeof(glm::vec3)));
+      glEnableVertexAttribArray(2 + attribute);
+      glVertexAttribDivisor(2 + attribute, 1);
+    }
+  }
+  glBindVertexArray(0);
+  auto static_count = static_cast<GLsizei>(static_instances.size() / 2);
+
+  auto draw_ground = [&]() {
+    glBindVertexArray(vaos[2]);
+    glVertexAttrib3f(2, 0.0f, -0.5f, 0.0f);
+    glVertexAttrib3f(3, kGroundSize * 2.0f, 1.0f, kGroundSize * 2.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+  };
+  auto draw_static = [&](int cascade, const glm::mat4& light_view_projection) {
+    depth_shader.Use();
+    depth_shader.SetMat4("lightViewProjection", light_view_projection);
+    draw_ground();
+    glBindVertexArray(vaos[0]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_count);
+  };
+  auto draw_dynamic = [&](int cascade, const glm::mat4& light_view_projection) {
+    depth_shader.Use();
+    depth_shader.SetMat4("lightViewProjection", light_view_projection);
+    glBindVertexArray(vaos[1]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, kDynamicCubes);
+  };
+
+  camera.SetPerspective((float)context.width() / (float)context.height(), 0.1f, 300.0f);
+
+  float title_time = 0.0f;
+  while (context.BeginFrame()) {
+    auto current_time = static_cast<float>(context.time());
+    delta_time = static_cast<float>(context.delta_time());
+
+    if (window != nullptr) {
+      ProcessInput(window);
+    } else {
+      // 无窗口时镜头匀速转动，配合--fixed-dt每次运行画面一致
+      camera.ProcessMouseMovement(delta_time * 100.0f, 0.0f);
+    }
+
+    for (int i = 0; i < kDynamicCubes; i++) {
+      const glm::vec4& motion = dynamic_motion[i];
+      float angle = motion.w + current_time * motion.z;
+      dynamic_instances[i * 2] = glm::vec3(std::cos(angle) * motion.x, motion.y, std::sin(angle) * motion.x);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, dynamic_instances.size() * sizeof(glm::vec3), dynamic_instances.data());
+
+    float sun_angle = glm::radians(30.0f + sun_speed * current_time);
+    glm::vec3 light_direction = glm::normalize(glm::vec3(std::cos(sun_angle), -1.5f, std::sin(sun_angle)));
+
+    camera.SetAspect((float)context.width() / (float)context.height());
+    shadows.Update(camera, light_direction);
+    shadows.Render(draw_static, draw_dynamic);
+
+    glClearColor(0.5, 0.6, 0.7, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetMat4("projection", camera.GetProjectionMatrix());
+    shader.SetMat4("view", camera.GetViewMatrix());
+    shader.SetVec3("lightDirection", light_direction);
+    shader.SetBool("showCascades", show_cascades);
+    shadows.Bind(shader, 0);
+
+    shader.SetVec3("color", glm::vec3(0.6f, 0.6f, 0.55f));
+    draw_ground();
+    shader.SetVec3("color", glm::vec3(0.8f));
+    glBindVertexArray(vaos[0]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_count);
+    shader.SetVec3("color", glm::vec3(0.9f, 0.4f, 0.2f));
+    glBindVertexArray(vaos[1]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, kDynamicCubes);
+
+    context.EndFrame();
+
+    if (window != nullptr && current_time - title_time >= 1.0f) {
+      std::string title = "Cascaded Shadows - cache hit rate " + std::to_string(shadows.cache_hit_rate() * 100.0) + "%";
+      glfwSetWindowTitle(window, title.c_str());
+      title_time = current_time;
+    }
+  }
+  context.LogTimingStats();
+
+  std::cout << "cascade  split  static renders  static avg ms  dynamic avg ms" << std::endl;
+  for (int i = 0; i < shadows.cascade_count(); i++) {
+    const utils::CascadeStats& stats = shadows.stats(i);
+    double static_avg = stats.static_samples == 0 ? 0.0 : stats.static_ms_sum / stats.static_samples;
+    double dynamic_avg = stats.dynamic_samples == 0 ? 0.0 : stats.dynamic_ms_sum / stats.dynamic_samples;
+    std::cout << i << "  " << stats.split_far << "  " << stats.static_renders << "/" << stats.frames << "  "
+              << static_avg << "  " << dynamic_avg << std::endl;
+  }
+  std::cout << "static cache hit rate: " << shadows.cache_hit_rate() * 100.0 << "%" << std::endl;
+
+  shadows.Release();
+  glDeleteVertexArrays(3, vaos);
+  glDeleteBuffers(3, buffers);
+  return 0;
+}
+
+static void ProcessInput(GLFWwindow *window) {
+  float speed = 20.0f;
+  // C键按住时按级联着色
+  show_cascades = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::FORWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::BACKWARD, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::LEFT, delta_time * speed);
+  } else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessKeyboard(utils::FpsCamera::Movement::RIGHT, delta_time * speed);
+  }
+}
+
+static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  camera.ProcessMouseScroll(static_cast<float>(y_offset));
+}
+
+static void MouseCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  static bool first_mouse = true;
+  static float last_x = 0;
+  static float last_y = 0;
+
+  if (first_mouse) {
+    last_x = x_pos;
+    last_y = y_pos;
+    first_mouse = false;
+  }
+
+  float x_offset = x_pos - last_x;
+  float y_offset = last_y - y_pos;
+
+  last_x = x_pos;
+  last_y = y_pos;
+
+  camera.ProcessMouseMovement(x_offset, y_offset);
+}
+
+static std::tuple<std::string, std::string, std::string, std::string> GetShaderPaths() {
+  std::filesystem::path path(__FILE__);
+  return {
+    path.parent_path().append("1.9cascaded_shadows.vs").string(),
+    path.parent_path().append("1.9cascaded_shadows.fs").string(),
+    path.parent_path().append("1.9cascaded_shadows_depth.vs").string(),
+    path.parent_path().append("1.9cascaded_shadows_depth.fs").string(),
+  };
+}
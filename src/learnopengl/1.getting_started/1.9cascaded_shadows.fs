@@ -0,0 +1,29 @@
+#version 330 core
+#include "cascaded_shadows.glsl"
+
+out vec4 FragColor;
+
+in vec3 WorldPos;
+in vec3 Normal;
+in float ViewDepth;
+
+uniform vec3 color;
+uniform vec3 lightDirection;
+uniform bool showCascades;
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    float diffuse = max(dot(normal, -lightDirection), 0.0);
+    float shadow = ShadowFactor(WorldPos, normal, ViewDepth);
+    vec3 result = color * (0.25 + 0.75 * diffuse * shadow);
+    if (showCascades) {
+        // 按级联着色：红、绿、蓝、黄
+        const vec3 tints[4] = vec3[](vec3(1.0, 0.5, 0.5), vec3(0.5, 1.0, 0.5), vec3(0.5, 0.5, 1.0), vec3(1.0, 1.0, 0.5));
+        int cascade = ShadowCascade(ViewDepth);
+        if (cascade >= 0) {
+            result *= tints[cascade];
+        }
+    }
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 实例属性：立方体的位置和缩放，地面用常量属性值
+layout (location = 2) in vec3 aOffset;
+layout (location = 3) in vec3 aScale;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 WorldPos;
+out vec3 Normal;
+out float ViewDepth;
+
+void main()
+{
+    WorldPos = aPos * aScale + aOffset;
+    Normal = aNormal;
+    vec4 viewPos = view * vec4(WorldPos, 1.0);
+    ViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,37 @@
+#include "utils/allocation_counter.h"
+
+#include <atomic>
+
+namespace utils {
+
+namespace {
+
+// 常量初始化，其它编译单元的静态初始化里分配内存时也可以使用
+std::atomic<uint64_t> allocation_count{ 0 };
+std::atomic<uint64_t> allocated_bytes{ 0 };
+std::atomic<bool> counting_enabled{ false };
+
+}  // namespace
+
+uint64_t AllocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocatedBytes() {
+  return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+bool AllocationCountingEnabled() {
+  return counting_enabled.load(std::memory_order_relaxed);
+}
+
+void EnableAllocationCounting() {
+  counting_enabled.store(true, std::memory_order_relaxed);
+}
+
+void RecordAllocation(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace utils
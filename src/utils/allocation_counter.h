@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+// 全局operator new的调用次数和请求的字节数（所有线程累计），用于检查稳定状态的帧没有堆分配：
+//   uint64_t before = AllocationCount(); RenderFrame(); assert(AllocationCount() == before);
+// 计数需要替换全局的new/delete，这由benchmarks/count_allocations.cpp完成。只有把它编进可执行文件的程序才计数
+// （每次分配两个relaxed原子加法），目前是检查分配的基准和1.3fps_camera；
+// 其余程序使用标准分配器，AllocationCount()始终为0。
+// 只统计C++的new，C库和驱动直接调用的malloc不在其中
+uint64_t AllocationCount();
+uint64_t AllocatedBytes();
+
+// 当前程序是否替换了全局new（链接了count_allocations.cpp）
+bool AllocationCountingEnabled();
+
+// 由替换的operator new调用
+void EnableAllocationCounting();
+void RecordAllocation(size_t size);
+
+}  // namespace utils
@@ -0,0 +1,314 @@
+#include "utils/animation_clip.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "spdlog/spdlog.h"
+
+namespace utils {
+
+namespace {
+
+// smallest-three中较小的三个分量在[-1/sqrt(2), 1/sqrt(2)]内
+constexpr float kRotationRange = 0.70710678f;
+constexpr float kRotationSteps = 32767.0f;
+constexpr float kVectorSteps = 65535.0f;
+
+glm::vec3 LerpVector(const glm::vec3& a, const glm::vec3& b, float t) {
+  return a + (b - a) * t;
+}
+
+// 与BlendPoses相同的nlerp，取最短路径
+glm::quat NlerpRotation(const glm::quat& a, const glm::quat& b, float t) {
+  float wb = glm::dot(a, b) < 0.0f ? -t : t;
+  glm::quat q(a.w * (1.0f - t) + b.w * wb, a.x * (1.0f - t) + b.x * wb, a.y * (1.0f - t) + b.y * wb,
+              a.z * (1.0f - t) + b.z * wb);
+  return glm::normalize(q);
+}
+
+// 导入的关键帧之间按slerp插值
+glm::quat SlerpRotation(const glm::quat& a, const glm::quat& b, float t) {
+  return glm::slerp(a, b, t);
+}
+
+float RotationError(const glm::quat& a, const glm::quat& b) {
+  float dot = std::min(1.0f, std::abs(glm::dot(a, b)));
+  return 2.0f * std::acos(dot);
+}
+
+// times升序，返回t处线性插值的值
+template <typename T, typename Lerp>
+T SampleKeys(const std::vector<float>& times, const std::vector<T>& values, float t, Lerp lerp) {
+  auto it = std::upper_bound(times.begin(), times.end(), t);
+  if (it == times.begin()) {
+    return values.front();
+  }
+  if (it == times.end()) {
+    return values.back();
+  }
+  size_t b = it - times.begin();
+  size_t a = b - 1;
+  float span = times[b] - times[a];
+  float fraction = span > 0.0f ? (t - times[a]) / span : 0.0f;
+  return lerp(values[a], values[b], fraction);
+}
+
+// 贪心地延长每一段，直到段内某一帧的线性插值误差超过容差。返回保留的帧号，全部在容差内时只保留第0帧
+template <typename T, typename Lerp, typename Error>
+std::vector<uint16_t> ReduceKeys(const std::vector<T>& values, float tolerance, Lerp lerp, Error error) {
+  std::vector<uint16_t> keys;
+  keys.push_back(0);
+  bool constant = true;
+  for (const T& value : values) {
+    constant = constant && error(values[0], value) <= tolerance;
+  }
+  if (constant) {
+    return keys;
+  }
+
+  size_t start = 0;
+  size_t last = values.size() - 1;
+  for (size_t end = start + 2; end <= last; end++) {
+    bool fits = true;
+    for (size_t i = start + 1; i < end && fits; i++) {
+      float t = static_cast<float>(i - start) / static_cast<float>(end - start);
+      fits = error(lerp(values[start], values[end], t), values[i]) <= tolerance;
+    }
+    if (!fits) {
+      start = end - 1;
+      keys.push_back(static_cast<uint16_t>(start));
+    }
+  }
+  if (keys.back() != last) {
+    keys.push_back(static_cast<uint16_t>(last));
+  }
+  return keys;
+}
+
+uint16_t QuantizeUnit(float value, float steps) {
+  return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * steps));
+}
+
+void EncodeRotation(glm::quat q, uint16_t* out) {
+  float c[4] = { q.x, q.y, q.z, q.w };
+  int largest = 0;
+  for (int i = 1; i < 4; i++) {
+    if (std::abs(c[i]) > std::abs(c[largest])) {
+      largest = i;
+    }
+  }
+  // q和-q是同一个旋转，让最大分量为正，解码时由其余分量算出
+  float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+  int n = 0;
+  for (int i = 0; i < 4; i++) {
+    if (i != largest) {
+      out[n++] = QuantizeUnit(c[i] * sign / (2.0f * kRotationRange) + 0.5f, kRotationSteps);
+    }
+  }
+  out[0] = static_cast<uint16_t>(out[0] | ((largest & 1) << 15));
+  out[1] = static_cast<uint16_t>(out[1] | ((largest >> 1) << 15));
+}
+
+uint32_t ResampledFrameCount(const RawAnimation& raw, float sample_rate) {
+  return static_cast<uint32_t>(std::ceil(std::max(0.0f, raw.duration) * sample_rate)) + 1;
+}
+
+}  // namespace
+
+size_t RawAnimation::memory_bytes() const {
+  size_t bytes = 0;
+  for (const RawJointTrack& track : tracks) {
+    bytes += (track.translation_times.size() + track.rotation_times.size() + track.scale_times.size()) *
+             sizeof(float);
+    bytes += (track.translations.size() + track.scales.size()) * sizeof(glm::vec3);
+    bytes += track.rotations.size() * sizeof(glm::quat);
+  }
+  return bytes;
+}
+
+glm::vec3 AnimationClip::DecodeVector(const Track& track, uint32_t key) const {
+  const uint16_t* values = &key_values_[key * 3];
+  glm::vec3 unit(values[0], values[1], values[2]);
+  return track.min + unit * (1.0f / kVectorSteps) * track.extent;
+}
+
+glm::quat AnimationClip::DecodeRotation(uint32_t key) const {
+  const uint16_t* values = &key_values_[key * 3];
+  float a = ((values[0] & 0x7fff) * (1.0f / kRotationSteps) - 0.5f) * (2.0f * kRotationRange);
+  float b = ((values[1] & 0x7fff) * (1.0f / kRotationSteps) - 0.5f) * (2.0f * kRotationRange);
+  float c = ((values[2] & 0x7fff) * (1.0f / kRotationSteps) - 0.5f) * (2.0f * kRotationRange);
+  float d = std::sqrt(std::max(0.0f, 1.0f - a * a - b * b - c * c));
+  // 其余三个分量按x、y、z、w的顺序存放
+  switch ((values[0] >> 15) | ((values[1] >> 15) << 1)) {
+    case 0:
+      return glm::quat(c, d, a, b);
+    case 1:
+      return glm::quat(c, a, d, b);
+    case 2:
+      return glm::quat(c, a, b, d);
+    default:
+      return glm::quat(d, a, b, c);
+  }
+}
+
+void AnimationClip::Sample(float time, TrsArrays* pose) const {
+  size_t joints = joint_count();
+  pose->Resize(joints);
+  float t = duration_ > 0.0f ? std::fmod(time, duration_) : 0.0f;
+  if (t < 0.0f) {
+    t += duration_;
+  }
+  float frame = std::min(t * sample_rate_, static_cast<float>(frame_count_ - 1));
+  auto whole_frame = static_cast<uint16_t>(frame);
+
+  for (size_t joint = 0; joint < joints; joint++) {
+    for (int channel = 0; channel < kChannelCount; channel++) {
+      const Track& track = tracks_[joint * kChannelCount + channel];
+      // a为frame之前（含）的最后一个关键帧
+      uint32_t a = track.first_key;
+      uint32_t b = a;
+      float fraction = 0.0f;
+      if (track.key_count > 1) {
+        // 无分支的二分查找，base停在最后一个帧号不大于frame的关键帧上，不含轨道的最后一个关键帧
+        const uint16_t* base = &key_frames_[track.first_key];
+        uint32_t n = track.key_count - 1;
+        while (n > 1) {
+          uint32_t half = n / 2;
+          base = base[half] <= whole_frame ? base + half : base;
+          n -= half;
+        }
+        a = static_cast<uint32_t>(base - key_frames_.data());
+        b = a + 1;
+        fraction = (frame - key_frames_[a]) / static_cast<float>(key_frames_[b] - key_frames_[a]);
+      }
+
+      if (channel == kRotation) {
+        glm::quat q = DecodeRotation(a);
+        if (b != a) {
+          q = NlerpRotation(q, DecodeRotation(b), fraction);
+        }
+        pose->rotation_x[joint] = q.x;
+        pose->rotation_y[joint] = q.y;
+        pose->rotation_z[joint] = q.z;
+        pose->rotation_w[joint] = q.w;
+        continue;
+      }
+      glm::vec3 v = DecodeVector(track, a);
+      if (b != a) {
+        v = LerpVector(v, DecodeVector(track, b), fraction);
+      }
+      if (channel == kTranslation) {
+        pose->position_x[joint] = v.x;
+        pose->position_y[joint] = v.y;
+        pose->position_z[joint] = v.z;
+      } else {
+        pose->scale_x[joint] = v.x;
+        pose->scale_y[joint] = v.y;
+        pose->scale_z[joint] = v.z;
+      }
+    }
+  }
+}
+
+size_t AnimationClip::memory_bytes() const {
+  return tracks_.size() * sizeof(Track) + key_frames_.size() * sizeof(uint16_t) +
+         key_values_.size() * sizeof(uint16_t);
+}
+
+bool CompressAnimation(const RawAnimation& raw, const Skeleton& skeleton, const AnimationCompressionOptions& options,
+                       AnimationClip* clip) {
+  size_t joints = skeleton.joint_count();
+  if (raw.tracks.size() > joints) {
+    SPDLOG_ERROR("Animation {} has {} tracks but the skeleton has {} joints", raw.name, raw.tracks.size(), joints);
+    return false;
+  }
+  uint32_t frame_count = ResampledFrameCount(raw, options.sample_rate);
+  if (options.sample_rate <= 0.0f || frame_count > 65536) {
+    SPDLOG_ERROR("Animation {} cannot be resampled to {} frames", raw.name, frame_count);
+    return false;
+  }
+
+  clip->name_ = raw.name;
+  clip->duration_ = raw.duration;
+  clip->sample_rate_ = options.sample_rate;
+  clip->frame_count_ = frame_count;
+  clip->tracks_.assign(joints * AnimationClip::kChannelCount, {});
+  clip->key_frames_.clear();
+  clip->key_values_.clear();
+
+  static const RawJointTrack kEmptyTrack;
+  std::vector<glm::vec3> vectors(frame_count);
+  std::vector<glm::quat> rotations(frame_count);
+  for (size_t joint = 0; joint < joints; joint++) {
+    const RawJointTrack& raw_track = joint < raw.tracks.size() ? raw.tracks[joint] : kEmptyTrack;
+    const TrsArrays& bind = skeleton.bind_pose;
+    for (int channel = 0; channel < AnimationClip::kChannelCount; channel++) {
+      AnimationClip::Track& track = clip->tracks_[joint * AnimationClip::kChannelCount + channel];
+      track.first_key = static_cast<uint32_t>(clip->key_frames_.size());
+
+      std::vector<uint16_t> keys;
+      if (channel == AnimationClip::kRotation) {
+        glm::quat bind_rotation(bind.rotation_w[joint], bind.rotation_x[joint], bind.rotation_y[joint],
+                                bind.rotation_z[joint]);
+        for (uint32_t f = 0; f < frame_count; f++) {
+          float t = std::min(f / options.sample_rate, raw.duration);
+          glm::quat q = raw_track.rotations.empty() ?
+                          bind_rotation :
+                          SampleKeys(raw_track.rotation_times, raw_track.rotations, t, SlerpRotation);
+          q = glm::normalize(q);
+          // 相邻帧在同一半球，关键帧之间的插值不会绕远路
+          if (f > 0 && glm::dot(rotations[f - 1], q) < 0.0f) {
+            q = glm::quat(-q.w, -q.x, -q.y, -q.z);
+          }
+          rotations[f] = q;
+        }
+        keys = ReduceKeys(rotations, options.rotation_tolerance, NlerpRotation, RotationError);
+        for (uint16_t key : keys) {
+          uint16_t values[3];
+          EncodeRotation(rotations[key], values);
+          clip->key_frames_.push_back(key);
+          clip->key_values_.insert(clip->key_values_.end(), values, values + 3);
+        }
+      } else {
+        bool translation = channel == AnimationClip::kTranslation;
+        const std::vector<float>& times = translation ? raw_track.translation_times : raw_track.scale_times;
+        const std::vector<glm::vec3>& values = translation ? raw_track.translations : raw_track.scales;
+        glm::vec3 bind_value = translation ?
+                                 glm::vec3(bind.position_x[joint], bind.position_y[joint], bind.position_z[joint]) :
+                                 glm::vec3(bind.scale_x[joint], bind.scale_y[joint], bind.scale_z[joint]);
+        for (uint32_t f = 0; f < frame_count; f++) {
+          float t = std::min(f / options.sample_rate, raw.duration);
+          vectors[f] = values.empty() ? bind_value : SampleKeys(times, values, t, LerpVector);
+        }
+        float tolerance = translation ? options.translation_tolerance : options.scale_tolerance;
+        keys = ReduceKeys(vectors, tolerance, LerpVector,
+                          [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); });
+
+        glm::vec3 min = vectors[keys[0]];
+        glm::vec3 max = min;
+        for (uint16_t key : keys) {
+          min = glm::min(min, vectors[key]);
+          max = glm::max(max, vectors[key]);
+        }
+        track.min = min;
+        track.extent = max - min;
+        for (uint16_t key : keys) {
+          clip->key_frames_.push_back(key);
+          for (int c = 0; c < 3; c++) {
+            float unit = track.extent[c] > 0.0f ? (vectors[key][c] - min[c]) / track.extent[c] : 0.0f;
+            clip->key_values_.push_back(QuantizeUnit(unit, kVectorSteps));
+          }
+        }
+      }
+      track.key_count = static_cast<uint32_t>(keys.size());
+    }
+  }
+  return true;
+}
+
+size_t ResampledAnimationBytes(const RawAnimation& raw, const Skeleton& skeleton,
+                               const AnimationCompressionOptions& options) {
+  return ResampledFrameCount(raw, options.sample_rate) * skeleton.joint_count() * 10 * sizeof(float);
+}
+
+}  // namespace utils
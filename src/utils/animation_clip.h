@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "utils/skeleton.h"
+#include "utils/transform_batch.h"
+
+namespace utils {
+
+// 导入的关键帧，时间单位为秒，各通道的关键帧互相独立。空通道保持绑定姿势
+struct RawJointTrack {
+  std::vector<float> translation_times;
+  std::vector<glm::vec3> translations;
+  std::vector<float> rotation_times;
+  std::vector<glm::quat> rotations;
+  std::vector<float> scale_times;
+  std::vector<glm::vec3> scales;
+};
+
+struct RawAnimation {
+  std::string name;
+  float duration = 0.0f;
+  // 下标与Skeleton的关节相同，数量可以少于关节数
+  std::vector<RawJointTrack> tracks;
+
+  // 关键帧时间和值按float存储的字节数
+  size_t memory_bytes() const;
+};
+
+struct AnimationCompressionOptions {
+  // 先按这个频率重采样，关键帧按帧号存储
+  float sample_rate = 30.0f;
+  // 去掉线性插值误差不超过容差的关键帧。旋转的单位是弧度
+  float translation_tolerance = 0.001f;
+  float rotation_tolerance = 0.001f;
+  float scale_tolerance = 0.001f;
+};
+
+// 压缩后的动画。每个关节的平移、旋转、缩放各一条轨道，按容差去掉可以线性插值得到的关键帧，
+// 剩下的关键帧存uint16帧号：平移和缩放按轨道的取值范围量化为3个uint16，
+// 旋转用smallest-three量化为3个uint16（两个最高位存最大分量的下标，其余每个分量15位）。
+// Sample只读，可以在多个线程同时调用
+class AnimationClip {
+public:
+  // time超出时长时循环。pose会被调整为关节数量
+  void Sample(float time, TrsArrays* pose) const;
+
+  const std::string& name() const {
+    return name_;
+  }
+
+  float duration() const {
+    return duration_;
+  }
+
+  size_t joint_count() const {
+    return tracks_.size() / kChannelCount;
+  }
+
+  size_t key_count() const {
+    return key_frames_.size();
+  }
+
+  // 压缩数据（轨道描述、帧号和量化值）占用的字节数
+  size_t memory_bytes() const;
+
+private:
+  friend bool CompressAnimation(const RawAnimation& raw, const Skeleton& skeleton,
+                                const AnimationCompressionOptions& options, AnimationClip* clip);
+
+  enum Channel {
+    kTranslation,
+    kRotation,
+    kScale,
+    kChannelCount,
+  };
+
+  struct Track {
+    uint32_t first_key = 0;
+    uint32_t key_count = 0;
+    // 平移和缩放的量化范围，旋转不用
+    glm::vec3 min{ 0.0f };
+    glm::vec3 extent{ 0.0f };
+  };
+
+  glm::vec3 DecodeVector(const Track& track, uint32_t key) const;
+  glm::quat DecodeRotation(uint32_t key) const;
+
+private:
+  std::string name_;
+  float duration_ = 0.0f;
+  float sample_rate_ = 30.0f;
+  uint32_t frame_count_ = 0;
+  // tracks_[joint * kChannelCount + channel]
+  std::vector<Track> tracks_;
+  std::vector<uint16_t> key_frames_;
+  // 每个关键帧3个值
+  std::vector<uint16_t> key_values_;
+};
+
+// 重采样、拟合并量化raw。动画超过65535帧或轨道多于关节时返回false
+bool CompressAnimation(const RawAnimation& raw, const Skeleton& skeleton, const AnimationCompressionOptions& options,
+                       AnimationClip* clip);
+
+// 按options.sample_rate重采样后每帧每个关节存10个float所需的字节数，作为压缩前的对照
+size_t ResampledAnimationBytes(const RawAnimation& raw, const Skeleton& skeleton,
+                               const AnimationCompressionOptions& options);
+
+}  // namespace utils
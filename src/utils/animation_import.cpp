@@ -0,0 +1,236 @@
+#include "utils/animation_import.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+#include "spdlog/spdlog.h"
+
+namespace utils {
+
+namespace {
+
+// 没有设置时Assimp按每秒25个tick处理
+constexpr double kDefaultTicksPerSecond = 25.0;
+
+// aiMatrix4x4和Matrix3x4都按行存储
+Matrix3x4 ToMatrix3x4(const aiMatrix4x4& m) {
+  Matrix3x4 result;
+  result.rows[0] = glm::vec4(m.a1, m.a2, m.a3, m.a4);
+  result.rows[1] = glm::vec4(m.b1, m.b2, m.b3, m.b4);
+  result.rows[2] = glm::vec4(m.c1, m.c2, m.c3, m.c4);
+  return result;
+}
+
+class SkeletonBuilder {
+public:
+  explicit SkeletonBuilder(const aiScene* scene) {
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+      const aiMesh* mesh = scene->mMeshes[m];
+      for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        offsets_[mesh->mBones[b]->mName.C_Str()] = mesh->mBones[b]->mOffsetMatrix;
+      }
+    }
+  }
+
+  // 场景根节点总是关节0，没有骨骼的子网格绑定到它
+  bool Build(const aiNode* root, Skeleton* skeleton) {
+    MarkNeeded(root);
+    needed_.insert(root);
+    positions_.clear();
+    rotations_.clear();
+    scales_.clear();
+    if (!AddJoints(root, -1, skeleton)) {
+      return false;
+    }
+    skeleton->bind_pose.Resize(skeleton->joint_count());
+    for (size_t i = 0; i < skeleton->joint_count(); i++) {
+      skeleton->bind_pose.Set(i, positions_[i], rotations_[i], scales_[i]);
+    }
+    return true;
+  }
+
+  // 没有找到时返回-1
+  int FindJoint(const char* name) const {
+    auto it = joints_.find(name);
+    return it != joints_.end() ? it->second : -1;
+  }
+
+private:
+  // node或它的子孙是骨骼时返回true
+  bool MarkNeeded(const aiNode* node) {
+    bool needed = offsets_.count(node->mName.C_Str()) > 0;
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+      needed = MarkNeeded(node->mChildren[i]) || needed;
+    }
+    if (needed) {
+      needed_.insert(node);
+    }
+    return needed;
+  }
+
+  bool AddJoints(const aiNode* node, int parent, Skeleton* skeleton) {
+    if (needed_.count(node) == 0) {
+      return true;
+    }
+    if (skeleton->joint_count() >= kMaxJoints) {
+      SPDLOG_ERROR("Skeleton has more than {} joints", kMaxJoints);
+      return false;
+    }
+    int index = static_cast<int>(skeleton->joint_count());
+    std::string name = node->mName.C_Str();
+    skeleton->joint_names.push_back(name);
+    skeleton->parents.push_back(static_cast<int16_t>(parent));
+    // 骨骼的祖先节点不直接影响顶点，逆绑定矩阵用不到
+    Matrix3x4 inverse_bind = { { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                                 glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) } };
+    auto offset = offsets_.find(name);
+    if (offset != offsets_.end()) {
+      inverse_bind = ToMatrix3x4(offset->second);
+    }
+    skeleton->inverse_bind.push_back(inverse_bind);
+    joints_[name] = index;
+
+    aiVector3D scaling;
+    aiQuaternion rotation;
+    aiVector3D position;
+    node->mTransformation.Decompose(scaling, rotation, position);
+    positions_.emplace_back(position.x, position.y, position.z);
+    rotations_.emplace_back(rotation.w, rotation.x, rotation.y, rotation.z);
+    scales_.emplace_back(scaling.x, scaling.y, scaling.z);
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+      if (!AddJoints(node->mChildren[i], index, skeleton)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::unordered_map<std::string, aiMatrix4x4> offsets_;
+  std::unordered_set<const aiNode*> needed_;
+  std::unordered_map<std::string, int> joints_;
+  std::vector<glm::vec3> positions_;
+  std::vector<glm::quat> rotations_;
+  std::vector<glm::vec3> scales_;
+};
+
+void ImportMeshes(const aiScene* scene, const SkeletonBuilder& builder, SkinnedMeshData* mesh) {
+  mesh->vertices.clear();
+  mesh->indices.clear();
+  std::vector<std::vector<std::pair<uint32_t, float>>> influences;
+  std::vector<uint32_t> joints;
+  std::vector<float> weights;
+  for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+    const aiMesh* src = scene->mMeshes[m];
+    uint32_t base = static_cast<uint32_t>(mesh->vertices.size());
+
+    influences.assign(src->mNumVertices, {});
+    for (unsigned int b = 0; b < src->mNumBones; b++) {
+      const aiBone* bone = src->mBones[b];
+      int joint = builder.FindJoint(bone->mName.C_Str());
+      for (unsigned int w = 0; w < bone->mNumWeights && joint >= 0; w++) {
+        influences[bone->mWeights[w].mVertexId].emplace_back(joint, bone->mWeights[w].mWeight);
+      }
+    }
+
+    for (unsigned int v = 0; v < src->mNumVertices; v++) {
+      SkinnedVertex vertex = {};
+      vertex.position = glm::vec3(src->mVertices[v].x, src->mVertices[v].y, src->mVertices[v].z);
+      if (src->mNormals != nullptr) {
+        vertex.normal = glm::vec3(src->mNormals[v].x, src->mNormals[v].y, src->mNormals[v].z);
+      }
+      if (src->mTextureCoords[0] != nullptr) {
+        vertex.uv = glm::vec2(src->mTextureCoords[0][v].x, src->mTextureCoords[0][v].y);
+      }
+      joints.clear();
+      weights.clear();
+      for (const auto& influence : influences[v]) {
+        joints.push_back(influence.first);
+        weights.push_back(influence.second);
+      }
+      QuantizeWeights(joints.data(), weights.data(), static_cast<int>(joints.size()), &vertex);
+      mesh->vertices.push_back(vertex);
+    }
+
+    for (unsigned int f = 0; f < src->mNumFaces; f++) {
+      const aiFace& face = src->mFaces[f];
+      // 三角化后只剩下点和线
+      if (face.mNumIndices != 3) {
+        continue;
+      }
+      for (unsigned int i = 0; i < 3; i++) {
+        mesh->indices.push_back(base + face.mIndices[i]);
+      }
+    }
+  }
+}
+
+void ImportAnimations(const aiScene* scene, const SkeletonBuilder& builder, size_t joint_count,
+                      std::vector<RawAnimation>* animations) {
+  animations->clear();
+  for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+    const aiAnimation* src = scene->mAnimations[a];
+    double ticks = src->mTicksPerSecond > 0.0 ? src->mTicksPerSecond : kDefaultTicksPerSecond;
+    RawAnimation animation;
+    animation.name = src->mName.C_Str();
+    animation.duration = static_cast<float>(src->mDuration / ticks);
+    animation.tracks.resize(joint_count);
+    for (unsigned int c = 0; c < src->mNumChannels; c++) {
+      const aiNodeAnim* channel = src->mChannels[c];
+      int joint = builder.FindJoint(channel->mNodeName.C_Str());
+      if (joint < 0) {
+        continue;
+      }
+      RawJointTrack& track = animation.tracks[joint];
+      for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+        const aiVectorKey& key = channel->mPositionKeys[k];
+        track.translation_times.push_back(static_cast<float>(key.mTime / ticks));
+        track.translations.emplace_back(key.mValue.x, key.mValue.y, key.mValue.z);
+      }
+      for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+        const aiQuatKey& key = channel->mRotationKeys[k];
+        track.rotation_times.push_back(static_cast<float>(key.mTime / ticks));
+        track.rotations.emplace_back(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z);
+      }
+      for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+        const aiVectorKey& key = channel->mScalingKeys[k];
+        track.scale_times.push_back(static_cast<float>(key.mTime / ticks));
+        track.scales.emplace_back(key.mValue.x, key.mValue.y, key.mValue.z);
+      }
+    }
+    animations->push_back(std::move(animation));
+  }
+}
+
+}  // namespace
+
+bool ImportSkinnedModel(const std::string& path, SkinnedMeshData* mesh, Skeleton* skeleton,
+                        std::vector<RawAnimation>* animations) {
+  Assimp::Importer importer;
+  const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals |
+                                                   aiProcess_JoinIdenticalVertices | aiProcess_LimitBoneWeights);
+  if (scene == nullptr || scene->mRootNode == nullptr) {
+    SPDLOG_ERROR("Failed to import {}: {}", path, importer.GetErrorString());
+    return false;
+  }
+
+  *skeleton = Skeleton();
+  SkeletonBuilder builder(scene);
+  if (!builder.Build(scene->mRootNode, skeleton)) {
+    return false;
+  }
+  ImportMeshes(scene, builder, mesh);
+  if (animations != nullptr) {
+    ImportAnimations(scene, builder, skeleton->joint_count(), animations);
+  }
+  SPDLOG_INFO("Imported {}: {} vertices, {} joints, {} animations", path, mesh->vertices.size(),
+              skeleton->joint_count(), animations != nullptr ? animations->size() : 0);
+  return true;
+}
+
+}  // namespace utils
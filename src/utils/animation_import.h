@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "utils/animation_clip.h"
+#include "utils/skeleton.h"
+
+namespace utils {
+
+// 用Assimp读取带骨骼的模型，所有子网格合并为一个SkinnedMeshData。
+// 关节为所有骨骼及其祖先节点，按深度优先顺序排列；每个顶点最多保留4个影响。
+// 没有骨骼的子网格绑定到根关节。animations可以为空，此时不读取动画
+bool ImportSkinnedModel(const std::string& path, SkinnedMeshData* mesh, Skeleton* skeleton,
+                        std::vector<RawAnimation>* animations);
+
+}  // namespace utils
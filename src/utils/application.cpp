@@ -0,0 +1,228 @@
+#include "utils/application.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+bool ParseApplicationOptions(int argc, char** argv, ApplicationOptions* options) {
+  if (!ParseContextOptions(argc, argv, &options->context)) {
+    return false;
+  }
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--serial") == 0) {
+      options->pipelined = false;
+    } else if (strcmp(argv[i], "--sim-hz") == 0) {
+      double hz = i + 1 < argc ? atof(argv[i + 1]) : 0.0;
+      if (hz <= 0.0) {
+        SPDLOG_ERROR("Invalid --sim-hz value.");
+        return false;
+      }
+      options->fixed_step = 1.0 / hz;
+      i++;
+    }
+  }
+  return true;
+}
+
+ApplicationBase::~ApplicationBase() {
+  // 正常情况下Run结束前已经停止，这里只防止异常路径上线程没有join
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    job_cv_.notify_one();
+    worker_.join();
+  }
+}
+
+int ApplicationBase::Run() {
+  if (!context_.Init(options_.context)) {
+    return -1;
+  }
+  InstallCallbacks();
+  if (!Init()) {
+    return -1;
+  }
+
+  PublishInitial(0);
+  int read_slot = 0;
+  float alphas[2] = { 0.0f, 0.0f };
+  bool in_flight = false;
+  if (options_.pipelined) {
+    StartWorker();
+  }
+
+  while (context_.BeginFrame()) {
+    PROFILE_BEGIN_FRAME();
+    Job job;
+    float alpha = 0.0f;
+    job.steps = AdvanceClock(context_.delta_time(), &alpha);
+    // 这一帧不推进模拟时输入留到下一次，鼠标增量和按下过的键继续累计，不会被丢掉
+    if (job.steps > 0) {
+      job.input = TakeInput();
+    }
+
+    if (options_.pipelined) {
+      // 上一帧交出去的模拟完成后它的结果成为这一帧要渲染的快照，随即开始下一次模拟
+      if (in_flight) {
+        PROFILE_SCOPE("WaitSimulation");
+        Wait();
+        read_slot = 1 - read_slot;
+      }
+      job.read_slot = read_slot;
+      job.write_slot = 1 - read_slot;
+      alphas[job.write_slot] = alpha;
+      Submit(std::move(job));
+      in_flight = true;
+    } else {
+      {
+        PROFILE_SCOPE("Simulate");
+        RunSimulation(1 - read_slot, read_slot, job.input, job.steps);
+      }
+      read_slot = 1 - read_slot;
+      alphas[read_slot] = alpha;
+    }
+
+    {
+      GPU_PROFILE_SCOPE("Render");
+      RenderSnapshot(read_slot, alphas[read_slot]);
+    }
+    PROFILE_END_FRAME();
+    context_.EndFrame();
+  }
+
+  StopWorker();
+  Shutdown();
+  Profiler::Instance().ReleaseGpu();
+  context_.LogTimingStats();
+  return 0;
+}
+
+void ApplicationBase::InstallCallbacks() {
+  GLFWwindow* window = context_.window();
+  if (window == nullptr) {
+    return;
+  }
+  glfwSetWindowUserPointer(window, this);
+  glfwSetKeyCallback(window, KeyCallback);
+  glfwSetCursorPosCallback(window, CursorPosCallback);
+  glfwSetScrollCallback(window, ScrollCallback);
+}
+
+InputState ApplicationBase::TakeInput() {
+  InputState input = pending_input_;
+  pending_input_.keys_pressed.reset();
+  pending_input_.mouse_dx = 0.0f;
+  pending_input_.mouse_dy = 0.0f;
+  pending_input_.scroll = 0.0f;
+  return input;
+}
+
+int ApplicationBase::AdvanceClock(double delta_time, float* alpha) {
+  double step = options_.fixed_step;
+  accumulator_ += delta_time;
+  int steps = static_cast<int>(accumulator_ / step);
+  if (steps > options_.max_steps) {
+    steps = options_.max_steps;
+  }
+  accumulator_ -= steps * step;
+  if (accumulator_ >= step) {
+    accumulator_ = std::fmod(accumulator_, step);
+  }
+  *alpha = static_cast<float>(accumulator_ / step);
+  return steps;
+}
+
+void ApplicationBase::StartWorker() {
+  quit_ = false;
+  job_pending_ = false;
+  worker_ = std::thread(&ApplicationBase::WorkerLoop, this);
+}
+
+void ApplicationBase::StopWorker() {
+  if (!worker_.joinable()) {
+    return;
+  }
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  job_cv_.notify_one();
+  worker_.join();
+}
+
+void ApplicationBase::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    job_cv_.wait(lock, [this] { return job_pending_ || quit_; });
+    if (quit_) {
+      return;
+    }
+    lock.unlock();
+    {
+      PROFILE_SCOPE("Simulate");
+      RunSimulation(job_.write_slot, job_.read_slot, job_.input, job_.steps);
+    }
+    lock.lock();
+    job_pending_ = false;
+    done_cv_.notify_one();
+  }
+}
+
+void ApplicationBase::Submit(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = std::move(job);
+    job_pending_ = true;
+  }
+  job_cv_.notify_one();
+}
+
+void ApplicationBase::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return !job_pending_; });
+}
+
+void ApplicationBase::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  auto* app = static_cast<ApplicationBase*>(glfwGetWindowUserPointer(window));
+  if (key < 0 || key > GLFW_KEY_LAST) {
+    return;
+  }
+  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+  }
+  if (action == GLFW_PRESS) {
+    app->pending_input_.keys_down.set(key);
+    app->pending_input_.keys_pressed.set(key);
+  } else if (action == GLFW_RELEASE) {
+    app->pending_input_.keys_down.reset(key);
+  }
+}
+
+void ApplicationBase::CursorPosCallback(GLFWwindow* window, double x_pos, double y_pos) {
+  auto* app = static_cast<ApplicationBase*>(glfwGetWindowUserPointer(window));
+  if (app->first_mouse_) {
+    app->last_x_ = x_pos;
+    app->last_y_ = y_pos;
+    app->first_mouse_ = false;
+  }
+  app->pending_input_.mouse_dx += static_cast<float>(x_pos - app->last_x_);
+  app->pending_input_.mouse_dy += static_cast<float>(app->last_y_ - y_pos);
+  app->last_x_ = x_pos;
+  app->last_y_ = y_pos;
+}
+
+void ApplicationBase::ScrollCallback(GLFWwindow* window, double x_offset, double y_offset) {
+  auto* app = static_cast<ApplicationBase*>(glfwGetWindowUserPointer(window));
+  app->pending_input_.scroll += static_cast<float>(y_offset);
+}
+
+}  // namespace utils
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <bitset>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "utils/gl_context.h"
+
+namespace utils {
+
+struct ApplicationOptions {
+  ContextOptions context;
+  // 固定的模拟步长（秒）
+  double fixed_step = 1.0 / 60.0;
+  // 一帧最多补几步，渲染太慢时丢掉多余的时间，避免越追越慢
+  int max_steps = 8;
+  // false时模拟与渲染在GL线程上串行执行，用于对比和调试
+  bool pipelined = true;
+};
+
+// 在ParseContextOptions的基础上增加：--serial --sim-hz N
+bool ParseApplicationOptions(int argc, char** argv, ApplicationOptions* options);
+
+// 两次推进模拟之间GL线程上收集到的输入
+struct InputState {
+  std::bitset<GLFW_KEY_LAST + 1> keys_down;
+  // 这段时间内按下过的键
+  std::bitset<GLFW_KEY_LAST + 1> keys_pressed;
+  float mouse_dx = 0.0f;
+  float mouse_dy = 0.0f;
+  float scroll = 0.0f;
+
+  bool down(int key) const {
+    return key >= 0 && key <= GLFW_KEY_LAST && keys_down[key];
+  }
+
+  bool pressed(int key) const {
+    return key >= 0 && key <= GLFW_KEY_LAST && keys_pressed[key];
+  }
+};
+
+// 共用的主循环：创建GL上下文、收集输入、固定步长模拟、渲染。
+// 流水线模式下第N帧开始时把第N帧的模拟交给工作线程，GL线程同时渲染第N-1帧模拟出的快照，
+// 模拟的开销被渲染和提交掩盖，代价是画面比输入晚一帧。
+// 一般不直接继承它，而是继承Application<Snapshot>。
+class ApplicationBase {
+public:
+  explicit ApplicationBase(const ApplicationOptions& options) : options_(options) {}
+  virtual ~ApplicationBase();
+
+  ApplicationBase(const ApplicationBase&) = delete;
+  ApplicationBase& operator=(const ApplicationBase&) = delete;
+
+  // 运行到窗口关闭或达到帧数，返回进程退出码
+  int Run();
+
+  GlContext& context() {
+    return context_;
+  }
+
+  const ApplicationOptions& options() const {
+    return options_;
+  }
+
+protected:
+  // GL线程，上下文创建之后、第一次模拟之前
+  virtual bool Init() {
+    return true;
+  }
+
+  // GL线程，主循环结束后（工作线程已空闲）
+  virtual void Shutdown() {}
+
+  // 用当前模拟状态初始化快照槽slot
+  virtual void PublishInitial(int slot) = 0;
+  // 执行steps步模拟，结果写入快照槽write_slot，read_slot为上一次的结果。流水线模式下在工作线程调用
+  virtual void RunSimulation(int write_slot, int read_slot, const InputState& input, int steps) = 0;
+  // GL线程，alpha为上一步到最新一步之间的插值系数
+  virtual void RenderSnapshot(int slot, float alpha) = 0;
+
+private:
+  struct Job {
+    int write_slot = 0;
+    int read_slot = 0;
+    int steps = 0;
+    InputState input;
+  };
+
+  void InstallCallbacks();
+  InputState TakeInput();
+  int AdvanceClock(double delta_time, float* alpha);
+
+  void StartWorker();
+  void StopWorker();
+  void WorkerLoop();
+  void Submit(Job job);
+  void Wait();
+
+  static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+  static void CursorPosCallback(GLFWwindow* window, double x_pos, double y_pos);
+  static void ScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+
+private:
+  ApplicationOptions options_;
+  GlContext context_;
+  double accumulator_ = 0.0;
+
+  // 只在GL线程访问
+  InputState pending_input_;
+  bool first_mouse_ = true;
+  double last_x_ = 0.0;
+  double last_y_ = 0.0;
+
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  Job job_;
+  bool job_pending_ = false;
+  bool quit_ = false;
+};
+
+// Snapshot是渲染需要的那部分模拟状态（位置、朝向等），应当可以廉价地复制。
+// 子类实现：
+//   HandleInput(input)  工作线程，每次推进模拟（steps>0）前调用一次，一般只记录意图，在Simulate里使用
+//   Simulate(step)      工作线程，推进一个固定步长
+//   Publish(snapshot)   工作线程，把当前模拟状态写入快照
+//   Render(previous, current, alpha)  GL线程，在最后两步的快照之间插值后绘制
+// 模拟一侧不能调用GL；渲染一侧只能读快照，不能访问模拟状态。
+template <typename Snapshot>
+class Application : public ApplicationBase {
+public:
+  explicit Application(const ApplicationOptions& options) : ApplicationBase(options) {}
+
+protected:
+  virtual void HandleInput(const InputState& input) {}
+  virtual void Simulate(double step) = 0;
+  virtual void Publish(Snapshot* snapshot) = 0;
+  virtual void Render(const Snapshot& previous, const Snapshot& current, float alpha) = 0;
+
+private:
+  // 一个槽保存一次模拟任务的最后两步，两个槽轮流由工作线程写、GL线程读
+  struct Slot {
+    Snapshot previous;
+    Snapshot current;
+  };
+
+  void PublishInitial(int slot) final {
+    Publish(&slots_[slot].current);
+    slots_[slot].previous = slots_[slot].current;
+  }
+
+  void RunSimulation(int write_slot, int read_slot, const InputState& input, int steps) final {
+    Slot& out = slots_[write_slot];
+    const Slot& in = slots_[read_slot];
+    if (steps == 0) {
+      out = in;
+      return;
+    }
+    HandleInput(input);
+    for (int i = 0; i < steps; i++) {
+      if (i + 1 == steps) {
+        // 最后一步之前的状态，只有一步时就是上一次的结果
+        if (steps == 1) {
+          out.previous = in.current;
+        } else {
+          Publish(&out.previous);
+        }
+      }
+      Simulate(options().fixed_step);
+    }
+    Publish(&out.current);
+  }
+
+  void RenderSnapshot(int slot, float alpha) final {
+    Render(slots_[slot].previous, slots_[slot].current, alpha);
+  }
+
+private:
+  Slot slots_[2];
+};
+
+}  // namespace utils
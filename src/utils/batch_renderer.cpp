@@ -0,0 +1,299 @@
+#include "utils/batch_renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+
+namespace utils {
+
+namespace {
+
+double NowMs() {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+BatchRenderer::~BatchRenderer() {
+  Release();
+}
+
+bool BatchRenderer::Init(const BatchRenderOptions& options) {
+  Release();
+  options_ = options;
+  if (options_.width <= 0 || options_.height <= 0) {
+    SPDLOG_ERROR("Invalid batch render size {}x{}", options_.width, options_.height);
+    return false;
+  }
+  GLint max_layers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+  if (options_.mode == BatchTargetMode::kSequential) {
+    options_.batch_size = 1;
+  } else if (options_.batch_size < 1 || options_.batch_size > max_layers) {
+    SPDLOG_ERROR("Batch size {} out of range [1, {}]", options_.batch_size, max_layers);
+    return false;
+  }
+  options_.max_queued_images = std::max(options_.max_queued_images, 1);
+
+  glGenTextures(1, &color_texture_);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, color_texture_);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, options_.width, options_.height, options_.batch_size, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // 每个视角渲染前都会清除深度，所有层共用一个深度缓冲
+  glGenRenderbuffers(1, &depth_buffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options_.width, options_.height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  GLint previous_framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+  glGenFramebuffers(1, &framebuffer_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color_texture_, 0, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    SPDLOG_ERROR("Batch render target {}x{} is incomplete: {:#x}", options_.width, options_.height, status);
+    Release();
+    return false;
+  }
+
+  // 两个PBO轮流使用：一个在GPU上接收这一批的读回，另一个在CPU上取出上一批
+  if (options_.mode == BatchTargetMode::kLayered) {
+    glGenBuffers(2, pack_buffers_);
+    for (GLuint buffer : pack_buffers_) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+      glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(image_bytes() * options_.batch_size), nullptr,
+                   GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  return true;
+}
+
+void BatchRenderer::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    framebuffer_ = 0;
+  }
+  if (color_texture_ != 0) {
+    glDeleteTextures(1, &color_texture_);
+    color_texture_ = 0;
+  }
+  if (depth_buffer_ != 0) {
+    glDeleteRenderbuffers(1, &depth_buffer_);
+    depth_buffer_ = 0;
+  }
+  if (pack_buffers_[0] != 0) {
+    glDeleteBuffers(2, pack_buffers_);
+    pack_buffers_[0] = 0;
+    pack_buffers_[1] = 0;
+  }
+}
+
+bool BatchRenderer::Render(const std::vector<CameraPose>& poses, const DrawFunc& draw, const ImageSink& sink) {
+  stats_ = BatchRenderStats();
+  if (framebuffer_ == 0) {
+    SPDLOG_ERROR("BatchRenderer is not initialized.");
+    return false;
+  }
+  double start = NowMs();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.clear();
+    done_ = false;
+    failed_ = false;
+    write_ms_ = 0.0;
+  }
+  std::thread writer(&BatchRenderer::WriterLoop, this, std::cref(sink));
+
+  GLint previous_draw = 0;
+  GLint previous_read = 0;
+  GLint previous_viewport[4] = { 0, 0, 0, 0 };
+  GLint pack_alignment = 4;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw);
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+  glGetIntegerv(GL_VIEWPORT, previous_viewport);
+  glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glViewport(0, 0, options_.width, options_.height);
+
+  FpsCamera camera(glm::vec3(0.0f));
+  camera.SetPerspective(static_cast<float>(options_.width) / static_cast<float>(options_.height),
+                        options_.near_plane, options_.far_plane);
+
+  bool ok = true;
+  if (options_.mode == BatchTargetMode::kSequential) {
+    for (size_t i = 0; i < poses.size() && ok; i++) {
+      double render_start = NowMs();
+      DrawView(poses[i], 0, draw, &camera);
+      double readback_start = NowMs();
+      stats_.render_ms += readback_start - render_start;
+
+      Image image;
+      image.index = i;
+      image.rgba.resize(image_bytes());
+      glReadPixels(0, 0, options_.width, options_.height, GL_RGBA, GL_UNSIGNED_BYTE, image.rgba.data());
+      stats_.readback_ms += NowMs() - readback_start;
+      stats_.batches++;
+      ok = PushImage(std::move(image));
+    }
+  } else {
+    size_t batch_size = static_cast<size_t>(options_.batch_size);
+    PendingBatch previous;
+    int buffer = 0;
+    for (size_t first = 0; first < poses.size() && ok; first += batch_size) {
+      double render_start = NowMs();
+      PendingBatch batch;
+      batch.buffer = buffer;
+      batch.first = first;
+      batch.count = std::min(batch_size, poses.size() - first);
+      for (size_t i = 0; i < batch.count; i++) {
+        DrawView(poses[first + i], static_cast<int>(i), draw, &camera);
+      }
+      // 整批画完后再发出读回，读回写到PBO，不等待GPU
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffers_[buffer]);
+      for (size_t i = 0; i < batch.count; i++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color_texture_, 0, static_cast<GLint>(i));
+        glReadPixels(0, 0, options_.width, options_.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                     reinterpret_cast<void*>(i * image_bytes()));
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      stats_.render_ms += NowMs() - render_start;
+      stats_.batches++;
+
+      // 这一批已经在GPU上排队，此时取出上一批，CPU拷贝与GPU渲染重叠
+      if (previous.fence != nullptr) {
+        ok = CollectBatch(&previous);
+      }
+      previous = batch;
+      buffer ^= 1;
+    }
+    if (previous.fence != nullptr) {
+      if (ok) {
+        ok = CollectBatch(&previous);
+      } else {
+        glDeleteSync(previous.fence);
+      }
+    }
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+  glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous_draw));
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_read));
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  cv_.notify_all();
+  writer.join();
+  stats_.write_ms = write_ms_;
+  stats_.total_ms = NowMs() - start;
+  return ok && !failed_;
+}
+
+void BatchRenderer::DrawView(const CameraPose& pose, int layer, const DrawFunc& draw, FpsCamera* camera) {
+  glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color_texture_, 0, layer);
+  const glm::vec4& color = options_.clear_color;
+  glClearColor(color.x, color.y, color.z, color.w);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  pose.ApplyTo(camera);
+  draw(camera);
+}
+
+bool BatchRenderer::CollectBatch(PendingBatch* batch) {
+  double start = NowMs();
+  GLenum result = glClientWaitSync(batch->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  while (result == GL_TIMEOUT_EXPIRED) {
+    result = glClientWaitSync(batch->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  }
+  glDeleteSync(batch->fence);
+  batch->fence = nullptr;
+  if (result == GL_WAIT_FAILED) {
+    SPDLOG_ERROR("glClientWaitSync failed on batch starting at view {}.", batch->first);
+    return false;
+  }
+
+  size_t bytes = image_bytes();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffers_[batch->buffer]);
+  const auto* data = static_cast<const uint8_t*>(glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes * batch->count), GL_MAP_READ_BIT));
+  if (data == nullptr) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    SPDLOG_ERROR("Failed to map readback buffer.");
+    return false;
+  }
+  std::vector<Image> images(batch->count);
+  for (size_t i = 0; i < batch->count; i++) {
+    images[i].index = batch->first + i;
+    images[i].rgba.assign(data + i * bytes, data + (i + 1) * bytes);
+  }
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  stats_.readback_ms += NowMs() - start;
+
+  for (Image& image : images) {
+    if (!PushImage(std::move(image))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BatchRenderer::PushImage(Image image) {
+  double start = NowMs();
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return failed_ || queue_.size() < static_cast<size_t>(options_.max_queued_images); });
+  stats_.queue_wait_ms += NowMs() - start;
+  if (failed_) {
+    return false;
+  }
+  queue_.push_back(std::move(image));
+  stats_.images++;
+  lock.unlock();
+  cv_.notify_all();
+  return true;
+}
+
+void BatchRenderer::WriterLoop(const ImageSink& sink) {
+  while (true) {
+    Image image;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return done_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      image = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    // 唤醒等待队列空位的渲染线程
+    cv_.notify_all();
+
+    double start = NowMs();
+    bool ok = sink(image.index, image.rgba);
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_ms_ += NowMs() - start;
+    if (!ok) {
+      failed_ = true;
+      cv_.notify_all();
+      return;
+    }
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "utils/camera_recorder.h"
+#include "utils/fps_camera.h"
+
+namespace utils {
+
+enum class BatchTargetMode {
+  // 所有视角依次渲染到同一个目标，每张图渲染完立即同步读回
+  kSequential,
+  // 一批视角渲染到纹理数组的各层，整批异步读回到PBO，渲染下一批时再取出上一批的结果
+  kLayered,
+};
+
+struct BatchRenderOptions {
+  int width = 256;
+  int height = 256;
+  BatchTargetMode mode = BatchTargetMode::kLayered;
+  // kLayered模式下纹理数组的层数
+  int batch_size = 16;
+  // 等待写出的图片数超过该值时渲染暂停，限制内存占用
+  int max_queued_images = 64;
+  float near_plane = 0.1f;
+  float far_plane = 100.0f;
+  glm::vec4 clear_color = glm::vec4(0.2f, 0.3f, 0.4f, 1.0f);
+};
+
+struct BatchRenderStats {
+  size_t images = 0;
+  size_t batches = 0;
+  // GL线程上提交绘制命令、等待读回、等待写出队列的时间
+  double render_ms = 0.0;
+  double readback_ms = 0.0;
+  double queue_wait_ms = 0.0;
+  // 写出线程上sink的总时间
+  double write_ms = 0.0;
+  double total_ms = 0.0;
+
+  double images_per_second() const {
+    return total_ms > 0.0 ? static_cast<double>(images) * 1000.0 / total_ms : 0.0;
+  }
+};
+
+// 场景只加载一次，按视角列表批量渲染缩略图。图片在独立的写出线程上按视角顺序交给sink，
+// 编码和写文件与渲染重叠。只能在GL线程调用，渲染到自己的帧缓冲，结束后恢复原来的绑定。
+class BatchRenderer {
+public:
+  // 绘制场景，帧缓冲、视口和清屏已经设置好，camera的宽高比与目标一致
+  using DrawFunc = std::function<void(FpsCamera* camera)>;
+  // 在写出线程上调用，rgba为按行紧密排列的RGBA8，第0行在底部；返回false时停止渲染
+  using ImageSink = std::function<bool(size_t index, const std::vector<uint8_t>& rgba)>;
+
+  BatchRenderer() = default;
+  ~BatchRenderer();
+
+  BatchRenderer(const BatchRenderer&) = delete;
+  BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+  bool Init(const BatchRenderOptions& options);
+  void Release();
+
+  // 渲染所有视角，返回时所有图片都已经交给sink
+  bool Render(const std::vector<CameraPose>& poses, const DrawFunc& draw, const ImageSink& sink);
+
+  const BatchRenderStats& stats() const {
+    return stats_;
+  }
+
+  int width() const {
+    return options_.width;
+  }
+
+  int height() const {
+    return options_.height;
+  }
+
+private:
+  struct Image {
+    size_t index = 0;
+    std::vector<uint8_t> rgba;
+  };
+
+  // 已经发出读回、尚未取出的一批
+  struct PendingBatch {
+    int buffer = 0;
+    size_t first = 0;
+    size_t count = 0;
+    GLsync fence = nullptr;
+  };
+
+  size_t image_bytes() const {
+    return static_cast<size_t>(options_.width) * options_.height * 4;
+  }
+
+  void DrawView(const CameraPose& pose, int layer, const DrawFunc& draw, FpsCamera* camera);
+  bool CollectBatch(PendingBatch* batch);
+  bool PushImage(Image image);
+  void WriterLoop(const ImageSink& sink);
+
+private:
+  BatchRenderOptions options_;
+  GLuint framebuffer_ = 0;
+  GLuint color_texture_ = 0;
+  GLuint depth_buffer_ = 0;
+  GLuint pack_buffers_[2] = { 0, 0 };
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Image> queue_;
+  bool done_ = false;
+  bool failed_ = false;
+  double write_ms_ = 0.0;
+
+  BatchRenderStats stats_;
+};
+
+}  // namespace utils
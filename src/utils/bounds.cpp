@@ -0,0 +1,131 @@
+#include "utils/bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace utils {
+
+Aabb TransformAabb(const Aabb& aabb, const glm::mat4& transform) {
+  glm::vec3 center = glm::vec3(transform * glm::vec4(aabb.center(), 1.0f));
+  glm::vec3 extent = aabb.extent();
+
+  glm::vec3 new_extent(0.0f);
+  for (int i = 0; i < 3; i++) {
+    new_extent += glm::abs(glm::vec3(transform[i])) * extent[i];
+  }
+  return Aabb(center - new_extent, center + new_extent);
+}
+
+Ray ScreenPointToRay(const glm::vec2& screen_point, const glm::vec2& viewport_size, const glm::mat4& view,
+                     const glm::mat4& projection) {
+  // 屏幕坐标转到NDC，y轴向上
+  float x = 2.0f * screen_point.x / viewport_size.x - 1.0f;
+  float y = 1.0f - 2.0f * screen_point.y / viewport_size.y;
+
+  glm::mat4 inverse = glm::inverse(projection * view);
+  glm::vec4 near_point = inverse * glm::vec4(x, y, -1.0f, 1.0f);
+  glm::vec4 far_point = inverse * glm::vec4(x, y, 1.0f, 1.0f);
+  glm::vec3 origin = glm::vec3(near_point) / near_point.w;
+  glm::vec3 target = glm::vec3(far_point) / far_point.w;
+
+  Ray ray;
+  ray.origin = origin;
+  ray.direction = glm::normalize(target - origin);
+  return ray;
+}
+
+bool IntersectRayAabb(const Ray& ray, const glm::vec3& inv_direction, const Aabb& aabb, float t_max, float* t_hit) {
+  float t_near = 0.0f;
+  float t_far = t_max;
+  for (int i = 0; i < 3; i++) {
+    float t0 = (aabb.min[i] - ray.origin[i]) * inv_direction[i];
+    float t1 = (aabb.max[i] - ray.origin[i]) * inv_direction[i];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    // 射线与平面平行并恰好在边界上时得到NaN，此时不收缩区间
+    t_near = t0 > t_near ? t0 : t_near;
+    t_far = t1 < t_far ? t1 : t_far;
+    if (t_near > t_far) {
+      return false;
+    }
+  }
+
+  *t_hit = t_near;
+  return true;
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& m) {
+  // glm是列主序，m[c][r]，取第r行
+  auto row = [&m](int r) {
+    return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+  };
+
+  Frustum frustum;
+  frustum.planes[kLeft] = row(3) + row(0);
+  frustum.planes[kRight] = row(3) - row(0);
+  frustum.planes[kBottom] = row(3) + row(1);
+  frustum.planes[kTop] = row(3) - row(1);
+  frustum.planes[kNear] = row(3) + row(2);
+  frustum.planes[kFar] = row(3) - row(2);
+
+  for (glm::vec4& plane : frustum.planes) {
+    float length = glm::length(glm::vec3(plane));
+    plane = plane / length;
+  }
+  return frustum;
+}
+
+Containment Frustum::Classify(const Aabb& aabb) const {
+  uint32_t plane_mask = (1u << kPlaneCount) - 1;
+  return Classify(aabb, &plane_mask);
+}
+
+Containment Frustum::Classify(const Aabb& aabb, uint32_t* plane_mask) const {
+  glm::vec3 center = aabb.center();
+  glm::vec3 extent = aabb.extent();
+
+  uint32_t mask = *plane_mask;
+  for (int i = 0; i < kPlaneCount; i++) {
+    if ((mask & (1u << i)) == 0) {
+      continue;
+    }
+
+    const glm::vec4& plane = planes[i];
+    float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+    float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+    if (distance + radius < 0.0f) {
+      return Containment::kOutside;
+    }
+    if (distance - radius >= 0.0f) {
+      mask &= ~(1u << i);
+    }
+  }
+
+  *plane_mask = mask;
+  return mask == 0 ? Containment::kInside : Containment::kIntersect;
+}
+
+bool Frustum::Intersects(const Aabb& aabb) const {
+  glm::vec3 center = aabb.center();
+  glm::vec3 extent = aabb.extent();
+  for (const glm::vec4& plane : planes) {
+    float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+    float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+    if (distance + radius < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Frustum::Intersects(const Sphere& sphere) const {
+  for (const glm::vec4& plane : planes) {
+    if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace utils
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+namespace utils {
+
+struct Aabb {
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+
+  Aabb() = default;
+  Aabb(const glm::vec3& min_point, const glm::vec3& max_point) : min(min_point), max(max_point) {
+  }
+
+  bool valid() const {
+    return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+  }
+
+  glm::vec3 center() const {
+    return (min + max) * 0.5f;
+  }
+
+  glm::vec3 extent() const {
+    return (max - min) * 0.5f;
+  }
+
+  void Expand(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  void Expand(const Aabb& other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+
+  float SurfaceArea() const {
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+
+  bool Contains(const Aabb& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && max.x >= other.max.x &&
+           max.y >= other.max.y && max.z >= other.max.z;
+  }
+};
+
+inline Aabb Union(const Aabb& a, const Aabb& b) {
+  return Aabb(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+// 变换后的包围盒（Arvo的方法），结果仍然是轴对齐的
+Aabb TransformAabb(const Aabb& aabb, const glm::mat4& transform);
+
+struct Sphere {
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 0.0f;
+};
+
+struct Ray {
+  glm::vec3 origin = glm::vec3(0.0f);
+  glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+// 由屏幕坐标（左上角为原点，单位像素）生成世界空间射线，用于鼠标拾取
+Ray ScreenPointToRay(const glm::vec2& screen_point, const glm::vec2& viewport_size, const glm::mat4& view,
+                     const glm::mat4& projection);
+
+// 射线与包围盒求交，inv_direction为1/direction。命中时返回进入距离（起点在盒内时为0）
+bool IntersectRayAabb(const Ray& ray, const glm::vec3& inv_direction, const Aabb& aabb, float t_max, float* t_hit);
+
+enum class Containment {
+  kOutside,
+  kIntersect,
+  kInside
+};
+
+// 平面以(n, d)存储，dot(n, p) + d >= 0 表示在视锥体内侧，法线已归一化。
+struct Frustum {
+  enum Plane {
+    kLeft = 0,
+    kRight,
+    kBottom,
+    kTop,
+    kNear,
+    kFar,
+    kPlaneCount
+  };
+
+  glm::vec4 planes[kPlaneCount];
+
+  // Gribb/Hartmann方法，从projection * view中提取世界空间的六个平面
+  static Frustum FromMatrix(const glm::mat4& view_projection);
+
+  Containment Classify(const Aabb& aabb) const;
+
+  // 只测试plane_mask中的平面，完全在内侧的平面会从mask中清掉，便于层级遍历时跳过
+  Containment Classify(const Aabb& aabb, uint32_t* plane_mask) const;
+
+  bool Intersects(const Aabb& aabb) const;
+  bool Intersects(const Sphere& sphere) const;
+};
+
+}  // namespace utils
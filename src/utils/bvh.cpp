@@ -0,0 +1,758 @@
+#include "utils/bvh.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace utils {
+
+namespace {
+
+constexpr int kBinCount = 16;
+constexpr uint32_t kMaxDepth = 48;
+constexpr int kStackSize = kMaxDepth + 2;
+constexpr uint32_t kAllPlanes = (1u << Frustum::kPlaneCount) - 1;
+
+struct Bin {
+  Aabb bounds;
+  uint32_t count = 0;
+};
+
+struct FrustumEntry {
+  uint32_t node;
+  uint32_t plane_mask;
+};
+
+struct BatchEntry {
+  uint32_t node;
+  // 与节点部分相交、需要继续测试的视锥体
+  uint32_t active;
+  // 完全包含节点的视锥体
+  uint32_t inside;
+};
+
+glm::vec3 InverseDirection(const glm::vec3& direction) {
+  return glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+}
+
+uint32_t LowestBit(uint32_t mask) {
+  uint32_t index = 0;
+  while ((mask & (1u << index)) == 0) {
+    index++;
+  }
+  return index;
+}
+
+// 更新批量查询的掩码，返回false表示节点不在任何视锥体内
+bool ClassifyBatch(const Frustum* frustums, const Aabb& bounds, BatchEntry* entry) {
+  uint32_t active = entry->active;
+  while (active != 0) {
+    uint32_t index = LowestBit(active);
+    uint32_t bit = 1u << index;
+    active &= ~bit;
+
+    Containment containment = frustums[index].Classify(bounds);
+    if (containment == Containment::kOutside) {
+      entry->active &= ~bit;
+    } else if (containment == Containment::kInside) {
+      entry->active &= ~bit;
+      entry->inside |= bit;
+    }
+  }
+  return (entry->active | entry->inside) != 0;
+}
+
+void AppendBatch(const Frustum* frustums, const BatchEntry& entry, const Aabb& bounds, uint32_t object,
+                 std::vector<uint32_t>* results) {
+  uint32_t mask = entry.inside | entry.active;
+  while (mask != 0) {
+    uint32_t index = LowestBit(mask);
+    uint32_t bit = 1u << index;
+    mask &= ~bit;
+    if ((entry.inside & bit) != 0 || frustums[index].Intersects(bounds)) {
+      results[index].push_back(object);
+    }
+  }
+}
+
+uint32_t BatchMask(uint32_t frustum_count) {
+  return frustum_count >= 32 ? UINT32_MAX : (1u << frustum_count) - 1;
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// StaticBvh
+
+void StaticBvh::Clear() {
+  nodes_.clear();
+  objects_.clear();
+  object_bounds_.clear();
+}
+
+void StaticBvh::Build(const std::vector<Aabb>& bounds) {
+  Clear();
+  if (bounds.empty()) {
+    return;
+  }
+
+  auto count = static_cast<uint32_t>(bounds.size());
+  objects_.resize(count);
+  std::iota(objects_.begin(), objects_.end(), 0);
+
+  // 构建期间object_bounds_按物体id索引
+  object_bounds_ = bounds;
+  std::vector<glm::vec3> centroids(count);
+  Node root;
+  root.left_or_first = 0;
+  root.count = count;
+  for (uint32_t i = 0; i < count; i++) {
+    centroids[i] = bounds[i].center();
+    root.bounds.Expand(bounds[i]);
+  }
+
+  nodes_.reserve(2 * count);
+  nodes_.push_back(root);
+
+  // 限制深度，查询时可以使用固定大小的栈
+  std::vector<std::pair<uint32_t, uint32_t>> stack;
+  stack.emplace_back(0, 0);
+  while (!stack.empty()) {
+    auto [node, depth] = stack.back();
+    stack.pop_back();
+    if (depth < kMaxDepth && Split(node, centroids)) {
+      stack.emplace_back(nodes_[node].left_or_first + 1, depth + 1);
+      stack.emplace_back(nodes_[node].left_or_first, depth + 1);
+    }
+  }
+
+  // 按叶子引用顺序重排包围盒，遍历叶子时连续访问
+  for (uint32_t i = 0; i < count; i++) {
+    object_bounds_[i] = bounds[objects_[i]];
+  }
+}
+
+bool StaticBvh::Split(uint32_t node_index, const std::vector<glm::vec3>& centroids) {
+  uint32_t first = nodes_[node_index].left_or_first;
+  uint32_t count = nodes_[node_index].count;
+  if (count <= 1) {
+    return false;
+  }
+
+  Aabb centroid_bounds;
+  for (uint32_t i = first; i < first + count; i++) {
+    centroid_bounds.Expand(centroids[objects_[i]]);
+  }
+
+  float best_cost = FLT_MAX;
+  int best_axis = -1;
+  int best_split = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+    if (extent <= 0.0f) {
+      continue;
+    }
+
+    Bin bins[kBinCount];
+    float scale = kBinCount / extent;
+    for (uint32_t i = first; i < first + count; i++) {
+      uint32_t object = objects_[i];
+      int bin = std::min(kBinCount - 1, static_cast<int>((centroids[object][axis] - centroid_bounds.min[axis]) * scale));
+      bins[bin].count++;
+      bins[bin].bounds.Expand(object_bounds_[object]);
+    }
+
+    // 从左往右、从右往左各扫描一遍得到每个划分位置两侧的面积和数量
+    float left_area[kBinCount - 1];
+    uint32_t left_count[kBinCount - 1];
+    Aabb left_bounds;
+    uint32_t left_sum = 0;
+    for (int i = 0; i < kBinCount - 1; i++) {
+      left_sum += bins[i].count;
+      left_count[i] = left_sum;
+      left_bounds.Expand(bins[i].bounds);
+      left_area[i] = left_sum > 0 ? left_bounds.SurfaceArea() : 0.0f;
+    }
+
+    Aabb right_bounds;
+    uint32_t right_sum = 0;
+    for (int i = kBinCount - 1; i > 0; i--) {
+      right_sum += bins[i].count;
+      right_bounds.Expand(bins[i].bounds);
+      float right_area = right_sum > 0 ? right_bounds.SurfaceArea() : 0.0f;
+      float cost = left_count[i - 1] * left_area[i - 1] + right_sum * right_area;
+      if (left_count[i - 1] > 0 && right_sum > 0 && cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = i - 1;
+      }
+    }
+  }
+
+  // 划分的代价不比叶子低时不再划分（相对代价，遍历一次节点的代价记为一次求交）
+  float node_area = nodes_[node_index].bounds.SurfaceArea();
+  float leaf_cost = count * node_area;
+  float split_cost = node_area + best_cost;
+
+  uint32_t middle = first;
+  if (best_axis >= 0 && (count > max_leaf_size_ || split_cost < leaf_cost)) {
+    float extent = centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis];
+    float scale = kBinCount / extent;
+    float min_value = centroid_bounds.min[best_axis];
+    auto* begin = objects_.data() + first;
+    auto* end = begin + count;
+    middle = static_cast<uint32_t>(std::partition(begin, end,
+                                                  [&](uint32_t object) {
+                                                    int bin = std::min(kBinCount - 1,
+                                                                       static_cast<int>((centroids[object][best_axis] -
+                                                                                         min_value) * scale));
+                                                    return bin <= best_split;
+                                                  }) - objects_.data());
+  } else if (count > max_leaf_size_) {
+    // 所有中心点重合，无法按位置划分，只能对半分
+    middle = first + count / 2;
+  } else {
+    return false;
+  }
+
+  if (middle == first || middle == first + count) {
+    middle = first + count / 2;
+  }
+
+  auto left = static_cast<uint32_t>(nodes_.size());
+  Node left_node;
+  left_node.left_or_first = first;
+  left_node.count = middle - first;
+  Node right_node;
+  right_node.left_or_first = middle;
+  right_node.count = first + count - middle;
+  for (uint32_t i = left_node.left_or_first; i < middle; i++) {
+    left_node.bounds.Expand(object_bounds_[objects_[i]]);
+  }
+  for (uint32_t i = middle; i < first + count; i++) {
+    right_node.bounds.Expand(object_bounds_[objects_[i]]);
+  }
+  nodes_.push_back(left_node);
+  nodes_.push_back(right_node);
+
+  nodes_[node_index].left_or_first = left;
+  nodes_[node_index].count = 0;
+  return true;
+}
+
+void StaticBvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* result) const {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  FrustumEntry stack[kStackSize];
+  int top = 0;
+  stack[top++] = { 0, kAllPlanes };
+  while (top > 0) {
+    FrustumEntry entry = stack[--top];
+    const Node& node = nodes_[entry.node];
+    uint32_t mask = entry.plane_mask;
+    if (mask != 0 && frustum.Classify(node.bounds, &mask) == Containment::kOutside) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (uint32_t i = node.left_or_first; i < node.left_or_first + node.count; i++) {
+        uint32_t object_mask = mask;
+        if (mask == 0 || frustum.Classify(object_bounds_[i], &object_mask) != Containment::kOutside) {
+          result->push_back(objects_[i]);
+        }
+      }
+    } else {
+      stack[top++] = { node.left_or_first + 1, mask };
+      stack[top++] = { node.left_or_first, mask };
+    }
+  }
+}
+
+void StaticBvh::QueryFrustums(const Frustum* frustums, uint32_t frustum_count, std::vector<uint32_t>* results) const {
+  if (nodes_.empty() || frustum_count == 0) {
+    return;
+  }
+
+  frustum_count = std::min(frustum_count, kMaxBatchFrustums);
+  BatchEntry stack[kStackSize];
+  int top = 0;
+  stack[top++] = { 0, BatchMask(frustum_count), 0 };
+  while (top > 0) {
+    BatchEntry entry = stack[--top];
+    const Node& node = nodes_[entry.node];
+    if (entry.active != 0 && !ClassifyBatch(frustums, node.bounds, &entry)) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (uint32_t i = node.left_or_first; i < node.left_or_first + node.count; i++) {
+        AppendBatch(frustums, entry, object_bounds_[i], objects_[i], results);
+      }
+    } else {
+      stack[top++] = { node.left_or_first + 1, entry.active, entry.inside };
+      stack[top++] = { node.left_or_first, entry.active, entry.inside };
+    }
+  }
+}
+
+void StaticBvh::QueryAabb(const Aabb& aabb, std::vector<uint32_t>* result) const {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  auto overlaps = [&aabb](const Aabb& other) {
+    return aabb.min.x <= other.max.x && aabb.max.x >= other.min.x && aabb.min.y <= other.max.y &&
+           aabb.max.y >= other.min.y && aabb.min.z <= other.max.z && aabb.max.z >= other.min.z;
+  };
+
+  uint32_t stack[kStackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node& node = nodes_[stack[--top]];
+    if (!overlaps(node.bounds)) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (uint32_t i = node.left_or_first; i < node.left_or_first + node.count; i++) {
+        if (overlaps(object_bounds_[i])) {
+          result->push_back(objects_[i]);
+        }
+      }
+    } else {
+      stack[top++] = node.left_or_first + 1;
+      stack[top++] = node.left_or_first;
+    }
+  }
+}
+
+bool StaticBvh::Raycast(const Ray& ray, float max_distance, RayHit* hit, const RayIntersectFunc& intersect) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  glm::vec3 inv_direction = InverseDirection(ray.direction);
+  float best = max_distance;
+  bool found = false;
+
+  uint32_t stack[kStackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node& node = nodes_[stack[--top]];
+    float t = 0.0f;
+    if (!IntersectRayAabb(ray, inv_direction, node.bounds, best, &t)) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (uint32_t i = node.left_or_first; i < node.left_or_first + node.count; i++) {
+        float distance = 0.0f;
+        bool is_hit = intersect ? intersect(objects_[i], ray, &distance)
+                                : IntersectRayAabb(ray, inv_direction, object_bounds_[i], best, &distance);
+        if (is_hit && distance <= best) {
+          best = distance;
+          hit->object = objects_[i];
+          hit->distance = distance;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    // 先访问近的孩子，便于尽早缩短最近距离
+    uint32_t near_child = node.left_or_first;
+    uint32_t far_child = node.left_or_first + 1;
+    float t_near = 0.0f;
+    float t_far = 0.0f;
+    bool hit_near = IntersectRayAabb(ray, inv_direction, nodes_[near_child].bounds, best, &t_near);
+    bool hit_far = IntersectRayAabb(ray, inv_direction, nodes_[far_child].bounds, best, &t_far);
+    if (hit_near && hit_far) {
+      if (t_far < t_near) {
+        std::swap(near_child, far_child);
+      }
+      stack[top++] = far_child;
+      stack[top++] = near_child;
+    } else if (hit_near) {
+      stack[top++] = near_child;
+    } else if (hit_far) {
+      stack[top++] = far_child;
+    }
+  }
+
+  return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// DynamicBvh
+
+DynamicBvh::DynamicBvh(float margin) : margin_(margin) {
+}
+
+Aabb DynamicBvh::Fatten(const Aabb& bounds) const {
+  return Aabb(bounds.min - glm::vec3(margin_), bounds.max + glm::vec3(margin_));
+}
+
+uint32_t DynamicBvh::AllocateNode() {
+  uint32_t node = 0;
+  if (free_list_ != kNullNode) {
+    node = free_list_;
+    free_list_ = nodes_[node].parent;
+  } else {
+    node = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+  }
+
+  nodes_[node] = Node();
+  nodes_[node].height = 0;
+  return node;
+}
+
+void DynamicBvh::FreeNode(uint32_t node) {
+  nodes_[node].parent = free_list_;
+  nodes_[node].height = -1;
+  free_list_ = node;
+}
+
+uint32_t DynamicBvh::CreateProxy(const Aabb& bounds, uint32_t object) {
+  uint32_t proxy = AllocateNode();
+  nodes_[proxy].tight = bounds;
+  nodes_[proxy].fat = Fatten(bounds);
+  nodes_[proxy].object = object;
+  InsertLeaf(proxy);
+  proxy_count_++;
+  return proxy;
+}
+
+void DynamicBvh::DestroyProxy(uint32_t proxy) {
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  proxy_count_--;
+}
+
+bool DynamicBvh::MoveProxy(uint32_t proxy, const Aabb& bounds) {
+  nodes_[proxy].tight = bounds;
+  if (nodes_[proxy].fat.Contains(bounds)) {
+    return false;
+  }
+
+  RemoveLeaf(proxy);
+  nodes_[proxy].fat = Fatten(bounds);
+  InsertLeaf(proxy);
+  return true;
+}
+
+void DynamicBvh::SetBounds(uint32_t proxy, const Aabb& bounds) {
+  nodes_[proxy].tight = bounds;
+  nodes_[proxy].fat = Fatten(bounds);
+}
+
+void DynamicBvh::Refit() {
+  if (root_ == kNullNode) {
+    return;
+  }
+
+  // 先序遍历后倒序处理，保证孩子先于父节点更新
+  std::vector<uint32_t> order;
+  order.reserve(nodes_.size());
+  order.push_back(root_);
+  for (size_t i = 0; i < order.size(); i++) {
+    const Node& node = nodes_[order[i]];
+    if (!node.IsLeaf()) {
+      order.push_back(node.child1);
+      order.push_back(node.child2);
+    }
+  }
+
+  for (size_t i = order.size(); i > 0; i--) {
+    Node& node = nodes_[order[i - 1]];
+    if (!node.IsLeaf()) {
+      node.fat = Union(nodes_[node.child1].fat, nodes_[node.child2].fat);
+    }
+  }
+}
+
+void DynamicBvh::InsertLeaf(uint32_t leaf) {
+  if (root_ == kNullNode) {
+    root_ = leaf;
+    nodes_[leaf].parent = kNullNode;
+    return;
+  }
+
+  // 分支定界寻找代价最小的兄弟节点：代价为新父节点的面积加上所有祖先增长的面积。
+  // 按下界从小到大展开，下界不小于当前最优时剪枝
+  Aabb leaf_bounds = nodes_[leaf].fat;
+  float leaf_area = leaf_bounds.SurfaceArea();
+  uint32_t index = root_;
+  float best_cost = Union(nodes_[root_].fat, leaf_bounds).SurfaceArea();
+
+  // 小顶堆，复用成员数组避免每次插入分配内存
+  auto greater = [](const Candidate& a, const Candidate& b) { return a.first > b.first; };
+  candidates_.clear();
+  candidates_.emplace_back(0.0f, root_);
+  while (!candidates_.empty()) {
+    std::pop_heap(candidates_.begin(), candidates_.end(), greater);
+    auto [inherited_cost, candidate] = candidates_.back();
+    candidates_.pop_back();
+    if (inherited_cost + leaf_area >= best_cost) {
+      break;
+    }
+
+    const Node& node = nodes_[candidate];
+    float direct_cost = Union(node.fat, leaf_bounds).SurfaceArea();
+    float cost = direct_cost + inherited_cost;
+    if (cost < best_cost) {
+      best_cost = cost;
+      index = candidate;
+    }
+
+    float child_inherited_cost = inherited_cost + direct_cost - node.fat.SurfaceArea();
+    if (!node.IsLeaf() && child_inherited_cost + leaf_area < best_cost) {
+      candidates_.emplace_back(child_inherited_cost, node.child1);
+      std::push_heap(candidates_.begin(), candidates_.end(), greater);
+      candidates_.emplace_back(child_inherited_cost, node.child2);
+      std::push_heap(candidates_.begin(), candidates_.end(), greater);
+    }
+  }
+
+  uint32_t sibling = index;
+  uint32_t old_parent = nodes_[sibling].parent;
+  uint32_t new_parent = AllocateNode();
+  nodes_[new_parent].parent = old_parent;
+  nodes_[new_parent].fat = Union(leaf_bounds, nodes_[sibling].fat);
+  nodes_[new_parent].height = nodes_[sibling].height + 1;
+  nodes_[new_parent].child1 = sibling;
+  nodes_[new_parent].child2 = leaf;
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+
+  if (old_parent == kNullNode) {
+    root_ = new_parent;
+  } else if (nodes_[old_parent].child1 == sibling) {
+    nodes_[old_parent].child1 = new_parent;
+  } else {
+    nodes_[old_parent].child2 = new_parent;
+  }
+
+  for (index = nodes_[leaf].parent; index != kNullNode; index = nodes_[index].parent) {
+    index = Balance(index);
+    Node& node = nodes_[index];
+    node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+    node.fat = Union(nodes_[node.child1].fat, nodes_[node.child2].fat);
+  }
+}
+
+void DynamicBvh::RemoveLeaf(uint32_t leaf) {
+  if (leaf == root_) {
+    root_ = kNullNode;
+    return;
+  }
+
+  uint32_t parent = nodes_[leaf].parent;
+  uint32_t grand_parent = nodes_[parent].parent;
+  uint32_t sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+  if (grand_parent == kNullNode) {
+    root_ = sibling;
+    nodes_[sibling].parent = kNullNode;
+    FreeNode(parent);
+    return;
+  }
+
+  if (nodes_[grand_parent].child1 == parent) {
+    nodes_[grand_parent].child1 = sibling;
+  } else {
+    nodes_[grand_parent].child2 = sibling;
+  }
+  nodes_[sibling].parent = grand_parent;
+  FreeNode(parent);
+
+  for (uint32_t index = grand_parent; index != kNullNode; index = nodes_[index].parent) {
+    index = Balance(index);
+    Node& node = nodes_[index];
+    node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+    node.fat = Union(nodes_[node.child1].fat, nodes_[node.child2].fat);
+  }
+}
+
+uint32_t DynamicBvh::Balance(uint32_t a) {
+  Node& node_a = nodes_[a];
+  if (node_a.IsLeaf() || node_a.height < 2) {
+    return a;
+  }
+
+  uint32_t b = node_a.child1;
+  uint32_t c = node_a.child2;
+  int32_t balance = nodes_[c].height - nodes_[b].height;
+  if (balance >= -1 && balance <= 1) {
+    return a;
+  }
+
+  // 把较高的孩子旋转上来，p为新的子树根，q为另一个孩子
+  uint32_t p = balance > 1 ? c : b;
+  uint32_t q = balance > 1 ? b : c;
+  Node& node_p = nodes_[p];
+  uint32_t f = node_p.child1;
+  uint32_t g = node_p.child2;
+
+  node_p.child1 = a;
+  node_p.parent = node_a.parent;
+  node_a.parent = p;
+
+  if (node_p.parent == kNullNode) {
+    root_ = p;
+  } else if (nodes_[node_p.parent].child1 == a) {
+    nodes_[node_p.parent].child1 = p;
+  } else {
+    nodes_[node_p.parent].child2 = p;
+  }
+
+  // p的两个孩子中较高的留在p下面，较矮的交给a
+  uint32_t keep = nodes_[f].height > nodes_[g].height ? f : g;
+  uint32_t give = keep == f ? g : f;
+  node_p.child2 = keep;
+  if (balance > 1) {
+    node_a.child2 = give;
+  } else {
+    node_a.child1 = give;
+  }
+  nodes_[give].parent = a;
+
+  node_a.fat = Union(nodes_[q].fat, nodes_[give].fat);
+  node_p.fat = Union(node_a.fat, nodes_[keep].fat);
+  node_a.height = 1 + std::max(nodes_[q].height, nodes_[give].height);
+  node_p.height = 1 + std::max(node_a.height, nodes_[keep].height);
+  return p;
+}
+
+void DynamicBvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* result) const {
+  if (root_ == kNullNode) {
+    return;
+  }
+
+  std::vector<FrustumEntry> stack;
+  stack.push_back({ root_, kAllPlanes });
+  while (!stack.empty()) {
+    FrustumEntry entry = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[entry.node];
+    uint32_t mask = entry.plane_mask;
+    const Aabb& bounds = node.IsLeaf() ? node.tight : node.fat;
+    if (mask != 0 && frustum.Classify(bounds, &mask) == Containment::kOutside) {
+      continue;
+    }
+
+    if (node.IsLeaf()) {
+      result->push_back(node.object);
+    } else {
+      stack.push_back({ node.child2, mask });
+      stack.push_back({ node.child1, mask });
+    }
+  }
+}
+
+void DynamicBvh::QueryFrustums(const Frustum* frustums, uint32_t frustum_count,
+                               std::vector<uint32_t>* results) const {
+  if (root_ == kNullNode || frustum_count == 0) {
+    return;
+  }
+
+  frustum_count = std::min(frustum_count, kMaxBatchFrustums);
+  std::vector<BatchEntry> stack;
+  stack.push_back({ root_, BatchMask(frustum_count), 0 });
+  while (!stack.empty()) {
+    BatchEntry entry = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[entry.node];
+    if (node.IsLeaf()) {
+      AppendBatch(frustums, entry, node.tight, node.object, results);
+      continue;
+    }
+
+    if (entry.active != 0 && !ClassifyBatch(frustums, node.fat, &entry)) {
+      continue;
+    }
+    stack.push_back({ node.child2, entry.active, entry.inside });
+    stack.push_back({ node.child1, entry.active, entry.inside });
+  }
+}
+
+void DynamicBvh::QueryAabb(const Aabb& aabb, std::vector<uint32_t>* result) const {
+  if (root_ == kNullNode) {
+    return;
+  }
+
+  auto overlaps = [&aabb](const Aabb& other) {
+    return aabb.min.x <= other.max.x && aabb.max.x >= other.min.x && aabb.min.y <= other.max.y &&
+           aabb.max.y >= other.min.y && aabb.min.z <= other.max.z && aabb.max.z >= other.min.z;
+  };
+
+  std::vector<uint32_t> stack;
+  stack.push_back(root_);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (node.IsLeaf()) {
+      if (overlaps(node.tight)) {
+        result->push_back(node.object);
+      }
+    } else if (overlaps(node.fat)) {
+      stack.push_back(node.child2);
+      stack.push_back(node.child1);
+    }
+  }
+}
+
+bool DynamicBvh::Raycast(const Ray& ray, float max_distance, RayHit* hit, const RayIntersectFunc& intersect) const {
+  if (root_ == kNullNode) {
+    return false;
+  }
+
+  glm::vec3 inv_direction = InverseDirection(ray.direction);
+  float best = max_distance;
+  bool found = false;
+
+  std::vector<uint32_t> stack;
+  stack.push_back(root_);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+
+    float t = 0.0f;
+    if (node.IsLeaf()) {
+      bool is_hit = intersect ? intersect(node.object, ray, &t)
+                              : IntersectRayAabb(ray, inv_direction, node.tight, best, &t);
+      if (is_hit && t <= best) {
+        best = t;
+        hit->object = node.object;
+        hit->distance = t;
+        found = true;
+      }
+      continue;
+    }
+
+    if (!IntersectRayAabb(ray, inv_direction, node.fat, best, &t)) {
+      continue;
+    }
+
+    // 先访问近的孩子
+    float t1 = 0.0f;
+    float t2 = 0.0f;
+    bool hit1 = IntersectRayAabb(ray, inv_direction, nodes_[node.child1].fat, best, &t1);
+    bool hit2 = IntersectRayAabb(ray, inv_direction, nodes_[node.child2].fat, best, &t2);
+    if (hit1 && hit2) {
+      stack.push_back(t1 <= t2 ? node.child2 : node.child1);
+      stack.push_back(t1 <= t2 ? node.child1 : node.child2);
+    } else if (hit1) {
+      stack.push_back(node.child1);
+    } else if (hit2) {
+      stack.push_back(node.child2);
+    }
+  }
+
+  return found;
+}
+
+}  // namespace utils
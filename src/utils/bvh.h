@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "utils/bounds.h"
+
+namespace utils {
+
+struct RayHit {
+  uint32_t object = UINT32_MAX;
+  float distance = 0.0f;
+};
+
+// 精确求交回调：返回true表示命中并写入距离。为空时使用物体的包围盒求交
+using RayIntersectFunc = std::function<bool(uint32_t object, const Ray& ray, float* distance)>;
+
+// 一次遍历最多同时查询的视锥体数量（例如主相机加阴影级联）
+constexpr uint32_t kMaxBatchFrustums = 32;
+
+// 静态几何的BVH，用分箱SAH自顶向下构建，构建后只读。
+class StaticBvh {
+public:
+  struct Node {
+    Aabb bounds;
+    // 内部节点：左孩子下标，右孩子紧跟其后；叶子：第一个物体在objects_中的位置
+    uint32_t left_or_first = 0;
+    // 0表示内部节点
+    uint32_t count = 0;
+  };
+
+  // 物体id就是bounds中的下标
+  void Build(const std::vector<Aabb>& bounds);
+
+  void Clear();
+
+  // 与视锥体相交的物体id追加到result
+  void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* result) const;
+
+  // 一次遍历同时查询多个视锥体，results[i]对应frustums[i]
+  void QueryFrustums(const Frustum* frustums, uint32_t frustum_count, std::vector<uint32_t>* results) const;
+
+  void QueryAabb(const Aabb& aabb, std::vector<uint32_t>* result) const;
+
+  // 返回最近的命中
+  bool Raycast(const Ray& ray, float max_distance, RayHit* hit, const RayIntersectFunc& intersect = nullptr) const;
+
+  size_t node_count() const {
+    return nodes_.size();
+  }
+
+  size_t object_count() const {
+    return objects_.size();
+  }
+
+  const std::vector<Node>& nodes() const {
+    return nodes_;
+  }
+
+  void set_max_leaf_size(uint32_t size) {
+    max_leaf_size_ = size;
+  }
+
+private:
+  // 用SAH选择划分，值得划分时创建两个孩子并返回true
+  bool Split(uint32_t node_index, const std::vector<glm::vec3>& centroids);
+
+private:
+  std::vector<Node> nodes_;
+  // 叶子按顺序引用的物体id及其包围盒
+  std::vector<uint32_t> objects_;
+  std::vector<Aabb> object_bounds_;
+  uint32_t max_leaf_size_ = 4;
+};
+
+// 动态物体的BVH：增量插入/删除，叶子使用放大的包围盒，物体小幅移动时不需要重新插入。
+// 大量物体同时移动时可以用SetBounds + Refit只更新包围盒，不改变树的结构。
+class DynamicBvh {
+public:
+  static constexpr uint32_t kNullNode = UINT32_MAX;
+
+  explicit DynamicBvh(float margin = 0.1f);
+
+  // 返回代理id，object为用户数据（通常是实体或物体下标）
+  uint32_t CreateProxy(const Aabb& bounds, uint32_t object);
+  void DestroyProxy(uint32_t proxy);
+
+  // 包围盒超出放大范围时重新插入并返回true
+  bool MoveProxy(uint32_t proxy, const Aabb& bounds);
+
+  // 只修改叶子包围盒，调用Refit后生效
+  void SetBounds(uint32_t proxy, const Aabb& bounds);
+
+  // 自底向上重新计算所有内部节点的包围盒
+  void Refit();
+
+  void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>* result) const;
+  void QueryFrustums(const Frustum* frustums, uint32_t frustum_count, std::vector<uint32_t>* results) const;
+  void QueryAabb(const Aabb& aabb, std::vector<uint32_t>* result) const;
+  bool Raycast(const Ray& ray, float max_distance, RayHit* hit, const RayIntersectFunc& intersect = nullptr) const;
+
+  uint32_t object(uint32_t proxy) const {
+    return nodes_[proxy].object;
+  }
+
+  const Aabb& fat_bounds(uint32_t proxy) const {
+    return nodes_[proxy].fat;
+  }
+
+  size_t proxy_count() const {
+    return proxy_count_;
+  }
+
+  int height() const {
+    return root_ == kNullNode ? 0 : nodes_[root_].height;
+  }
+
+private:
+  struct Node {
+    // 内部节点为孩子包围盒的并集，叶子为放大后的包围盒
+    Aabb fat;
+    // 叶子的实际包围盒，查询结果以它为准
+    Aabb tight;
+    uint32_t parent = kNullNode;
+    uint32_t child1 = kNullNode;
+    uint32_t child2 = kNullNode;
+    // 叶子为0，空闲节点为-1
+    int32_t height = -1;
+    uint32_t object = UINT32_MAX;
+
+    bool IsLeaf() const {
+      return child1 == kNullNode;
+    }
+  };
+
+  uint32_t AllocateNode();
+  void FreeNode(uint32_t node);
+  void InsertLeaf(uint32_t leaf);
+  void RemoveLeaf(uint32_t leaf);
+  uint32_t Balance(uint32_t node);
+  Aabb Fatten(const Aabb& bounds) const;
+
+private:
+  using Candidate = std::pair<float, uint32_t>;
+
+  std::vector<Node> nodes_;
+  uint32_t root_ = kNullNode;
+  uint32_t free_list_ = kNullNode;
+  size_t proxy_count_ = 0;
+  float margin_ = 0.1f;
+
+  // 插入时分支定界搜索用的堆
+  std::vector<Candidate> candidates_;
+};
+
+}  // namespace utils
@@ -0,0 +1,306 @@
+#include "utils/camera_recorder.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#include "spdlog/spdlog.h"
+
+namespace utils {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43455243;  // "CREC"
+constexpr uint16_t kVersion = 1;
+
+enum EventType : uint8_t {
+  kKeyboard = 1,
+  kMouseMovement = 2,
+  kMouseScroll = 3,
+};
+
+template <typename T>
+void Append(std::vector<uint8_t>* data, const T& value) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  data->insert(data->end(), bytes, bytes + sizeof(T));
+}
+
+void AppendPose(std::vector<uint8_t>* data, const CameraPose& pose) {
+  const float values[6] = { pose.position.x, pose.position.y, pose.position.z, pose.yaw, pose.pitch, pose.zoom };
+  for (float value : values) {
+    Append(data, value);
+  }
+}
+
+// 顺序读取，越界后ok()为false
+class Reader {
+public:
+  Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T Read() {
+    T value{};
+    if (offset_ + sizeof(T) > size_) {
+      ok_ = false;
+      return value;
+    }
+    memcpy(&value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  CameraPose ReadPose() {
+    CameraPose pose;
+    pose.position.x = Read<float>();
+    pose.position.y = Read<float>();
+    pose.position.z = Read<float>();
+    pose.yaw = Read<float>();
+    pose.pitch = Read<float>();
+    pose.zoom = Read<float>();
+    return pose;
+  }
+
+  bool ok() const {
+    return ok_;
+  }
+
+  size_t remaining() const {
+    return size_ - offset_;
+  }
+
+private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+
+}  // namespace
+
+CameraPose CameraPose::FromCamera(const FpsCamera& camera) {
+  CameraPose pose;
+  pose.position = camera.position();
+  pose.yaw = camera.yaw();
+  pose.pitch = camera.pitch();
+  pose.zoom = camera.zoom();
+  return pose;
+}
+
+void CameraPose::ApplyTo(FpsCamera* camera) const {
+  camera->SetPose(position, yaw, pitch, zoom);
+}
+
+bool CameraPose::operator==(const CameraPose& other) const {
+  return position == other.position && yaw == other.yaw && pitch == other.pitch && zoom == other.zoom;
+}
+
+bool LoadCameraPoses(const std::string& path, std::vector<CameraPose>* poses) {
+  std::ifstream ifs(path);
+  if (ifs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  poses->clear();
+  std::string line;
+  for (int line_number = 1; std::getline(ifs, line); line_number++) {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    CameraPose pose;
+    if (!(iss >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch >> pose.zoom)) {
+      SPDLOG_ERROR("Invalid camera pose at {}:{}", path, line_number);
+      return false;
+    }
+    poses->push_back(pose);
+  }
+  return true;
+}
+
+bool SaveCameraPoses(const std::string& path, const std::vector<CameraPose>& poses) {
+  std::ofstream ofs(path);
+  if (ofs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  // 9位有效数字保证float读回后逐位相同
+  ofs << "# x y z yaw pitch zoom\n" << std::setprecision(9);
+  for (const CameraPose& pose : poses) {
+    ofs << pose.position.x << ' ' << pose.position.y << ' ' << pose.position.z << ' ' << pose.yaw << ' '
+        << pose.pitch << ' ' << pose.zoom << '\n';
+  }
+  if (ofs.fail()) {
+    SPDLOG_ERROR("Failed to write camera poses: {}", path);
+    return false;
+  }
+  return true;
+}
+
+void CameraRecorder::Start(const FpsCamera& camera) {
+  start_pose_ = CameraPose::FromCamera(camera);
+  frame_count_ = 0;
+  data_.clear();
+  pending_count_ = 0;
+  pending_.clear();
+}
+
+void CameraRecorder::EndFrame(float delta_time) {
+  Append(&data_, delta_time);
+  Append(&data_, pending_count_);
+  data_.insert(data_.end(), pending_.begin(), pending_.end());
+  frame_count_++;
+  pending_count_ = 0;
+  pending_.clear();
+}
+
+void CameraRecorder::AppendEvent(uint8_t type, const float* values, int value_count, uint8_t extra) {
+  if (pending_count_ == UINT16_MAX) {
+    SPDLOG_ERROR("Too many camera events in one frame, event dropped.");
+    return;
+  }
+  pending_count_++;
+  pending_.push_back(type);
+  if (type == kKeyboard) {
+    pending_.push_back(extra);
+  }
+  for (int i = 0; i < value_count; i++) {
+    Append(&pending_, values[i]);
+  }
+}
+
+void CameraRecorder::RecordKeyboard(FpsCamera::Movement direction, float delta_time) {
+  AppendEvent(kKeyboard, &delta_time, 1, static_cast<uint8_t>(direction));
+}
+
+void CameraRecorder::RecordMouseMovement(float x_offset, float y_offset) {
+  const float values[2] = { x_offset, y_offset };
+  AppendEvent(kMouseMovement, values, 2, 0);
+}
+
+void CameraRecorder::RecordMouseScroll(float y_offset) {
+  AppendEvent(kMouseScroll, &y_offset, 1, 0);
+}
+
+bool CameraRecorder::Save(const std::string& path, const FpsCamera& end_camera) const {
+  std::vector<uint8_t> header;
+  Append(&header, kMagic);
+  Append(&header, kVersion);
+  Append(&header, uint16_t(0));
+  AppendPose(&header, start_pose_);
+  // 窗口关闭前最后一次轮询的输入还没有EndFrame，作为时长为0的最后一帧写入，否则回放的终点对不上
+  bool flush_pending = pending_count_ > 0;
+  Append(&header, flush_pending ? frame_count_ + 1 : frame_count_);
+
+  std::vector<uint8_t> last_frame;
+  if (flush_pending) {
+    Append(&last_frame, 0.0f);
+    Append(&last_frame, pending_count_);
+    last_frame.insert(last_frame.end(), pending_.begin(), pending_.end());
+  }
+
+  std::vector<uint8_t> footer;
+  AppendPose(&footer, CameraPose::FromCamera(end_camera));
+
+  std::ofstream ofs(path, std::ios::binary);
+  if (ofs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  ofs.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+  ofs.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+  ofs.write(reinterpret_cast<const char*>(last_frame.data()), static_cast<std::streamsize>(last_frame.size()));
+  ofs.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+  if (ofs.fail()) {
+    SPDLOG_ERROR("Failed to write camera recording: {}", path);
+    return false;
+  }
+  return true;
+}
+
+bool CameraReplay::Load(const std::string& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (ifs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+  frames_.clear();
+  events_.clear();
+
+  Reader reader(data.data(), data.size());
+  uint32_t magic = reader.Read<uint32_t>();
+  uint16_t version = reader.Read<uint16_t>();
+  reader.Read<uint16_t>();
+  if (!reader.ok() || magic != kMagic || version != kVersion) {
+    SPDLOG_ERROR("Not a camera recording (or unsupported version): {}", path);
+    return false;
+  }
+  start_pose_ = reader.ReadPose();
+  uint32_t frame_count = reader.Read<uint32_t>();
+
+  for (uint32_t i = 0; i < frame_count && reader.ok(); i++) {
+    Frame frame;
+    frame.delta_time = reader.Read<float>();
+    frame.first_event = events_.size();
+    frame.event_count = reader.Read<uint16_t>();
+    for (size_t e = 0; e < frame.event_count && reader.ok(); e++) {
+      Event event = {};
+      event.type = reader.Read<uint8_t>();
+      if (event.type == kKeyboard) {
+        event.extra = reader.Read<uint8_t>();
+        event.values[0] = reader.Read<float>();
+      } else if (event.type == kMouseMovement) {
+        event.values[0] = reader.Read<float>();
+        event.values[1] = reader.Read<float>();
+      } else if (event.type == kMouseScroll) {
+        event.values[0] = reader.Read<float>();
+      } else {
+        SPDLOG_ERROR("Unknown camera event type {} in {}", static_cast<int>(event.type), path);
+        return false;
+      }
+      events_.push_back(event);
+    }
+    frames_.push_back(frame);
+  }
+  end_pose_ = reader.ReadPose();
+
+  if (!reader.ok() || reader.remaining() != 0) {
+    SPDLOG_ERROR("Camera recording is truncated or corrupted: {}", path);
+    frames_.clear();
+    events_.clear();
+    return false;
+  }
+  return true;
+}
+
+void CameraReplay::Reset(FpsCamera* camera) const {
+  start_pose_.ApplyTo(camera);
+}
+
+float CameraReplay::ApplyFrame(size_t frame, FpsCamera* camera) const {
+  if (frame >= frames_.size()) {
+    return 0.0f;
+  }
+  const Frame& record = frames_[frame];
+  for (size_t i = record.first_event; i < record.first_event + record.event_count; i++) {
+    const Event& event = events_[i];
+    if (event.type == kKeyboard) {
+      camera->ProcessKeyboard(static_cast<FpsCamera::Movement>(event.extra), event.values[0]);
+    } else if (event.type == kMouseMovement) {
+      camera->ProcessMouseMovement(event.values[0], event.values[1]);
+    } else {
+      camera->ProcessMouseScroll(event.values[0]);
+    }
+  }
+  return record.delta_time;
+}
+
+bool CameraReplay::Verify(const FpsCamera& camera) const {
+  return CameraPose::FromCamera(camera) == end_pose_;
+}
+
+}  // namespace utils
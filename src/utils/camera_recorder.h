@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "utils/fps_camera.h"
+
+namespace utils {
+
+// 相机的完整状态，录制文件在开头和结尾各保存一份
+struct CameraPose {
+  glm::vec3 position = glm::vec3(0.0f);
+  float yaw = 0.0f;
+  float pitch = 0.0f;
+  float zoom = 0.0f;
+
+  static CameraPose FromCamera(const FpsCamera& camera);
+  void ApplyTo(FpsCamera* camera) const;
+
+  bool operator==(const CameraPose& other) const;
+  bool operator!=(const CameraPose& other) const {
+    return !(*this == other);
+  }
+};
+
+// 文本格式的视角列表，每行"x y z yaw pitch zoom"，空行和#开头的行忽略
+bool LoadCameraPoses(const std::string& path, std::vector<CameraPose>* poses);
+bool SaveCameraPoses(const std::string& path, const std::vector<CameraPose>& poses);
+
+// 录制一次交互中传给FpsCamera的所有输入。回放时原样重新调用，相机轨迹与录制时逐位一致，
+// 与回放时的帧率无关。文件格式（小端）：
+//   头：'CREC' 版本 初始姿态 帧数
+//   每帧：float帧间隔 uint16事件数，每个事件一个uint8类型加上参数
+//   尾：结束姿态，回放后用于校验
+class CameraRecorder {
+public:
+  // 记录初始姿态并清空已有数据
+  void Start(const FpsCamera& camera);
+
+  // 在调用相机对应的Process函数时一起调用，输入先暂存，属于下一次EndFrame的那一帧
+  void RecordKeyboard(FpsCamera::Movement direction, float delta_time);
+  void RecordMouseMovement(float x_offset, float y_offset);
+  void RecordMouseScroll(float y_offset);
+
+  // 每帧结束时调用一次。glfwPollEvents中回调的输入也会归入这一帧，回放时顺序不变
+  void EndFrame(float delta_time);
+
+  // end_camera为录制结束时的相机
+  bool Save(const std::string& path, const FpsCamera& end_camera) const;
+
+  size_t frame_count() const {
+    return frame_count_;
+  }
+
+private:
+  void AppendEvent(uint8_t type, const float* values, int value_count, uint8_t extra);
+
+private:
+  CameraPose start_pose_;
+  uint32_t frame_count_ = 0;
+  std::vector<uint8_t> data_;
+  // 当前帧尚未提交的事件
+  uint16_t pending_count_ = 0;
+  std::vector<uint8_t> pending_;
+};
+
+class CameraReplay {
+public:
+  bool Load(const std::string& path);
+
+  size_t frame_count() const {
+    return frames_.size();
+  }
+
+  // 把相机恢复到录制开始时的状态
+  void Reset(FpsCamera* camera) const;
+
+  // 重放第frame帧的输入，返回录制时的帧间隔
+  float ApplyFrame(size_t frame, FpsCamera* camera) const;
+
+  // 全部帧回放后检查相机是否与录制结束时一致
+  bool Verify(const FpsCamera& camera) const;
+
+private:
+  struct Frame {
+    float delta_time;
+    size_t first_event;
+    size_t event_count;
+  };
+
+  struct Event {
+    uint8_t type;
+    uint8_t extra;
+    float values[2];
+  };
+
+private:
+  CameraPose start_pose_;
+  CameraPose end_pose_;
+  std::vector<Frame> frames_;
+  std::vector<Event> events_;
+};
+
+}  // namespace utils
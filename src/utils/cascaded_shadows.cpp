@@ -0,0 +1,311 @@
+#include "utils/cascaded_shadows.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "spdlog/spdlog.h"
+#include "utils/fps_camera.h"
+#include "utils/profiler.h"
+#include "utils/shader.h"
+
+namespace utils {
+
+namespace {
+
+// 包围球半径向上取整到这个粒度，浮点误差不会让投影尺寸抖动
+constexpr float kRadiusQuantum = 1.0f / 16.0f;
+
+const char* const kCascadeMatrixNames[CascadedShadowMap::kMaxCascades] = {
+  "cascadeMatrices[0]", "cascadeMatrices[1]", "cascadeMatrices[2]", "cascadeMatrices[3]",
+};
+
+glm::vec3 LightUp(const glm::vec3& light_direction) {
+  return std::abs(light_direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+}  // namespace
+
+CascadedShadowMap::~CascadedShadowMap() {
+  Release();
+}
+
+bool CascadedShadowMap::Init(const CascadeOptions& options) {
+  Release();
+  if (options.cascade_count < 1 || options.cascade_count > kMaxCascades || options.resolution <= 0) {
+    SPDLOG_ERROR("Invalid cascade options: {} cascades of {}", options.cascade_count, options.resolution);
+    return false;
+  }
+  options_ = options;
+  for (int i = 0; i < kMaxCascades; i++) {
+    cascades_[i] = Cascade();
+    stats_[i] = CascadeStats();
+  }
+  cache_lookups_ = 0;
+  cache_hits_ = 0;
+
+  shadow_texture_ = CreateDepthArray(true);
+  static_texture_ = CreateDepthArray(false);
+
+  // 只有深度附件的帧缓冲，图层在Render中切换
+  glGenFramebuffers(1, &read_framebuffer_);
+  glGenFramebuffers(1, &draw_framebuffer_);
+  for (GLuint framebuffer : {read_framebuffer_, draw_framebuffer_}) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, static_texture_, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      SPDLOG_ERROR("Shadow framebuffer is not complete.");
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      Release();
+      return false;
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  timers_supported_ = GLAD_GL_VERSION_3_3 != 0;
+  if (timers_supported_) {
+    for (TimerSlot& slot : timers_) {
+      glGenQueries(kMaxCascades * 3, slot.queries);
+    }
+  }
+  return true;
+}
+
+void CascadedShadowMap::Release() {
+  if (shadow_texture_ != 0) {
+    glDeleteTextures(1, &shadow_texture_);
+    shadow_texture_ = 0;
+  }
+  if (static_texture_ != 0) {
+    glDeleteTextures(1, &static_texture_);
+    static_texture_ = 0;
+  }
+  if (read_framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &read_framebuffer_);
+    glDeleteFramebuffers(1, &draw_framebuffer_);
+    read_framebuffer_ = 0;
+    draw_framebuffer_ = 0;
+  }
+  for (TimerSlot& slot : timers_) {
+    if (slot.queries[0] != 0) {
+      glDeleteQueries(kMaxCascades * 3, slot.queries);
+    }
+    slot = TimerSlot();
+  }
+  timers_supported_ = false;
+}
+
+void CascadedShadowMap::Update(FpsCamera& camera, const glm::vec3& light_direction) {
+  glm::vec3 direction = glm::normalize(light_direction);
+  float near_plane = camera.near_plane();
+  float far_plane = std::min(camera.far_plane(), options_.max_distance);
+  float tan_y = std::tan(glm::radians(camera.zoom()) * 0.5f);
+  float tan_x = tan_y * camera.aspect();
+  glm::mat4 inverse_view = glm::inverse(camera.GetViewMatrix());
+  float cos_threshold = std::cos(glm::radians(options_.light_threshold));
+
+  float split_near = near_plane;
+  for (int i = 0; i < options_.cascade_count; i++) {
+    Cascade& cascade = cascades_[i];
+    float ratio = static_cast<float>(i + 1) / options_.cascade_count;
+    float log_split = near_plane * std::pow(far_plane / near_plane, ratio);
+    float uniform_split = near_plane + (far_plane - near_plane) * ratio;
+    float split_far = options_.split_lambda * log_split + (1.0f - options_.split_lambda) * uniform_split;
+    cascade.split_near = split_near;
+    cascade.split_far = split_far;
+    stats_[i].split_far = split_far;
+    split_near = split_far;
+
+    // 球心放在视线上，半径只和投影参数有关，相机旋转时不变
+    float center_depth = (cascade.split_near + cascade.split_far) * 0.5f;
+    float radius = 0.0f;
+    for (float depth : {cascade.split_near, cascade.split_far}) {
+      glm::vec3 corner(tan_x * depth, tan_y * depth, depth - center_depth);
+      radius = std::max(radius, glm::length(corner));
+    }
+    cascade.slice_radius = std::ceil(radius / kRadiusQuantum) * kRadiusQuantum;
+    cascade.slice_center = glm::vec3(inverse_view * glm::vec4(0.0f, 0.0f, -center_depth, 1.0f));
+
+    bool light_moved = cascade.radius == 0.0f || glm::dot(direction, cascade.light_direction) < cos_threshold;
+    bool slice_outside = glm::length(cascade.slice_center - cascade.center) + cascade.slice_radius > cascade.radius;
+    if (light_moved || slice_outside) {
+      Fit(&cascade, direction);
+      cascade.static_dirty = true;
+    } else if (!options_.cache_static) {
+      cascade.static_dirty = true;
+    }
+  }
+}
+
+void CascadedShadowMap::Fit(Cascade* cascade, const glm::vec3& light_direction) const {
+  float radius = cascade->slice_radius * (1.0f + options_.cache_margin);
+  radius = std::ceil(radius / kRadiusQuantum) * kRadiusQuantum;
+  float texel = 2.0f * radius / options_.resolution;
+
+  // 在光源空间中把中心对齐到纹素，静态物体在阴影贴图上的位置只会整纹素移动
+  glm::vec3 up = LightUp(light_direction);
+  glm::mat4 rotation = glm::lookAt(glm::vec3(0.0f), light_direction, up);
+  glm::vec3 light_center = glm::vec3(rotation * glm::vec4(cascade->slice_center, 1.0f));
+  light_center.x = std::floor(light_center.x / texel) * texel;
+  light_center.y = std::floor(light_center.y / texel) * texel;
+  glm::vec3 center = glm::vec3(glm::inverse(rotation) * glm::vec4(light_center, 1.0f));
+
+  float distance = radius + options_.depth_padding;
+  glm::mat4 view = glm::lookAt(center - light_direction * distance, center, up);
+  glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, distance + radius);
+  cascade->center = center;
+  cascade->radius = radius;
+  cascade->light_direction = light_direction;
+  cascade->view_projection = projection * view;
+}
+
+void CascadedShadowMap::Render(const ShadowDrawFunc& draw_static, const ShadowDrawFunc& draw_dynamic) {
+  PROFILE_SCOPE("CascadedShadowMap::Render");
+  ResolveTimers();
+  TimerSlot& slot = timers_[frame_ % kTimerLatency];
+  // GPU落后太多、这一块的结果还没读回时这一帧不计时
+  bool timing = timers_supported_ && !slot.pending;
+  if (timing) {
+    slot.cascade_count = options_.cascade_count;
+  }
+
+  // 无窗口模式下默认画到离屏帧缓冲，结束后恢复
+  GLint framebuffer = 0;
+  GLint viewport[4];
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glViewport(0, 0, options_.resolution, options_.resolution);
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_TRUE);
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(2.0f, 4.0f);
+
+  for (int i = 0; i < options_.cascade_count; i++) {
+    Cascade& cascade = cascades_[i];
+    stats_[i].frames++;
+    cache_lookups_++;
+    if (timing) {
+      glQueryCounter(slot.queries[i * 3], GL_TIMESTAMP);
+      slot.static_rendered[i] = cascade.static_dirty;
+    }
+    if (cascade.static_dirty) {
+      glBindFramebuffer(GL_FRAMEBUFFER, draw_framebuffer_);
+      glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, static_texture_, 0, i);
+      glClear(GL_DEPTH_BUFFER_BIT);
+      draw_static(i, cascade.view_projection);
+      cascade.static_dirty = false;
+      stats_[i].static_renders++;
+    } else {
+      cache_hits_++;
+    }
+
+    // 静态阴影复制到阴影贴图，再叠加动态物体
+    if (timing) {
+      glQueryCounter(slot.queries[i * 3 + 1], GL_TIMESTAMP);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer_);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, static_texture_, 0, i);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer_);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_texture_, 0, i);
+    glBlitFramebuffer(0, 0, options_.resolution, options_.resolution, 0, 0, options_.resolution, options_.resolution,
+                      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, draw_framebuffer_);
+    draw_dynamic(i, cascade.view_projection);
+    if (timing) {
+      glQueryCounter(slot.queries[i * 3 + 2], GL_TIMESTAMP);
+    }
+  }
+
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  slot.pending = timing;
+  frame_++;
+}
+
+void CascadedShadowMap::InvalidateStatic() {
+  for (Cascade& cascade : cascades_) {
+    cascade.static_dirty = true;
+  }
+}
+
+void CascadedShadowMap::Bind(const Shader& shader, int texture_unit) const {
+  glActiveTexture(GL_TEXTURE0 + texture_unit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, shadow_texture_);
+  glActiveTexture(GL_TEXTURE0);
+  shader.SetInt("shadowMap", texture_unit);
+  shader.SetInt("cascadeCount", options_.cascade_count);
+
+  glm::vec4 splits(0.0f);
+  glm::vec4 texel_sizes(0.0f);
+  for (int i = 0; i < options_.cascade_count; i++) {
+    splits[i] = cascades_[i].split_far;
+    texel_sizes[i] = 2.0f * cascades_[i].radius / options_.resolution;
+    shader.SetMat4(kCascadeMatrixNames[i], cascades_[i].view_projection);
+  }
+  shader.SetVec4("cascadeSplits", splits);
+  shader.SetVec4("cascadeTexelSizes", texel_sizes);
+}
+
+double CascadedShadowMap::cache_hit_rate() const {
+  return cache_lookups_ == 0 ? 0.0 : static_cast<double>(cache_hits_) / cache_lookups_;
+}
+
+void CascadedShadowMap::ResolveTimers() {
+  if (!timers_supported_) {
+    return;
+  }
+  for (TimerSlot& slot : timers_) {
+    if (!slot.pending) {
+      continue;
+    }
+    // 查询按顺序完成，最后一个可用时其它的也都可用
+    GLint available = 0;
+    glGetQueryObjectiv(slot.queries[slot.cascade_count * 3 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+    for (int i = 0; i < slot.cascade_count; i++) {
+      GLuint64 timestamps[3] = {0, 0, 0};
+      for (int j = 0; j < 3; j++) {
+        glGetQueryObjectui64v(slot.queries[i * 3 + j], GL_QUERY_RESULT, &timestamps[j]);
+      }
+      CascadeStats& stats = stats_[i];
+      if (slot.static_rendered[i]) {
+        stats.static_ms = static_cast<double>(timestamps[1] - timestamps[0]) / 1e6;
+        stats.static_ms_sum += stats.static_ms;
+        stats.static_samples++;
+      }
+      stats.dynamic_ms = static_cast<double>(timestamps[2] - timestamps[1]) / 1e6;
+      stats.dynamic_ms_sum += stats.dynamic_ms;
+      stats.dynamic_samples++;
+    }
+    slot.pending = false;
+  }
+}
+
+GLuint CascadedShadowMap::CreateDepthArray(bool compare) const {
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, options_.resolution, options_.resolution,
+               options_.cascade_count, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  if (compare) {
+    // 硬件比较加双线性过滤，一次采样得到2x2的PCF
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  } else {
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  return texture;
+}
+
+}  // namespace utils
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+namespace utils {
+
+class FpsCamera;
+class Shader;
+
+struct CascadeOptions {
+  int cascade_count = 4;
+  int resolution = 2048;
+  // 阴影覆盖的最远观察距离，超过相机远平面时取远平面
+  float max_distance = 150.0f;
+  // 对数划分和均匀划分的混合比例
+  float split_lambda = 0.75f;
+  // 级联包围球比视锥体切片的包围球大出的比例，相机在余量内移动时沿用缓存的静态阴影
+  float cache_margin = 0.15f;
+  // 光源方向变化超过这个角度（度）时重画静态阴影
+  float light_threshold = 0.5f;
+  // 光源方向上额外包含的距离，级联之外的遮挡物也能投下阴影
+  float depth_padding = 100.0f;
+  // 为false时每帧都重画静态阴影，用于对比
+  bool cache_static = true;
+};
+
+// 每个级联的统计，GPU时间用时间戳查询在之后的帧读回
+struct CascadeStats {
+  float split_far = 0.0f;
+  uint64_t frames = 0;
+  uint64_t static_renders = 0;
+  // 最近一次读回的时间（毫秒）：重画静态阴影，以及复制静态阴影加画动态物体
+  double static_ms = 0.0;
+  double dynamic_ms = 0.0;
+  double static_ms_sum = 0.0;
+  double dynamic_ms_sum = 0.0;
+  uint64_t static_samples = 0;
+  uint64_t dynamic_samples = 0;
+};
+
+// 参数为级联序号和光源的视图投影矩阵，使用者在回调中设置着色器并绘制遮挡物
+using ShadowDrawFunc = std::function<void(int cascade, const glm::mat4& light_view_projection)>;
+
+// 方向光的级联阴影贴图。每个级联用包住视锥体切片的球拟合，投影尺寸不随相机旋转变化，
+// 中心按阴影贴图纹素对齐，画面不会闪烁。
+// 静态遮挡物按级联缓存在单独的深度纹理数组中：光源方向没有明显变化、且视锥体切片仍在缓存的级联内时
+// 不重画，每帧只把缓存复制到阴影贴图再叠加动态遮挡物。
+// 着色器通过res/shaders/cascaded_shadows.glsl采样。
+class CascadedShadowMap {
+public:
+  static constexpr int kMaxCascades = 4;
+
+  CascadedShadowMap() = default;
+  ~CascadedShadowMap();
+
+  CascadedShadowMap(const CascadedShadowMap&) = delete;
+  CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+  bool Init(const CascadeOptions& options);
+  void Release();
+
+  // light_direction为光线照射方向（从光源指向场景）
+  void Update(FpsCamera& camera, const glm::vec3& light_direction);
+
+  // 画阴影贴图，结束后恢复原来的帧缓冲和视口
+  void Render(const ShadowDrawFunc& draw_static, const ShadowDrawFunc& draw_dynamic);
+
+  // 静态几何体改变时调用，下一次Render重画所有级联
+  void InvalidateStatic();
+
+  // 调用前需要先Use
+  void Bind(const Shader& shader, int texture_unit) const;
+
+  int cascade_count() const {
+    return options_.cascade_count;
+  }
+
+  const glm::mat4& light_view_projection(int cascade) const {
+    return cascades_[cascade].view_projection;
+  }
+
+  const CascadeStats& stats(int cascade) const {
+    return stats_[cascade];
+  }
+
+  // 所有级联中沿用静态缓存的比例
+  double cache_hit_rate() const;
+
+private:
+  struct Cascade {
+    float split_near = 0.0f;
+    float split_far = 0.0f;
+    // 视锥体切片的包围球
+    glm::vec3 slice_center = glm::vec3(0.0f);
+    float slice_radius = 0.0f;
+    // 当前使用（也是静态缓存对应）的级联
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 light_direction = glm::vec3(0.0f);
+    glm::mat4 view_projection = glm::mat4(1.0f);
+    bool static_dirty = true;
+  };
+
+  static constexpr int kTimerLatency = 4;
+
+  // 每帧每个级联三个时间戳：画静态阴影前、复制静态阴影前、画完动态物体后，结果可用时才读取
+  struct TimerSlot {
+    GLuint queries[kMaxCascades * 3] = {};
+    bool static_rendered[kMaxCascades] = {};
+    int cascade_count = 0;
+    bool pending = false;
+  };
+
+  void Fit(Cascade* cascade, const glm::vec3& light_direction) const;
+  void ResolveTimers();
+  GLuint CreateDepthArray(bool compare) const;
+
+private:
+  CascadeOptions options_;
+  Cascade cascades_[kMaxCascades];
+  CascadeStats stats_[kMaxCascades];
+  uint64_t cache_lookups_ = 0;
+  uint64_t cache_hits_ = 0;
+
+  GLuint shadow_texture_ = 0;
+  GLuint static_texture_ = 0;
+  GLuint read_framebuffer_ = 0;
+  GLuint draw_framebuffer_ = 0;
+
+  bool timers_supported_ = false;
+  TimerSlot timers_[kTimerLatency];
+  uint64_t frame_ = 0;
+};
+
+}  // namespace utils
@@ -0,0 +1,108 @@
+#include "utils/clustered_lighting.h"
+
+#include <algorithm>
+
+#include "spdlog/spdlog.h"
+#include "utils/metrics.h"
+#include "utils/shader.h"
+
+namespace utils {
+
+namespace {
+
+// 点光源的cos_outer标记值，小于任何余弦
+constexpr float kPointLightCone = -2.0f;
+
+}  // namespace
+
+ClusteredLighting::~ClusteredLighting() {
+  Release();
+}
+
+bool ClusteredLighting::Init() {
+  Release();
+  lights_.format = GL_RGBA32F;
+  clusters_.format = GL_RG32UI;
+  indices_.format = GL_R32UI;
+  for (TextureBuffer* texture_buffer : {&lights_, &clusters_, &indices_}) {
+    glGenBuffers(1, &texture_buffer->buffer);
+    glGenTextures(1, &texture_buffer->texture);
+    if (texture_buffer->buffer == 0 || texture_buffer->texture == 0) {
+      SPDLOG_ERROR("Failed to create light cluster texture buffers.");
+      Release();
+      return false;
+    }
+    // 空缓冲不能绑定到纹理，先分配一个纹素
+    Update(texture_buffer, nullptr, 16);
+  }
+  return true;
+}
+
+void ClusteredLighting::Release() {
+  for (TextureBuffer* texture_buffer : {&lights_, &clusters_, &indices_}) {
+    if (texture_buffer->texture != 0) {
+      glDeleteTextures(1, &texture_buffer->texture);
+    }
+    if (texture_buffer->buffer != 0) {
+      glDeleteBuffers(1, &texture_buffer->buffer);
+    }
+    *texture_buffer = TextureBuffer();
+  }
+}
+
+void ClusteredLighting::Upload(const LightClusterer& clusterer, const std::vector<Light>& lights) {
+  light_texels_.resize(lights.size() * 3);
+  for (size_t i = 0; i < lights.size(); i++) {
+    const Light& light = lights[i];
+    bool spot = light.type == LightType::kSpot;
+    light_texels_[i * 3] = glm::vec4(light.position, light.range);
+    light_texels_[i * 3 + 1] = glm::vec4(light.color * light.intensity, light.cos_inner);
+    light_texels_[i * 3 + 2] = glm::vec4(light.direction, spot ? light.cos_outer : kPointLightCone);
+  }
+  Update(&lights_, light_texels_.data(), light_texels_.size() * sizeof(glm::vec4));
+  Update(&clusters_, clusterer.clusters().data(), clusterer.clusters().size() * sizeof(uint32_t));
+  Update(&indices_, clusterer.light_indices().data(), clusterer.light_indices().size() * sizeof(uint32_t));
+
+  const ClusterGridSize& size = clusterer.size();
+  grid_size_ = glm::vec3(size.x, size.y, size.z);
+  z_params_ = glm::vec2(clusterer.z_scale(), clusterer.z_bias());
+}
+
+void ClusteredLighting::Bind(const Shader& shader, int first_unit, int viewport_width, int viewport_height) const {
+  const char* names[3] = {"clusterLights", "clusterRanges", "clusterIndices"};
+  const TextureBuffer* texture_buffers[3] = {&lights_, &clusters_, &indices_};
+  for (int i = 0; i < 3; i++) {
+    glActiveTexture(GL_TEXTURE0 + first_unit + i);
+    glBindTexture(GL_TEXTURE_BUFFER, texture_buffers[i]->texture);
+    shader.SetInt(names[i], first_unit + i);
+  }
+  glActiveTexture(GL_TEXTURE0);
+
+  // 着色器用gl_FragCoord.xy * tileScale得到簇的x、y
+  glm::vec2 tile_scale(grid_size_.x / std::max(viewport_width, 1), grid_size_.y / std::max(viewport_height, 1));
+  shader.SetVec3("clusterGridSize", grid_size_);
+  shader.SetVec2("clusterTileScale", tile_scale);
+  shader.SetVec2("clusterZParams", z_params_);
+}
+
+void ClusteredLighting::Update(TextureBuffer* texture_buffer, const void* data, size_t size) {
+  glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer->buffer);
+  if (size > texture_buffer->capacity) {
+    // 按需扩容，留出余量避免光源数量小幅变化时反复重新分配
+    texture_buffer->capacity = std::max(size, texture_buffer->capacity * 3 / 2);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(texture_buffer->capacity), nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture_buffer->texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, texture_buffer->format, texture_buffer->buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  } else if (data != nullptr) {
+    // 丢弃旧内容，驱动可以换一块新内存而不必等待上一帧读完
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(texture_buffer->capacity), nullptr, GL_STREAM_DRAW);
+  }
+  if (data != nullptr && size > 0) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    RenderMetrics::Get().buffer_upload_bytes.Add(size);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+}  // namespace utils
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "utils/light_clusters.h"
+
+namespace utils {
+
+class Shader;
+
+// 把LightClusterer的结果上传为三个纹理缓冲（TBO），供res/shaders/clustered_lighting.glsl读取：
+// 光源参数（每个光源3个RGBA32F纹素）、每个簇的起始位置和数量（RG32UI）、光源下标列表（R32UI）。
+// 1万个光源超出UBO的大小限制，所以不用UBO。
+class ClusteredLighting {
+public:
+  ClusteredLighting() = default;
+  ~ClusteredLighting();
+
+  ClusteredLighting(const ClusteredLighting&) = delete;
+  ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+  bool Init();
+  void Release();
+
+  // lights为传给Assign的同一组光源
+  void Upload(const LightClusterer& clusterer, const std::vector<Light>& lights);
+
+  // 占用[first_unit, first_unit + 3)三个纹理单元，调用前需要先Use
+  void Bind(const Shader& shader, int first_unit, int viewport_width, int viewport_height) const;
+
+private:
+  struct TextureBuffer {
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    GLenum format = GL_R32UI;
+    size_t capacity = 0;
+  };
+
+  static void Update(TextureBuffer* texture_buffer, const void* data, size_t size);
+
+private:
+  TextureBuffer lights_;
+  TextureBuffer clusters_;
+  TextureBuffer indices_;
+  std::vector<glm::vec4> light_texels_;
+  glm::vec3 grid_size_ = glm::vec3(0.0f);
+  glm::vec2 z_params_ = glm::vec2(0.0f);
+};
+
+}  // namespace utils
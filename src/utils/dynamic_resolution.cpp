@@ -0,0 +1,170 @@
+#include "utils/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "spdlog/spdlog.h"
+#include "utils/metrics.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+DynamicResolution::~DynamicResolution() {
+  Release();
+}
+
+bool DynamicResolution::Init(const DynamicResolutionOptions& options, const std::string& upscale_vertex_path,
+                             const std::string& upscale_fragment_path) {
+  Release();
+  if (options.min_scale <= 0.0f || options.min_scale > options.max_scale || options.target_ms <= 0.0) {
+    SPDLOG_ERROR("Invalid dynamic resolution options: scale [{}, {}], target {} ms", options.min_scale,
+                 options.max_scale, options.target_ms);
+    return false;
+  }
+  if (!upscale_shader_.Compile(upscale_vertex_path, upscale_fragment_path)) {
+    return false;
+  }
+  options_ = options;
+  scale_ = options.max_scale;
+  last_error_ = 0.0f;
+  gpu_ms_ = 0.0;
+
+  // 全屏三角形的顶点在着色器中由gl_VertexID生成，但核心模式仍需要绑定一个VAO
+  glGenVertexArrays(1, &vao_);
+
+  timers_supported_ = GLAD_GL_VERSION_3_3 != 0;
+  if (timers_supported_) {
+    for (TimerSlot& slot : timers_) {
+      glGenQueries(2, slot.queries);
+    }
+  }
+  return true;
+}
+
+void DynamicResolution::Release() {
+  if (target_ != nullptr) {
+    pool_.Release(target_);
+    target_ = nullptr;
+  }
+  pool_.Clear();
+  if (vao_ != 0) {
+    glDeleteVertexArrays(1, &vao_);
+    vao_ = 0;
+  }
+  for (TimerSlot& slot : timers_) {
+    if (slot.queries[0] != 0) {
+      glDeleteQueries(2, slot.queries);
+    }
+    slot = TimerSlot();
+  }
+  timers_supported_ = false;
+}
+
+void DynamicResolution::BeginFrame(int output_width, int output_height) {
+  PROFILE_SCOPE("DynamicResolution::BeginFrame");
+  ResolveTimers();
+
+  output_width_ = std::max(output_width, 1);
+  output_height_ = std::max(output_height, 1);
+  float scale = options_.enabled ? scale_ : options_.max_scale;
+  if (options_.scale_step > 0.0f) {
+    scale = std::round(scale / options_.scale_step) * options_.scale_step;
+    scale = std::clamp(scale, options_.min_scale, options_.max_scale);
+  }
+  render_width_ = std::max(static_cast<int>(std::lround(output_width_ * scale)), 1);
+  render_height_ = std::max(static_cast<int>(std::lround(output_height_ * scale)), 1);
+
+  RenderTargetDesc desc;
+  desc.width = render_width_;
+  desc.height = render_height_;
+  desc.color_format = options_.color_format;
+  desc.depth_format = options_.depth_format;
+  if (target_ == nullptr || !(target_->desc == desc)) {
+    if (target_ != nullptr) {
+      pool_.Release(target_);
+    }
+    target_ = pool_.Acquire(desc);
+  }
+
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output_framebuffer_);
+  TimerSlot& slot = timers_[frame_ % kTimerLatency];
+  timing_ = timers_supported_ && !slot.pending;
+  if (timing_) {
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, target_ != nullptr ? target_->framebuffer : output_framebuffer_);
+  glViewport(0, 0, render_width_, render_height_);
+}
+
+void DynamicResolution::EndFrame() {
+  PROFILE_SCOPE("DynamicResolution::EndFrame");
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output_framebuffer_));
+  glViewport(0, 0, output_width_, output_height_);
+  if (target_ != nullptr) {
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cull_face = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    upscale_shader_.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, target_->color_texture);
+    upscale_shader_.SetInt("source", 0);
+    upscale_shader_.SetVec2("sourceSize", static_cast<float>(render_width_), static_cast<float>(render_height_));
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    RenderMetrics::Get().draw_calls.Add();
+
+    if (depth_test) {
+      glEnable(GL_DEPTH_TEST);
+    }
+    if (cull_face) {
+      glEnable(GL_CULL_FACE);
+    }
+  }
+
+  TimerSlot& slot = timers_[frame_ % kTimerLatency];
+  if (timing_) {
+    glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+    slot.pending = true;
+  }
+  pool_.EndFrame();
+  frame_++;
+}
+
+void DynamicResolution::ResolveTimers() {
+  if (!timers_supported_) {
+    return;
+  }
+  // 从最旧的帧开始按顺序读回，每个结果都更新一次控制器，增量PI的积分项不会漏掉样本；gpu_ms_留下最新的
+  for (uint64_t i = 0; i < kTimerLatency; i++) {
+    TimerSlot& slot = timers_[(frame_ + i) % kTimerLatency];
+    if (!slot.pending) {
+      continue;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+    GLuint64 begin_ns = 0;
+    GLuint64 end_ns = 0;
+    glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &begin_ns);
+    glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &end_ns);
+    slot.pending = false;
+    gpu_ms_ = static_cast<double>(end_ns - begin_ns) / 1e6;
+    UpdateScale(gpu_ms_);
+  }
+}
+
+void DynamicResolution::UpdateScale(double measured_ms) {
+  // 增量形式的PI：比例项作用于误差的变化，积分项作用于误差本身；输出直接截断，不会积分饱和
+  auto error = static_cast<float>((options_.target_ms - measured_ms) / options_.target_ms);
+  error = std::clamp(error, -1.0f, 1.0f);
+  scale_ += options_.kp * (error - last_error_) + options_.ki * error;
+  scale_ = std::clamp(scale_, options_.min_scale, options_.max_scale);
+  last_error_ = error;
+}
+
+}  // namespace utils
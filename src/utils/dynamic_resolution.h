@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "glad/glad.h"
+#include "utils/render_target_pool.h"
+#include "utils/shader.h"
+
+namespace utils {
+
+struct DynamicResolutionOptions {
+  // GPU时间预算（毫秒），包括场景和放大
+  double target_ms = 16.0;
+  float min_scale = 0.5f;
+  float max_scale = 1.0f;
+  // 缩放按这个步长取整，尺寸种类有限，渲染目标可以复用
+  float scale_step = 0.05f;
+  // PI控制器（增量形式）的比例和积分系数，误差为(预算 - 实测) / 预算
+  float kp = 0.3f;
+  float ki = 0.08f;
+  // 为false时固定使用max_scale，用于对比
+  bool enabled = true;
+  GLenum color_format = GL_RGBA8;
+  GLenum depth_format = GL_DEPTH24_STENCIL8;
+};
+
+// 动态分辨率：场景画到缩小的离屏渲染目标，再用双三次滤波放大到输出帧缓冲。
+// 缩放比例每帧由PI控制器根据读回的GPU时间调整，渲染目标从RenderTargetPool中按尺寸复用。
+//   resolution.BeginFrame(width, height);
+//   ...画场景...
+//   resolution.EndFrame();
+class DynamicResolution {
+public:
+  DynamicResolution() = default;
+  ~DynamicResolution();
+
+  DynamicResolution(const DynamicResolution&) = delete;
+  DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+  bool Init(const DynamicResolutionOptions& options, const std::string& upscale_vertex_path,
+            const std::string& upscale_fragment_path);
+  void Release();
+
+  // 绑定本帧的渲染目标并设置视口，output为最终输出的尺寸
+  void BeginFrame(int output_width, int output_height);
+
+  // 放大到BeginFrame时绑定的帧缓冲
+  void EndFrame();
+
+  float scale() const {
+    return scale_;
+  }
+
+  int render_width() const {
+    return render_width_;
+  }
+
+  int render_height() const {
+    return render_height_;
+  }
+
+  // 最近一次读回的GPU时间（毫秒），尚无结果时为0
+  double gpu_ms() const {
+    return gpu_ms_;
+  }
+
+  const RenderTargetPool& pool() const {
+    return pool_;
+  }
+
+private:
+  static constexpr int kTimerLatency = 4;
+
+  struct TimerSlot {
+    GLuint queries[2] = {0, 0};
+    bool pending = false;
+  };
+
+  void ResolveTimers();
+  void UpdateScale(double measured_ms);
+
+private:
+  DynamicResolutionOptions options_;
+  Shader upscale_shader_;
+  GLuint vao_ = 0;
+  RenderTargetPool pool_;
+  RenderTarget* target_ = nullptr;
+  GLint output_framebuffer_ = 0;
+  int output_width_ = 0;
+  int output_height_ = 0;
+  int render_width_ = 0;
+  int render_height_ = 0;
+
+  float scale_ = 1.0f;
+  float last_error_ = 0.0f;
+  double gpu_ms_ = 0.0;
+
+  bool timers_supported_ = false;
+  TimerSlot timers_[kTimerLatency];
+  uint64_t frame_ = 0;
+  bool timing_ = false;
+};
+
+}  // namespace utils
@@ -0,0 +1,429 @@
+#include "utils/ecs.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdlib>
+#include <mutex>
+
+#include "spdlog/spdlog.h"
+#include "utils/thread_pool.h"
+
+namespace utils {
+namespace ecs {
+
+namespace {
+
+std::mutex registry_mutex;
+ComponentInfo registry[kMaxComponentTypes];
+uint32_t registry_size = 0;
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+ComponentTypeId RegisterComponentType(size_t size, size_t alignment, const char* name) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  if (registry_size >= kMaxComponentTypes) {
+    SPDLOG_CRITICAL("Too many ECS component types, max: {}. Type: {}", kMaxComponentTypes, name);
+    std::abort();
+  }
+
+  if (alignment > alignof(std::max_align_t) * 4) {
+    SPDLOG_CRITICAL("ECS component alignment {} is not supported. Type: {}", alignment, name);
+    std::abort();
+  }
+
+  registry[registry_size] = { size, alignment, name };
+  return registry_size++;
+}
+
+const ComponentInfo& GetComponentInfo(ComponentTypeId type) {
+  return registry[type];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Archetype
+
+Archetype::Archetype(ComponentMask mask) : mask_(mask) {
+  size_t row_size = sizeof(Entity);
+  for (ComponentTypeId type = 0; type < kMaxComponentTypes; type++) {
+    offsets_[type] = UINT32_MAX;
+    sizes_[type] = 0;
+    if ((mask & (ComponentMask(1) << type)) != 0) {
+      types_.push_back(type);
+      sizes_[type] = static_cast<uint32_t>(GetComponentInfo(type).size);
+      row_size += sizes_[type];
+    }
+  }
+
+  // 先按每行大小估算容量，再减掉对齐填充放不下的部分
+  auto capacity = static_cast<uint32_t>(kChunkSize / row_size);
+  for (; capacity > 0; capacity--) {
+    size_t offset = sizeof(Entity) * capacity;
+    for (ComponentTypeId type : types_) {
+      offset = AlignUp(offset, GetComponentInfo(type).alignment);
+      offsets_[type] = static_cast<uint32_t>(offset);
+      offset += sizes_[type] * capacity;
+    }
+    if (offset <= kChunkSize) {
+      break;
+    }
+  }
+
+  if (capacity == 0) {
+    SPDLOG_CRITICAL("ECS components do not fit into a {} byte chunk.", kChunkSize);
+    std::abort();
+  }
+  capacity_ = capacity;
+}
+
+size_t Archetype::entity_count() const {
+  if (counts_.empty()) {
+    return 0;
+  }
+  return (counts_.size() - 1) * capacity_ + counts_.back();
+}
+
+void Archetype::Allocate(Entity entity, uint32_t* chunk, uint32_t* row) {
+  if (counts_.empty() || counts_.back() == capacity_) {
+    if (spare_chunk_ != nullptr) {
+      chunks_.push_back(std::move(spare_chunk_));
+    } else {
+      chunks_.push_back(std::unique_ptr<Chunk>(new Chunk));
+    }
+    counts_.push_back(0);
+  }
+
+  *chunk = static_cast<uint32_t>(counts_.size() - 1);
+  *row = counts_.back()++;
+  entities(*chunk)[*row] = entity;
+}
+
+Entity Archetype::Remove(uint32_t chunk, uint32_t row) {
+  auto last_chunk = static_cast<uint32_t>(counts_.size() - 1);
+  uint32_t last_row = counts_.back() - 1;
+
+  Entity moved;
+  if (chunk != last_chunk || row != last_row) {
+    for (ComponentTypeId type : types_) {
+      std::memcpy(ComponentAt(type, chunk, row), ComponentAt(type, last_chunk, last_row), sizes_[type]);
+    }
+    moved = entities(last_chunk)[last_row];
+    entities(chunk)[row] = moved;
+  }
+
+  // 空chunk留一个备用，避免实体数量在边界附近抖动时反复分配
+  if (--counts_.back() == 0) {
+    spare_chunk_ = std::move(chunks_.back());
+    chunks_.pop_back();
+    counts_.pop_back();
+  }
+
+  return moved;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// World
+
+World::World() = default;
+
+World::~World() = default;
+
+Entity World::CreateEntity(ComponentMask mask) {
+  Archetype* archetype = GetArchetype(mask);
+  Entity entity = AllocateEntity(archetype);
+
+  const EntityRecord& record = records_[entity.index];
+  for (ComponentTypeId type : archetype->types_) {
+    std::memset(archetype->ComponentAt(type, record.chunk, record.row), 0, archetype->sizes_[type]);
+  }
+
+  return entity;
+}
+
+Entity World::AllocateEntity(Archetype* archetype) {
+  Entity entity;
+  if (!free_indices_.empty()) {
+    entity.index = free_indices_.back();
+    free_indices_.pop_back();
+  } else {
+    entity.index = static_cast<uint32_t>(records_.size());
+    records_.emplace_back();
+  }
+
+  EntityRecord& record = records_[entity.index];
+  entity.generation = record.generation;
+  record.archetype = archetype;
+  archetype->Allocate(entity, &record.chunk, &record.row);
+  return entity;
+}
+
+void World::DestroyEntity(Entity entity) {
+  if (!IsAlive(entity)) {
+    return;
+  }
+
+  EntityRecord& record = records_[entity.index];
+  Archetype* archetype = record.archetype;
+  uint32_t chunk = record.chunk;
+  uint32_t row = record.row;
+
+  record.archetype = nullptr;
+  record.generation++;
+  free_indices_.push_back(entity.index);
+
+  RemoveRow(archetype, chunk, row);
+}
+
+bool World::IsAlive(Entity entity) const {
+  return entity.index < records_.size() && records_[entity.index].archetype != nullptr &&
+         records_[entity.index].generation == entity.generation;
+}
+
+void World::AddComponentRaw(Entity entity, ComponentTypeId type, const void* data) {
+  if (!IsAlive(entity)) {
+    return;
+  }
+
+  Archetype* source = records_[entity.index].archetype;
+  if ((source->mask() & (ComponentMask(1) << type)) == 0) {
+    Archetype*& target = source->add_edges_[type];
+    if (target == nullptr) {
+      target = GetArchetype(source->mask() | (ComponentMask(1) << type));
+    }
+    MoveEntity(entity, target);
+  }
+
+  SetComponentRaw(entity, type, data);
+}
+
+void World::RemoveComponentRaw(Entity entity, ComponentTypeId type) {
+  if (!IsAlive(entity)) {
+    return;
+  }
+
+  Archetype* source = records_[entity.index].archetype;
+  if ((source->mask() & (ComponentMask(1) << type)) == 0) {
+    return;
+  }
+
+  Archetype*& target = source->remove_edges_[type];
+  if (target == nullptr) {
+    target = GetArchetype(source->mask() & ~(ComponentMask(1) << type));
+  }
+  MoveEntity(entity, target);
+}
+
+void World::SetComponentRaw(Entity entity, ComponentTypeId type, const void* data) {
+  void* component = GetComponentRaw(entity, type);
+  if (component != nullptr) {
+    std::memcpy(component, data, GetComponentInfo(type).size);
+  }
+}
+
+void* World::GetComponentRaw(Entity entity, ComponentTypeId type) {
+  if (!IsAlive(entity)) {
+    return nullptr;
+  }
+
+  const EntityRecord& record = records_[entity.index];
+  if ((record.archetype->mask() & (ComponentMask(1) << type)) == 0) {
+    return nullptr;
+  }
+  return record.archetype->ComponentAt(type, record.chunk, record.row);
+}
+
+Archetype* World::GetArchetype(ComponentMask mask) {
+  auto iter = archetype_map_.find(mask);
+  if (iter != archetype_map_.end()) {
+    return iter->second.get();
+  }
+
+  auto archetype = std::make_unique<Archetype>(mask);
+  Archetype* result = archetype.get();
+  archetype_map_.emplace(mask, std::move(archetype));
+  archetypes_.push_back(result);
+  return result;
+}
+
+void World::MoveEntity(Entity entity, Archetype* target) {
+  EntityRecord& record = records_[entity.index];
+  Archetype* source = record.archetype;
+  uint32_t source_chunk = record.chunk;
+  uint32_t source_row = record.row;
+
+  uint32_t chunk = 0;
+  uint32_t row = 0;
+  target->Allocate(entity, &chunk, &row);
+  for (ComponentTypeId type : target->types_) {
+    void* dst = target->ComponentAt(type, chunk, row);
+    if ((source->mask() & (ComponentMask(1) << type)) != 0) {
+      std::memcpy(dst, source->ComponentAt(type, source_chunk, source_row), target->sizes_[type]);
+    } else {
+      std::memset(dst, 0, target->sizes_[type]);
+    }
+  }
+
+  record.archetype = target;
+  record.chunk = chunk;
+  record.row = row;
+
+  RemoveRow(source, source_chunk, source_row);
+}
+
+void World::RemoveRow(Archetype* archetype, uint32_t chunk, uint32_t row) {
+  Entity moved = archetype->Remove(chunk, row);
+  if (moved.index != UINT32_MAX) {
+    records_[moved.index].chunk = chunk;
+    records_[moved.index].row = row;
+  }
+}
+
+void World::CollectChunks(ComponentMask required, std::vector<std::pair<Archetype*, uint32_t>>* chunks) const {
+  chunks->clear();
+  for (Archetype* archetype : archetypes_) {
+    if ((archetype->mask() & required) != required) {
+      continue;
+    }
+    for (size_t chunk = 0; chunk < archetype->chunk_count(); chunk++) {
+      chunks->emplace_back(archetype, static_cast<uint32_t>(chunk));
+    }
+  }
+}
+
+void World::RunParallel(ThreadPool* pool, size_t count, const std::function<void(size_t, size_t)>& func) {
+  if (pool == nullptr) {
+    func(0, count);
+  } else {
+    pool->ParallelFor(count, 1, func);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CommandBuffer
+
+void CommandBuffer::DestroyEntity(Entity entity) {
+  Command command;
+  command.type = CommandType::kDestroy;
+  command.entity = entity;
+  commands_.push_back(command);
+}
+
+void CommandBuffer::PushComponent(ComponentTypeId type, const void* data, size_t size) {
+  size_t offset = data_.size();
+  data_.resize(offset + sizeof(ComponentTypeId) + size);
+  std::memcpy(data_.data() + offset, &type, sizeof(ComponentTypeId));
+  std::memcpy(data_.data() + offset + sizeof(ComponentTypeId), data, size);
+}
+
+void CommandBuffer::Playback(World* world) {
+  for (const Command& command : commands_) {
+    switch (command.type) {
+      case CommandType::kCreate: {
+        Entity entity = world->CreateEntity(command.mask);
+        const uint8_t* data = data_.data() + command.data_offset;
+        size_t count = std::bitset<64>(command.mask).count();
+        for (size_t i = 0; i < count; i++) {
+          ComponentTypeId type = 0;
+          std::memcpy(&type, data, sizeof(ComponentTypeId));
+          data += sizeof(ComponentTypeId);
+          world->SetComponentRaw(entity, type, data);
+          data += GetComponentInfo(type).size;
+        }
+        break;
+      }
+      case CommandType::kDestroy:
+        world->DestroyEntity(command.entity);
+        break;
+      case CommandType::kAdd:
+        world->AddComponentRaw(command.entity, command.component,
+                               data_.data() + command.data_offset + sizeof(ComponentTypeId));
+        break;
+      case CommandType::kRemove:
+        world->RemoveComponentRaw(command.entity, command.component);
+        break;
+    }
+  }
+
+  Clear();
+}
+
+void CommandBuffer::Clear() {
+  commands_.clear();
+  data_.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SystemScheduler
+
+void SystemScheduler::AddSystem(const std::string& name, ComponentMask reads, ComponentMask writes,
+                                SystemFunc func) {
+  System system;
+  system.name = name;
+  system.reads = reads;
+  system.writes = writes;
+  system.func = std::move(func);
+  systems_.push_back(std::move(system));
+  phases_dirty_ = true;
+}
+
+const std::vector<std::vector<size_t>>& SystemScheduler::phases() {
+  if (phases_dirty_) {
+    BuildPhases();
+  }
+  return phases_;
+}
+
+void SystemScheduler::BuildPhases() {
+  // 每个系统放在和它冲突的前序系统之后的第一个阶段，保持注册顺序的语义
+  std::vector<size_t> system_phase(systems_.size(), 0);
+  phases_.clear();
+  for (size_t i = 0; i < systems_.size(); i++) {
+    const System& system = systems_[i];
+    for (size_t j = 0; j < i; j++) {
+      const System& other = systems_[j];
+      bool conflict = (system.writes & (other.reads | other.writes)) != 0 || (system.reads & other.writes) != 0;
+      if (conflict) {
+        system_phase[i] = std::max(system_phase[i], system_phase[j] + 1);
+      }
+    }
+
+    if (system_phase[i] >= phases_.size()) {
+      phases_.resize(system_phase[i] + 1);
+    }
+    phases_[system_phase[i]].push_back(i);
+  }
+
+  phases_dirty_ = false;
+}
+
+void SystemScheduler::Run(World* world, ThreadPool* pool) {
+  if (phases_dirty_) {
+    BuildPhases();
+  }
+
+  for (const auto& phase : phases_) {
+    if (pool == nullptr || phase.size() == 1) {
+      for (size_t index : phase) {
+        systems_[index].func(*world, systems_[index].commands);
+      }
+      continue;
+    }
+
+    pool->ParallelFor(phase.size(), 1, [this, world, &phase](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        System& system = systems_[phase[i]];
+        system.func(*world, system.commands);
+      }
+    });
+  }
+
+  for (System& system : systems_) {
+    system.commands.Playback(world);
+  }
+}
+
+}  // namespace ecs
+}  // namespace utils
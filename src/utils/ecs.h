@@ -0,0 +1,376 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+class ThreadPool;
+
+// 基于archetype的ECS：组件组合相同的实体放在同一个archetype里，
+// 每个archetype按16KB的chunk分配内存，chunk内每种组件各自连续存放（SoA）。
+namespace ecs {
+
+constexpr size_t kChunkSize = 16 * 1024;
+constexpr uint32_t kMaxComponentTypes = 64;
+
+using ComponentTypeId = uint32_t;
+using ComponentMask = uint64_t;
+
+struct Entity {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool operator==(const Entity& other) const {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator!=(const Entity& other) const {
+    return !(*this == other);
+  }
+};
+
+struct ComponentInfo {
+  size_t size = 0;
+  size_t alignment = 0;
+  const char* name = "";
+};
+
+ComponentTypeId RegisterComponentType(size_t size, size_t alignment, const char* name);
+const ComponentInfo& GetComponentInfo(ComponentTypeId type);
+
+// 组件必须是可以直接memcpy的POD类型，chunk之间搬移时不调用构造和析构函数。
+// const T和T是同一种组件，const只用来表示只读访问。
+template <typename T>
+ComponentTypeId ComponentTypeOf() {
+  if constexpr (!std::is_same<T, std::remove_cv_t<T>>::value) {
+    return ComponentTypeOf<std::remove_cv_t<T>>();
+  } else {
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                  "ECS components must be trivially copyable and destructible");
+    static const ComponentTypeId type = RegisterComponentType(sizeof(T), alignof(T), typeid(T).name());
+    return type;
+  }
+}
+
+template <typename... Ts>
+ComponentMask MaskOf() {
+  return (ComponentMask(0) | ... | (ComponentMask(1) << ComponentTypeOf<Ts>()));
+}
+
+class Archetype {
+public:
+  explicit Archetype(ComponentMask mask);
+
+  ComponentMask mask() const {
+    return mask_;
+  }
+
+  uint32_t chunk_capacity() const {
+    return capacity_;
+  }
+
+  size_t chunk_count() const {
+    return counts_.size();
+  }
+
+  uint32_t chunk_entity_count(size_t chunk) const {
+    return counts_[chunk];
+  }
+
+  size_t entity_count() const;
+
+  Entity* entities(size_t chunk) {
+    return reinterpret_cast<Entity*>(chunks_[chunk]->data);
+  }
+
+  // 该archetype不包含这种组件时返回nullptr。
+  void* component_array(size_t chunk, ComponentTypeId type) {
+    uint32_t offset = offsets_[type];
+    return offset == UINT32_MAX ? nullptr : chunks_[chunk]->data + offset;
+  }
+
+  template <typename T>
+  T* components(size_t chunk) {
+    return static_cast<T*>(component_array(chunk, ComponentTypeOf<T>()));
+  }
+
+private:
+  friend class World;
+
+  struct alignas(64) Chunk {
+    uint8_t data[kChunkSize];
+  };
+
+  void* ComponentAt(ComponentTypeId type, uint32_t chunk, uint32_t row) {
+    return chunks_[chunk]->data + offsets_[type] + row * sizes_[type];
+  }
+
+  // 在末尾追加一行，返回所在的chunk和行号。
+  void Allocate(Entity entity, uint32_t* chunk, uint32_t* row);
+
+  // 用最后一行填补被删除的行，返回被移动的实体（没有移动时返回无效实体）。
+  Entity Remove(uint32_t chunk, uint32_t row);
+
+private:
+  ComponentMask mask_ = 0;
+  uint32_t capacity_ = 0;
+  std::vector<ComponentTypeId> types_;
+  uint32_t offsets_[kMaxComponentTypes];
+  uint32_t sizes_[kMaxComponentTypes];
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  std::vector<uint32_t> counts_;
+  std::unique_ptr<Chunk> spare_chunk_;
+
+  std::unordered_map<ComponentTypeId, Archetype*> add_edges_;
+  std::unordered_map<ComponentTypeId, Archetype*> remove_edges_;
+};
+
+class World {
+public:
+  World();
+  ~World();
+
+  World(const World&) = delete;
+  World& operator=(const World&) = delete;
+
+  // 创建一个实体，组件内容清零。
+  Entity CreateEntity(ComponentMask mask);
+
+  template <typename... Ts>
+  Entity CreateEntity(const Ts&... components) {
+    Archetype* archetype = GetArchetype(MaskOf<Ts...>());
+    Entity entity = AllocateEntity(archetype);
+    const EntityRecord& record = records_[entity.index];
+    (std::memcpy(archetype->ComponentAt(ComponentTypeOf<Ts>(), record.chunk, record.row), &components, sizeof(Ts)),
+     ...);
+    return entity;
+  }
+
+  void DestroyEntity(Entity entity);
+  bool IsAlive(Entity entity) const;
+
+  void AddComponentRaw(Entity entity, ComponentTypeId type, const void* data);
+  void RemoveComponentRaw(Entity entity, ComponentTypeId type);
+  void SetComponentRaw(Entity entity, ComponentTypeId type, const void* data);
+  void* GetComponentRaw(Entity entity, ComponentTypeId type);
+
+  template <typename T>
+  void AddComponent(Entity entity, const T& component) {
+    AddComponentRaw(entity, ComponentTypeOf<T>(), &component);
+  }
+
+  template <typename T>
+  void RemoveComponent(Entity entity) {
+    RemoveComponentRaw(entity, ComponentTypeOf<T>());
+  }
+
+  template <typename T>
+  T* GetComponent(Entity entity) {
+    return static_cast<T*>(GetComponentRaw(entity, ComponentTypeOf<T>()));
+  }
+
+  template <typename T>
+  bool HasComponent(Entity entity) const {
+    return IsAlive(entity) && (records_[entity.index].archetype->mask() & MaskOf<T>()) != 0;
+  }
+
+  size_t entity_count() const {
+    return records_.size() - free_indices_.size();
+  }
+
+  const std::vector<Archetype*>& archetypes() const {
+    return archetypes_;
+  }
+
+  // func(uint32_t count, const Entity* entities, Ts* components...)，每个chunk调用一次，
+  // 组件数组是连续的，适合写SIMD循环。const组件表示只读。
+  template <typename... Ts, typename Func>
+  void ForEachChunk(Func&& func) {
+    ComponentMask required = MaskOf<Ts...>();
+    for (Archetype* archetype : archetypes_) {
+      if ((archetype->mask() & required) != required) {
+        continue;
+      }
+      for (size_t chunk = 0; chunk < archetype->chunk_count(); chunk++) {
+        func(archetype->chunk_entity_count(chunk), archetype->entities(chunk),
+             archetype->components<Ts>(chunk)...);
+      }
+    }
+  }
+
+  // func(Ts&... components)，每个实体调用一次。
+  template <typename... Ts, typename Func>
+  void ForEach(Func&& func) {
+    ForEachChunk<Ts...>([&func](uint32_t count, const Entity*, Ts*... arrays) {
+      for (uint32_t i = 0; i < count; i++) {
+        func(arrays[i]...);
+      }
+    });
+  }
+
+  // 以chunk为单位分发到线程池。
+  template <typename... Ts, typename Func>
+  void ParallelForEach(ThreadPool* pool, Func&& func);
+
+private:
+  struct EntityRecord {
+    Archetype* archetype = nullptr;
+    uint32_t chunk = 0;
+    uint32_t row = 0;
+    uint32_t generation = 0;
+  };
+
+  Archetype* GetArchetype(ComponentMask mask);
+  Entity AllocateEntity(Archetype* archetype);
+  void MoveEntity(Entity entity, Archetype* target);
+  void RemoveRow(Archetype* archetype, uint32_t chunk, uint32_t row);
+
+  void CollectChunks(ComponentMask required, std::vector<std::pair<Archetype*, uint32_t>>* chunks) const;
+  static void RunParallel(ThreadPool* pool, size_t count, const std::function<void(size_t, size_t)>& func);
+
+private:
+  std::vector<EntityRecord> records_;
+  std::vector<uint32_t> free_indices_;
+
+  std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetype_map_;
+  std::vector<Archetype*> archetypes_;
+};
+
+template <typename... Ts, typename Func>
+void World::ParallelForEach(ThreadPool* pool, Func&& func) {
+  std::vector<std::pair<Archetype*, uint32_t>> chunks;
+  CollectChunks(MaskOf<Ts...>(), &chunks);
+  RunParallel(pool, chunks.size(), [&chunks, &func](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      Archetype* archetype = chunks[i].first;
+      uint32_t chunk = chunks[i].second;
+      uint32_t count = archetype->chunk_entity_count(chunk);
+      auto arrays = std::make_tuple(archetype->components<Ts>(chunk)...);
+      for (uint32_t row = 0; row < count; row++) {
+        std::apply([&func, row](Ts*... a) { func(a[row]...); }, arrays);
+      }
+    }
+  });
+}
+
+// 记录结构性修改（创建、销毁、增删组件），在安全的时机统一回放到World。
+// 每个线程或系统使用自己的CommandBuffer，不需要加锁。
+class CommandBuffer {
+public:
+  template <typename... Ts>
+  void CreateEntity(const Ts&... components) {
+    Command command;
+    command.type = CommandType::kCreate;
+    command.mask = MaskOf<Ts...>();
+    command.data_offset = static_cast<uint32_t>(data_.size());
+    (PushComponent(ComponentTypeOf<Ts>(), &components, sizeof(Ts)), ...);
+    commands_.push_back(command);
+  }
+
+  void DestroyEntity(Entity entity);
+
+  template <typename T>
+  void AddComponent(Entity entity, const T& component) {
+    Command command;
+    command.type = CommandType::kAdd;
+    command.entity = entity;
+    command.component = ComponentTypeOf<T>();
+    command.data_offset = static_cast<uint32_t>(data_.size());
+    PushComponent(ComponentTypeOf<T>(), &component, sizeof(T));
+    commands_.push_back(command);
+  }
+
+  template <typename T>
+  void RemoveComponent(Entity entity) {
+    Command command;
+    command.type = CommandType::kRemove;
+    command.entity = entity;
+    command.component = ComponentTypeOf<T>();
+    commands_.push_back(command);
+  }
+
+  // 按记录顺序执行并清空。已经销毁的实体上的命令会被忽略。
+  void Playback(World* world);
+
+  void Clear();
+
+  bool empty() const {
+    return commands_.empty();
+  }
+
+  size_t size() const {
+    return commands_.size();
+  }
+
+private:
+  enum class CommandType : uint8_t {
+    kCreate,
+    kDestroy,
+    kAdd,
+    kRemove
+  };
+
+  struct Command {
+    CommandType type = CommandType::kCreate;
+    Entity entity;
+    ComponentMask mask = 0;
+    ComponentTypeId component = 0;
+    uint32_t data_offset = 0;
+  };
+
+  // 数据格式：类型id + 组件字节，回放时用memcpy读出，不要求对齐
+  void PushComponent(ComponentTypeId type, const void* data, size_t size);
+
+private:
+  std::vector<Command> commands_;
+  std::vector<uint8_t> data_;
+};
+
+// 系统声明读写的组件集合，调度器据此把互不冲突的系统放到同一阶段并行执行。
+// 系统内部只能通过自己的CommandBuffer做结构性修改，所有阶段结束后按系统注册顺序回放。
+// 系统本身在线程池上运行，内部可以对同一个线程池再调用ParallelForEach，等待时当前线程会执行其它任务。
+class SystemScheduler {
+public:
+  using SystemFunc = std::function<void(World& world, CommandBuffer& commands)>;
+
+  void AddSystem(const std::string& name, ComponentMask reads, ComponentMask writes, SystemFunc func);
+
+  void Run(World* world, ThreadPool* pool = nullptr);
+
+  // 每个阶段包含的系统下标
+  const std::vector<std::vector<size_t>>& phases();
+
+  const std::string& system_name(size_t system) const {
+    return systems_[system].name;
+  }
+
+private:
+  struct System {
+    std::string name;
+    ComponentMask reads = 0;
+    ComponentMask writes = 0;
+    SystemFunc func;
+    CommandBuffer commands;
+  };
+
+  void BuildPhases();
+
+private:
+  std::vector<System> systems_;
+  std::vector<std::vector<size_t>> phases_;
+  bool phases_dirty_ = true;
+};
+
+}  // namespace ecs
+
+}  // namespace utils
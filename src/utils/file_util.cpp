@@ -18,4 +18,23 @@ std::string ReadFile(const std::string& file_path) {
   return ss.str();
 }
 
+void WriteJsonString(FILE* file, const char* text) {
+  fputc('"', file);
+  for (const char* c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+      fputc(*c, file);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      fprintf(file, "\\u%04x", *c);
+    } else {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+void WriteJsonString(FILE* file, const std::string& text) {
+  WriteJsonString(file, text.c_str());
+}
+
 }  // namespace utils
\ No newline at end of file
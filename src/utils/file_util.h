@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdio>
 #include <string>
 #include <fstream>
 
@@ -7,4 +8,8 @@ namespace utils {
 
 std::string ReadFile(const std::string& file_path);
 
+// 把text写成带引号的JSON字符串，转义引号、反斜杠和控制字符
+void WriteJsonString(FILE* file, const char* text);
+void WriteJsonString(FILE* file, const std::string& text);
+
 }  // namespace utils
@@ -19,9 +19,68 @@ void FpsCamera::UpdateVectors() {
   front_ = glm::normalize(front);
   right_ = glm::normalize(glm::cross(front_, world_up_));
   up_ = glm::normalize(glm::cross(right_, front_));
+  view_dirty_ = true;
 }
-glm::mat4 FpsCamera::GetViewMatrix() {
-  return glm::lookAt(position_, position_ + front_, up_);
+
+void FpsCamera::SetPose(const glm::vec3& position, float yaw, float pitch, float zoom) {
+  position_ = position;
+  yaw_ = yaw;
+  pitch_ = pitch;
+  zoom_ = zoom;
+  projection_dirty_ = true;
+  UpdateVectors();
+}
+
+void FpsCamera::SetPerspective(float aspect, float near_plane, float far_plane) {
+  aspect_ = aspect;
+  near_plane_ = near_plane;
+  far_plane_ = far_plane;
+  projection_dirty_ = true;
+}
+
+void FpsCamera::SetAspect(float aspect) {
+  if (aspect != aspect_) {
+    aspect_ = aspect;
+    projection_dirty_ = true;
+  }
+}
+
+void FpsCamera::UpdateMatrices() {
+  if (!view_dirty_ && !projection_dirty_) {
+    return;
+  }
+
+  if (view_dirty_) {
+    view_ = glm::lookAt(position_, position_ + front_, up_);
+  }
+  if (projection_dirty_) {
+    projection_ = glm::perspective(glm::radians(zoom_), aspect_, near_plane_, far_plane_);
+  }
+
+  view_projection_ = projection_ * view_;
+  frustum_ = Frustum::FromMatrix(view_projection_);
+  view_dirty_ = false;
+  projection_dirty_ = false;
+}
+
+const glm::mat4& FpsCamera::GetViewMatrix() {
+  UpdateMatrices();
+  return view_;
+}
+
+const glm::mat4& FpsCamera::GetProjectionMatrix() {
+  UpdateMatrices();
+  return projection_;
+}
+
+const glm::mat4& FpsCamera::GetViewProjectionMatrix() {
+  UpdateMatrices();
+  return view_projection_;
+}
+
+const Frustum& FpsCamera::GetFrustum() {
+  UpdateMatrices();
+  return frustum_;
 }
 
 void FpsCamera::ProcessMouseScroll(float y_offset) {
@@ -33,6 +92,8 @@ void FpsCamera::ProcessMouseScroll(float y_offset) {
   if (zoom_ > 45.0f) {
     zoom_ = 45.0f;
   }
+
+  projection_dirty_ = true;
 }
 
 void FpsCamera::ProcessKeyboard(FpsCamera::Movement direction, float delta_time) {
@@ -47,6 +108,8 @@ void FpsCamera::ProcessKeyboard(FpsCamera::Movement direction, float delta_time)
   } else if (direction == Movement::RIGHT) {
     position_ += right_ * velocity;
   }
+
+  view_dirty_ = true;
 }
 
 void FpsCamera::ProcessMouseMovement(float x_offset, float y_offset, bool constrain_pitch) {
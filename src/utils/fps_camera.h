@@ -2,6 +2,7 @@
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "utils/bounds.h"
 
 namespace utils {
 
@@ -23,7 +24,48 @@ public:
     return zoom_;
   }
 
-  glm::mat4 GetViewMatrix();
+  const glm::vec3& position() const {
+    return position_;
+  }
+
+  const glm::vec3& front() const {
+    return front_;
+  }
+
+  float yaw() const {
+    return yaw_;
+  }
+
+  float pitch() const {
+    return pitch_;
+  }
+
+  // 直接设置相机状态，用于回放录制的镜头
+  void SetPose(const glm::vec3& position, float yaw, float pitch, float zoom);
+
+  // 投影参数，zoom作为垂直视角（角度）
+  void SetPerspective(float aspect, float near_plane, float far_plane);
+  void SetAspect(float aspect);
+
+  float aspect() const {
+    return aspect_;
+  }
+
+  float near_plane() const {
+    return near_plane_;
+  }
+
+  float far_plane() const {
+    return far_plane_;
+  }
+
+  // 矩阵和视锥体在相机参数变化后才重新计算
+  const glm::mat4& GetViewMatrix();
+  const glm::mat4& GetProjectionMatrix();
+  const glm::mat4& GetViewProjectionMatrix();
+
+  // 世界空间的六个裁剪平面
+  const Frustum& GetFrustum();
 
   void ProcessMouseScroll(float yoffset);
 
@@ -33,6 +75,7 @@ public:
 
 private:
   void UpdateVectors();
+  void UpdateMatrices();
 
 private:
   glm::vec3 position_;
@@ -48,6 +91,17 @@ private:
 
   float movement_speed_ = 2.5f;
   float mouse_sensitivity = 0.1f;
+
+  float aspect_ = 800.0f / 600.0f;
+  float near_plane_ = 0.1f;
+  float far_plane_ = 100.0f;
+
+  bool view_dirty_ = true;
+  bool projection_dirty_ = true;
+  glm::mat4 view_ = glm::mat4(1.0f);
+  glm::mat4 projection_ = glm::mat4(1.0f);
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  Frustum frustum_;
 };
 
 }  // namespace utils
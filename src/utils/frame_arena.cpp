@@ -0,0 +1,127 @@
+#include "utils/frame_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace utils {
+
+namespace {
+
+std::mutex& RegistryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<FrameArena*>& Registry() {
+  static std::vector<FrameArena*> arenas;
+  return arenas;
+}
+
+// 线程的分配器在创建时登记，ResetThreadArenas遍历登记表
+struct ThreadArena {
+  FrameArena arena;
+
+  ThreadArena() {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry().push_back(&arena);
+  }
+
+  ~ThreadArena() {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    std::vector<FrameArena*>& arenas = Registry();
+    arenas.erase(std::find(arenas.begin(), arenas.end(), &arena));
+  }
+};
+
+uint8_t* AlignUp(uint8_t* p, size_t alignment) {
+  auto address = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<uint8_t*>((address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t block_size, bool poison) : block_size_(std::max<size_t>(block_size, 64)),
+                                                         poison_(poison) {}
+
+FrameArena::~FrameArena() {
+  for (Block& block : blocks_) {
+    delete[] block.data;
+  }
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+  if (current_ < blocks_.size()) {
+    Block& block = blocks_[current_];
+    uint8_t* p = AlignUp(block.data + offset_, alignment);
+    size_t end = static_cast<size_t>(p - block.data) + size;
+    if (end <= block.size) {
+      used_ += end - offset_;
+      offset_ = end;
+      high_water_mark_ = std::max(high_water_mark_, used_);
+      return p;
+    }
+  }
+  return AllocateSlow(size, alignment);
+}
+
+void* FrameArena::AllocateSlow(size_t size, size_t alignment) {
+  // 帧内只会在最后一个块上分配，它剩下的空间不再使用，计入used
+  if (!blocks_.empty()) {
+    used_ += blocks_.back().size - offset_;
+    offset_ = 0;
+  }
+  AddBlock(std::max(block_size_, size + alignment));
+  current_ = blocks_.size() - 1;
+  return Allocate(size, alignment);
+}
+
+void FrameArena::AddBlock(size_t size) {
+  Block block;
+  block.data = new uint8_t[size];
+  block.size = size;
+  blocks_.push_back(block);
+  block_allocations_++;
+}
+
+void FrameArena::Reset() {
+  if (poison_) {
+    for (size_t i = 0; i < blocks_.size() && i <= current_; i++) {
+      size_t size = i == current_ ? offset_ : blocks_[i].size;
+      memset(blocks_[i].data, kPoisonByte, size);
+    }
+  }
+  if (blocks_.size() > 1) {
+    size_t total = capacity();
+    for (Block& block : blocks_) {
+      delete[] block.data;
+    }
+    blocks_.clear();
+    AddBlock(total);
+  }
+  current_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+size_t FrameArena::capacity() const {
+  size_t total = 0;
+  for (const Block& block : blocks_) {
+    total += block.size;
+  }
+  return total;
+}
+
+FrameArena& FrameArena::ForThread() {
+  thread_local ThreadArena thread_arena;
+  return thread_arena.arena;
+}
+
+void FrameArena::ResetThreadArenas() {
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  for (FrameArena* arena : Registry()) {
+    arena->Reset();
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+// 按帧重置的线性分配器：Allocate只移动指针，单个对象不释放，Reset时整体回收，对象的析构函数不会被调用。
+// 当前块用完时分配新块；Reset时如果这一帧用到了多个块，把它们合并成一个，之后同样大小的帧不再分配。
+// 不是线程安全的，每个线程用自己的分配器（ForThread）。
+class FrameArena {
+public:
+  static constexpr size_t kDefaultBlockSize = 256 * 1024;
+  // Reset时填充回收内存的值，读到0xdddddddd说明使用了上一帧的指针
+  static constexpr uint8_t kPoisonByte = 0xdd;
+#ifdef UTILS_ARENA_POISON
+  static constexpr bool kPoisonByDefault = true;
+#else
+  static constexpr bool kPoisonByDefault = false;
+#endif
+
+  explicit FrameArena(size_t block_size = kDefaultBlockSize, bool poison = kPoisonByDefault);
+  ~FrameArena();
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  template <typename T>
+  T* AllocateArray(size_t count) {
+    return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  // 回收这一帧的所有分配，之前返回的指针全部失效
+  void Reset();
+
+  // 这一帧用掉的字节数，包括对齐的填充和换块时浪费的尾部
+  size_t used() const {
+    return used_;
+  }
+
+  size_t capacity() const;
+
+  // 所有帧中used()的最大值
+  size_t high_water_mark() const {
+    return high_water_mark_;
+  }
+
+  // 向系统申请块的次数，稳定状态下不再增长
+  uint64_t block_allocations() const {
+    return block_allocations_;
+  }
+
+  // 当前线程的分配器，第一次调用时创建，线程退出时销毁
+  static FrameArena& ForThread();
+
+  // 重置所有线程的分配器。在帧结束、没有其它线程还在使用各自分配器时调用
+  static void ResetThreadArenas();
+
+private:
+  struct Block {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+  };
+
+  void* AllocateSlow(size_t size, size_t alignment);
+  void AddBlock(size_t size);
+
+private:
+  size_t block_size_;
+  bool poison_;
+  std::vector<Block> blocks_;
+  size_t current_ = 0;
+  size_t offset_ = 0;
+  size_t used_ = 0;
+  size_t high_water_mark_ = 0;
+  uint64_t block_allocations_ = 0;
+};
+
+// 从FrameArena分配的STL分配器，deallocate什么都不做。vector增长时旧的缓冲留在分配器中直到Reset，
+// 大小可以预估时先reserve。容器必须在分配器Reset之前销毁或不再使用。
+template <typename T>
+class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena* arena) noexcept : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    return arena_->AllocateArray<T>(count);
+  }
+
+  void deallocate(T*, size_t) noexcept {}
+
+  FrameArena* arena() const {
+    return arena_;
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  FrameArena* arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace utils
@@ -0,0 +1,372 @@
+#include "utils/frame_capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+#include "utils/gl_context.h"
+
+namespace utils {
+
+namespace {
+
+double NowMs() {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+}
+
+// block为false时只查询一次，未完成返回GL_TIMEOUT_EXPIRED
+GLenum WaitFence(GLsync fence, bool block) {
+  GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  while (block && result == GL_TIMEOUT_EXPIRED) {
+    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  }
+  if (result == GL_WAIT_FAILED) {
+    SPDLOG_ERROR("glClientWaitSync failed on frame capture.");
+  }
+  return result;
+}
+
+// BT.601有限范围
+uint8_t RgbToY(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+uint8_t RgbToU(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+uint8_t RgbToV(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+}  // namespace
+
+FrameCapture::~FrameCapture() {
+  Release();
+}
+
+bool FrameCapture::Init(const FrameCaptureOptions& options) {
+  Release();
+  options_ = options;
+  options_.ring_size = std::max(options_.ring_size, 1);
+  options_.max_queued_frames = std::max(options_.max_queued_frames, 1);
+  if (options_.format == CaptureFormat::kPng) {
+    std::error_code error;
+    std::filesystem::create_directories(options_.path, error);
+    if (error) {
+      SPDLOG_ERROR("Failed to create capture directory: {}", options_.path);
+      return false;
+    }
+  } else {
+    y4m_file_ = fopen(options_.path.c_str(), "wb");
+    if (y4m_file_ == nullptr) {
+      SPDLOG_ERROR("Failed to open file: {}", options_.path);
+      return false;
+    }
+    y4m_width_ = 0;
+    y4m_height_ = 0;
+  }
+
+  slots_.resize(options_.ring_size);
+  for (Slot& slot : slots_) {
+    glGenBuffers(1, &slot.buffer);
+  }
+  next_ = 0;
+  poll_count_ = 0;
+  latency_ms_.clear();
+  latency_ms_.reserve(kLatencySamples);
+  latency_count_ = 0;
+  latency_frames_ = 0;
+  stats_ = FrameCaptureStats();
+  quit_ = false;
+  encoding_ = 0;
+  encoder_ = std::thread(&FrameCapture::EncoderLoop, this);
+  return true;
+}
+
+void FrameCapture::Release() {
+  if (slots_.empty()) {
+    return;
+  }
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  encoder_.join();
+
+  for (Slot& slot : slots_) {
+    glDeleteBuffers(1, &slot.buffer);
+  }
+  slots_.clear();
+  free_buffers_.clear();
+  if (y4m_file_ != nullptr) {
+    fclose(y4m_file_);
+    y4m_file_ = nullptr;
+  }
+}
+
+bool FrameCapture::Capture(GLuint framebuffer, int width, int height, uint64_t frame_index) {
+  Slot& slot = slots_[next_];
+  if (slot.fence != nullptr) {
+    // 最早的读回还没取出，不丢帧时等它完成
+    double start = NowMs();
+    GLenum result = WaitFence(slot.fence, !options_.drop_frames);
+    if (result == GL_TIMEOUT_EXPIRED) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.dropped_ring_full++;
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.stall_ms += NowMs() - start;
+    }
+    CollectSlot(&slot, !options_.drop_frames);
+  }
+
+  size_t bytes = static_cast<size_t>(width) * height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (slot.capacity < bytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+    slot.capacity = bytes;
+  }
+  GLint previous_read = 0;
+  GLint pack_alignment = 4;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+  glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_read));
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.frame_index = frame_index;
+  slot.width = width;
+  slot.height = height;
+  slot.issue_ms = NowMs();
+  slot.issue_poll = poll_count_;
+  next_ = (next_ + 1) % slots_.size();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.captured++;
+  return true;
+}
+
+void FrameCapture::Poll() {
+  poll_count_++;
+  // 从最早的读回开始按顺序取出，遇到没完成的就停下，保证编码顺序与帧顺序一致
+  for (size_t i = 0; i < slots_.size(); i++) {
+    Slot& slot = slots_[(next_ + i) % slots_.size()];
+    if (slot.fence == nullptr) {
+      continue;
+    }
+    if (WaitFence(slot.fence, false) == GL_TIMEOUT_EXPIRED) {
+      break;
+    }
+    CollectSlot(&slot, !options_.drop_frames);
+  }
+}
+
+void FrameCapture::Flush() {
+  for (size_t i = 0; i < slots_.size(); i++) {
+    Slot& slot = slots_[(next_ + i) % slots_.size()];
+    if (slot.fence != nullptr) {
+      WaitFence(slot.fence, true);
+      CollectSlot(&slot, true);
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return queue_.empty() && encoding_ == 0; });
+}
+
+void FrameCapture::CollectSlot(Slot* slot, bool block) {
+  glDeleteSync(slot->fence);
+  slot->fence = nullptr;
+  double latency_ms = NowMs() - slot->issue_ms;
+  if (latency_ms_.size() < kLatencySamples) {
+    latency_ms_.push_back(latency_ms);
+  } else {
+    latency_ms_[latency_count_ % kLatencySamples] = latency_ms;
+  }
+  latency_count_++;
+  latency_frames_ += poll_count_ - slot->issue_poll;
+
+  Frame frame;
+  frame.frame_index = slot->frame_index;
+  frame.width = slot->width;
+  frame.height = slot->height;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto has_space = [this] { return queue_.size() < static_cast<size_t>(options_.max_queued_frames); };
+    if (!has_space()) {
+      if (!block) {
+        stats_.dropped_queue_full++;
+        return;
+      }
+      double start = NowMs();
+      cv_.wait(lock, has_space);
+      stats_.stall_ms += NowMs() - start;
+    }
+    if (!free_buffers_.empty()) {
+      frame.rgba = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+  }
+
+  size_t bytes = static_cast<size_t>(frame.width) * frame.height * 4;
+  frame.rgba.resize(bytes);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT);
+  if (data == nullptr) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    SPDLOG_ERROR("Failed to map capture buffer for frame {}.", frame.frame_index);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.failed++;
+    return;
+  }
+  memcpy(frame.rgba.data(), data, bytes);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(frame));
+  }
+  cv_.notify_all();
+}
+
+void FrameCapture::EncoderLoop() {
+  while (true) {
+    Frame frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return quit_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      frame = std::move(queue_.front());
+      queue_.pop_front();
+      encoding_++;
+    }
+    // 唤醒等待队列空位的GL线程
+    cv_.notify_all();
+
+    double start = NowMs();
+    bool ok = Encode(frame);
+    double elapsed = NowMs() - start;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      encoding_--;
+      stats_.encode_ms += elapsed;
+      if (ok) {
+        stats_.encoded++;
+      } else {
+        stats_.failed++;
+      }
+      if (free_buffers_.size() < static_cast<size_t>(options_.max_queued_frames)) {
+        free_buffers_.push_back(std::move(frame.rgba));
+      }
+    }
+    cv_.notify_all();
+  }
+}
+
+bool FrameCapture::Encode(const Frame& frame) {
+  if (options_.format == CaptureFormat::kY4m) {
+    return WriteY4mFrame(frame);
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(frame.frame_index));
+  return WriteImagePng((std::filesystem::path(options_.path) / name).string(), frame.width, frame.height,
+                       frame.rgba.data());
+}
+
+bool FrameCapture::WriteY4mFrame(const Frame& frame) {
+  if (y4m_width_ == 0) {
+    y4m_width_ = frame.width;
+    y4m_height_ = frame.height;
+    fprintf(y4m_file_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", y4m_width_, y4m_height_, options_.fps);
+  } else if (frame.width != y4m_width_ || frame.height != y4m_height_) {
+    SPDLOG_ERROR("Frame {} is {}x{}, Y4M stream is {}x{}", frame.frame_index, frame.width, frame.height, y4m_width_,
+                 y4m_height_);
+    return false;
+  }
+
+  // Y4M自上而下，GL的第0行在底部
+  int width = frame.width;
+  int height = frame.height;
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  size_t luma_size = static_cast<size_t>(width) * height;
+  size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+  yuv_.resize(luma_size + chroma_size * 2);
+  uint8_t* y_plane = yuv_.data();
+  uint8_t* u_plane = y_plane + luma_size;
+  uint8_t* v_plane = u_plane + chroma_size;
+  auto pixel = [&](int x, int y) {
+    return frame.rgba.data() + (static_cast<size_t>(height - 1 - y) * width + x) * 4;
+  };
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const uint8_t* p = pixel(x, y);
+      y_plane[static_cast<size_t>(y) * width + x] = RgbToY(p[0], p[1], p[2]);
+    }
+  }
+  // 色度取2x2像素的平均，奇数尺寸的边上只有1列或1行
+  for (int cy = 0; cy < chroma_height; cy++) {
+    for (int cx = 0; cx < chroma_width; cx++) {
+      int sum[3] = { 0, 0, 0 };
+      int count = 0;
+      for (int y = cy * 2; y < std::min(cy * 2 + 2, height); y++) {
+        for (int x = cx * 2; x < std::min(cx * 2 + 2, width); x++) {
+          const uint8_t* p = pixel(x, y);
+          sum[0] += p[0];
+          sum[1] += p[1];
+          sum[2] += p[2];
+          count++;
+        }
+      }
+      int r = (sum[0] + count / 2) / count;
+      int g = (sum[1] + count / 2) / count;
+      int b = (sum[2] + count / 2) / count;
+      size_t index = static_cast<size_t>(cy) * chroma_width + cx;
+      u_plane[index] = RgbToU(r, g, b);
+      v_plane[index] = RgbToV(r, g, b);
+    }
+  }
+  if (fputs("FRAME\n", y4m_file_) < 0 || fwrite(yuv_.data(), 1, yuv_.size(), y4m_file_) != yuv_.size()) {
+    SPDLOG_ERROR("Failed to write Y4M frame {} to {}", frame.frame_index, options_.path);
+    return false;
+  }
+  return true;
+}
+
+FrameCaptureStats FrameCapture::stats() const {
+  FrameCaptureStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats = stats_;
+  }
+  stats.latency = Summarize(latency_ms_);
+  if (latency_count_ > 0) {
+    stats.avg_latency_frames = static_cast<double>(latency_frames_) / static_cast<double>(latency_count_);
+  }
+  return stats;
+}
+
+void FrameCapture::LogStats() const {
+  FrameCaptureStats stats = this->stats();
+  SPDLOG_INFO("Capture: {} captured, {} encoded, {} failed, dropped {} (ring full) + {} (encoder behind), "
+              "latency avg {:.2f} ms / {:.2f} frames, p95 {:.2f} ms, stall {:.1f} ms, encode {:.1f} ms",
+              stats.captured, stats.encoded, stats.failed, stats.dropped_ring_full, stats.dropped_queue_full,
+              stats.latency.avg_ms, stats.avg_latency_frames, stats.latency.p95_ms, stats.stall_ms, stats.encode_ms);
+}
+
+}  // namespace utils
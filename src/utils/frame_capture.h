@@ -0,0 +1,142 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glad/glad.h"
+#include "utils/frame_stats.h"
+
+namespace utils {
+
+enum class CaptureFormat {
+  // 每帧一个frame_NNNNNN.png
+  kPng,
+  // 所有帧写入一个YUV4MPEG2文件（C420jpeg，BT.601有限范围），尺寸以第一帧为准
+  kY4m,
+};
+
+struct FrameCaptureOptions {
+  CaptureFormat format = CaptureFormat::kPng;
+  // kPng为输出目录，kY4m为输出文件
+  std::string path;
+  // PBO环的大小：发出读回的帧最多在ring_size - 1帧之后取出
+  int ring_size = 3;
+  // 等待编码的帧数上限
+  int max_queued_frames = 8;
+  // 为true时PBO环或编码队列满了直接丢弃帧，否则等待（离线录制不丢帧）
+  bool drop_frames = false;
+  // 写入Y4M头的帧率
+  int fps = 60;
+};
+
+struct FrameCaptureStats {
+  uint64_t captured = 0;
+  uint64_t encoded = 0;
+  uint64_t failed = 0;
+  // PBO环中没有空闲的缓冲
+  uint64_t dropped_ring_full = 0;
+  // 编码线程跟不上
+  uint64_t dropped_queue_full = 0;
+  // 不丢帧时GL线程等待读回和编码队列的时间
+  double stall_ms = 0.0;
+  double encode_ms = 0.0;
+  // 从发出读回到映射出数据的时间（最近FrameCapture::kLatencySamples次）和平均帧数（全部读回）
+  PercentileSummary latency;
+  double avg_latency_frames = 0.0;
+};
+
+// 异步读回帧缓冲：glReadPixels写到PBO环中，几帧之后fence完成时再映射取出，GL线程不等待GPU。
+// 取出的帧交给编码线程写PNG或Y4M。Capture和Poll只能在GL线程调用，Release必须在GL上下文销毁前调用。
+class FrameCapture {
+public:
+  // 保留的延迟样本数，长时间录制时stats()的开销不随帧数增长
+  static constexpr size_t kLatencySamples = 1024;
+
+  FrameCapture() = default;
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  bool Init(const FrameCaptureOptions& options);
+
+  // 等待所有读回和编码完成，删除PBO并结束编码线程
+  void Release();
+
+  bool active() const {
+    return !slots_.empty();
+  }
+
+  // 读回framebuffer（0为默认帧缓冲的后缓冲）的颜色，返回false表示这一帧被丢弃
+  bool Capture(GLuint framebuffer, int width, int height, uint64_t frame_index);
+
+  // 把已经完成的读回交给编码线程，每帧调用一次
+  void Poll();
+
+  // 取出所有读回并等待编码线程写完
+  void Flush();
+
+  FrameCaptureStats stats() const;
+  void LogStats() const;
+
+private:
+  struct Slot {
+    GLuint buffer = 0;
+    size_t capacity = 0;
+    GLsync fence = nullptr;
+    uint64_t frame_index = 0;
+    int width = 0;
+    int height = 0;
+    double issue_ms = 0.0;
+    uint64_t issue_poll = 0;
+  };
+
+  struct Frame {
+    uint64_t frame_index = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+  };
+
+  // 映射已完成的读回交给编码线程，编码队列满时block为false则丢弃
+  void CollectSlot(Slot* slot, bool block);
+  void EncoderLoop();
+  bool Encode(const Frame& frame);
+  bool WriteY4mFrame(const Frame& frame);
+
+private:
+  FrameCaptureOptions options_;
+  std::vector<Slot> slots_;
+  // 下一次读回使用的槽，也是仍在等待的最早的槽
+  size_t next_ = 0;
+  uint64_t poll_count_ = 0;
+  // 延迟样本的环，写满后覆盖最早的
+  std::vector<double> latency_ms_;
+  uint64_t latency_count_ = 0;
+  uint64_t latency_frames_ = 0;
+
+  std::thread encoder_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Frame> queue_;
+  // 编码完的帧缓冲留给下一次读回复用
+  std::vector<std::vector<uint8_t>> free_buffers_;
+  // 编码线程正在处理的帧数
+  int encoding_ = 0;
+  bool quit_ = false;
+  FrameCaptureStats stats_;
+
+  FILE* y4m_file_ = nullptr;
+  int y4m_width_ = 0;
+  int y4m_height_ = 0;
+  std::vector<uint8_t> yuv_;
+};
+
+}  // namespace utils
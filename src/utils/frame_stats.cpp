@@ -0,0 +1,196 @@
+#include "utils/frame_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+#include "glad/glad.h"
+#include "spdlog/spdlog.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+namespace {
+
+constexpr const char* kFrameMarker = "Frame";
+
+struct Metric {
+  const char* name;
+  double PercentileSummary::*field;
+};
+
+const Metric kMetrics[] = {
+  { "p50", &PercentileSummary::p50_ms },
+  { "p95", &PercentileSummary::p95_ms },
+  { "p99", &PercentileSummary::p99_ms },
+};
+
+}  // namespace
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+PercentileSummary Summarize(std::vector<double> samples_ms) {
+  PercentileSummary summary;
+  if (samples_ms.empty()) {
+    return summary;
+  }
+  std::sort(samples_ms.begin(), samples_ms.end());
+  double sum = 0.0;
+  for (double ms : samples_ms) {
+    sum += ms;
+  }
+  summary.samples = static_cast<int>(samples_ms.size());
+  summary.avg_ms = sum / static_cast<double>(samples_ms.size());
+  summary.p50_ms = Percentile(samples_ms, 0.50);
+  summary.p95_ms = Percentile(samples_ms, 0.95);
+  summary.p99_ms = Percentile(samples_ms, 0.99);
+  summary.max_ms = samples_ms.back();
+  return summary;
+}
+
+void FrameTimeRecorder::BeginFrame() {
+  Profiler& profiler = Profiler::Instance();
+  profiler.BeginFrame();
+  CollectGpuFrames();
+  profiler.BeginGpu(kFrameMarker);
+}
+
+void FrameTimeRecorder::EndFrame() {
+  Profiler& profiler = Profiler::Instance();
+  profiler.EndGpu();
+  profiler.EndFrame();
+
+  const ProfileFrame& frame = profiler.cpu_frame();
+  if (frame.index >= static_cast<uint64_t>(warmup_frames_)) {
+    cpu_ms_.push_back(static_cast<double>(frame.end_ns - frame.start_ns) / 1e6);
+  }
+}
+
+void FrameTimeRecorder::CollectGpuFrames() {
+  const Profiler& profiler = Profiler::Instance();
+  for (size_t i = 0; i < profiler.resolved_gpu_frame_count(); i++) {
+    const ProfileFrame& frame = profiler.resolved_gpu_frame(i);
+    if (frame.index < static_cast<uint64_t>(warmup_frames_)) {
+      continue;
+    }
+    for (const ProfileEvent& event : frame.events) {
+      if (event.depth == 0 && event.name == kFrameMarker) {
+        gpu_ms_.push_back(static_cast<double>(event.end_ns - event.start_ns) / 1e6);
+      }
+    }
+  }
+}
+
+void FrameTimeRecorder::Flush() {
+  glFinish();
+  // 空的一帧只为了读回之前所有帧的查询结果
+  Profiler& profiler = Profiler::Instance();
+  profiler.BeginFrame();
+  CollectGpuFrames();
+  profiler.EndFrame();
+}
+
+FrameTimeSummary FrameTimeRecorder::Summary() const {
+  FrameTimeSummary summary;
+  summary.cpu = Summarize(cpu_ms_);
+  summary.gpu = Summarize(gpu_ms_);
+  return summary;
+}
+
+bool SaveBaseline(const std::string& path, const FrameTimeSummary& summary) {
+  std::ofstream ofs(path);
+  if (ofs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  const std::pair<const char*, const PercentileSummary*> groups[] = { { "cpu", &summary.cpu },
+                                                                      { "gpu", &summary.gpu } };
+  for (const auto& [group, values] : groups) {
+    if (values->samples == 0) {
+      continue;
+    }
+    for (const Metric& metric : kMetrics) {
+      ofs << group << "_" << metric.name << " " << values->*metric.field << "\n";
+    }
+  }
+  return !ofs.fail();
+}
+
+bool LoadBaseline(const std::string& path, FrameTimeSummary* summary) {
+  std::ifstream ifs(path);
+  if (ifs.fail()) {
+    SPDLOG_ERROR("Failed to open file: {}", path);
+    return false;
+  }
+  *summary = FrameTimeSummary();
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    std::string key;
+    double value = 0.0;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    if (!(iss >> key >> value) || key.size() < 5 || key[3] != '_') {
+      SPDLOG_ERROR("Invalid baseline line in {}: {}", path, line);
+      return false;
+    }
+    PercentileSummary* group = nullptr;
+    if (key.compare(0, 3, "cpu") == 0) {
+      group = &summary->cpu;
+    } else if (key.compare(0, 3, "gpu") == 0) {
+      group = &summary->gpu;
+    }
+    auto metric = std::find_if(std::begin(kMetrics), std::end(kMetrics),
+                               [&key](const Metric& m) { return key.compare(4, std::string::npos, m.name) == 0; });
+    if (group == nullptr || metric == std::end(kMetrics)) {
+      SPDLOG_ERROR("Unknown baseline metric in {}: {}", path, key);
+      return false;
+    }
+    group->*(metric->field) = value;
+    group->samples = 1;
+  }
+  return true;
+}
+
+bool CheckRegression(const FrameTimeSummary& current, const FrameTimeSummary& baseline, double threshold,
+                     double min_delta_ms, std::string* report) {
+  bool passed = true;
+  std::ostringstream oss;
+  const std::tuple<const char*, const PercentileSummary*, const PercentileSummary*> groups[] = {
+    { "cpu", &current.cpu, &baseline.cpu },
+    { "gpu", &current.gpu, &baseline.gpu },
+  };
+  for (const auto& [group, now, base] : groups) {
+    // 基线或本次没有这一组数据时跳过
+    if (now->samples == 0 || base->samples == 0) {
+      continue;
+    }
+    for (const Metric& metric : kMetrics) {
+      double value = now->*metric.field;
+      double reference = base->*metric.field;
+      double limit = std::max(reference * (1.0 + threshold), reference + min_delta_ms);
+      bool regressed = value > limit;
+      char line[160];
+      snprintf(line, sizeof(line), "%s_%s: %.3f ms (baseline %.3f ms, limit %.3f ms, %+.1f%%)%s\n", group,
+               metric.name, value, reference, limit, reference > 0.0 ? (value / reference - 1.0) * 100.0 : 0.0,
+               regressed ? "  REGRESSION" : "");
+      oss << line;
+      passed = passed && !regressed;
+    }
+  }
+  if (report != nullptr) {
+    *report = oss.str();
+  }
+  return passed;
+}
+
+}  // namespace utils
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// sorted须已升序排列且非空，p在[0, 1]，取最近的样本
+double Percentile(const std::vector<double>& sorted, double p);
+
+struct PercentileSummary {
+  int samples = 0;
+  double avg_ms = 0.0;
+  double p50_ms = 0.0;
+  double p95_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+};
+
+PercentileSummary Summarize(std::vector<double> samples_ms);
+
+struct FrameTimeSummary {
+  PercentileSummary cpu;
+  // 没有GPU计时（不支持时间戳查询）时samples为0
+  PercentileSummary gpu;
+};
+
+// 逐帧记录CPU和GPU时间：CPU为BeginFrame到EndFrame，GPU为这段区间内提交的GL命令的执行时间
+// （通过Profiler的时间戳查询，几帧之后才读回）。帧边界由它调用Profiler::BeginFrame/EndFrame，
+// 使用它时不要再调用PROFILE_BEGIN_FRAME/PROFILE_END_FRAME。
+class FrameTimeRecorder {
+public:
+  // 前warmup_frames帧（着色器编译、首次上传等）不计入
+  explicit FrameTimeRecorder(int warmup_frames = 5) : warmup_frames_(warmup_frames) {}
+
+  void BeginFrame();
+  void EndFrame();
+
+  // 等GPU完成并读回剩余的GPU时间
+  void Flush();
+
+  FrameTimeSummary Summary() const;
+
+  const std::vector<double>& cpu_ms() const {
+    return cpu_ms_;
+  }
+
+  const std::vector<double>& gpu_ms() const {
+    return gpu_ms_;
+  }
+
+private:
+  void CollectGpuFrames();
+
+private:
+  int warmup_frames_;
+  std::vector<double> cpu_ms_;
+  std::vector<double> gpu_ms_;
+};
+
+// 基线为文本文件，每行“指标名 毫秒数”，例如“cpu_p99 1.234”
+bool SaveBaseline(const std::string& path, const FrameTimeSummary& summary);
+bool LoadBaseline(const std::string& path, FrameTimeSummary* summary);
+
+// threshold为允许的相对增长（0.1即10%），增长不超过min_delta_ms的视为噪声。
+// 任一p50/p95/p99超出时返回false，report中为逐项对比
+bool CheckRegression(const FrameTimeSummary& current, const FrameTimeSummary& baseline, double threshold,
+                     double min_delta_ms, std::string* report);
+
+}  // namespace utils
@@ -0,0 +1,381 @@
+#include "utils/frustum_cull.h"
+
+#include <cmath>
+
+#include "utils/simd_dispatch.h"
+
+namespace utils {
+
+void SphereArrays::Resize(size_t count) {
+  x.resize(count);
+  y.resize(count);
+  z.resize(count);
+  radius.resize(count);
+}
+
+void SphereArrays::Set(size_t index, const Sphere& sphere) {
+  x[index] = sphere.center.x;
+  y[index] = sphere.center.y;
+  z[index] = sphere.center.z;
+  radius[index] = sphere.radius;
+}
+
+void AabbArrays::Resize(size_t count) {
+  center_x.resize(count);
+  center_y.resize(count);
+  center_z.resize(count);
+  extent_x.resize(count);
+  extent_y.resize(count);
+  extent_z.resize(count);
+}
+
+void AabbArrays::Set(size_t index, const Aabb& aabb) {
+  glm::vec3 center = aabb.center();
+  glm::vec3 extent = aabb.extent();
+  center_x[index] = center.x;
+  center_y[index] = center.y;
+  center_z[index] = center.z;
+  extent_x[index] = extent.x;
+  extent_y[index] = extent.y;
+  extent_z[index] = extent.z;
+}
+
+namespace {
+
+// 计算顺序与Frustum::Intersects相同，保证各实现的结果一致
+size_t CullSpheresScalar(const Frustum& frustum, const SphereArrays& spheres, size_t begin, size_t end,
+                         uint32_t* visible, size_t visible_count) {
+  for (size_t i = begin; i < end; i++) {
+    bool inside = true;
+    for (const glm::vec4& plane : frustum.planes) {
+      float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+      inside &= !(distance < -spheres.radius[i]);
+    }
+    visible[visible_count] = static_cast<uint32_t>(i);
+    visible_count += inside ? 1 : 0;
+  }
+  return visible_count;
+}
+
+size_t CullAabbsScalar(const Frustum& frustum, const AabbArrays& aabbs, size_t begin, size_t end, uint32_t* visible,
+                       size_t visible_count) {
+  for (size_t i = begin; i < end; i++) {
+    bool inside = true;
+    for (const glm::vec4& plane : frustum.planes) {
+      float distance =
+          plane.x * aabbs.center_x[i] + plane.y * aabbs.center_y[i] + plane.z * aabbs.center_z[i] + plane.w;
+      float radius = std::abs(plane.x) * aabbs.extent_x[i] + std::abs(plane.y) * aabbs.extent_y[i] +
+                     std::abs(plane.z) * aabbs.extent_z[i];
+      inside &= !(distance + radius < 0.0f);
+    }
+    visible[visible_count] = static_cast<uint32_t>(i);
+    visible_count += inside ? 1 : 0;
+  }
+  return visible_count;
+}
+
+#ifdef UTILS_SIMD_SSE
+
+// 每次4个物体，6个平面的结果相与后按位写出下标
+size_t CullSpheresSse(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible) {
+  size_t count = spheres.size();
+  size_t simd_end = count & ~size_t(3);
+  size_t visible_count = 0;
+
+  __m128 plane_x[Frustum::kPlaneCount];
+  __m128 plane_y[Frustum::kPlaneCount];
+  __m128 plane_z[Frustum::kPlaneCount];
+  __m128 plane_w[Frustum::kPlaneCount];
+  for (int p = 0; p < Frustum::kPlaneCount; p++) {
+    plane_x[p] = _mm_set1_ps(frustum.planes[p].x);
+    plane_y[p] = _mm_set1_ps(frustum.planes[p].y);
+    plane_z[p] = _mm_set1_ps(frustum.planes[p].z);
+    plane_w[p] = _mm_set1_ps(frustum.planes[p].w);
+  }
+
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 x = _mm_loadu_ps(&spheres.x[i]);
+    __m128 y = _mm_loadu_ps(&spheres.y[i]);
+    __m128 z = _mm_loadu_ps(&spheres.z[i]);
+    __m128 negative_radius = _mm_xor_ps(_mm_loadu_ps(&spheres.radius[i]), sign);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < Frustum::kPlaneCount; p++) {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)), _mm_mul_ps(plane_z[p], z)),
+          plane_w[p]);
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negative_radius));
+    }
+
+    uint32_t mask = static_cast<uint32_t>(~_mm_movemask_ps(outside)) & 0xf;
+    while (mask != 0) {
+      visible[visible_count++] = static_cast<uint32_t>(i + CountTrailingZeros(mask));
+      mask &= mask - 1;
+    }
+  }
+
+  return CullSpheresScalar(frustum, spheres, simd_end, count, visible, visible_count);
+}
+
+size_t CullAabbsSse(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible) {
+  size_t count = aabbs.size();
+  size_t simd_end = count & ~size_t(3);
+  size_t visible_count = 0;
+
+  __m128 plane_x[Frustum::kPlaneCount];
+  __m128 plane_y[Frustum::kPlaneCount];
+  __m128 plane_z[Frustum::kPlaneCount];
+  __m128 plane_w[Frustum::kPlaneCount];
+  __m128 abs_x[Frustum::kPlaneCount];
+  __m128 abs_y[Frustum::kPlaneCount];
+  __m128 abs_z[Frustum::kPlaneCount];
+  for (int p = 0; p < Frustum::kPlaneCount; p++) {
+    const glm::vec4& plane = frustum.planes[p];
+    plane_x[p] = _mm_set1_ps(plane.x);
+    plane_y[p] = _mm_set1_ps(plane.y);
+    plane_z[p] = _mm_set1_ps(plane.z);
+    plane_w[p] = _mm_set1_ps(plane.w);
+    abs_x[p] = _mm_set1_ps(std::abs(plane.x));
+    abs_y[p] = _mm_set1_ps(std::abs(plane.y));
+    abs_z[p] = _mm_set1_ps(std::abs(plane.z));
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 cx = _mm_loadu_ps(&aabbs.center_x[i]);
+    __m128 cy = _mm_loadu_ps(&aabbs.center_y[i]);
+    __m128 cz = _mm_loadu_ps(&aabbs.center_z[i]);
+    __m128 ex = _mm_loadu_ps(&aabbs.extent_x[i]);
+    __m128 ey = _mm_loadu_ps(&aabbs.extent_y[i]);
+    __m128 ez = _mm_loadu_ps(&aabbs.extent_z[i]);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < Frustum::kPlaneCount; p++) {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], cx), _mm_mul_ps(plane_y[p], cy)), _mm_mul_ps(plane_z[p], cz)),
+          plane_w[p]);
+      __m128 radius =
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_x[p], ex), _mm_mul_ps(abs_y[p], ey)), _mm_mul_ps(abs_z[p], ez));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+    }
+
+    uint32_t mask = static_cast<uint32_t>(~_mm_movemask_ps(outside)) & 0xf;
+    while (mask != 0) {
+      visible[visible_count++] = static_cast<uint32_t>(i + CountTrailingZeros(mask));
+      mask &= mask - 1;
+    }
+  }
+
+  return CullAabbsScalar(frustum, aabbs, simd_end, count, visible, visible_count);
+}
+
+#endif  // UTILS_SIMD_SSE
+
+#ifdef UTILS_SIMD_AVX2
+
+// 8位可见掩码到紧凑排列的置换表：第k个置位的下标放到第k个通道
+struct CompactTable {
+  alignas(32) uint32_t lanes[256][8];
+
+  CompactTable() {
+    for (uint32_t mask = 0; mask < 256; mask++) {
+      uint32_t n = 0;
+      for (uint32_t bit = 0; bit < 8; bit++) {
+        if (mask & (1u << bit)) {
+          lanes[mask][n++] = bit;
+        }
+      }
+      while (n < 8) {
+        lanes[mask][n++] = 0;
+      }
+    }
+  }
+};
+
+const CompactTable& GetCompactTable() {
+  static const CompactTable table;
+  return table;
+}
+
+// 每次8个物体。直接写出8个通道再按可见数量前移，
+// 写入位置不超过当前组的起始下标，所以不会越过visible的末尾
+UTILS_TARGET_AVX2 inline size_t StoreCompacted(uint32_t mask, size_t base, const CompactTable& table,
+                                               uint32_t* visible, size_t visible_count) {
+  __m256i indices =
+      _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(base)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes[mask]));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + visible_count),
+                      _mm256_permutevar8x32_epi32(indices, permutation));
+  return visible_count + _mm_popcnt_u32(mask);
+}
+
+UTILS_TARGET_AVX2 size_t CullSpheresAvx2(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible) {
+  size_t count = spheres.size();
+  size_t simd_end = count & ~size_t(7);
+  size_t visible_count = 0;
+  const CompactTable& table = GetCompactTable();
+
+  __m256 plane_x[Frustum::kPlaneCount];
+  __m256 plane_y[Frustum::kPlaneCount];
+  __m256 plane_z[Frustum::kPlaneCount];
+  __m256 plane_w[Frustum::kPlaneCount];
+  for (int p = 0; p < Frustum::kPlaneCount; p++) {
+    plane_x[p] = _mm256_set1_ps(frustum.planes[p].x);
+    plane_y[p] = _mm256_set1_ps(frustum.planes[p].y);
+    plane_z[p] = _mm256_set1_ps(frustum.planes[p].z);
+    plane_w[p] = _mm256_set1_ps(frustum.planes[p].w);
+  }
+
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+    __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+    __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+    __m256 negative_radius = _mm256_xor_ps(_mm256_loadu_ps(&spheres.radius[i]), sign);
+
+    // 不使用FMA，保持与标量实现相同的舍入
+    __m256 outside = _mm256_setzero_ps();
+    for (int p = 0; p < Frustum::kPlaneCount; p++) {
+      __m256 distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], x), _mm256_mul_ps(plane_y[p], y)),
+                        _mm256_mul_ps(plane_z[p], z)),
+          plane_w[p]);
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negative_radius, _CMP_LT_OQ));
+    }
+
+    uint32_t mask = static_cast<uint32_t>(~_mm256_movemask_ps(outside)) & 0xff;
+    visible_count = StoreCompacted(mask, i, table, visible, visible_count);
+  }
+
+  return CullSpheresScalar(frustum, spheres, simd_end, count, visible, visible_count);
+}
+
+UTILS_TARGET_AVX2 size_t CullAabbsAvx2(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible) {
+  size_t count = aabbs.size();
+  size_t simd_end = count & ~size_t(7);
+  size_t visible_count = 0;
+  const CompactTable& table = GetCompactTable();
+
+  __m256 plane_x[Frustum::kPlaneCount];
+  __m256 plane_y[Frustum::kPlaneCount];
+  __m256 plane_z[Frustum::kPlaneCount];
+  __m256 plane_w[Frustum::kPlaneCount];
+  __m256 abs_x[Frustum::kPlaneCount];
+  __m256 abs_y[Frustum::kPlaneCount];
+  __m256 abs_z[Frustum::kPlaneCount];
+  for (int p = 0; p < Frustum::kPlaneCount; p++) {
+    const glm::vec4& plane = frustum.planes[p];
+    plane_x[p] = _mm256_set1_ps(plane.x);
+    plane_y[p] = _mm256_set1_ps(plane.y);
+    plane_z[p] = _mm256_set1_ps(plane.z);
+    plane_w[p] = _mm256_set1_ps(plane.w);
+    abs_x[p] = _mm256_set1_ps(std::abs(plane.x));
+    abs_y[p] = _mm256_set1_ps(std::abs(plane.y));
+    abs_z[p] = _mm256_set1_ps(std::abs(plane.z));
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 cx = _mm256_loadu_ps(&aabbs.center_x[i]);
+    __m256 cy = _mm256_loadu_ps(&aabbs.center_y[i]);
+    __m256 cz = _mm256_loadu_ps(&aabbs.center_z[i]);
+    __m256 ex = _mm256_loadu_ps(&aabbs.extent_x[i]);
+    __m256 ey = _mm256_loadu_ps(&aabbs.extent_y[i]);
+    __m256 ez = _mm256_loadu_ps(&aabbs.extent_z[i]);
+
+    __m256 outside = _mm256_setzero_ps();
+    for (int p = 0; p < Frustum::kPlaneCount; p++) {
+      __m256 distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], cx), _mm256_mul_ps(plane_y[p], cy)),
+                        _mm256_mul_ps(plane_z[p], cz)),
+          plane_w[p]);
+      __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abs_x[p], ex), _mm256_mul_ps(abs_y[p], ey)),
+                                    _mm256_mul_ps(abs_z[p], ez));
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+    }
+
+    uint32_t mask = static_cast<uint32_t>(~_mm256_movemask_ps(outside)) & 0xff;
+    visible_count = StoreCompacted(mask, i, table, visible, visible_count);
+  }
+
+  return CullAabbsScalar(frustum, aabbs, simd_end, count, visible, visible_count);
+}
+
+#endif  // UTILS_SIMD_AVX2
+
+CullKernel Supported(CullKernel kernel) {
+#ifdef UTILS_SIMD_AVX2
+  if (kernel == CullKernel::kAvx2 && !HasAvx2()) {
+    kernel = CullKernel::kSse;
+  }
+#else
+  if (kernel == CullKernel::kAvx2) {
+    kernel = CullKernel::kSse;
+  }
+#endif
+#ifndef UTILS_SIMD_SSE
+  if (kernel == CullKernel::kSse) {
+    kernel = CullKernel::kScalar;
+  }
+#endif
+  return kernel;
+}
+
+}  // namespace
+
+CullKernel BestCullKernel() {
+  return Supported(CullKernel::kAvx2);
+}
+
+const char* CullKernelName(CullKernel kernel) {
+  switch (kernel) {
+    case CullKernel::kScalar:
+      return "scalar";
+    case CullKernel::kSse:
+      return "sse";
+    case CullKernel::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible) {
+  return CullSpheres(frustum, spheres, visible, BestCullKernel());
+}
+
+size_t CullAabbs(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible) {
+  return CullAabbs(frustum, aabbs, visible, BestCullKernel());
+}
+
+size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible, CullKernel kernel) {
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case CullKernel::kAvx2:
+      return CullSpheresAvx2(frustum, spheres, visible);
+#endif
+#ifdef UTILS_SIMD_SSE
+    case CullKernel::kSse:
+      return CullSpheresSse(frustum, spheres, visible);
+#endif
+    default:
+      return CullSpheresScalar(frustum, spheres, 0, spheres.size(), visible, 0);
+  }
+}
+
+size_t CullAabbs(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible, CullKernel kernel) {
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case CullKernel::kAvx2:
+      return CullAabbsAvx2(frustum, aabbs, visible);
+#endif
+#ifdef UTILS_SIMD_SSE
+    case CullKernel::kSse:
+      return CullAabbsSse(frustum, aabbs, visible);
+#endif
+    default:
+      return CullAabbsScalar(frustum, aabbs, 0, aabbs.size(), visible, 0);
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils/bounds.h"
+
+namespace utils {
+
+// SoA存储的包围球，便于一次测试多个物体
+struct SphereArrays {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> radius;
+
+  void Resize(size_t count);
+  void Set(size_t index, const Sphere& sphere);
+
+  size_t size() const {
+    return x.size();
+  }
+};
+
+// SoA存储的包围盒，以中心和半长表示
+struct AabbArrays {
+  std::vector<float> center_x;
+  std::vector<float> center_y;
+  std::vector<float> center_z;
+  std::vector<float> extent_x;
+  std::vector<float> extent_y;
+  std::vector<float> extent_z;
+
+  void Resize(size_t count);
+  void Set(size_t index, const Aabb& aabb);
+
+  size_t size() const {
+    return center_x.size();
+  }
+};
+
+enum class CullKernel {
+  kScalar,
+  kSse,
+  kAvx2,
+};
+
+// 当前CPU支持的最快实现
+CullKernel BestCullKernel();
+const char* CullKernelName(CullKernel kernel);
+
+// 可见物体的下标按升序紧凑写入visible（容量至少为物体数量），返回可见数量。
+// 判定规则与Frustum::Intersects一致，各实现结果完全相同
+size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible);
+size_t CullAabbs(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible);
+
+// 指定实现，用于测试和对比。CPU不支持时退回到可用的实现
+size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, uint32_t* visible, CullKernel kernel);
+size_t CullAabbs(const Frustum& frustum, const AabbArrays& aabbs, uint32_t* visible, CullKernel kernel);
+
+}  // namespace utils
@@ -0,0 +1,534 @@
+#include "utils/gl_context.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#ifdef UTILS_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "stb/stb_image_write.h"
+#include "spdlog/spdlog.h"
+#include "utils/allocation_counter.h"
+#include "utils/frame_arena.h"
+#include "utils/frame_stats.h"
+
+namespace utils {
+
+namespace {
+
+double NowSeconds() {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point start = Clock::now();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool ParseInt(const char* text, int* value) {
+  char* end = nullptr;
+  long result = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || result < 0) {
+    return false;
+  }
+  *value = static_cast<int>(result);
+  return true;
+}
+
+#ifdef UTILS_HAS_EGL
+
+bool HasExtension(const char* extensions, const char* name) {
+  if (extensions == nullptr) {
+    return false;
+  }
+  size_t length = strlen(name);
+  for (const char* p = strstr(extensions, name); p != nullptr; p = strstr(p + length, name)) {
+    if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 依次尝试Mesa surfaceless、第一个EGL设备和默认display，返回已初始化的display
+EGLDisplay OpenEglDisplay(bool* surfaceless) {
+  const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+  EGLint major = 0;
+  EGLint minor = 0;
+  if (get_platform_display != nullptr && HasExtension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) {
+      *surfaceless = true;
+      return display;
+    }
+  }
+
+  auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+  if (get_platform_display != nullptr && query_devices != nullptr &&
+      HasExtension(client_extensions, "EGL_EXT_platform_device")) {
+    EGLDeviceEXT device = nullptr;
+    EGLint device_count = 0;
+    if (query_devices(1, &device, &device_count) && device_count > 0) {
+      EGLDisplay display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+      if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) {
+        *surfaceless = true;
+        return display;
+      }
+    }
+  }
+
+  EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) {
+    *surfaceless = false;
+    return display;
+  }
+  return EGL_NO_DISPLAY;
+}
+
+#endif
+
+}  // namespace
+
+bool ParseContextOptions(int argc, char** argv, ContextOptions* options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--headless") == 0) {
+      options->mode = ContextMode::kHeadless;
+    } else if (strcmp(arg, "--no-vsync") == 0) {
+      options->vsync = false;
+    } else if (strcmp(arg, "--frames") == 0) {
+      if (value == nullptr || !ParseInt(value, &options->frame_count)) {
+        SPDLOG_ERROR("Invalid --frames value.");
+        return false;
+      }
+      i++;
+    } else if (strcmp(arg, "--size") == 0) {
+      int width = 0;
+      int height = 0;
+      if (value == nullptr || sscanf(value, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+        SPDLOG_ERROR("Invalid --size value, expected WxH.");
+        return false;
+      }
+      options->width = width;
+      options->height = height;
+      i++;
+    } else if (strcmp(arg, "--fixed-dt") == 0) {
+      char* end = nullptr;
+      options->fixed_delta = value != nullptr ? strtod(value, &end) : 0.0;
+      if (value == nullptr || end == value || options->fixed_delta < 0.0) {
+        SPDLOG_ERROR("Invalid --fixed-dt value.");
+        return false;
+      }
+      i++;
+    } else if (strcmp(arg, "--dump") == 0) {
+      if (value == nullptr) {
+        SPDLOG_ERROR("Missing --dump directory.");
+        return false;
+      }
+      options->dump_dir = value;
+      i++;
+    } else if (strcmp(arg, "--dump-y4m") == 0) {
+      if (value == nullptr) {
+        SPDLOG_ERROR("Missing --dump-y4m file.");
+        return false;
+      }
+      options->dump_y4m = value;
+      i++;
+    } else if (strcmp(arg, "--dump-drop") == 0) {
+      options->dump_drop_frames = true;
+    } else if (strcmp(arg, "--dump-every") == 0) {
+      if (value == nullptr || !ParseInt(value, &options->dump_interval) || options->dump_interval == 0) {
+        SPDLOG_ERROR("Invalid --dump-every value.");
+        return false;
+      }
+      i++;
+    } else if (strcmp(arg, "--metrics") == 0) {
+      if (value == nullptr) {
+        SPDLOG_ERROR("Missing --metrics file.");
+        return false;
+      }
+      options->metrics_path = value;
+      i++;
+    } else if (strcmp(arg, "--metrics-every") == 0) {
+      char* end = nullptr;
+      options->metrics_interval = value != nullptr ? strtod(value, &end) : 0.0;
+      if (value == nullptr || end == value || !(options->metrics_interval > 0.0)) {
+        SPDLOG_ERROR("Invalid --metrics-every value.");
+        return false;
+      }
+      i++;
+    }
+  }
+  if (!options->dump_dir.empty() && !options->dump_y4m.empty()) {
+    SPDLOG_ERROR("--dump and --dump-y4m cannot be used together.");
+    return false;
+  }
+  return true;
+}
+
+bool WriteImagePng(const std::string& path, int width, int height, const uint8_t* rgba) {
+  // GL的第一行在底部。stbi_flip_vertically_on_write是全局开关，编码线程同时调用会竞争，所以自己翻转一份
+  size_t row_bytes = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> flipped(row_bytes * static_cast<size_t>(height));
+  for (int y = 0; y < height; y++) {
+    const uint8_t* source = rgba + static_cast<size_t>(height - 1 - y) * row_bytes;
+    std::memcpy(flipped.data() + static_cast<size_t>(y) * row_bytes, source, row_bytes);
+  }
+  if (stbi_write_png(path.c_str(), width, height, 4, flipped.data(), static_cast<int>(row_bytes)) == 0) {
+    SPDLOG_ERROR("Failed to write image: {}", path);
+    return false;
+  }
+  return true;
+}
+
+GlContext::~GlContext() {
+  Release();
+}
+
+bool GlContext::Init(const ContextOptions& options) {
+  Release();
+  options_ = options;
+  width_ = options.width;
+  height_ = options.height;
+
+  bool result = options.mode == ContextMode::kHeadless ? InitHeadless() : InitWindow();
+  if (!result) {
+    Release();
+    return false;
+  }
+
+  if (!options_.dump_dir.empty() || !options_.dump_y4m.empty()) {
+    FrameCaptureOptions capture_options;
+    capture_options.format = options_.dump_dir.empty() ? CaptureFormat::kY4m : CaptureFormat::kPng;
+    capture_options.path = options_.dump_dir.empty() ? options_.dump_y4m : options_.dump_dir;
+    capture_options.drop_frames = options_.dump_drop_frames;
+    if (options_.fixed_delta > 0.0) {
+      capture_options.fps = std::max(static_cast<int>(std::lround(1.0 / options_.fixed_delta)), 1);
+    }
+    if (!capture_.Init(capture_options)) {
+      Release();
+      return false;
+    }
+  }
+
+  if (!options_.metrics_path.empty() && !metrics_exporter_.Init(options_.metrics_path, options_.metrics_interval)) {
+    Release();
+    return false;
+  }
+
+  SPDLOG_INFO("GL context: {} {} ({}x{}, {})", reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+              reinterpret_cast<const char*>(glGetString(GL_RENDERER)), width_, height_,
+              headless() ? "headless" : "window");
+  frame_index_ = 0;
+  frame_ms_.clear();
+  frame_ms_.reserve(kTimingSamples);
+  timed_frames_ = 0;
+  total_frame_ms_ = 0.0;
+  min_frame_ms_ = 0.0;
+  max_frame_ms_ = 0.0;
+  steady_allocations_ = 0;
+  max_frame_allocations_ = 0;
+  start_time_ = NowSeconds();
+  frame_start_ = start_time_;
+  return true;
+}
+
+bool GlContext::InitWindow() {
+  if (glfwInit() == GLFW_FALSE) {
+    SPDLOG_ERROR("Failed to init GLFW.");
+    return false;
+  }
+  glfw_initialized_ = true;
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options_.gl_major);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options_.gl_minor);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+  window_ = glfwCreateWindow(options_.width, options_.height, options_.title.c_str(), nullptr, nullptr);
+  if (window_ == nullptr) {
+    SPDLOG_ERROR("Failed to create window (OpenGL {}.{}).", options_.gl_major, options_.gl_minor);
+    return false;
+  }
+
+  glfwMakeContextCurrent(window_);
+  glfwSwapInterval(options_.vsync ? 1 : 0);
+  if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) == GL_FALSE) {
+    SPDLOG_ERROR("Failed to load GL.");
+    return false;
+  }
+  glfwGetFramebufferSize(window_, &width_, &height_);
+  return true;
+}
+
+bool GlContext::InitHeadless() {
+#ifdef UTILS_HAS_EGL
+  bool surfaceless = false;
+  EGLDisplay display = OpenEglDisplay(&surfaceless);
+  if (display == EGL_NO_DISPLAY) {
+    SPDLOG_ERROR("Failed to open an EGL display.");
+    return false;
+  }
+  egl_display_ = display;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    SPDLOG_ERROR("EGL does not support desktop OpenGL.");
+    return false;
+  }
+
+  // 没有surfaceless时用1x1的pbuffer，实际渲染都在FBO里
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  const EGLint config_attributes[] = {
+    EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE,
+  };
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+    if (!surfaceless) {
+      SPDLOG_ERROR("No EGL config with OpenGL and pbuffer support.");
+      return false;
+    }
+    config = nullptr;
+  }
+
+  const EGLint context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, options_.gl_major,
+    EGL_CONTEXT_MINOR_VERSION, options_.gl_minor,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE,
+  };
+  EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+  if (context == EGL_NO_CONTEXT) {
+    SPDLOG_ERROR("Failed to create EGL context (OpenGL {}.{}), error: {:#x}", options_.gl_major, options_.gl_minor,
+                 eglGetError());
+    return false;
+  }
+  egl_context_ = context;
+
+  EGLSurface surface = EGL_NO_SURFACE;
+  if (!surfaceless) {
+    const EGLint pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+    if (surface == EGL_NO_SURFACE) {
+      SPDLOG_ERROR("Failed to create EGL pbuffer.");
+      return false;
+    }
+    egl_surface_ = surface;
+  }
+
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    SPDLOG_ERROR("Failed to make EGL context current.");
+    return false;
+  }
+  if (gladLoadGLLoader((GLADloadproc)eglGetProcAddress) == GL_FALSE) {
+    SPDLOG_ERROR("Failed to load GL.");
+    return false;
+  }
+  return CreateFramebuffer();
+#else
+  SPDLOG_ERROR("Headless mode is not available, utils was built without EGL.");
+  return false;
+#endif
+}
+
+bool GlContext::CreateFramebuffer() {
+  glGenRenderbuffers(1, &color_buffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+
+  glGenRenderbuffers(1, &depth_buffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    SPDLOG_ERROR("Headless framebuffer is incomplete: {:#x}", status);
+    return false;
+  }
+  glViewport(0, 0, width_, height_);
+  return true;
+}
+
+void GlContext::Release() {
+  // 等待还在进行的读回和编码，PBO要在上下文销毁前删除
+  if (capture_.active()) {
+    capture_.Release();
+    capture_.LogStats();
+  }
+  resources_.Release();
+  if (metrics_exporter_.active()) {
+    metrics_exporter_.Flush(MetricsRegistry::Instance());
+    metrics_exporter_ = MetricsExporter();
+  }
+
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteRenderbuffers(1, &color_buffer_);
+    glDeleteRenderbuffers(1, &depth_buffer_);
+    framebuffer_ = 0;
+    color_buffer_ = 0;
+    depth_buffer_ = 0;
+  }
+
+#ifdef UTILS_HAS_EGL
+  if (egl_display_ != nullptr) {
+    eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_surface_ != nullptr) {
+      eglDestroySurface(egl_display_, egl_surface_);
+    }
+    if (egl_context_ != nullptr) {
+      eglDestroyContext(egl_display_, egl_context_);
+    }
+    eglTerminate(egl_display_);
+  }
+#endif
+  egl_display_ = nullptr;
+  egl_context_ = nullptr;
+  egl_surface_ = nullptr;
+
+  if (window_ != nullptr) {
+    glfwDestroyWindow(window_);
+    window_ = nullptr;
+  }
+  if (glfw_initialized_) {
+    glfwTerminate();
+    glfw_initialized_ = false;
+  }
+}
+
+bool GlContext::BeginFrame() {
+  int frame_count = options_.frame_count;
+  if (headless() && frame_count == 0) {
+    frame_count = 1;
+  }
+  if (frame_count > 0 && frame_index_ >= static_cast<uint64_t>(frame_count)) {
+    return false;
+  }
+
+  if (window_ != nullptr) {
+    glfwPollEvents();
+    if (glfwWindowShouldClose(window_)) {
+      return false;
+    }
+    glfwGetFramebufferSize(window_, &width_, &height_);
+  }
+
+  double now = NowSeconds();
+  frame_start_ = now;
+  if (options_.fixed_delta > 0.0) {
+    time_ = static_cast<double>(frame_index_) * options_.fixed_delta;
+    delta_time_ = options_.fixed_delta;
+  } else {
+    double last_time = time_;
+    time_ = now - start_time_;
+    delta_time_ = frame_index_ == 0 ? 0.0 : time_ - last_time;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, width_, height_);
+  frame_allocations_start_ = AllocationCount();
+  return true;
+}
+
+void GlContext::EndFrame() {
+  // 第一帧里容器第一次增长、驱动延迟编译等都算预热，不计入
+  if (frame_index_ > 0) {
+    uint64_t allocations = AllocationCount() - frame_allocations_start_;
+    steady_allocations_ += allocations;
+    max_frame_allocations_ = std::max(max_frame_allocations_, allocations);
+  }
+
+  if (capture_.active()) {
+    capture_.Poll();
+    if (frame_index_ % static_cast<uint64_t>(options_.dump_interval) == 0) {
+      capture_.Capture(framebuffer_, width_, height_, frame_index_);
+    }
+  }
+
+  if (window_ != nullptr) {
+    glfwSwapBuffers(window_);
+  } else {
+    // 没有交换链限速，等GPU做完才能得到真实的帧时间
+    glFinish();
+  }
+
+  double frame_ms = (NowSeconds() - frame_start_) * 1000.0;
+  if (frame_ms_.size() < kTimingSamples) {
+    frame_ms_.push_back(frame_ms);
+  } else {
+    frame_ms_[timed_frames_ % kTimingSamples] = frame_ms;
+  }
+  min_frame_ms_ = timed_frames_ == 0 ? frame_ms : std::min(min_frame_ms_, frame_ms);
+  max_frame_ms_ = std::max(max_frame_ms_, frame_ms);
+  total_frame_ms_ += frame_ms;
+  timed_frames_++;
+  resources_.EndFrame();
+  MetricsRegistry::Instance().EndFrame();
+  metrics_exporter_.Update(MetricsRegistry::Instance());
+  frame_index_++;
+  // GL线程的临时数据只在一帧内有效，其它线程的分配器由使用者在安全的时机重置
+  FrameArena::ForThread().Reset();
+}
+
+bool GlContext::SaveFrame(const std::string& path) const {
+  std::vector<unsigned char> pixels(static_cast<size_t>(width_) * height_ * 4);
+  GLint pack_alignment = 4;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+  glReadBuffer(framebuffer_ == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+  return WriteImagePng(path, width_, height_, pixels.data());
+}
+
+FrameTimingStats GlContext::timing_stats() const {
+  FrameTimingStats stats;
+  if (timed_frames_ == 0) {
+    return stats;
+  }
+  std::vector<double> sorted = frame_ms_;
+  std::sort(sorted.begin(), sorted.end());
+  stats.frames = static_cast<int>(timed_frames_);
+  stats.total_ms = total_frame_ms_;
+  stats.avg_ms = total_frame_ms_ / static_cast<double>(timed_frames_);
+  stats.min_ms = min_frame_ms_;
+  stats.p50_ms = Percentile(sorted, 0.50);
+  stats.p95_ms = Percentile(sorted, 0.95);
+  stats.p99_ms = Percentile(sorted, 0.99);
+  stats.max_ms = max_frame_ms_;
+  if (timed_frames_ > 1) {
+    stats.allocations_per_frame = static_cast<double>(steady_allocations_) / static_cast<double>(timed_frames_ - 1);
+  }
+  stats.max_allocations = max_frame_allocations_;
+  return stats;
+}
+
+void GlContext::LogTimingStats() const {
+  FrameTimingStats stats = timing_stats();
+  SPDLOG_INFO("{} frames in {:.1f} ms, avg {:.3f} ms, min {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, max {:.3f}",
+              stats.frames, stats.total_ms, stats.avg_ms, stats.min_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms,
+              stats.max_ms);
+  if (AllocationCountingEnabled()) {
+    SPDLOG_INFO("heap allocations per frame after the first: avg {:.2f}, max {}", stats.allocations_per_frame,
+                stats.max_allocations);
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "utils/frame_capture.h"
+#include "utils/gpu_resources.h"
+#include "utils/metrics.h"
+
+namespace utils {
+
+enum class ContextMode {
+  // GLFW窗口，渲染到默认帧缓冲
+  kWindow,
+  // 无窗口：EGL（surfaceless/device/pbuffer）上下文，渲染到固定大小的FBO，可在Mesa llvmpipe上运行
+  kHeadless,
+};
+
+struct ContextOptions {
+  ContextMode mode = ContextMode::kWindow;
+  int width = 800;
+  int height = 600;
+  std::string title = "LearnOpenGL";
+  int gl_major = 3;
+  int gl_minor = 3;
+  bool vsync = true;
+  // 运行多少帧后退出，0为不限制（无窗口模式下0当作1）
+  int frame_count = 0;
+  // 大于0时使用固定的帧间隔（秒），time()只由帧号决定，渲染结果可重复
+  double fixed_delta = 0.0;
+  // 非空时每dump_interval帧保存一张PNG到该目录
+  std::string dump_dir;
+  // 非空时每dump_interval帧写入一帧Y4M视频，与dump_dir只能用一个
+  std::string dump_y4m;
+  int dump_interval = 1;
+  // 异步读回或编码跟不上时丢弃帧，而不是等待
+  bool dump_drop_frames = false;
+  // 非空时每metrics_interval秒把MetricsRegistry写入该文件（.json为JSON，否则为Prometheus文本）
+  std::string metrics_path;
+  double metrics_interval = 1.0;
+};
+
+// 解析命令行：--headless --frames N --size WxH --fixed-dt SECONDS --dump DIR --dump-y4m FILE --dump-every N
+// --dump-drop --no-vsync --metrics FILE --metrics-every SECONDS
+// 未识别的参数忽略，格式错误时返回false
+bool ParseContextOptions(int argc, char** argv, ContextOptions* options);
+
+// 把按行紧密排列的RGBA8保存为PNG，rgba的第0行在底部（glReadPixels的顺序）
+bool WriteImagePng(const std::string& path, int width, int height, const uint8_t* rgba);
+
+// 帧数、总时间、平均、最小和最大覆盖全部帧，百分位取最近GlContext::kTimingSamples帧
+struct FrameTimingStats {
+  int frames = 0;
+  double total_ms = 0.0;
+  double avg_ms = 0.0;
+  double min_ms = 0.0;
+  double p50_ms = 0.0;
+  double p95_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+  // 第一帧之后每帧BeginFrame到EndFrame之间的堆分配次数（AllocationCount），没有链接count_allocations.cpp时为0
+  double allocations_per_frame = 0.0;
+  uint64_t max_allocations = 0;
+};
+
+// 统一的GL上下文创建。典型用法：
+//   while (context.BeginFrame()) { 渲染到context.framebuffer(); context.EndFrame(); }
+class GlContext {
+public:
+  // 保留的帧时间样本数，长时间运行时内存和timing_stats()的开销不随帧数增长
+  static constexpr size_t kTimingSamples = 4096;
+
+  GlContext() = default;
+  ~GlContext();
+
+  GlContext(const GlContext&) = delete;
+  GlContext& operator=(const GlContext&) = delete;
+
+  // 创建上下文并加载GL函数
+  bool Init(const ContextOptions& options);
+
+  // 开始一帧并绑定渲染目标，返回false表示应该退出
+  bool BeginFrame();
+
+  // 结束一帧：交换缓冲（无窗口模式为glFinish），记录帧时间，按需异步读回并保存PNG或Y4M，
+  // 最后重置当前线程的FrameArena
+  void EndFrame();
+
+  // 同步读取当前渲染目标的颜色保存为PNG
+  bool SaveFrame(const std::string& path) const;
+
+  FrameTimingStats timing_stats() const;
+  void LogTimingStats() const;
+
+  // 无窗口模式下为nullptr
+  GLFWwindow* window() const {
+    return window_;
+  }
+
+  bool headless() const {
+    return options_.mode == ContextMode::kHeadless;
+  }
+
+  // 渲染目标，窗口模式为0
+  GLuint framebuffer() const {
+    return framebuffer_;
+  }
+
+  int width() const {
+    return width_;
+  }
+
+  int height() const {
+    return height_;
+  }
+
+  uint64_t frame_index() const {
+    return frame_index_;
+  }
+
+  // 当前帧的时间和帧间隔（秒），固定步长时由帧号计算
+  double time() const {
+    return time_;
+  }
+
+  double delta_time() const {
+    return delta_time_;
+  }
+
+  const ContextOptions& options() const {
+    return options_;
+  }
+
+  // 随上下文存在的GL对象池，EndFrame中删除到期的对象，上下文销毁前报告泄漏
+  GpuResources* resources() {
+    return &resources_;
+  }
+
+private:
+  bool InitWindow();
+  bool InitHeadless();
+  bool CreateFramebuffer();
+  void Release();
+
+private:
+  ContextOptions options_;
+  GLFWwindow* window_ = nullptr;
+  bool glfw_initialized_ = false;
+
+  // EGL对象，避免在头文件中引入EGL
+  void* egl_display_ = nullptr;
+  void* egl_context_ = nullptr;
+  void* egl_surface_ = nullptr;
+
+  // --dump/--dump-y4m的异步录制，上下文销毁时输出读回延迟和丢帧统计
+  FrameCapture capture_;
+  GpuResources resources_;
+  // --metrics的定期导出，上下文销毁时再写一次
+  MetricsExporter metrics_exporter_;
+
+  GLuint framebuffer_ = 0;
+  GLuint color_buffer_ = 0;
+  GLuint depth_buffer_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+
+  uint64_t frame_index_ = 0;
+  double time_ = 0.0;
+  double delta_time_ = 0.0;
+  double start_time_ = 0.0;
+  double frame_start_ = 0.0;
+  // 最近kTimingSamples帧的帧时间，写满后按timed_frames_循环覆盖
+  std::vector<double> frame_ms_;
+  uint64_t timed_frames_ = 0;
+  double total_frame_ms_ = 0.0;
+  double min_frame_ms_ = 0.0;
+  double max_frame_ms_ = 0.0;
+  uint64_t frame_allocations_start_ = 0;
+  uint64_t steady_allocations_ = 0;
+  uint64_t max_frame_allocations_ = 0;
+};
+
+}  // namespace utils
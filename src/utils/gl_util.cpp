@@ -2,10 +2,12 @@
 
 #include "stb/stb_image.h"
 #include "spdlog/spdlog.h"
+#include "utils/metrics.h"
 
 namespace utils {
 
-GLuint LoadTexture(const std::string& image_path, GLint internal_format, GLenum format, bool flip_y) {
+GLuint LoadTexture(const std::string& image_path, GLint internal_format, GLenum format, bool flip_y,
+                   size_t* memory_bytes) {
   GLuint texture = 0;
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D, texture);
@@ -34,7 +36,105 @@ GLuint LoadTexture(const std::string& image_path, GLint internal_format, GLenum
 
   stbi_image_free(data);
 
+  size_t level0_bytes =
+      static_cast<size_t>(width) * height * TextureBytesPerPixel(static_cast<GLenum>(internal_format));
+  const RenderMetrics& metrics = RenderMetrics::Get();
+  metrics.texture_uploads.Add();
+  metrics.texture_upload_bytes.Add(level0_bytes);
+  if (memory_bytes != nullptr) {
+    // 整条mip链约为第0级的4/3
+    *memory_bytes = level0_bytes / 3 * 4;
+  }
+
   return texture;
 }
 
+bool LoadImageRgba(const std::string& image_path, bool flip_y, int* width, int* height, std::vector<uint8_t>* rgba) {
+  stbi_set_flip_vertically_on_load(flip_y);
+  int channels_in_file = 0;
+  unsigned char* data = stbi_load(image_path.c_str(), width, height, &channels_in_file, 4);
+  if (data == nullptr) {
+    SPDLOG_ERROR("Failed to load image: {}.", image_path);
+    return false;
+  }
+  rgba->assign(data, data + static_cast<size_t>(*width) * *height * 4);
+  stbi_image_free(data);
+  return true;
+}
+
+size_t TextureBytesPerPixel(GLenum internal_format) {
+  switch (internal_format) {
+    case 0:
+      return 0;
+    case GL_R8:
+      return 1;
+    case GL_RG8:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_DEPTH_COMPONENT24:
+      return 3;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGBA32F:
+      return 16;
+    default:
+      // GL_RGBA8、GL_RG16F、GL_R32F、GL_R11F_G11F_B10F、GL_DEPTH24_STENCIL8、GL_DEPTH_COMPONENT32F等
+      return 4;
+  }
+}
+
+bool IsDepthFormat(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH32F_STENCIL8:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void TextureUploadFormat(GLenum internal_format, GLenum* format, GLenum* type) {
+  *type = GL_FLOAT;
+  switch (internal_format) {
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+      *format = GL_DEPTH_COMPONENT;
+      break;
+    case GL_DEPTH24_STENCIL8:
+      *format = GL_DEPTH_STENCIL;
+      *type = GL_UNSIGNED_INT_24_8;
+      break;
+    case GL_DEPTH32F_STENCIL8:
+      *format = GL_DEPTH_STENCIL;
+      *type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+      break;
+    case GL_R8:
+    case GL_R16F:
+    case GL_R32F:
+      *format = GL_RED;
+      break;
+    case GL_RG8:
+    case GL_RG16F:
+    case GL_RG32F:
+      *format = GL_RG;
+      break;
+    case GL_R11F_G11F_B10F:
+    case GL_RGB8:
+      *format = GL_RGB;
+      break;
+    default:
+      *format = GL_RGBA;
+      break;
+  }
+}
+
 }  // namespace utils
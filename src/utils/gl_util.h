@@ -1,10 +1,26 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 #include "glad/glad.h"
 
 namespace utils {
 
-GLuint LoadTexture(const std::string& image_path, GLint internal_format, GLenum format, bool flip_y);
+// memory_bytes不为空时返回纹理占用的显存（含多级渐远纹理），计入RenderMetrics的上传统计
+GLuint LoadTexture(const std::string& image_path, GLint internal_format, GLenum format, bool flip_y,
+                   size_t* memory_bytes = nullptr);
+
+// 解码图片为按行紧密排列的RGBA8，翻转方式与LoadTexture相同
+bool LoadImageRgba(const std::string& image_path, bool flip_y, int* width, int* height, std::vector<uint8_t>* rgba);
+
+// 内部格式每个像素的字节数，用于统计显存
+size_t TextureBytesPerPixel(GLenum internal_format);
+
+// 深度或深度模板格式
+bool IsDepthFormat(GLenum internal_format);
+
+// 分配空纹理（glTexImage2D数据为空）时与内部格式兼容的外部格式和类型
+void TextureUploadFormat(GLenum internal_format, GLenum* format, GLenum* type);
 
 }  // namespace utils
@@ -0,0 +1,296 @@
+#include "utils/gpu_culling.h"
+
+#include <algorithm>
+
+#include "spdlog/spdlog.h"
+#include "utils/metrics.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+namespace {
+
+// 与gpu_cull.comp中的绑定点一致
+constexpr GLuint kObjectBinding = 0;
+constexpr GLuint kMeshBinding = 1;
+constexpr GLuint kCommandBinding = 2;
+constexpr GLuint kCountBinding = 3;
+
+constexpr GLuint kCullGroupSize = 64;
+constexpr GLuint kPyramidGroupSize = 8;
+
+const char* const kPlaneNames[Frustum::kPlaneCount] = {
+  "planes[0]", "planes[1]", "planes[2]", "planes[3]", "planes[4]", "planes[5]",
+};
+
+}  // namespace
+
+GpuCuller::~GpuCuller() {
+  GLuint buffers[] = { object_buffer_, mesh_buffer_, model_buffer_, instance_buffer_, command_buffer_, count_buffer_ };
+  if (object_buffer_ != 0) {
+    glDeleteBuffers(6, buffers);
+  }
+  ReleasePyramid();
+}
+
+bool GpuCuller::Init(const std::string& cull_shader_path, const std::string& depth_pyramid_shader_path) {
+  if (!GLAD_GL_VERSION_4_3) {
+    SPDLOG_ERROR("GPU culling requires OpenGL 4.3");
+    return false;
+  }
+
+  if (!cull_shader_.CompileCompute(cull_shader_path) || !pyramid_shader_.CompileCompute(depth_pyramid_shader_path)) {
+    return false;
+  }
+
+  glGenBuffers(1, &object_buffer_);
+  glGenBuffers(1, &mesh_buffer_);
+  glGenBuffers(1, &model_buffer_);
+  glGenBuffers(1, &instance_buffer_);
+  glGenBuffers(1, &command_buffer_);
+  glGenBuffers(1, &count_buffer_);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  use_draw_count_ = GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+  return true;
+}
+
+void GpuCuller::Upload(const std::vector<GpuMeshRange>& meshes, const std::vector<Aabb>& bounds,
+                       const std::vector<uint32_t>& object_meshes, const std::vector<glm::mat4>& models) {
+  object_count_ = static_cast<uint32_t>(bounds.size());
+  object_meshes_ = object_meshes;
+
+  std::vector<glm::ivec4> mesh_data(meshes.size());
+  for (size_t i = 0; i < meshes.size(); i++) {
+    mesh_data[i] = glm::ivec4(meshes[i].index_count, meshes[i].first_index, meshes[i].base_vertex, 0);
+  }
+
+  // 每个物体两个vec4：中心（w为网格下标）和半长
+  std::vector<glm::vec4> objects(bounds.size() * 2);
+  for (size_t i = 0; i < bounds.size(); i++) {
+    objects[i * 2] = glm::vec4(bounds[i].center(), static_cast<float>(object_meshes[i]));
+    objects[i * 2 + 1] = glm::vec4(bounds[i].extent(), 0.0f);
+  }
+
+  std::vector<GLuint> instances(bounds.size());
+  for (size_t i = 0; i < instances.size(); i++) {
+    instances[i] = static_cast<GLuint>(i);
+  }
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mesh_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, mesh_data.size() * sizeof(glm::ivec4), mesh_data.data(), GL_STATIC_DRAW);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(glm::vec4), objects.data(), GL_DYNAMIC_DRAW);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, model_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_DYNAMIC_DRAW);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, bounds.size() * sizeof(DrawElementsIndirectCommand), nullptr,
+               GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(GLuint), instances.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  RenderMetrics::Get().buffer_upload_bytes.Add(mesh_data.size() * sizeof(glm::ivec4) +
+                                               objects.size() * sizeof(glm::vec4) + models.size() * sizeof(glm::mat4) +
+                                               instances.size() * sizeof(GLuint));
+}
+
+void GpuCuller::UpdateObjects(uint32_t first, const Aabb* bounds, const glm::mat4* models, uint32_t count) {
+  // 网格下标不变，从CPU端的副本取出，整体写入vec4，不读回GPU缓冲
+  update_objects_.resize(count * 2);
+  for (uint32_t i = 0; i < count; i++) {
+    update_objects_[i * 2] = glm::vec4(bounds[i].center(), static_cast<float>(object_meshes_[first + i]));
+    update_objects_[i * 2 + 1] = glm::vec4(bounds[i].extent(), 0.0f);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_buffer_);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * 2 * sizeof(glm::vec4), count * 2 * sizeof(glm::vec4),
+                  update_objects_.data());
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, model_buffer_);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(glm::mat4), count * sizeof(glm::mat4), models);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  RenderMetrics::Get().buffer_upload_bytes.Add(count * 2 * sizeof(glm::vec4) + count * sizeof(glm::mat4));
+}
+
+void GpuCuller::BindInstanceAttribute(GLuint location) const {
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+  glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+  glEnableVertexAttribArray(location);
+  glVertexAttribDivisor(location, 1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuCuller::Cull(const glm::mat4& view_projection, bool use_hiz) {
+  GPU_PROFILE_SCOPE("GpuCuller::Cull");
+  last_view_projection_ = view_projection;
+  if (object_count_ == 0) {
+    return;
+  }
+
+  // 计数清零。不支持计数绘制时还要把命令清零，剩余命令的instance_count为0，不会绘制任何东西
+  GLuint zero = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer_);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+  if (!use_draw_count_) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  Frustum frustum = Frustum::FromMatrix(view_projection);
+  bool hiz = use_hiz && pyramid_levels_ > 0;
+
+  cull_shader_.Use();
+  cull_shader_.SetInt("objectCount", static_cast<int>(object_count_));
+  for (int i = 0; i < Frustum::kPlaneCount; i++) {
+    cull_shader_.SetVec4(kPlaneNames[i], frustum.planes[i]);
+  }
+  cull_shader_.SetBool("hizEnabled", hiz);
+  if (hiz) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pyramid_texture_);
+    cull_shader_.SetInt("hiz", 0);
+    cull_shader_.SetInt("hizLevels", pyramid_levels_);
+    cull_shader_.SetVec2("depthSize", static_cast<float>(depth_width_), static_cast<float>(depth_height_));
+    cull_shader_.SetMat4("hizViewProjection", pyramid_view_projection_);
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kObjectBinding, object_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kMeshBinding, mesh_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, command_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCountBinding, count_buffer_);
+  cull_shader_.Dispatch((object_count_ + kCullGroupSize - 1) / kCullGroupSize);
+
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuCuller::Draw(GLuint model_binding) const {
+  if (object_count_ == 0) {
+    return;
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, model_binding, model_buffer_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  if (use_draw_count_) {
+    glBindBuffer(GL_PARAMETER_BUFFER_ARB, count_buffer_);
+    if (GLAD_GL_VERSION_4_6) {
+      glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, object_count_, 0);
+    } else {
+      glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, object_count_, 0);
+    }
+    glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+  } else {
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, object_count_, 0);
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  RenderMetrics::Get().draw_calls.Add();
+}
+
+void GpuCuller::UpdateDepthPyramid(int width, int height) {
+  GPU_PROFILE_SCOPE("GpuCuller::UpdateDepthPyramid");
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+
+  // 复制深度要求纹理与读帧缓冲的深度格式一致（定点或浮点）
+  GLint read_framebuffer = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+  GLint component_type = GL_UNSIGNED_NORMALIZED;
+  glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, read_framebuffer == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT,
+                                        GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &component_type);
+  GLenum depth_format = component_type == GL_FLOAT ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24;
+
+  if (width != depth_width_ || height != depth_height_ || depth_format != depth_format_) {
+    ReleasePyramid();
+    depth_width_ = width;
+    depth_height_ = height;
+    depth_format_ = depth_format;
+
+    glGenTextures(1, &depth_texture_);
+    glBindTexture(GL_TEXTURE_2D, depth_texture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, depth_format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // 第0层为一半分辨率，之后按GL的mip规则逐层减半（向下取整）到1x1
+    int level_width = std::max(1, width / 2);
+    int level_height = std::max(1, height / 2);
+    int levels = 1;
+    while (level_width > 1 || level_height > 1) {
+      level_width = std::max(1, level_width / 2);
+      level_height = std::max(1, level_height / 2);
+      levels++;
+    }
+
+    glGenTextures(1, &pyramid_texture_);
+    glBindTexture(GL_TEXTURE_2D, pyramid_texture_);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, std::max(1, width / 2), std::max(1, height / 2));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    pyramid_levels_ = levels;
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, depth_texture_);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+  pyramid_shader_.Use();
+  pyramid_shader_.SetInt("depthTexture", 0);
+
+  int level_width = std::max(1, width / 2);
+  int level_height = std::max(1, height / 2);
+  for (int level = 0; level < pyramid_levels_; level++) {
+    pyramid_shader_.SetBool("fromDepth", level == 0);
+    glBindImageTexture(0, pyramid_texture_, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, pyramid_texture_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    pyramid_shader_.Dispatch((level_width + kPyramidGroupSize - 1) / kPyramidGroupSize,
+                             (level_height + kPyramidGroupSize - 1) / kPyramidGroupSize);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    level_width = std::max(1, level_width / 2);
+    level_height = std::max(1, level_height / 2);
+  }
+
+  pyramid_view_projection_ = last_view_projection_;
+}
+
+uint32_t GpuCuller::ReadDrawCount() const {
+  GLuint count = 0;
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer_);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &count);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return count;
+}
+
+std::vector<DrawElementsIndirectCommand> GpuCuller::ReadCommands() const {
+  std::vector<DrawElementsIndirectCommand> commands(ReadDrawCount());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand),
+                     commands.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return commands;
+}
+
+void GpuCuller::ReleasePyramid() {
+  if (depth_texture_ != 0) {
+    glDeleteTextures(1, &depth_texture_);
+    depth_texture_ = 0;
+  }
+  if (pyramid_texture_ != 0) {
+    glDeleteTextures(1, &pyramid_texture_);
+    pyramid_texture_ = 0;
+  }
+  pyramid_levels_ = 0;
+  depth_width_ = 0;
+  depth_height_ = 0;
+}
+
+}  // namespace utils
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "utils/bounds.h"
+#include "utils/shader.h"
+
+namespace utils {
+
+// 与GL要求的间接绘制命令布局一致
+struct DrawElementsIndirectCommand {
+  GLuint count = 0;
+  GLuint instance_count = 0;
+  GLuint first_index = 0;
+  GLint base_vertex = 0;
+  GLuint base_instance = 0;
+};
+
+// 网格在共享顶点/索引缓冲中的范围，索引类型为GL_UNSIGNED_INT
+struct GpuMeshRange {
+  GLuint index_count = 0;
+  GLuint first_index = 0;
+  GLint base_vertex = 0;
+};
+
+// GPU驱动的剔除（需要GL 4.3）：物体包围盒和模型矩阵只上传一次，每帧由计算着色器做视锥体剔除，
+// 可选地用上一帧的深度金字塔做Hi-Z遮挡剔除，再把可见物体紧凑写成间接绘制命令，一次MultiDraw画完。
+//
+// 顶点着色器通过实例属性（除数为1）得到物体下标，再从模型矩阵SSBO中取矩阵：
+//   layout (location = N) in uint aObject;
+//   layout (std430, binding = M) readonly buffer Models { mat4 models[]; };
+class GpuCuller {
+public:
+  GpuCuller() = default;
+  ~GpuCuller();
+
+  GpuCuller(const GpuCuller&) = delete;
+  GpuCuller& operator=(const GpuCuller&) = delete;
+
+  bool Init(const std::string& cull_shader_path, const std::string& depth_pyramid_shader_path);
+
+  // 物体i使用网格meshes[object_meshes[i]]，包围盒和模型矩阵都在世界空间
+  void Upload(const std::vector<GpuMeshRange>& meshes, const std::vector<Aabb>& bounds,
+              const std::vector<uint32_t>& object_meshes, const std::vector<glm::mat4>& models);
+
+  // 只更新部分物体的包围盒和模型矩阵
+  void UpdateObjects(uint32_t first, const Aabb* bounds, const glm::mat4* models, uint32_t count);
+
+  // 给当前绑定的VAO加上物体下标的实例属性
+  void BindInstanceAttribute(GLuint location) const;
+
+  // 剔除并生成间接绘制命令。use_hiz需要之前调用过UpdateDepthPyramid
+  void Cull(const glm::mat4& view_projection, bool use_hiz);
+
+  // 使用者绑定好VAO（含索引缓冲）和着色器后调用
+  void Draw(GLuint model_binding) const;
+
+  // 一帧画完后调用：从当前读帧缓冲复制深度并建立深度金字塔，下一帧Cull时使用
+  void UpdateDepthPyramid(int width, int height);
+
+  // 读回可见物体数量，会等待GPU，只用于调试和统计
+  uint32_t ReadDrawCount() const;
+
+  // 读回紧凑后的命令，会等待GPU
+  std::vector<DrawElementsIndirectCommand> ReadCommands() const;
+
+  uint32_t object_count() const {
+    return object_count_;
+  }
+
+  bool has_depth_pyramid() const {
+    return pyramid_levels_ > 0;
+  }
+
+  // 是否使用glMultiDrawElementsIndirectCount（GL 4.6或ARB_indirect_parameters）
+  bool uses_draw_count() const {
+    return use_draw_count_;
+  }
+
+private:
+  void ReleasePyramid();
+
+private:
+  Shader cull_shader_;
+  Shader pyramid_shader_;
+
+  GLuint object_buffer_ = 0;
+  GLuint mesh_buffer_ = 0;
+  GLuint model_buffer_ = 0;
+  GLuint instance_buffer_ = 0;
+  GLuint command_buffer_ = 0;
+  GLuint count_buffer_ = 0;
+  uint32_t object_count_ = 0;
+  bool use_draw_count_ = false;
+
+  // 每个物体的网格下标，UpdateObjects写中心时用；update_objects_是复用的上传缓冲
+  std::vector<uint32_t> object_meshes_;
+  std::vector<glm::vec4> update_objects_;
+
+  // 深度金字塔以及建立它时使用的视图投影矩阵
+  GLuint depth_texture_ = 0;
+  GLuint pyramid_texture_ = 0;
+  GLenum depth_format_ = 0;
+  int depth_width_ = 0;
+  int depth_height_ = 0;
+  int pyramid_levels_ = 0;
+  glm::mat4 last_view_projection_ = glm::mat4(1.0f);
+  glm::mat4 pyramid_view_projection_ = glm::mat4(1.0f);
+};
+
+}  // namespace utils
@@ -0,0 +1,195 @@
+#include "utils/gpu_resources.h"
+
+#include "spdlog/spdlog.h"
+#include "utils/gl_util.h"
+#include "utils/metrics.h"
+
+namespace utils {
+
+namespace {
+
+// 泄漏报告只逐个列出前这么多个对象，之后只计数
+constexpr size_t kMaxLeakReports = 32;
+
+const char* const kTypeNames[static_cast<size_t>(GpuResourceType::kCount)] = {
+  "buffer",
+  "texture",
+  "vertex array",
+  "program",
+};
+
+}  // namespace
+
+uint32_t GpuResources::Pool::Add(GLuint name, const std::string& label, uint32_t* generation) {
+  uint32_t index = 0;
+  if (free_.empty()) {
+    index = static_cast<uint32_t>(names_.size());
+    names_.push_back(name);
+    generations_.push_back(0);
+    labels_.push_back(label);
+  } else {
+    index = free_.back();
+    free_.pop_back();
+    names_[index] = name;
+    labels_[index] = label;
+  }
+  *generation = generations_[index];
+  return index;
+}
+
+GLuint GpuResources::Pool::Remove(uint32_t index, uint32_t generation) {
+  GLuint name = Get(index, generation);
+  if (name == 0) {
+    return 0;
+  }
+  names_[index] = 0;
+  generations_[index]++;
+  labels_[index].clear();
+  free_.push_back(index);
+  return name;
+}
+
+GpuResources::~GpuResources() {
+  Release();
+}
+
+BufferHandle GpuResources::CreateBuffer(const std::string& label) {
+  GLuint buffer = 0;
+  glGenBuffers(1, &buffer);
+  return Adopt<GpuResourceType::kBuffer>(buffer, label);
+}
+
+TextureHandle GpuResources::CreateTexture(const std::string& label) {
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  return Adopt<GpuResourceType::kTexture>(texture, label);
+}
+
+VertexArrayHandle GpuResources::CreateVertexArray(const std::string& label) {
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  return Adopt<GpuResourceType::kVertexArray>(vao, label);
+}
+
+TextureHandle GpuResources::LoadTexture(const std::string& image_path, GLint internal_format, GLenum format,
+                                        bool flip_y) {
+  size_t bytes = 0;
+  GLuint texture = utils::LoadTexture(image_path, internal_format, format, flip_y, &bytes);
+  TextureHandle handle = Adopt<GpuResourceType::kTexture>(texture, image_path);
+  if (handle.valid()) {
+    if (texture_bytes_.size() <= handle.index) {
+      texture_bytes_.resize(handle.index + 1, 0);
+    }
+    texture_bytes_[handle.index] = bytes;
+    RenderMetrics::Get().texture_memory_bytes.Add(static_cast<int64_t>(bytes));
+  }
+  return handle;
+}
+
+void GpuResources::ProcessRequests() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    processing_.swap(requests_);
+  }
+  for (const DestroyRequest& request : processing_) {
+    GLuint name = pools_[static_cast<size_t>(request.type)].Remove(request.index, request.generation);
+    if (name == 0) {
+      SPDLOG_WARN("Destroying a stale {} handle ({}, generation {})", kTypeNames[static_cast<size_t>(request.type)],
+                  request.index, request.generation);
+      continue;
+    }
+    size_t bytes = request.type == GpuResourceType::kTexture ? TakeTextureBytes(request.index) : 0;
+    pending_.push_back({ request.type, name, frame_ + kDeleteDelayFrames, bytes });
+  }
+  processing_.clear();
+}
+
+void GpuResources::EndFrame() {
+  ProcessRequests();
+  size_t kept = 0;
+  for (const PendingDelete& pending : pending_) {
+    if (pending.delete_frame <= frame_) {
+      DeleteObject(pending.type, pending.name, pending.bytes);
+      deleted_++;
+    } else {
+      pending_[kept++] = pending;
+    }
+  }
+  pending_.resize(kept);
+  frame_++;
+}
+
+void GpuResources::Release() {
+  ProcessRequests();
+  for (const PendingDelete& pending : pending_) {
+    DeleteObject(pending.type, pending.name, pending.bytes);
+    deleted_++;
+  }
+  pending_.clear();
+
+  size_t leaked = 0;
+  for (size_t type = 0; type < static_cast<size_t>(GpuResourceType::kCount); type++) {
+    Pool& pool = pools_[type];
+    for (uint32_t index = 0; index < pool.names().size(); index++) {
+      GLuint name = pool.names()[index];
+      if (name == 0) {
+        continue;
+      }
+      if (leaked < kMaxLeakReports) {
+        SPDLOG_WARN("Leaked {} {}: {}", kTypeNames[type], name, pool.label(index));
+      }
+      pool.Remove(index, pool.generation(index));
+      auto resource_type = static_cast<GpuResourceType>(type);
+      size_t bytes = resource_type == GpuResourceType::kTexture ? TakeTextureBytes(index) : 0;
+      DeleteObject(resource_type, name, bytes);
+      leaked++;
+    }
+  }
+  if (leaked > 0) {
+    SPDLOG_WARN("{} GPU resources were not destroyed before shutdown", leaked);
+  }
+}
+
+GpuResourceStats GpuResources::stats() const {
+  GpuResourceStats stats;
+  for (size_t type = 0; type < static_cast<size_t>(GpuResourceType::kCount); type++) {
+    stats.live[type] = pools_[type].live();
+  }
+  stats.pending_deletes = pending_.size();
+  stats.created = created_;
+  stats.deleted = deleted_;
+  return stats;
+}
+
+size_t GpuResources::TakeTextureBytes(uint32_t index) {
+  if (index >= texture_bytes_.size()) {
+    return 0;
+  }
+  size_t bytes = texture_bytes_[index];
+  texture_bytes_[index] = 0;
+  return bytes;
+}
+
+void GpuResources::DeleteObject(GpuResourceType type, GLuint name, size_t bytes) {
+  if (bytes > 0) {
+    RenderMetrics::Get().texture_memory_bytes.Add(-static_cast<int64_t>(bytes));
+  }
+  switch (type) {
+    case GpuResourceType::kBuffer:
+      glDeleteBuffers(1, &name);
+      break;
+    case GpuResourceType::kTexture:
+      glDeleteTextures(1, &name);
+      break;
+    case GpuResourceType::kVertexArray:
+      glDeleteVertexArrays(1, &name);
+      break;
+    case GpuResourceType::kProgram:
+      glDeleteProgram(name);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace utils {
+
+enum class GpuResourceType : uint8_t {
+  kBuffer,
+  kTexture,
+  kVertexArray,
+  kProgram,
+  kCount,
+};
+
+// 带代数的句柄：槽位回收时代数加一，旧句柄查不到对象，而不会拿到之后复用了同一个GL名字的对象。
+// 类型是模板参数，纹理句柄不能当作缓冲句柄使用。
+template <GpuResourceType kType>
+struct GpuHandle {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool valid() const {
+    return index != UINT32_MAX;
+  }
+
+  bool operator==(const GpuHandle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator!=(const GpuHandle& other) const {
+    return !(*this == other);
+  }
+};
+
+using BufferHandle = GpuHandle<GpuResourceType::kBuffer>;
+using TextureHandle = GpuHandle<GpuResourceType::kTexture>;
+using VertexArrayHandle = GpuHandle<GpuResourceType::kVertexArray>;
+using ProgramHandle = GpuHandle<GpuResourceType::kProgram>;
+
+struct GpuResourceStats {
+  size_t live[static_cast<size_t>(GpuResourceType::kCount)] = {};
+  // 已经销毁、等待安全帧删除的GL对象
+  size_t pending_deletes = 0;
+  uint64_t created = 0;
+  uint64_t deleted = 0;
+};
+
+// 按句柄管理的GL对象池，每种对象一个稠密的池。
+// 创建、查找和EndFrame只能在GL线程调用；Destroy可以在任何线程调用，只是登记请求，
+// 句柄在下一次EndFrame时失效，GL对象再过kDeleteDelayFrames帧才删除，此时已经提交的命令不会再用到它。
+// Release时还存在的对象当作泄漏打印出来。
+class GpuResources {
+public:
+  static constexpr uint64_t kDeleteDelayFrames = 2;
+
+  GpuResources() = default;
+  ~GpuResources();
+
+  GpuResources(const GpuResources&) = delete;
+  GpuResources& operator=(const GpuResources&) = delete;
+
+  // label用于泄漏报告
+  BufferHandle CreateBuffer(const std::string& label);
+  TextureHandle CreateTexture(const std::string& label);
+  VertexArrayHandle CreateVertexArray(const std::string& label);
+
+  // 接管已经创建的GL对象，之后由池负责删除。name为0时返回无效句柄
+  template <GpuResourceType kType>
+  GpuHandle<kType> Adopt(GLuint name, const std::string& label) {
+    GpuHandle<kType> handle;
+    if (name != 0) {
+      handle.index = pools_[static_cast<size_t>(kType)].Add(name, label, &handle.generation);
+      created_++;
+    }
+    return handle;
+  }
+
+  // 与utils::LoadTexture相同，失败时返回无效句柄。纹理的显存计入RenderMetrics，删除时扣除
+  TextureHandle LoadTexture(const std::string& image_path, GLint internal_format, GLenum format, bool flip_y);
+
+  // 句柄无效或对象已经销毁时返回0
+  template <GpuResourceType kType>
+  GLuint Get(GpuHandle<kType> handle) const {
+    return pools_[static_cast<size_t>(kType)].Get(handle.index, handle.generation);
+  }
+
+  template <GpuResourceType kType>
+  void Destroy(GpuHandle<kType> handle) {
+    if (handle.valid()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back({ kType, handle.index, handle.generation });
+    }
+  }
+
+  // 处理销毁请求，删除已经到期的GL对象，每帧调用一次
+  void EndFrame();
+
+  // 删除所有对象并报告泄漏，必须在GL上下文销毁前调用
+  void Release();
+
+  GpuResourceStats stats() const;
+
+private:
+  // GL名字和代数分别连续存放，查找只读两个数组的同一个下标；标签只在报告泄漏时用到
+  class Pool {
+  public:
+    GLuint Get(uint32_t index, uint32_t generation) const {
+      return index < generations_.size() && generations_[index] == generation ? names_[index] : 0;
+    }
+
+    uint32_t Add(GLuint name, const std::string& label, uint32_t* generation);
+
+    // 返回被移除的GL名字，句柄已经失效时返回0
+    GLuint Remove(uint32_t index, uint32_t generation);
+
+    size_t live() const {
+      return names_.size() - free_.size();
+    }
+
+    const std::vector<GLuint>& names() const {
+      return names_;
+    }
+
+    uint32_t generation(uint32_t index) const {
+      return generations_[index];
+    }
+
+    const std::string& label(uint32_t index) const {
+      return labels_[index];
+    }
+
+  private:
+    std::vector<GLuint> names_;
+    std::vector<uint32_t> generations_;
+    std::vector<std::string> labels_;
+    std::vector<uint32_t> free_;
+  };
+
+  struct DestroyRequest {
+    GpuResourceType type;
+    uint32_t index;
+    uint32_t generation;
+  };
+
+  struct PendingDelete {
+    GpuResourceType type;
+    GLuint name;
+    uint64_t delete_frame;
+    // 删除后从纹理显存统计中扣除的字节数
+    size_t bytes;
+  };
+
+  void ProcessRequests();
+  size_t TakeTextureBytes(uint32_t index);
+  static void DeleteObject(GpuResourceType type, GLuint name, size_t bytes);
+
+private:
+  Pool pools_[static_cast<size_t>(GpuResourceType::kCount)];
+  std::mutex mutex_;
+  std::vector<DestroyRequest> requests_;
+  // 与requests_交换，EndFrame处理请求时不持有锁，也不每帧分配
+  std::vector<DestroyRequest> processing_;
+  std::vector<PendingDelete> pending_;
+  // 按纹理池下标记录LoadTexture创建的纹理的显存，其它纹理为0
+  std::vector<size_t> texture_bytes_;
+  uint64_t frame_ = 0;
+  uint64_t created_ = 0;
+  uint64_t deleted_ = 0;
+};
+
+}  // namespace utils
@@ -0,0 +1,431 @@
+#include "utils/job_system.h"
+
+#include <algorithm>
+
+namespace utils {
+
+namespace {
+
+// 每次新分配的任务数
+constexpr size_t kJobBlockSize = 256;
+// 找不到任务时先让出若干次时间片再睡眠
+constexpr int kSpinCount = 64;
+
+static_assert((JobSystem::kQueueCapacity & (JobSystem::kQueueCapacity - 1)) == 0,
+              "Queue capacity must be a power of two");
+
+struct ThreadMembership {
+  const JobSystem* system = nullptr;
+  unsigned index = 0;
+};
+
+thread_local ThreadMembership tls_membership;
+thread_local uint32_t tls_random = 0x9E3779B9u;
+
+uint32_t NextRandom() {
+  uint32_t x = tls_random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  tls_random = x;
+  return x;
+}
+
+// 统计只由所属线程写入，不需要原子的读改写
+void Increment(std::atomic<uint64_t>* value) {
+  value->store(value->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+JobSystem::WorkQueue::WorkQueue() : buffer_(new std::atomic<Job*>[kQueueCapacity]) {}
+
+bool JobSystem::WorkQueue::Push(Job* job) {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed);
+  int64_t top = top_.load(std::memory_order_acquire);
+  if (bottom - top >= static_cast<int64_t>(kQueueCapacity)) {
+    return false;
+  }
+
+  buffer_[bottom & (kQueueCapacity - 1)].store(job, std::memory_order_relaxed);
+  // 偷任务的线程acquire读到bottom_后才能看到任务的内容。Pop对bottom_的写也用release，
+  // 否则偷的线程可能读到Pop写入的值而和之前的Push没有同步关系
+  bottom_.store(bottom + 1, std::memory_order_release);
+  return true;
+}
+
+JobSystem::Job* JobSystem::WorkQueue::Pop() {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  bottom_.store(bottom, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t top = top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return nullptr;
+  }
+
+  Job* job = buffer_[bottom & (kQueueCapacity - 1)].load(std::memory_order_relaxed);
+  if (top == bottom) {
+    // 只剩最后一个任务，和偷任务的线程竞争
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+  return job;
+}
+
+JobSystem::StealResult JobSystem::WorkQueue::Steal(Job** job) {
+  int64_t top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return StealResult::kEmpty;
+  }
+
+  Job* candidate = buffer_[top & (kQueueCapacity - 1)].load(std::memory_order_relaxed);
+  if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return StealResult::kConflict;
+  }
+  *job = candidate;
+  return StealResult::kSuccess;
+}
+
+JobSystem::JobSystem(unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned i = 0; i < thread_count; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  tls_membership.system = this;
+  tls_membership.index = 0;
+  for (unsigned i = 1; i < thread_count; i++) {
+    threads_.emplace_back(&JobSystem::WorkerLoop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    quit_.store(true, std::memory_order_release);
+  }
+  sleep_cv_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+
+  if (tls_membership.system == this) {
+    tls_membership = ThreadMembership();
+  }
+}
+
+unsigned JobSystem::Self() const {
+  return tls_membership.system == this ? tls_membership.index : kExternal;
+}
+
+JobSystem::Job* JobSystem::AllocateJob() {
+  unsigned self = Self();
+  if (self != kExternal) {
+    Worker& worker = *workers_[self];
+    return AllocateFrom(&worker.free, &worker.blocks);
+  }
+
+  std::lock_guard<std::mutex> lock(external_mutex_);
+  return AllocateFrom(&external_free_, &external_blocks_);
+}
+
+void JobSystem::FreeJob(unsigned self, Job* job) {
+  if (self != kExternal) {
+    Worker& worker = *workers_[self];
+    job->next = worker.free;
+    worker.free = job;
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(external_mutex_);
+  job->next = external_free_;
+  external_free_ = job;
+}
+
+JobSystem::Job* JobSystem::AllocateFrom(Job** free, std::vector<std::unique_ptr<Job[]>>* blocks) {
+  if (*free == nullptr) {
+    blocks->emplace_back(new Job[kJobBlockSize]);
+    Job* block = blocks->back().get();
+    for (size_t i = 0; i < kJobBlockSize; i++) {
+      block[i].next = i + 1 < kJobBlockSize ? &block[i + 1] : nullptr;
+    }
+    *free = block;
+  }
+
+  Job* job = *free;
+  *free = job->next;
+  job->next = nullptr;
+  return job;
+}
+
+void JobSystem::Submit(Job* job, JobCounter* counter, JobCounter* dependency) {
+  job->counter = counter;
+  if (counter != nullptr && counter->pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    // 计数刚归零时，完成它的线程可能还没把waiting_换成kCompleted，等它换完再开始新的一轮
+    uintptr_t expected = JobCounter::kCompleted;
+    while (!counter->waiting_.compare_exchange_weak(expected, 0, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed)) {
+      expected = JobCounter::kCompleted;
+      std::this_thread::yield();
+    }
+  }
+
+  if (dependency != nullptr) {
+    uintptr_t head = dependency->waiting_.load(std::memory_order_acquire);
+    while (head != JobCounter::kCompleted) {
+      job->next = reinterpret_cast<Job*>(head);
+      if (dependency->waiting_.compare_exchange_weak(head, reinterpret_cast<uintptr_t>(job),
+                                                     std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return;
+      }
+    }
+    job->next = nullptr;
+  }
+
+  Push(Self(), job);
+}
+
+void JobSystem::Push(unsigned self, Job* job) {
+  if (workers_.size() == 1) {
+    Execute(self, job);
+    return;
+  }
+
+  queued_.fetch_add(1, std::memory_order_seq_cst);
+  if (self != kExternal) {
+    if (!workers_[self]->queue.Push(job)) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      Execute(self, job);
+      return;
+    }
+  } else {
+    std::lock_guard<std::mutex> lock(external_mutex_);
+    injected_.push_back(job);
+    injected_total_++;
+    injected_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // 和WorkerLoop中先增加sleeping_再检查queued_的顺序配对，不会漏掉唤醒
+  if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+  }
+}
+
+JobSystem::Job* JobSystem::FindJob(unsigned self) {
+  if (self != kExternal) {
+    if (Job* job = workers_[self]->queue.Pop()) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  if (injected_size_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(external_mutex_);
+    if (!injected_.empty()) {
+      Job* job = injected_.front();
+      injected_.pop_front();
+      injected_size_.fetch_sub(1, std::memory_order_relaxed);
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  // 从随机的线程开始偷，避免所有空闲线程挤在同一个队列上
+  unsigned count = thread_count();
+  unsigned start = NextRandom() % count;
+  for (unsigned i = 0; i < count; i++) {
+    unsigned victim = (start + i) % count;
+    if (victim == self) {
+      continue;
+    }
+
+    Job* job = nullptr;
+    StealResult result = workers_[victim]->queue.Steal(&job);
+    if (self != kExternal) {
+      Worker& worker = *workers_[self];
+      Increment(&worker.steal_attempts);
+      if (result == StealResult::kSuccess) {
+        Increment(&worker.steals);
+      } else if (result == StealResult::kConflict) {
+        Increment(&worker.steal_conflicts);
+      }
+    }
+    if (result == StealResult::kSuccess) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::Execute(unsigned self, Job* job) {
+  job->invoke(this, job);
+
+  JobCounter* counter = job->counter;
+  FreeJob(self, job);
+  if (self != kExternal) {
+    Increment(&workers_[self]->executed);
+  }
+  Complete(self, counter);
+}
+
+void JobSystem::Complete(unsigned self, JobCounter* counter) {
+  if (counter == nullptr || counter->pending_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+
+  // 交换之后等待的线程可能已经销毁了计数，不能再访问它
+  uintptr_t waiting = counter->waiting_.exchange(JobCounter::kCompleted, std::memory_order_acq_rel);
+  Job* job = reinterpret_cast<Job*>(waiting);
+  while (job != nullptr) {
+    Job* next = job->next;
+    job->next = nullptr;
+    Push(self, job);
+    job = next;
+  }
+}
+
+void JobSystem::Wait(JobCounter* counter) {
+  unsigned self = Self();
+  while (!counter->done()) {
+    if (Job* job = FindJob(self)) {
+      Execute(self, job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::RunRange(RangeJob range, JobCounter* counter) {
+  unsigned self = Self();
+  if (range.splits >= 0 && self != range.owner) {
+    range.splits += kStolenSplits;
+  }
+
+  // 每次把右半边作为新任务压入自己的队列，左半边继续在本线程上切分
+  while (range.end - range.begin > range.grain && range.splits != 0) {
+    size_t units = (range.end - range.begin + range.grain - 1) / range.grain;
+    size_t mid = range.begin + units / 2 * range.grain;
+    if (range.splits > 0) {
+      range.splits--;
+    }
+
+    RangeJob right = range;
+    right.begin = mid;
+    right.owner = self;
+    range.end = mid;
+
+    Job* job = AllocateJob();
+    job->invoke = [](JobSystem* system, Job* current) {
+      system->RunRange(*reinterpret_cast<RangeJob*>(current->data), current->counter);
+    };
+    new (job->data) RangeJob(right);
+    Submit(job, counter, nullptr);
+  }
+
+  (*range.func)(range.begin, range.end);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const RangeFunc& func) {
+  grain = std::max<size_t>(grain, 1);
+  size_t units = (count + grain - 1) / grain;
+  size_t chunks = std::min(units, static_cast<size_t>(thread_count()) * kChunksPerThread);
+  int splits = 0;
+  while ((size_t(1) << splits) < chunks) {
+    splits++;
+  }
+  ParallelForImpl(count, grain, splits, func);
+}
+
+void JobSystem::ParallelForFixed(size_t count, size_t grain, const RangeFunc& func) {
+  ParallelForImpl(count, std::max<size_t>(grain, 1), -1, func);
+}
+
+void JobSystem::ParallelForImpl(size_t count, size_t grain, int splits, const RangeFunc& func) {
+  if (count == 0) {
+    return;
+  }
+
+  if (workers_.size() == 1 || count <= grain) {
+    func(0, count);
+    return;
+  }
+
+  JobCounter counter;
+  RunRange(RangeJob{ &func, 0, count, grain, splits, Self() }, &counter);
+  Wait(&counter);
+}
+
+JobSystemStats JobSystem::stats() const {
+  JobSystemStats result;
+  for (const auto& worker : workers_) {
+    JobWorkerStats stats;
+    stats.executed = worker->executed.load(std::memory_order_relaxed);
+    stats.steal_attempts = worker->steal_attempts.load(std::memory_order_relaxed);
+    stats.steals = worker->steals.load(std::memory_order_relaxed);
+    stats.steal_conflicts = worker->steal_conflicts.load(std::memory_order_relaxed);
+    stats.sleeps = worker->sleeps.load(std::memory_order_relaxed);
+    result.workers.push_back(stats);
+  }
+
+  std::lock_guard<std::mutex> lock(external_mutex_);
+  result.injected = injected_total_;
+  return result;
+}
+
+void JobSystem::ResetStats() {
+  for (auto& worker : workers_) {
+    worker->executed.store(0, std::memory_order_relaxed);
+    worker->steal_attempts.store(0, std::memory_order_relaxed);
+    worker->steals.store(0, std::memory_order_relaxed);
+    worker->steal_conflicts.store(0, std::memory_order_relaxed);
+    worker->sleeps.store(0, std::memory_order_relaxed);
+  }
+
+  std::lock_guard<std::mutex> lock(external_mutex_);
+  injected_total_ = 0;
+}
+
+void JobSystem::WorkerLoop(unsigned index) {
+  tls_membership.system = this;
+  tls_membership.index = index;
+  tls_random = 0x9E3779B9u * (index + 1);
+
+  Worker& worker = *workers_[index];
+  int idle = 0;
+  while (!quit_.load(std::memory_order_acquire)) {
+    if (Job* job = FindJob(index)) {
+      Execute(index, job);
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    idle = 0;
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleeping_.fetch_add(1, std::memory_order_seq_cst);
+    if (!quit_.load(std::memory_order_relaxed) && queued_.load(std::memory_order_seq_cst) <= 0) {
+      Increment(&worker.sleeps);
+      sleep_cv_.wait(lock, [this] {
+        return quit_.load(std::memory_order_relaxed) || queued_.load(std::memory_order_seq_cst) > 0;
+      });
+    }
+    sleeping_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+class JobSystem;
+
+// 一组任务的完成计数。Run时加一，任务执行完减一，归零后等待它的任务才会开始。
+// 提交过程中已有任务完成、计数暂时归零也没关系，之后的Run会开始新的一轮；Wait要在所有Run之后调用
+class JobCounter {
+public:
+  JobCounter() = default;
+
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  // 所有任务都已完成，之后可以销毁
+  bool done() const {
+    return waiting_.load(std::memory_order_acquire) == kCompleted;
+  }
+
+private:
+  friend class JobSystem;
+
+  static constexpr uintptr_t kCompleted = 1;
+
+  std::atomic<int> pending_{ 0 };
+  // 等待这个计数的任务组成的链表（Job*），归零后为kCompleted
+  std::atomic<uintptr_t> waiting_{ kCompleted };
+};
+
+struct JobWorkerStats {
+  uint64_t executed = 0;
+  // 去其它线程的队列偷任务的次数、成功的次数，以及和其它线程抢同一个任务失败的次数
+  uint64_t steal_attempts = 0;
+  uint64_t steals = 0;
+  uint64_t steal_conflicts = 0;
+  uint64_t sleeps = 0;
+};
+
+struct JobSystemStats {
+  // 下标0是创建JobSystem的线程
+  std::vector<JobWorkerStats> workers;
+  // 非成员线程提交、经过加锁队列的任务数
+  uint64_t injected = 0;
+};
+
+// 每个核心一个工作线程的任务系统。每个线程有一个Chase-Lev双端队列：自己从底部压入和取出，
+// 其它线程从顶部偷，都不加锁。创建JobSystem的线程是0号成员，Wait时也执行任务；
+// 其它非成员线程提交的任务进入加锁的共享队列。
+// 任务内部可以再提交任务、调用ParallelFor和Wait。
+class JobSystem {
+public:
+  using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+  // Run保存的函数对象的最大字节数
+  static constexpr size_t kJobDataSize = 48;
+  // 每个线程队列的容量，压满时任务直接在当前线程执行
+  static constexpr size_t kQueueCapacity = 4096;
+
+  // thread_count包含调用线程，为0时使用硬件线程数
+  explicit JobSystem(unsigned thread_count = 0);
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  unsigned thread_count() const {
+    return static_cast<unsigned>(workers_.size());
+  }
+
+  // 在某个线程上执行func()，完成后counter减一。dependency不为空时等它归零后才开始。
+  // func按值保存在任务里，要求可以平凡复制（捕获引用或指针的lambda），不超过kJobDataSize字节。
+  // 没有工作线程时直接执行
+  template <typename Func>
+  void Run(const Func& func, JobCounter* counter = nullptr, JobCounter* dependency = nullptr) {
+    static_assert(std::is_trivially_copyable<Func>::value, "Job functions must be trivially copyable");
+    static_assert(sizeof(Func) <= kJobDataSize && alignof(Func) <= alignof(std::max_align_t),
+                  "Job function is too large; capture by reference or pointer");
+    Job* job = AllocateJob();
+    job->invoke = [](JobSystem*, Job* self) { (*reinterpret_cast<Func*>(self->data))(); };
+    new (job->data) Func(func);
+    Submit(job, counter, dependency);
+  }
+
+  // 执行队列中的任务直到counter归零
+  void Wait(JobCounter* counter);
+
+  // 把[0, count)切成若干块并行执行func(begin, end)，全部完成后返回。块的起点是grain的整数倍，
+  // 开始时切成约每线程kChunksPerThread块，被其它线程偷走的块继续二分，负载不均时粒度自动变细
+  void ParallelFor(size_t count, size_t grain, const RangeFunc& func);
+
+  // 每块正好grain个（最后一块可能更少），用于按块号保存结果的场合
+  void ParallelForFixed(size_t count, size_t grain, const RangeFunc& func);
+
+  JobSystemStats stats() const;
+  void ResetStats();
+
+private:
+  static constexpr unsigned kExternal = ~0u;
+  static constexpr int kChunksPerThread = 4;
+  // 被偷走的块额外允许二分的次数
+  static constexpr int kStolenSplits = 2;
+
+  struct Job {
+    void (*invoke)(JobSystem* system, Job* job) = nullptr;
+    JobCounter* counter = nullptr;
+    // 空闲链表或等待同一个计数的任务链表
+    Job* next = nullptr;
+    alignas(std::max_align_t) unsigned char data[kJobDataSize];
+  };
+
+  struct RangeJob {
+    const RangeFunc* func;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    // 还可以二分的次数，为负时一直分到grain
+    int splits;
+    unsigned owner;
+  };
+
+  enum class StealResult {
+    kEmpty,
+    kConflict,
+    kSuccess,
+  };
+
+  // Chase-Lev双端队列（Lê等人针对弱内存模型的版本），容量固定
+  class WorkQueue {
+  public:
+    WorkQueue();
+
+    // 只有所属线程调用
+    bool Push(Job* job);
+    Job* Pop();
+
+    // 任意线程调用
+    StealResult Steal(Job** job);
+
+  private:
+    alignas(64) std::atomic<int64_t> top_{ 0 };
+    alignas(64) std::atomic<int64_t> bottom_{ 0 };
+    std::unique_ptr<std::atomic<Job*>[]> buffer_;
+  };
+
+  struct alignas(64) Worker {
+    WorkQueue queue;
+    // 执行完的任务回到执行它的线程的空闲链表，每个链表只被一个线程访问
+    Job* free = nullptr;
+    std::vector<std::unique_ptr<Job[]>> blocks;
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> steal_attempts{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+    std::atomic<uint64_t> steal_conflicts{ 0 };
+    std::atomic<uint64_t> sleeps{ 0 };
+  };
+
+  unsigned Self() const;
+  Job* AllocateJob();
+  void FreeJob(unsigned self, Job* job);
+  Job* AllocateFrom(Job** free, std::vector<std::unique_ptr<Job[]>>* blocks);
+  void Submit(Job* job, JobCounter* counter, JobCounter* dependency);
+  void Push(unsigned self, Job* job);
+  Job* FindJob(unsigned self);
+  void Execute(unsigned self, Job* job);
+  void Complete(unsigned self, JobCounter* counter);
+  void RunRange(RangeJob range, JobCounter* counter);
+  void ParallelForImpl(size_t count, size_t grain, int splits, const RangeFunc& func);
+  void WorkerLoop(unsigned index);
+
+private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // 非成员线程的任务
+  mutable std::mutex external_mutex_;
+  std::deque<Job*> injected_;
+  Job* external_free_ = nullptr;
+  std::vector<std::unique_ptr<Job[]>> external_blocks_;
+  uint64_t injected_total_ = 0;
+  // injected_的长度，不加锁地判断是否为空
+  std::atomic<size_t> injected_size_{ 0 };
+
+  // 所有队列中的任务数，空闲线程据此判断能否睡眠
+  std::atomic<int64_t> queued_{ 0 };
+  std::atomic<int> sleeping_{ 0 };
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<bool> quit_{ false };
+};
+
+}  // namespace utils
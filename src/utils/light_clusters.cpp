@@ -0,0 +1,328 @@
+#include "utils/light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "utils/fps_camera.h"
+#include "utils/profiler.h"
+#include "utils/simd_dispatch.h"
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+namespace {
+
+// 球心到盒子的距离用min/max形式计算：盒子变大时每一项都不会变大，逐级筛选不会漏掉下一级会通过的光源
+inline bool SphereIntersectsBox(float x, float y, float z, float radius, const glm::vec3& box_min,
+                                const glm::vec3& box_max) {
+  float dx = std::max(std::max(box_min.x - x, x - box_max.x), 0.0f);
+  float dy = std::max(std::max(box_min.y - y, y - box_max.y), 0.0f);
+  float dz = std::max(std::max(box_min.z - z, z - box_max.z), 0.0f);
+  return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+size_t SpheresInBoxScalar(const SphereArrays& spheres, size_t begin, size_t end, const uint32_t* ids,
+                          const glm::vec3& box_min, const glm::vec3& box_max, uint32_t* out, size_t out_count) {
+  for (size_t i = begin; i < end; i++) {
+    out[out_count] = ids[i];
+    out_count += SphereIntersectsBox(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i], box_min, box_max)
+                     ? 1 : 0;
+  }
+  return out_count;
+}
+
+#ifdef UTILS_SIMD_SSE
+
+size_t SpheresInBoxSse(const SphereArrays& spheres, size_t count, const uint32_t* ids, const glm::vec3& box_min,
+                       const glm::vec3& box_max, uint32_t* out) {
+  size_t simd_end = count & ~size_t(3);
+  size_t out_count = 0;
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 min_x = _mm_set1_ps(box_min.x);
+  const __m128 min_y = _mm_set1_ps(box_min.y);
+  const __m128 min_z = _mm_set1_ps(box_min.z);
+  const __m128 max_x = _mm_set1_ps(box_max.x);
+  const __m128 max_y = _mm_set1_ps(box_max.y);
+  const __m128 max_z = _mm_set1_ps(box_max.z);
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 x = _mm_loadu_ps(&spheres.x[i]);
+    __m128 y = _mm_loadu_ps(&spheres.y[i]);
+    __m128 z = _mm_loadu_ps(&spheres.z[i]);
+    __m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, x), _mm_sub_ps(x, max_x)), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, y), _mm_sub_ps(y, max_y)), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, z), _mm_sub_ps(z, max_z)), zero);
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius, radius))));
+    while (mask != 0) {
+      out[out_count++] = ids[i + CountTrailingZeros(mask)];
+      mask &= mask - 1;
+    }
+  }
+  return SpheresInBoxScalar(spheres, simd_end, count, ids, box_min, box_max, out, out_count);
+}
+
+#endif  // UTILS_SIMD_SSE
+
+#ifdef UTILS_SIMD_AVX2
+
+UTILS_TARGET_AVX2 size_t SpheresInBoxAvx2(const SphereArrays& spheres, size_t count, const uint32_t* ids,
+                                          const glm::vec3& box_min, const glm::vec3& box_max, uint32_t* out) {
+  size_t simd_end = count & ~size_t(7);
+  size_t out_count = 0;
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 min_x = _mm256_set1_ps(box_min.x);
+  const __m256 min_y = _mm256_set1_ps(box_min.y);
+  const __m256 min_z = _mm256_set1_ps(box_min.z);
+  const __m256 max_x = _mm256_set1_ps(box_max.x);
+  const __m256 max_y = _mm256_set1_ps(box_max.y);
+  const __m256 max_z = _mm256_set1_ps(box_max.z);
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+    __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+    __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+    __m256 radius = _mm256_loadu_ps(&spheres.radius[i]);
+    __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_x, x), _mm256_sub_ps(x, max_x)), zero);
+    __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_y, y), _mm256_sub_ps(y, max_y)), zero);
+    __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_z, z), _mm256_sub_ps(z, max_z)), zero);
+    __m256 distance =
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    __m256 inside = _mm256_cmp_ps(distance, _mm256_mul_ps(radius, radius), _CMP_LE_OQ);
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+    while (mask != 0) {
+      out[out_count++] = ids[i + CountTrailingZeros(mask)];
+      mask &= mask - 1;
+    }
+  }
+  return SpheresInBoxScalar(spheres, simd_end, count, ids, box_min, box_max, out, out_count);
+}
+
+#endif  // UTILS_SIMD_AVX2
+
+// 与盒子相交的球按顺序把ids[i]写入out（容量至少为count），返回数量
+size_t SpheresInBox(const SphereArrays& spheres, size_t count, const uint32_t* ids, const glm::vec3& box_min,
+                    const glm::vec3& box_max, uint32_t* out, CullKernel kernel) {
+  switch (kernel) {
+#ifdef UTILS_SIMD_AVX2
+    case CullKernel::kAvx2:
+      return SpheresInBoxAvx2(spheres, count, ids, box_min, box_max, out);
+#endif
+#ifdef UTILS_SIMD_SSE
+    case CullKernel::kSse:
+      return SpheresInBoxSse(spheres, count, ids, box_min, box_max, out);
+#endif
+    default:
+      return SpheresInBoxScalar(spheres, 0, count, ids, box_min, box_max, out, 0);
+  }
+}
+
+void Gather(const SphereArrays& source, const uint32_t* indices, size_t count, SphereArrays* target) {
+  for (size_t i = 0; i < count; i++) {
+    uint32_t index = indices[i];
+    target->x[i] = source.x[index];
+    target->y[i] = source.y[index];
+    target->z[i] = source.z[index];
+    target->radius[i] = source.radius[index];
+  }
+}
+
+// 观察空间中包住光源影响范围的球：聚光灯为包住光锥的最小球
+Sphere ViewSphere(const glm::mat4& view, const Light& light) {
+  Sphere sphere;
+  sphere.center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+  sphere.radius = light.range;
+  if (light.type == LightType::kSpot) {
+    glm::vec3 direction = glm::vec3(view * glm::vec4(light.direction, 0.0f));
+    float cos_angle = std::max(light.cos_outer, 0.0f);
+    float sin_angle = std::sqrt(1.0f - cos_angle * cos_angle);
+    if (cos_angle < 0.70710678f) {
+      // 超过45度时底面圆决定大小
+      sphere.center += direction * (light.range * cos_angle);
+      sphere.radius = light.range * sin_angle;
+    } else {
+      sphere.radius = light.range / (2.0f * cos_angle);
+      sphere.center += direction * sphere.radius;
+    }
+  }
+  return sphere;
+}
+
+}  // namespace
+
+LightClusterer::LightClusterer(const ClusterGridSize& size) : size_(size), kernel_(BestCullKernel()) {
+  slices_.resize(size_.z);
+  clusters_.assign(static_cast<size_t>(size_.count()) * 2, 0);
+}
+
+void LightClusterer::SetProjection(float fov_y, float aspect, float near_plane, float far_plane) {
+  if (fov_y == fov_y_ && aspect == aspect_ && near_plane == near_plane_ && far_plane == far_plane_) {
+    return;
+  }
+  fov_y_ = fov_y;
+  aspect_ = aspect;
+  near_plane_ = near_plane;
+  far_plane_ = far_plane;
+
+  float log_ratio = std::log(far_plane / near_plane);
+  z_scale_ = static_cast<float>(size_.z) / log_ratio;
+  z_bias_ = static_cast<float>(size_.z) * std::log(near_plane) / log_ratio;
+
+  float tan_y = std::tan(glm::radians(fov_y) * 0.5f);
+  float tan_x = tan_y * aspect;
+  size_t count = size_.count();
+  cluster_min_.resize(count);
+  cluster_max_.resize(count);
+  row_min_.assign(static_cast<size_t>(size_.y) * size_.z, glm::vec3(INFINITY));
+  row_max_.assign(static_cast<size_t>(size_.y) * size_.z, glm::vec3(-INFINITY));
+  slice_min_.assign(size_.z, glm::vec3(INFINITY));
+  slice_max_.assign(size_.z, glm::vec3(-INFINITY));
+
+  for (int z = 0; z < size_.z; z++) {
+    float depth0 = near_plane * std::pow(far_plane / near_plane, static_cast<float>(z) / size_.z);
+    float depth1 = near_plane * std::pow(far_plane / near_plane, static_cast<float>(z + 1) / size_.z);
+    for (int y = 0; y < size_.y; y++) {
+      float ndc_y0 = -1.0f + 2.0f * y / size_.y;
+      float ndc_y1 = -1.0f + 2.0f * (y + 1) / size_.y;
+      size_t row = static_cast<size_t>(z) * size_.y + y;
+      for (int x = 0; x < size_.x; x++) {
+        float ndc_x0 = -1.0f + 2.0f * x / size_.x;
+        float ndc_x1 = -1.0f + 2.0f * (x + 1) / size_.x;
+        glm::vec3 box_min(INFINITY);
+        glm::vec3 box_max(-INFINITY);
+        for (float depth : {depth0, depth1}) {
+          for (float ndc_x : {ndc_x0, ndc_x1}) {
+            for (float ndc_y : {ndc_y0, ndc_y1}) {
+              glm::vec3 corner(ndc_x * tan_x * depth, ndc_y * tan_y * depth, -depth);
+              box_min = glm::min(box_min, corner);
+              box_max = glm::max(box_max, corner);
+            }
+          }
+        }
+        size_t cluster = ClusterIndex(x, y, z);
+        cluster_min_[cluster] = box_min;
+        cluster_max_[cluster] = box_max;
+        row_min_[row] = glm::min(row_min_[row], box_min);
+        row_max_[row] = glm::max(row_max_[row], box_max);
+      }
+      slice_min_[z] = glm::min(slice_min_[z], row_min_[row]);
+      slice_max_[z] = glm::max(slice_max_[z], row_max_[row]);
+    }
+  }
+}
+
+void LightClusterer::SetProjection(const FpsCamera& camera) {
+  SetProjection(camera.zoom(), camera.aspect(), camera.near_plane(), camera.far_plane());
+}
+
+void LightClusterer::Assign(const glm::mat4& view, const std::vector<Light>& lights, ThreadPool* pool) {
+  PROFILE_SCOPE("LightClusterer::Assign");
+  size_t light_count = lights.size();
+  spheres_.Resize(light_count);
+  all_ids_.resize(light_count);
+  for (size_t i = 0; i < light_count; i++) {
+    spheres_.Set(i, ViewSphere(view, lights[i]));
+    all_ids_[i] = static_cast<uint32_t>(i);
+  }
+
+  if (pool != nullptr) {
+    pool->ParallelFor(size_.z, 1, [this](size_t begin, size_t end) {
+      for (size_t z = begin; z < end; z++) {
+        AssignSlice(static_cast<int>(z), &slices_[z]);
+      }
+    });
+  } else {
+    for (int z = 0; z < size_.z; z++) {
+      AssignSlice(z, &slices_[z]);
+    }
+  }
+
+  size_t total = 0;
+  for (const SliceScratch& slice : slices_) {
+    total += slice.indices.size();
+  }
+  light_indices_.resize(total);
+  size_t offset = 0;
+  size_t clusters_per_slice = static_cast<size_t>(size_.x) * size_.y;
+  for (int z = 0; z < size_.z; z++) {
+    const SliceScratch& slice = slices_[z];
+    if (!slice.indices.empty()) {
+      memcpy(light_indices_.data() + offset, slice.indices.data(), slice.indices.size() * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < clusters_per_slice; i++) {
+      size_t cluster = z * clusters_per_slice + i;
+      clusters_[cluster * 2] = static_cast<uint32_t>(offset);
+      clusters_[cluster * 2 + 1] = slice.counts[i];
+      offset += slice.counts[i];
+    }
+  }
+}
+
+void LightClusterer::AssignSlice(int z, SliceScratch* scratch) const {
+  CullKernel kernel = std::min(kernel_, BestCullKernel());
+  size_t light_count = all_ids_.size();
+  scratch->counts.assign(static_cast<size_t>(size_.x) * size_.y, 0);
+  scratch->indices.clear();
+
+  // 与整个切片相交的光源
+  scratch->slice_ids.resize(light_count);
+  size_t slice_count = SpheresInBox(spheres_, light_count, all_ids_.data(), slice_min_[z], slice_max_[z],
+                                    scratch->slice_ids.data(), kernel);
+  if (slice_count == 0) {
+    return;
+  }
+  scratch->slice_lights.Resize(slice_count);
+  Gather(spheres_, scratch->slice_ids.data(), slice_count, &scratch->slice_lights);
+  scratch->row_lights.Resize(slice_count);
+  scratch->row_ids.resize(slice_count);
+  scratch->row_local.resize(slice_count);
+  scratch->cluster_ids.resize(slice_count);
+  std::vector<uint32_t>& row_local = scratch->row_local;
+  std::vector<uint32_t>& cluster_ids = scratch->cluster_ids;
+
+  // 每行先筛出与这一行相交的光源，再逐簇测试。行内的候选用下标0..n-1表示，
+  // 这样同一个SIMD函数既能输出切片内下标（用于Gather）也能输出光源下标
+  std::vector<uint32_t>& local_ids = scratch->local_ids;
+  for (size_t i = local_ids.size(); i < slice_count; i++) {
+    local_ids.push_back(static_cast<uint32_t>(i));
+  }
+  for (int y = 0; y < size_.y; y++) {
+    size_t row = static_cast<size_t>(z) * size_.y + y;
+    size_t row_count = SpheresInBox(scratch->slice_lights, slice_count, local_ids.data(), row_min_[row],
+                                    row_max_[row], row_local.data(), kernel);
+    if (row_count == 0) {
+      continue;
+    }
+    Gather(scratch->slice_lights, row_local.data(), row_count, &scratch->row_lights);
+    for (size_t i = 0; i < row_count; i++) {
+      scratch->row_ids[i] = scratch->slice_ids[row_local[i]];
+    }
+    for (int x = 0; x < size_.x; x++) {
+      size_t cluster = ClusterIndex(x, y, z);
+      size_t count = SpheresInBox(scratch->row_lights, row_count, scratch->row_ids.data(), cluster_min_[cluster],
+                                  cluster_max_[cluster], cluster_ids.data(), kernel);
+      scratch->counts[static_cast<size_t>(y) * size_.x + x] = static_cast<uint32_t>(count);
+      scratch->indices.insert(scratch->indices.end(), cluster_ids.begin(), cluster_ids.begin() + count);
+    }
+  }
+}
+
+void AssignLightsBruteForce(const LightClusterer& clusterer, std::vector<uint32_t>* clusters,
+                            std::vector<uint32_t>* light_indices) {
+  const SphereArrays& spheres = clusterer.view_spheres();
+  size_t cluster_count = clusterer.size().count();
+  clusters->assign(cluster_count * 2, 0);
+  light_indices->clear();
+  for (size_t cluster = 0; cluster < cluster_count; cluster++) {
+    (*clusters)[cluster * 2] = static_cast<uint32_t>(light_indices->size());
+    for (size_t i = 0; i < spheres.size(); i++) {
+      if (SphereIntersectsBox(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i],
+                              clusterer.cluster_min(cluster), clusterer.cluster_max(cluster))) {
+        light_indices->push_back(static_cast<uint32_t>(i));
+      }
+    }
+    (*clusters)[cluster * 2 + 1] = static_cast<uint32_t>(light_indices->size()) - (*clusters)[cluster * 2];
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "utils/frustum_cull.h"
+
+namespace utils {
+
+class FpsCamera;
+class ThreadPool;
+
+enum class LightType : uint32_t {
+  kPoint = 0,
+  kSpot = 1,
+};
+
+// 世界空间的点光源或聚光灯，range之外没有贡献
+struct Light {
+  LightType type = LightType::kPoint;
+  glm::vec3 position = glm::vec3(0.0f);
+  float range = 1.0f;
+  glm::vec3 color = glm::vec3(1.0f);
+  float intensity = 1.0f;
+  // 只对聚光灯有效：朝向（单位向量）和内外锥角的余弦
+  glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+  float cos_inner = 0.9f;
+  float cos_outer = 0.8f;
+};
+
+// 覆盖视锥体的froxel网格：x、y在屏幕上均分，z在[near, far]上按指数划分
+struct ClusterGridSize {
+  int x = 16;
+  int y = 9;
+  int z = 24;
+
+  int count() const {
+    return x * y * z;
+  }
+};
+
+// CPU上把光源分配到视锥体簇中，不依赖GL，可以在无GPU的环境中测试。
+// 每个簇的光源列表按光源下标升序，判定为光源包围球与簇的观察空间AABB相交（聚光灯用包住光锥的球）。
+// 先按z切片、再按行、最后按簇逐级筛选，每级用SIMD一次测试多个光源；各z切片在线程池中并行处理。
+class LightClusterer {
+public:
+  explicit LightClusterer(const ClusterGridSize& size = ClusterGridSize());
+
+  // 投影参数变化时重新计算各簇的AABB。fov_y为垂直视角（角度）
+  void SetProjection(float fov_y, float aspect, float near_plane, float far_plane);
+  void SetProjection(const FpsCamera& camera);
+
+  // pool为空时在调用线程上执行
+  void Assign(const glm::mat4& view, const std::vector<Light>& lights, ThreadPool* pool = nullptr);
+
+  void set_kernel(CullKernel kernel) {
+    kernel_ = kernel;
+  }
+
+  const ClusterGridSize& size() const {
+    return size_;
+  }
+
+  size_t ClusterIndex(int x, int y, int z) const {
+    return (static_cast<size_t>(z) * size_.y + y) * size_.x + x;
+  }
+
+  // 每个簇两个值：在light_indices中的起始位置和数量
+  const std::vector<uint32_t>& clusters() const {
+    return clusters_;
+  }
+
+  const std::vector<uint32_t>& light_indices() const {
+    return light_indices_;
+  }
+
+  // 观察空间中的簇包围盒
+  const glm::vec3& cluster_min(size_t cluster) const {
+    return cluster_min_[cluster];
+  }
+
+  const glm::vec3& cluster_max(size_t cluster) const {
+    return cluster_max_[cluster];
+  }
+
+  // 着色器中由观察深度d（正数）求z切片：floor(log(d) * z_scale - z_bias)
+  float z_scale() const {
+    return z_scale_;
+  }
+
+  float z_bias() const {
+    return z_bias_;
+  }
+
+  // 光源在观察空间中的包围球，Assign之后有效
+  const SphereArrays& view_spheres() const {
+    return spheres_;
+  }
+
+private:
+  // 每个z切片独立的中间结果，复用内存
+  struct SliceScratch {
+    SphereArrays slice_lights;
+    std::vector<uint32_t> slice_ids;
+    SphereArrays row_lights;
+    std::vector<uint32_t> row_ids;
+    // 行内候选在切片中的下标，和行内的恒等下标0..n-1（只增长，前面的值不变）
+    std::vector<uint32_t> row_local;
+    std::vector<uint32_t> local_ids;
+    std::vector<uint32_t> cluster_ids;
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> indices;
+  };
+
+  void AssignSlice(int z, SliceScratch* scratch) const;
+
+private:
+  ClusterGridSize size_;
+  CullKernel kernel_;
+  float fov_y_ = 0.0f;
+  float aspect_ = 0.0f;
+  float near_plane_ = 0.0f;
+  float far_plane_ = 0.0f;
+  float z_scale_ = 0.0f;
+  float z_bias_ = 0.0f;
+
+  // 簇、行、切片的AABB，上一级是下一级的并集
+  std::vector<glm::vec3> cluster_min_;
+  std::vector<glm::vec3> cluster_max_;
+  std::vector<glm::vec3> row_min_;
+  std::vector<glm::vec3> row_max_;
+  std::vector<glm::vec3> slice_min_;
+  std::vector<glm::vec3> slice_max_;
+
+  SphereArrays spheres_;
+  std::vector<uint32_t> all_ids_;
+  std::vector<SliceScratch> slices_;
+  std::vector<uint32_t> clusters_;
+  std::vector<uint32_t> light_indices_;
+};
+
+// 与LightClusterer判定规则相同的暴力实现（每个光源对每个簇），用于校验
+void AssignLightsBruteForce(const LightClusterer& clusterer, std::vector<uint32_t>* clusters,
+                            std::vector<uint32_t>* light_indices);
+
+}  // namespace utils
@@ -0,0 +1,100 @@
+#include "utils/mapped_ring_buffer.h"
+
+#include "spdlog/spdlog.h"
+#include "utils/metrics.h"
+
+namespace utils {
+
+MappedRingBuffer::~MappedRingBuffer() {
+  Release();
+}
+
+bool MappedRingBuffer::Init(GLenum target, size_t region_size, int region_count) {
+  Release();
+  if (region_size == 0 || region_count <= 0) {
+    SPDLOG_ERROR("Invalid ring buffer size: {} x {}", region_count, region_size);
+    return false;
+  }
+  target_ = target;
+  region_size_ = region_size;
+  fences_.assign(region_count, nullptr);
+  next_ = 0;
+
+  GLsizeiptr total = static_cast<GLsizeiptr>(region_size * region_count);
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(target_, buffer_);
+  persistent_ = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+  if (persistent_) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target_, total, nullptr, flags);
+    base_ = static_cast<char*>(glMapBufferRange(target_, 0, total, flags));
+    if (base_ == nullptr) {
+      SPDLOG_ERROR("Failed to map ring buffer persistently.");
+      Release();
+      return false;
+    }
+  } else {
+    glBufferData(target_, total, nullptr, GL_STREAM_DRAW);
+    staging_.resize(total);
+    base_ = staging_.data();
+  }
+  return true;
+}
+
+void MappedRingBuffer::Release() {
+  for (GLsync& fence : fences_) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  fences_.clear();
+  if (buffer_ != 0) {
+    if (persistent_ && base_ != nullptr) {
+      glBindBuffer(target_, buffer_);
+      glUnmapBuffer(target_);
+    }
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+  }
+  base_ = nullptr;
+  staging_.clear();
+}
+
+int MappedRingBuffer::Acquire() {
+  int region = next_;
+  next_ = (next_ + 1) % region_count();
+
+  GLsync& fence = fences_[region];
+  if (fence != nullptr) {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    if (result == GL_WAIT_FAILED) {
+      SPDLOG_ERROR("glClientWaitSync failed on ring buffer region {}.", region);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  return region;
+}
+
+void MappedRingBuffer::Commit(int region) {
+  if (persistent_) {
+    return;
+  }
+  glBindBuffer(target_, buffer_);
+  glBufferSubData(target_, static_cast<GLintptr>(offset(region)), static_cast<GLsizeiptr>(region_size_),
+                  data(region));
+  RenderMetrics::Get().buffer_upload_bytes.Add(region_size_);
+}
+
+void MappedRingBuffer::Fence(int region) {
+  if (fences_[region] != nullptr) {
+    glDeleteSync(fences_[region]);
+  }
+  fences_[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+}  // namespace utils
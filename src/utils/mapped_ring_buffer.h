@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace utils {
+
+// 分成若干块轮流使用的GL缓冲，CPU（可以是任意线程）写一块的同时GPU读其它块。
+// GL 4.4（或ARB_buffer_storage）时整个缓冲持久、一致地映射，写入即GPU可见；
+// 否则写到CPU内存，Commit时用glBufferSubData整块上传。
+// 除data()指向的内存外，所有函数都只能在GL线程调用。
+class MappedRingBuffer {
+public:
+  MappedRingBuffer() = default;
+  ~MappedRingBuffer();
+
+  MappedRingBuffer(const MappedRingBuffer&) = delete;
+  MappedRingBuffer& operator=(const MappedRingBuffer&) = delete;
+
+  bool Init(GLenum target, size_t region_size, int region_count = 3);
+  void Release();
+
+  // 取下一块用于写入，必要时等待GPU读完它（上一次Fence之前的命令）
+  int Acquire();
+
+  // 写完region，之后的绘制命令可以读取它
+  void Commit(int region);
+
+  // 读取region的命令都已提交，之后的Acquire会等它们执行完
+  void Fence(int region);
+
+  void* data(int region) {
+    return base_ + region * region_size_;
+  }
+
+  // region在缓冲中的字节偏移
+  size_t offset(int region) const {
+    return region * region_size_;
+  }
+
+  GLuint buffer() const {
+    return buffer_;
+  }
+
+  size_t region_size() const {
+    return region_size_;
+  }
+
+  int region_count() const {
+    return static_cast<int>(fences_.size());
+  }
+
+  bool persistent() const {
+    return persistent_;
+  }
+
+private:
+  GLenum target_ = GL_ARRAY_BUFFER;
+  GLuint buffer_ = 0;
+  size_t region_size_ = 0;
+  bool persistent_ = false;
+  char* base_ = nullptr;
+  std::vector<char> staging_;
+  std::vector<GLsync> fences_;
+  int next_ = 0;
+};
+
+}  // namespace utils
@@ -0,0 +1,339 @@
+#include "utils/metrics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#include "spdlog/spdlog.h"
+#include "utils/file_util.h"
+
+namespace utils {
+
+namespace {
+
+const char* const kTypeNames[] = { "counter", "gauge", "histogram" };
+
+double NowSeconds() {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point start = Clock::now();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool ValidName(const std::string& name) {
+  if (name.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < name.size(); i++) {
+    char c = name[i];
+    bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+    if (!letter && (i == 0 || c < '0' || c > '9')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double SlotToDouble(uint64_t bits) {
+  double value = 0.0;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// HELP行中只需转义反斜杠和换行
+void WritePrometheusHelp(FILE* file, const std::string& text) {
+  for (char c : text) {
+    if (c == '\\') {
+      fputs("\\\\", file);
+    } else if (c == '\n') {
+      fputs("\\n", file);
+    } else {
+      fputc(c, file);
+    }
+  }
+}
+
+// 写到path.tmp，成功后替换path
+template <typename Writer>
+bool WriteFileAtomically(const std::string& path, Writer&& writer) {
+  std::string temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) {
+    SPDLOG_ERROR("Failed to open metrics file: {}", temp_path);
+    return false;
+  }
+  writer(file);
+  bool ok = ferror(file) == 0;
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    SPDLOG_ERROR("Failed to write metrics file: {}", temp_path);
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    SPDLOG_ERROR("Failed to replace metrics file {}: {}", path, error.message());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+MetricsRegistry& MetricsRegistry::Instance() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+MetricsRegistry::MetricsRegistry() = default;
+
+std::atomic<uint64_t>* MetricsRegistry::RegisterThread() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads_.push_back(std::make_unique<ThreadBuffer>());
+  tls_slots_ = threads_.back()->slots;
+  return tls_slots_;
+}
+
+MetricsRegistry::Metric* MetricsRegistry::FindOrAdd(const std::string& name, const std::string& help,
+                                                     MetricType type, uint32_t slot_count,
+                                                     const std::vector<double>& bounds) {
+  for (Metric& metric : metrics_) {
+    if (metric.name != name) {
+      continue;
+    }
+    if (metric.type != type || metric.bounds != bounds) {
+      SPDLOG_ERROR("Metric {} is already registered as a {}", name,
+                   kTypeNames[static_cast<size_t>(metric.type)]);
+      return nullptr;
+    }
+    return &metric;
+  }
+
+  if (!ValidName(name)) {
+    SPDLOG_ERROR("Invalid metric name: {}", name);
+    return nullptr;
+  }
+  if (next_slot_ + slot_count > kMaxSlots) {
+    SPDLOG_ERROR("Out of metric slots registering {}", name);
+    return nullptr;
+  }
+
+  Metric& metric = metrics_.emplace_back();
+  metric.name = name;
+  metric.help = help;
+  metric.type = type;
+  metric.slot = next_slot_;
+  metric.bounds = bounds;
+  next_slot_ += slot_count;
+  return &metric;
+}
+
+Counter MetricsRegistry::RegisterCounter(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Metric* metric = FindOrAdd(name, help, MetricType::kCounter, 1, {});
+  return metric != nullptr ? Counter(metric->slot) : Counter();
+}
+
+Gauge MetricsRegistry::RegisterGauge(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Metric* metric = FindOrAdd(name, help, MetricType::kGauge, 0, {});
+  return metric != nullptr ? Gauge(&metric->gauge) : Gauge();
+}
+
+Histogram MetricsRegistry::RegisterHistogram(const std::string& name, const std::string& help,
+                                             const std::vector<double>& bounds) {
+  if (bounds.size() > kMaxHistogramBounds) {
+    SPDLOG_ERROR("Histogram {} has {} bounds, at most {} are allowed", name, bounds.size(), kMaxHistogramBounds);
+    return Histogram();
+  }
+  for (size_t i = 1; i < bounds.size(); i++) {
+    if (!(bounds[i - 1] < bounds[i])) {
+      SPDLOG_ERROR("Histogram {} bounds must be strictly increasing", name);
+      return Histogram();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto bound_count = static_cast<uint32_t>(bounds.size());
+  // 各桶计数和一个样本和
+  Metric* metric = FindOrAdd(name, help, MetricType::kHistogram, bound_count + 2, bounds);
+  return metric != nullptr ? Histogram(metric->slot, metric->bounds.data(), bound_count) : Histogram();
+}
+
+uint64_t MetricsRegistry::SumSlot(uint32_t slot) const {
+  uint64_t total = 0;
+  for (const auto& thread : threads_) {
+    total += thread->slots[slot].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void MetricsRegistry::EndFrame() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (samples_.size() < metrics_.size()) {
+    const Metric& metric = metrics_[samples_.size()];
+    MetricSample& sample = samples_.emplace_back();
+    sample.name = metric.name;
+    sample.help = metric.help;
+    sample.type = metric.type;
+    sample.bounds = metric.bounds;
+    sample.history.assign(kHistorySize, 0.0f);
+    if (metric.type == MetricType::kHistogram) {
+      sample.cumulative.assign(metric.bounds.size() + 1, 0);
+    }
+  }
+
+  for (size_t i = 0; i < metrics_.size(); i++) {
+    Metric& metric = metrics_[i];
+    MetricSample& sample = samples_[i];
+    switch (metric.type) {
+      case MetricType::kCounter: {
+        uint64_t total = SumSlot(metric.slot);
+        sample.value = static_cast<double>(total);
+        sample.frame_value = static_cast<double>(total - metric.last_count);
+        metric.last_count = total;
+        break;
+      }
+      case MetricType::kGauge:
+        sample.value = static_cast<double>(metric.gauge.load(std::memory_order_relaxed));
+        sample.frame_value = sample.value;
+        break;
+      case MetricType::kHistogram: {
+        auto buckets = static_cast<uint32_t>(metric.bounds.size() + 1);
+        uint64_t count = 0;
+        for (uint32_t bucket = 0; bucket < buckets; bucket++) {
+          count += SumSlot(metric.slot + bucket);
+          sample.cumulative[bucket] = count;
+        }
+        double sum = 0.0;
+        for (const auto& thread : threads_) {
+          sum += SlotToDouble(thread->slots[metric.slot + buckets].load(std::memory_order_relaxed));
+        }
+        sample.value = static_cast<double>(count);
+        sample.frame_value = static_cast<double>(count - metric.last_count);
+        sample.sum = sum;
+        metric.last_count = count;
+        break;
+      }
+    }
+    sample.history[history_offset_] = static_cast<float>(sample.frame_value);
+  }
+  history_offset_ = (history_offset_ + 1) % kHistorySize;
+  frame_index_++;
+}
+
+bool WriteMetricsPrometheus(const MetricsRegistry& registry, const std::string& path) {
+  return WriteFileAtomically(path, [&registry](FILE* file) {
+    for (size_t i = 0; i < registry.metric_count(); i++) {
+      const MetricSample& sample = registry.metric(i);
+      const char* name = sample.name.c_str();
+      if (!sample.help.empty()) {
+        fprintf(file, "# HELP %s ", name);
+        WritePrometheusHelp(file, sample.help);
+        fputc('\n', file);
+      }
+      fprintf(file, "# TYPE %s %s\n", name, kTypeNames[static_cast<size_t>(sample.type)]);
+      if (sample.type != MetricType::kHistogram) {
+        fprintf(file, "%s %.17g\n", name, sample.value);
+        continue;
+      }
+      for (size_t bucket = 0; bucket < sample.cumulative.size(); bucket++) {
+        if (bucket < sample.bounds.size()) {
+          fprintf(file, "%s_bucket{le=\"%.17g\"} %llu\n", name, sample.bounds[bucket],
+                  static_cast<unsigned long long>(sample.cumulative[bucket]));
+        } else {
+          fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", name,
+                  static_cast<unsigned long long>(sample.cumulative[bucket]));
+        }
+      }
+      fprintf(file, "%s_sum %.17g\n", name, sample.sum);
+      fprintf(file, "%s_count %.17g\n", name, sample.value);
+    }
+  });
+}
+
+bool WriteMetricsJson(const MetricsRegistry& registry, const std::string& path) {
+  return WriteFileAtomically(path, [&registry](FILE* file) {
+    fprintf(file, "{\"frame\": %llu, \"metrics\": [", static_cast<unsigned long long>(registry.frame_index()));
+    for (size_t i = 0; i < registry.metric_count(); i++) {
+      const MetricSample& sample = registry.metric(i);
+      fputs(i == 0 ? "\n  {\"name\": " : ",\n  {\"name\": ", file);
+      WriteJsonString(file, sample.name);
+      fprintf(file, ", \"type\": \"%s\", \"help\": ", kTypeNames[static_cast<size_t>(sample.type)]);
+      WriteJsonString(file, sample.help);
+      fprintf(file, ", \"value\": %.17g, \"frame_value\": %.17g", sample.value, sample.frame_value);
+      if (sample.type == MetricType::kHistogram) {
+        fprintf(file, ", \"sum\": %.17g, \"buckets\": [", sample.sum);
+        for (size_t bucket = 0; bucket < sample.cumulative.size(); bucket++) {
+          fputs(bucket == 0 ? "" : ", ", file);
+          if (bucket < sample.bounds.size()) {
+            fprintf(file, "{\"le\": %.17g, ", sample.bounds[bucket]);
+          } else {
+            fputs("{\"le\": \"+Inf\", ", file);
+          }
+          fprintf(file, "\"count\": %llu}", static_cast<unsigned long long>(sample.cumulative[bucket]));
+        }
+        fputc(']', file);
+      }
+      fputc('}', file);
+    }
+    fputs("\n]}\n", file);
+  });
+}
+
+bool MetricsExporter::Init(const std::string& path, double interval_seconds) {
+  if (path.empty() || !(interval_seconds > 0.0)) {
+    SPDLOG_ERROR("Invalid metrics export: path \"{}\", interval {}", path, interval_seconds);
+    return false;
+  }
+  path_ = path;
+  json_ = std::filesystem::path(path).extension() == ".json";
+  interval_ = interval_seconds;
+  last_export_ = NowSeconds();
+  return true;
+}
+
+void MetricsExporter::Update(const MetricsRegistry& registry) {
+  if (!active() || NowSeconds() - last_export_ < interval_) {
+    return;
+  }
+  Flush(registry);
+}
+
+void MetricsExporter::Flush(const MetricsRegistry& registry) {
+  if (!active()) {
+    return;
+  }
+  last_export_ = NowSeconds();
+  if (json_) {
+    WriteMetricsJson(registry, path_);
+  } else {
+    WriteMetricsPrometheus(registry, path_);
+  }
+}
+
+const RenderMetrics& RenderMetrics::Get() {
+  static const RenderMetrics metrics = [] {
+    MetricsRegistry& registry = MetricsRegistry::Instance();
+    RenderMetrics result;
+    result.draw_calls = registry.RegisterCounter("gl_draw_calls_total", "Draw calls issued through utils");
+    result.state_changes =
+        registry.RegisterCounter("gl_state_changes_total", "Program and texture binds issued through utils");
+    result.buffer_upload_bytes =
+        registry.RegisterCounter("gl_buffer_upload_bytes_total", "Bytes uploaded to vertex, index and data buffers");
+    result.texture_uploads = registry.RegisterCounter("gl_texture_uploads_total", "Images uploaded by LoadTexture");
+    result.texture_upload_bytes =
+        registry.RegisterCounter("gl_texture_upload_bytes_total", "Level 0 bytes uploaded by LoadTexture");
+    result.texture_memory_bytes = registry.RegisterGauge(
+        "gl_texture_memory_bytes", "Texture memory owned by GpuResources and RenderTargetPool");
+    result.shader_compiles = registry.RegisterCounter("gl_shader_compiles_total", "Shader stages compiled");
+    result.shader_compile_failures =
+        registry.RegisterCounter("gl_shader_compile_failures_total", "Shader stages or programs that failed");
+    result.shader_compile_ms = registry.RegisterHistogram("gl_shader_compile_ms", "Compile and link time per program",
+                                                          { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 });
+    return result;
+  }();
+  return metrics;
+}
+
+}  // namespace utils
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+enum class MetricType : uint8_t {
+  kCounter,
+  kGauge,
+  kHistogram,
+};
+
+// 单调递增的计数（绘制调用、上传字节数等）。每个线程累加到自己的槽位，EndFrame时汇总
+class Counter {
+public:
+  Counter() = default;
+
+  void Add(uint64_t value = 1) const;
+
+  bool valid() const {
+    return slot_ != kInvalidSlot;
+  }
+
+private:
+  friend class MetricsRegistry;
+  static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+  explicit Counter(uint32_t slot) : slot_(slot) {}
+
+  uint32_t slot_ = kInvalidSlot;
+};
+
+// 可增可减的当前值（显存占用、存活对象数）。变化不频繁，所有线程共用一个relaxed原子
+class Gauge {
+public:
+  Gauge() = default;
+
+  void Set(int64_t value) const {
+    if (value_ != nullptr) {
+      value_->store(value, std::memory_order_relaxed);
+    }
+  }
+
+  void Add(int64_t delta) const {
+    if (value_ != nullptr) {
+      value_->fetch_add(delta, std::memory_order_relaxed);
+    }
+  }
+
+  bool valid() const {
+    return value_ != nullptr;
+  }
+
+private:
+  friend class MetricsRegistry;
+
+  explicit Gauge(std::atomic<int64_t>* value) : value_(value) {}
+
+  std::atomic<int64_t>* value_ = nullptr;
+};
+
+// 样本分布（编译耗时等），桶的上界在注册时给定，最后一个桶为+Inf。
+// 每个线程累加自己的桶计数和样本和
+class Histogram {
+public:
+  Histogram() = default;
+
+  void Observe(double value) const;
+
+  bool valid() const {
+    return bounds_ != nullptr;
+  }
+
+private:
+  friend class MetricsRegistry;
+
+  Histogram(uint32_t slot, const double* bounds, uint32_t bound_count)
+      : slot_(slot), bound_count_(bound_count), bounds_(bounds) {}
+
+  // 槽位依次为各桶计数（bound_count + 1个）和样本和（double的位模式）
+  uint32_t slot_ = 0;
+  uint32_t bound_count_ = 0;
+  const double* bounds_ = nullptr;
+};
+
+// 最近一次EndFrame汇总的结果
+struct MetricSample {
+  std::string name;
+  std::string help;
+  MetricType type = MetricType::kCounter;
+  // 计数器为累计值，仪表为当前值，直方图为累计样本数
+  double value = 0.0;
+  // 计数器和直方图为最近一帧的增量，仪表与value相同
+  double frame_value = 0.0;
+  // 直方图的桶上界（不含+Inf）、含+Inf的累积计数（Prometheus的le语义）和样本和
+  std::vector<double> bounds;
+  std::vector<uint64_t> cumulative;
+  double sum = 0.0;
+  // 最近kHistorySize帧的frame_value，MetricsRegistry::history_offset()为最旧一项
+  std::vector<float> history;
+};
+
+// 全局指标表。注册可以在任何线程、任何时候进行，同名同类型的重复注册返回同一个指标；
+// 更新只写当前线程的槽位（一次relaxed读和写，没有原子读改写），EndFrame在GL线程汇总所有线程。
+// 名字须符合Prometheus的规则：[a-zA-Z_:][a-zA-Z0-9_:]*
+class MetricsRegistry {
+public:
+  static constexpr size_t kMaxSlots = 2048;
+  static constexpr size_t kMaxHistogramBounds = 16;
+  static constexpr size_t kHistorySize = 240;
+
+  static MetricsRegistry& Instance();
+
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  // 名字不合法、与已有指标类型不同或槽位用完时返回无效的指标（更新什么也不做）
+  Counter RegisterCounter(const std::string& name, const std::string& help);
+  Gauge RegisterGauge(const std::string& name, const std::string& help);
+  // bounds须严格升序，最多kMaxHistogramBounds个
+  Histogram RegisterHistogram(const std::string& name, const std::string& help, const std::vector<double>& bounds);
+
+  // 汇总各线程的槽位，计算每帧增量并记入历史。每帧在GL线程调用一次，稳定状态下不分配内存
+  void EndFrame();
+
+  uint64_t frame_index() const {
+    return frame_index_;
+  }
+
+  // 以下只在调用EndFrame的线程上读取
+  size_t metric_count() const {
+    return samples_.size();
+  }
+
+  const MetricSample& metric(size_t i) const {
+    return samples_[i];
+  }
+
+  size_t history_offset() const {
+    return history_offset_;
+  }
+
+  // 热路径，由Counter/Histogram调用
+  static void AddToSlot(uint32_t slot, uint64_t value) {
+    std::atomic<uint64_t>& target = ThreadSlots()[slot];
+    target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  static void AddToSlot(uint32_t slot, double value) {
+    std::atomic<uint64_t>& target = ThreadSlots()[slot];
+    uint64_t bits = target.load(std::memory_order_relaxed);
+    double sum = 0.0;
+    memcpy(&sum, &bits, sizeof(sum));
+    sum += value;
+    memcpy(&bits, &sum, sizeof(sum));
+    target.store(bits, std::memory_order_relaxed);
+  }
+
+private:
+  struct ThreadBuffer {
+    std::atomic<uint64_t> slots[kMaxSlots];
+  };
+
+  struct Metric {
+    std::string name;
+    std::string help;
+    MetricType type = MetricType::kCounter;
+    uint32_t slot = 0;
+    std::atomic<int64_t> gauge{ 0 };
+    std::vector<double> bounds;
+    // 上一帧汇总的值，用于计算增量
+    uint64_t last_count = 0;
+  };
+
+  MetricsRegistry();
+
+  static std::atomic<uint64_t>* ThreadSlots() {
+    std::atomic<uint64_t>* slots = tls_slots_;
+    return slots != nullptr ? slots : Instance().RegisterThread();
+  }
+
+  std::atomic<uint64_t>* RegisterThread();
+  // 已有同名指标时返回它，类型不同时返回nullptr；否则新建并分配slot_count个槽位。调用时持有mutex_
+  Metric* FindOrAdd(const std::string& name, const std::string& help, MetricType type, uint32_t slot_count,
+                    const std::vector<double>& bounds);
+  uint64_t SumSlot(uint32_t slot) const;
+
+private:
+  inline static thread_local std::atomic<uint64_t>* tls_slots_ = nullptr;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+  // deque保证地址不变，Gauge和Histogram直接指向其中的数据
+  std::deque<Metric> metrics_;
+  uint32_t next_slot_ = 0;
+  // 只由调用EndFrame的线程访问，新注册的指标在EndFrame里追加
+  std::vector<MetricSample> samples_;
+  uint64_t frame_index_ = 0;
+  size_t history_offset_ = 0;
+};
+
+inline void Counter::Add(uint64_t value) const {
+  if (slot_ != kInvalidSlot) {
+    MetricsRegistry::AddToSlot(slot_, value);
+  }
+}
+
+inline void Histogram::Observe(double value) const {
+  if (bounds_ == nullptr) {
+    return;
+  }
+  uint32_t bucket = 0;
+  while (bucket < bound_count_ && value > bounds_[bucket]) {
+    bucket++;
+  }
+  MetricsRegistry::AddToSlot(slot_ + bucket, uint64_t{ 1 });
+  MetricsRegistry::AddToSlot(slot_ + bound_count_ + 1, value);
+}
+
+// Prometheus文本格式，可以交给node_exporter的textfile collector。先写临时文件再改名，读取方不会看到半个文件
+bool WriteMetricsPrometheus(const MetricsRegistry& registry, const std::string& path);
+
+// {"frame": N, "metrics": [{"name", "type", "help", "value", "frame_value", ...}]}
+bool WriteMetricsJson(const MetricsRegistry& registry, const std::string& path);
+
+// 每隔interval秒把指标写入文件，扩展名为.json时写JSON，否则写Prometheus文本
+class MetricsExporter {
+public:
+  bool Init(const std::string& path, double interval_seconds);
+
+  // EndFrame之后调用，到时间才写文件
+  void Update(const MetricsRegistry& registry);
+
+  // 立即写一次，用于退出前
+  void Flush(const MetricsRegistry& registry);
+
+  bool active() const {
+    return !path_.empty();
+  }
+
+private:
+  std::string path_;
+  bool json_ = false;
+  double interval_ = 1.0;
+  double last_export_ = 0.0;
+};
+
+// 渲染相关的内置指标，第一次调用时注册
+struct RenderMetrics {
+  Counter draw_calls;
+  // 程序、纹理等绑定
+  Counter state_changes;
+  Counter buffer_upload_bytes;
+  Counter texture_uploads;
+  Counter texture_upload_bytes;
+  // GpuResources和RenderTargetPool持有的纹理
+  Gauge texture_memory_bytes;
+  Counter shader_compiles;
+  Counter shader_compile_failures;
+  Histogram shader_compile_ms;
+
+  static const RenderMetrics& Get();
+};
+
+}  // namespace utils
@@ -0,0 +1,82 @@
+#include "utils/metrics_overlay.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "imgui/imgui.h"
+
+namespace utils {
+
+namespace {
+
+const char* const kTypeNames[] = { "counter", "gauge", "histogram" };
+
+void DrawHistory(const MetricSample& sample, size_t offset) {
+  float max_value = 0.0f;
+  float sum = 0.0f;
+  for (float value : sample.history) {
+    max_value = std::max(max_value, value);
+    sum += value;
+  }
+  char overlay[96];
+  snprintf(overlay, sizeof(overlay), "avg %.1f  max %.1f per frame", sum / sample.history.size(), max_value);
+  ImGui::PlotLines("##history", sample.history.data(), static_cast<int>(sample.history.size()),
+                   static_cast<int>(offset), overlay, 0.0f, std::max(max_value * 1.1f, 1.0f), ImVec2(-1.0f, 80.0f));
+}
+
+}  // namespace
+
+void DrawMetricsWindow(MetricsRegistry& registry, bool* open) {
+  if (!ImGui::Begin("Metrics", open)) {
+    ImGui::End();
+    return;
+  }
+
+  static size_t selected = 0;
+  ImGui::Text("frame %llu, %zu metrics", static_cast<unsigned long long>(registry.frame_index()),
+              registry.metric_count());
+  if (selected < registry.metric_count()) {
+    const MetricSample& sample = registry.metric(selected);
+    ImGui::TextUnformatted(sample.name.c_str());
+    DrawHistory(sample, registry.history_offset());
+  }
+
+  ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+  if (ImGui::BeginTable("metrics", 4, flags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Frame", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Total", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+    for (size_t i = 0; i < registry.metric_count(); i++) {
+      const MetricSample& sample = registry.metric(i);
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::PushID(static_cast<int>(i));
+      if (ImGui::Selectable(sample.name.c_str(), selected == i, ImGuiSelectableFlags_SpanAllColumns)) {
+        selected = i;
+      }
+      if (ImGui::IsItemHovered() && !sample.help.empty()) {
+        ImGui::SetTooltip("%s", sample.help.c_str());
+      }
+      ImGui::PopID();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(kTypeNames[static_cast<int>(sample.type)]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.0f", sample.frame_value);
+      ImGui::TableNextColumn();
+      if (sample.type == MetricType::kHistogram && sample.value > 0.0) {
+        // 直方图显示样本数和平均值
+        ImGui::Text("%.0f (avg %.2f)", sample.value, sample.sum / sample.value);
+      } else {
+        ImGui::Text("%.0f", sample.value);
+      }
+    }
+    ImGui::EndTable();
+  }
+
+  ImGui::End();
+}
+
+}  // namespace utils
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "utils/metrics.h"
+
+namespace utils {
+
+// ImGui窗口：所有指标最近一帧的值和累计值，选中的指标显示历史曲线。
+// 读取EndFrame的结果，必须在调用MetricsRegistry::EndFrame的线程上、ImGui::NewFrame和ImGui::Render之间调用
+void DrawMetricsWindow(MetricsRegistry& registry, bool* open = nullptr);
+
+}  // namespace utils
@@ -0,0 +1,474 @@
+#include "utils/occlusion_culler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+#include "utils/profiler.h"
+#include "utils/simd_dispatch.h"
+
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 每个线程任务处理的行数
+constexpr int kBandHeight = 8;
+
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+OccluderMesh SimplifyOccluder(const OccluderMesh& mesh, float cell_size) {
+  // 同一格子内的顶点合并为它们的平均位置
+  std::unordered_map<uint64_t, uint32_t> cells;
+  std::vector<uint32_t> remap(mesh.positions.size());
+  std::vector<glm::vec3> sums;
+  std::vector<uint32_t> counts;
+
+  float inv_cell = 1.0f / cell_size;
+  for (size_t i = 0; i < mesh.positions.size(); i++) {
+    glm::vec3 cell = glm::floor(mesh.positions[i] * inv_cell);
+    uint64_t key = (static_cast<uint64_t>(static_cast<int64_t>(cell.x) & 0x1fffff) << 42) |
+                   (static_cast<uint64_t>(static_cast<int64_t>(cell.y) & 0x1fffff) << 21) |
+                   static_cast<uint64_t>(static_cast<int64_t>(cell.z) & 0x1fffff);
+    auto result = cells.emplace(key, static_cast<uint32_t>(sums.size()));
+    if (result.second) {
+      sums.push_back(glm::vec3(0.0f));
+      counts.push_back(0);
+    }
+    uint32_t cluster = result.first->second;
+    sums[cluster] += mesh.positions[i];
+    counts[cluster]++;
+    remap[i] = cluster;
+  }
+
+  OccluderMesh simplified;
+  simplified.positions.resize(sums.size());
+  for (size_t i = 0; i < sums.size(); i++) {
+    simplified.positions[i] = sums[i] / static_cast<float>(counts[i]);
+  }
+
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    uint32_t a = remap[mesh.indices[i]];
+    uint32_t b = remap[mesh.indices[i + 1]];
+    uint32_t c = remap[mesh.indices[i + 2]];
+    if (a != b && b != c && c != a) {
+      simplified.indices.push_back(a);
+      simplified.indices.push_back(b);
+      simplified.indices.push_back(c);
+    }
+  }
+  return simplified;
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height) {
+  Resize(width, height);
+}
+
+void OcclusionCuller::Resize(int width, int height) {
+  width_ = std::max(4, (width + 3) & ~3);
+  height_ = std::max(1, height);
+  bands_.resize((height_ + kBandHeight - 1) / kBandHeight);
+
+  levels_.clear();
+  int level_width = width_;
+  int level_height = height_;
+  while (true) {
+    Level level;
+    level.width = level_width;
+    level.height = level_height;
+    level.depth.assign(static_cast<size_t>(level_width) * level_height, 1.0f);
+    levels_.push_back(std::move(level));
+    if (level_width == 1 && level_height == 1) {
+      break;
+    }
+    level_width = std::max(1, (level_width + 1) / 2);
+    level_height = std::max(1, (level_height + 1) / 2);
+  }
+}
+
+void OcclusionCuller::BeginFrame(const glm::mat4& view_projection) {
+  view_projection_ = view_projection;
+  occluders_.clear();
+  stats_ = OcclusionStats();
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const glm::mat4& model) {
+  occluders_.push_back({&mesh, model, 0});
+  stats_.occluder_triangles += mesh.triangle_count();
+}
+
+void OcclusionCuller::Rasterize(ThreadPool* pool) {
+  PROFILE_SCOPE("OcclusionCuller::Rasterize");
+  auto start = Clock::now();
+
+  size_t total = 0;
+  for (Occluder& occluder : occluders_) {
+    occluder.first_triangle = total;
+    total += occluder.mesh->triangle_count() * 2;
+  }
+  screen_triangles_.resize(total);
+  occluder_triangle_counts_.assign(occluders_.size(), 0);
+
+  if (pool != nullptr) {
+    pool->ParallelFor(occluders_.size(), 1, [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        TransformOccluder(i);
+      }
+    });
+  } else {
+    for (size_t i = 0; i < occluders_.size(); i++) {
+      TransformOccluder(i);
+    }
+  }
+
+  // 按三角形覆盖的行分到各个带中
+  for (auto& band : bands_) {
+    band.clear();
+  }
+  for (size_t i = 0; i < occluders_.size(); i++) {
+    size_t first = occluders_[i].first_triangle;
+    for (size_t t = first; t < first + occluder_triangle_counts_[i]; t++) {
+      const ScreenTriangle& triangle = screen_triangles_[t];
+      float min_y = std::min({triangle.v[0].y, triangle.v[1].y, triangle.v[2].y});
+      float max_y = std::max({triangle.v[0].y, triangle.v[1].y, triangle.v[2].y});
+      int row0 = std::max(0, static_cast<int>(std::ceil(min_y - 0.5f)));
+      int row1 = std::min(height_ - 1, static_cast<int>(std::floor(max_y - 0.5f)));
+      for (int band = row0 / kBandHeight; row0 <= row1 && band <= row1 / kBandHeight; band++) {
+        bands_[band].push_back(static_cast<uint32_t>(t));
+      }
+    }
+    stats_.rasterized_triangles += occluder_triangle_counts_[i];
+  }
+  stats_.transform_ms = ElapsedMs(start);
+
+  start = Clock::now();
+  if (pool != nullptr) {
+    pool->ParallelFor(bands_.size(), 1, [this](size_t begin, size_t end) {
+      for (size_t band = begin; band < end; band++) {
+        RasterizeBand(band);
+      }
+    });
+  } else {
+    for (size_t band = 0; band < bands_.size(); band++) {
+      RasterizeBand(band);
+    }
+  }
+  BuildHierarchy(pool);
+  stats_.raster_ms = ElapsedMs(start);
+}
+
+void OcclusionCuller::TransformOccluder(size_t occluder_index) {
+  const Occluder& occluder = occluders_[occluder_index];
+  const OccluderMesh& mesh = *occluder.mesh;
+  glm::mat4 mvp = view_projection_ * occluder.model;
+
+  thread_local std::vector<glm::vec4> clip;
+  clip.resize(mesh.positions.size());
+  for (size_t i = 0; i < mesh.positions.size(); i++) {
+    clip[i] = mvp * glm::vec4(mesh.positions[i], 1.0f);
+  }
+
+  ScreenTriangle* out = &screen_triangles_[occluder.first_triangle];
+  size_t count = 0;
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    const glm::vec4* v[3] = {&clip[mesh.indices[i]], &clip[mesh.indices[i + 1]], &clip[mesh.indices[i + 2]]};
+
+    // 三个顶点都在同一个裁剪平面外侧时直接丢弃
+    uint32_t outside_all = 0x3f;
+    uint32_t behind_near = 0;
+    for (const glm::vec4* p : v) {
+      uint32_t outside = (p->x < -p->w ? 1u : 0u) | (p->x > p->w ? 2u : 0u) | (p->y < -p->w ? 4u : 0u) |
+                         (p->y > p->w ? 8u : 0u) | (p->z < -p->w ? 16u : 0u) | (p->z > p->w ? 32u : 0u);
+      outside_all &= outside;
+      behind_near |= outside & 16u;
+    }
+    if (outside_all != 0) {
+      continue;
+    }
+
+    if (behind_near == 0) {
+      EmitTriangle(*v[0], *v[1], *v[2], out, &count);
+      continue;
+    }
+
+    // 只需要裁剪近平面（z + w >= 0），其余平面由屏幕范围限制
+    glm::vec4 polygon[4];
+    int polygon_size = 0;
+    for (int e = 0; e < 3; e++) {
+      const glm::vec4& p = *v[e];
+      const glm::vec4& q = *v[(e + 1) % 3];
+      float dp = p.z + p.w;
+      float dq = q.z + q.w;
+      if (dp >= 0.0f) {
+        polygon[polygon_size++] = p;
+      }
+      if ((dp >= 0.0f) != (dq >= 0.0f)) {
+        polygon[polygon_size++] = p + (q - p) * (dp / (dp - dq));
+      }
+    }
+    for (int k = 1; k + 1 < polygon_size; k++) {
+      EmitTriangle(polygon[0], polygon[k], polygon[k + 1], out, &count);
+    }
+  }
+
+  occluder_triangle_counts_[occluder_index] = count;
+}
+
+void OcclusionCuller::EmitTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, ScreenTriangle* out,
+                                   size_t* count) {
+  ScreenTriangle triangle;
+  const glm::vec4* clip[3] = {&a, &b, &c};
+  for (int i = 0; i < 3; i++) {
+    float inv_w = 1.0f / clip[i]->w;
+    triangle.v[i] = glm::vec3((clip[i]->x * inv_w * 0.5f + 0.5f) * width_, (clip[i]->y * inv_w * 0.5f + 0.5f) * height_,
+                              clip[i]->z * inv_w * 0.5f + 0.5f);
+  }
+
+  // y轴向上，逆时针为正面
+  glm::vec3 e1 = triangle.v[1] - triangle.v[0];
+  glm::vec3 e2 = triangle.v[2] - triangle.v[0];
+  float area = e1.x * e2.y - e1.y * e2.x;
+  if (area == 0.0f || (area < 0.0f && backface_culling_)) {
+    return;
+  }
+  if (area < 0.0f) {
+    std::swap(triangle.v[1], triangle.v[2]);
+  }
+
+  out[(*count)++] = triangle;
+}
+
+void OcclusionCuller::RasterizeBand(size_t band) {
+  int y0 = static_cast<int>(band) * kBandHeight;
+  int y1 = std::min(height_, y0 + kBandHeight);
+  std::fill(levels_[0].depth.begin() + static_cast<size_t>(y0) * width_,
+            levels_[0].depth.begin() + static_cast<size_t>(y1) * width_, 1.0f);
+
+  for (uint32_t index : bands_[band]) {
+    RasterizeTriangle(screen_triangles_[index], y0, y1);
+  }
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle& triangle, int band_y0, int band_y1) {
+  const glm::vec3& v0 = triangle.v[0];
+  const glm::vec3& v1 = triangle.v[1];
+  const glm::vec3& v2 = triangle.v[2];
+
+  // 只处理像素中心落在包围矩形内的像素
+  float min_x = std::min({v0.x, v1.x, v2.x});
+  float max_x = std::max({v0.x, v1.x, v2.x});
+  float min_y = std::min({v0.y, v1.y, v2.y});
+  float max_y = std::max({v0.y, v1.y, v2.y});
+  int col0 = std::max(0, static_cast<int>(std::ceil(min_x - 0.5f)));
+  int col1 = std::min(width_ - 1, static_cast<int>(std::floor(max_x - 0.5f)));
+  int row0 = std::max(band_y0, static_cast<int>(std::ceil(min_y - 0.5f)));
+  int row1 = std::min(band_y1 - 1, static_cast<int>(std::floor(max_y - 0.5f)));
+  if (col0 > col1 || row0 > row1) {
+    return;
+  }
+  col0 &= ~3;
+
+  // 边函数 E(x, y) = A * x + B * y + C，三角形内部三个值都不小于0
+  const glm::vec3* from[3] = {&v1, &v2, &v0};
+  const glm::vec3* to[3] = {&v2, &v0, &v1};
+  float edge_a[3];
+  float edge_b[3];
+  float edge_c[3];
+  for (int e = 0; e < 3; e++) {
+    edge_a[e] = from[e]->y - to[e]->y;
+    edge_b[e] = to[e]->x - from[e]->x;
+    edge_c[e] = -edge_a[e] * from[e]->x - edge_b[e] * from[e]->y;
+  }
+
+  // 深度是屏幕空间的线性函数：z = z0 + w1 * (z1 - z0) + w2 * (z2 - z0)，w1、w2为边1、边2的重心坐标
+  float area = edge_a[0] * v0.x + edge_b[0] * v0.y + edge_c[0];
+  float inv_area = 1.0f / area;
+  float dz1 = (v1.z - v0.z) * inv_area;
+  float dz2 = (v2.z - v0.z) * inv_area;
+  float z_a = dz1 * edge_a[1] + dz2 * edge_a[2];
+  float z_b = dz1 * edge_b[1] + dz2 * edge_b[2];
+  float z_c = v0.z + dz1 * edge_c[1] + dz2 * edge_c[2];
+
+  float* depth = levels_[0].depth.data();
+
+#ifdef UTILS_SIMD_SSE
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  __m128 a[3];
+  __m128 step[3];
+  for (int e = 0; e < 3; e++) {
+    a[e] = _mm_set1_ps(edge_a[e]);
+    step[e] = _mm_set1_ps(edge_a[e] * 4.0f);
+  }
+  __m128 za = _mm_set1_ps(z_a);
+  __m128 z_step = _mm_set1_ps(z_a * 4.0f);
+  __m128 x_start = _mm_add_ps(_mm_set1_ps(static_cast<float>(col0)), lane_offset);
+
+  for (int y = row0; y <= row1; y++) {
+    float yc = static_cast<float>(y) + 0.5f;
+    __m128 e0 = _mm_add_ps(_mm_mul_ps(a[0], x_start), _mm_set1_ps(edge_b[0] * yc + edge_c[0]));
+    __m128 e1 = _mm_add_ps(_mm_mul_ps(a[1], x_start), _mm_set1_ps(edge_b[1] * yc + edge_c[1]));
+    __m128 e2 = _mm_add_ps(_mm_mul_ps(a[2], x_start), _mm_set1_ps(edge_b[2] * yc + edge_c[2]));
+    __m128 z = _mm_add_ps(_mm_mul_ps(za, x_start), _mm_set1_ps(z_b * yc + z_c));
+
+    float* row = depth + static_cast<size_t>(y) * width_;
+    for (int x = col0; x <= col1; x += 4) {
+      __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+      if (_mm_movemask_ps(inside) != 0) {
+        __m128 old_depth = _mm_loadu_ps(row + x);
+        __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(z, old_depth));
+        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, old_depth)));
+      }
+      e0 = _mm_add_ps(e0, step[0]);
+      e1 = _mm_add_ps(e1, step[1]);
+      e2 = _mm_add_ps(e2, step[2]);
+      z = _mm_add_ps(z, z_step);
+    }
+  }
+#else
+  for (int y = row0; y <= row1; y++) {
+    float yc = static_cast<float>(y) + 0.5f;
+    float* row = depth + static_cast<size_t>(y) * width_;
+    for (int x = col0; x <= col1; x++) {
+      float xc = static_cast<float>(x) + 0.5f;
+      bool inside = true;
+      for (int e = 0; e < 3; e++) {
+        inside &= edge_a[e] * xc + edge_b[e] * yc + edge_c[e] >= 0.0f;
+      }
+      float z = z_a * xc + z_b * yc + z_c;
+      if (inside && z < row[x]) {
+        row[x] = z;
+      }
+    }
+  }
+#endif
+}
+
+void OcclusionCuller::BuildHierarchy(ThreadPool* pool) {
+  for (size_t l = 1; l < levels_.size(); l++) {
+    const Level& src = levels_[l - 1];
+    Level& dst = levels_[l];
+    auto downsample = [&src, &dst](size_t begin, size_t end) {
+      for (size_t y = begin; y < end; y++) {
+        int sy0 = static_cast<int>(y) * 2;
+        int sy1 = std::min(sy0 + 1, src.height - 1);
+        for (int x = 0; x < dst.width; x++) {
+          int sx0 = x * 2;
+          int sx1 = std::min(sx0 + 1, src.width - 1);
+          float d = std::max(std::max(src.depth[sy0 * src.width + sx0], src.depth[sy0 * src.width + sx1]),
+                             std::max(src.depth[sy1 * src.width + sx0], src.depth[sy1 * src.width + sx1]));
+          dst.depth[y * dst.width + x] = d;
+        }
+      }
+    };
+
+    // 只有较大的层值得并行
+    if (pool != nullptr && dst.width * dst.height >= 4096) {
+      pool->ParallelFor(dst.height, 16, downsample);
+    } else {
+      downsample(0, dst.height);
+    }
+  }
+}
+
+bool OcclusionCuller::IsVisible(const Aabb& bounds) const {
+  float min_x = FLT_MAX;
+  float min_y = FLT_MAX;
+  float max_x = -FLT_MAX;
+  float max_y = -FLT_MAX;
+  float min_z = FLT_MAX;
+  // 角点的裁剪坐标由最小角点加上各轴方向的增量得到，只需要一次矩阵乘法
+  glm::vec4 origin = view_projection_ * glm::vec4(bounds.min, 1.0f);
+  glm::vec3 size = bounds.max - bounds.min;
+  glm::vec4 dx = view_projection_[0] * size.x;
+  glm::vec4 dy = view_projection_[1] * size.y;
+  glm::vec4 dz = view_projection_[2] * size.z;
+  for (int i = 0; i < 8; i++) {
+    glm::vec4 clip = origin;
+    if (i & 1) {
+      clip += dx;
+    }
+    if (i & 2) {
+      clip += dy;
+    }
+    if (i & 4) {
+      clip += dz;
+    }
+    // 跨过近平面时无法得到可靠的屏幕范围，保守地认为可见
+    if (clip.z < -clip.w || clip.w <= 0.0f) {
+      return true;
+    }
+    float inv_w = 1.0f / clip.w;
+    min_x = std::min(min_x, clip.x * inv_w);
+    max_x = std::max(max_x, clip.x * inv_w);
+    min_y = std::min(min_y, clip.y * inv_w);
+    max_y = std::max(max_y, clip.y * inv_w);
+    min_z = std::min(min_z, clip.z * inv_w);
+  }
+
+  // 包围矩形接触到的所有像素
+  int x0 = static_cast<int>(std::floor((min_x * 0.5f + 0.5f) * width_));
+  int x1 = static_cast<int>(std::floor((max_x * 0.5f + 0.5f) * width_));
+  int y0 = static_cast<int>(std::floor((min_y * 0.5f + 0.5f) * height_));
+  int y1 = static_cast<int>(std::floor((max_y * 0.5f + 0.5f) * height_));
+  if (x1 < 0 || y1 < 0 || x0 >= width_ || y0 >= height_) {
+    return false;
+  }
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, width_ - 1);
+  y1 = std::min(y1, height_ - 1);
+
+  // 选择矩形最多覆盖2x2个texel的层
+  int level = 0;
+  while (level + 1 < level_count() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+    level++;
+  }
+
+  const Level& hiz = levels_[level];
+  float max_depth = 0.0f;
+  for (int y = y0 >> level; y <= (y1 >> level); y++) {
+    for (int x = x0 >> level; x <= (x1 >> level); x++) {
+      max_depth = std::max(max_depth, hiz.depth[y * hiz.width + x]);
+    }
+  }
+
+  float nearest = min_z * 0.5f + 0.5f;
+  return nearest <= max_depth;
+}
+
+size_t OcclusionCuller::FilterVisible(const Aabb* bounds, const uint32_t* candidates, size_t count, uint32_t* visible,
+                                     ThreadPool* pool) {
+  PROFILE_SCOPE("OcclusionCuller::FilterVisible");
+  auto start = Clock::now();
+  visibility_.resize(count);
+  auto test = [this, bounds, candidates](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      visibility_[i] = IsVisible(bounds[candidates[i]]) ? 1 : 0;
+    }
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(count, 1024, test);
+  } else {
+    test(0, count);
+  }
+
+  size_t visible_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    visible[visible_count] = candidates[i];
+    visible_count += visibility_[i];
+  }
+
+  stats_.tested += count;
+  stats_.occluded += count - visible_count;
+  stats_.test_ms += ElapsedMs(start);
+  return visible_count;
+}
+
+}  // namespace utils
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "utils/bounds.h"
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+// 遮挡体只需要位置和索引（三角形列表）。Samples/里的Mirage::Mesh不参与构建，模型数据由调用方转换成这个结构
+struct OccluderMesh {
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> indices;
+
+  size_t triangle_count() const {
+    return indices.size() / 3;
+  }
+};
+
+// 顶点聚类简化，生成遮挡用的低精度模型。cell_size相对模型要足够小，否则轮廓会向外扩张导致误剔除
+OccluderMesh SimplifyOccluder(const OccluderMesh& mesh, float cell_size);
+
+struct OcclusionStats {
+  size_t occluder_triangles = 0;
+  // 经过背面剔除和裁剪后实际光栅化的三角形
+  size_t rasterized_triangles = 0;
+  size_t tested = 0;
+  size_t occluded = 0;
+  double transform_ms = 0.0;
+  double raster_ms = 0.0;
+  double test_ms = 0.0;
+};
+
+// CPU软件遮挡剔除：把少量遮挡体光栅化到低分辨率深度缓冲，再建立最大深度的层级缓冲（Hi-Z），
+// 物体的包围盒在提交绘制前与之比较。深度缓冲按行分带，由线程池并行光栅化。
+// 深度为NDC深度映射到[0, 1]，越小越近。
+class OcclusionCuller {
+public:
+  // 宽度会向上取整到4的倍数（SIMD每次处理4个像素）
+  explicit OcclusionCuller(int width = 256, int height = 128);
+
+  void Resize(int width, int height);
+
+  // 清空深度缓冲和遮挡体
+  void BeginFrame(const glm::mat4& view_projection);
+
+  // mesh在Rasterize之前必须保持有效
+  void AddOccluder(const OccluderMesh& mesh, const glm::mat4& model);
+
+  // 变换、裁剪、光栅化所有遮挡体并建立层级深度
+  void Rasterize(ThreadPool* pool = nullptr);
+
+  // 保守测试：包围盒可能可见时返回true
+  bool IsVisible(const Aabb& bounds) const;
+
+  // 对candidates中的物体做遮挡测试，可见的按原顺序写入visible，返回可见数量
+  size_t FilterVisible(const Aabb* bounds, const uint32_t* candidates, size_t count, uint32_t* visible,
+                       ThreadPool* pool = nullptr);
+
+  void set_backface_culling(bool enable) {
+    backface_culling_ = enable;
+  }
+
+  int width() const {
+    return width_;
+  }
+
+  int height() const {
+    return height_;
+  }
+
+  // 第0层为全分辨率深度，之后每层为上一层2x2的最大值
+  const std::vector<float>& depth(int level = 0) const {
+    return levels_[level].depth;
+  }
+
+  int level_count() const {
+    return static_cast<int>(levels_.size());
+  }
+
+  const OcclusionStats& stats() const {
+    return stats_;
+  }
+
+private:
+  struct Occluder {
+    const OccluderMesh* mesh;
+    glm::mat4 model;
+    // 在screen_triangles_中的起始位置，每个三角形最多被近平面裁成两个
+    size_t first_triangle;
+  };
+
+  // 屏幕空间三角形：x、y为像素坐标，z为[0, 1]深度
+  struct ScreenTriangle {
+    glm::vec3 v[3];
+  };
+
+  struct Level {
+    int width = 0;
+    int height = 0;
+    std::vector<float> depth;
+  };
+
+  void TransformOccluder(size_t occluder_index);
+  void EmitTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, ScreenTriangle* out, size_t* count);
+  void RasterizeBand(size_t band);
+  void RasterizeTriangle(const ScreenTriangle& triangle, int band_y0, int band_y1);
+  void BuildHierarchy(ThreadPool* pool);
+
+private:
+  int width_ = 0;
+  int height_ = 0;
+  bool backface_culling_ = true;
+
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  std::vector<Occluder> occluders_;
+  std::vector<ScreenTriangle> screen_triangles_;
+  std::vector<size_t> occluder_triangle_counts_;
+
+  // 按行分带的三角形列表
+  std::vector<std::vector<uint32_t>> bands_;
+  std::vector<Level> levels_;
+  std::vector<uint8_t> visibility_;
+
+  OcclusionStats stats_;
+};
+
+}  // namespace utils
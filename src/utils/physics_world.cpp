@@ -0,0 +1,237 @@
+#include "utils/physics_world.h"
+
+#include <chrono>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+#include "spdlog/spdlog.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+static_assert(sizeof(btScalar) == sizeof(float), "Instance transforms require Bullet built with float precision");
+
+namespace {
+
+double NowMs() {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+// 把插值后的变换直接写入当前Step的目标内存
+class PhysicsWorld::InstanceMotionState : public btMotionState {
+public:
+  InstanceMotionState(const btTransform& start, float* const* target, int instance)
+      : start_(start), target_(target), instance_(instance) {}
+
+  void getWorldTransform(btTransform& transform) const override {
+    transform = start_;
+  }
+
+  void setWorldTransform(const btTransform& transform) override {
+    transform.getOpenGLMatrix(*target_ + instance_ * 16);
+  }
+
+private:
+  btTransform start_;
+  float* const* target_;
+  int instance_;
+};
+
+// 统计运动状态同步（写实例缓冲）的时间
+class PhysicsWorld::TimedWorld : public btDiscreteDynamicsWorldMt {
+public:
+  using btDiscreteDynamicsWorldMt::btDiscreteDynamicsWorldMt;
+
+  void synchronizeMotionStates() override {
+    double start = NowMs();
+    btDiscreteDynamicsWorldMt::synchronizeMotionStates();
+    sync_ms_ += NowMs() - start;
+  }
+
+  double TakeSyncMs() {
+    double ms = sync_ms_;
+    sync_ms_ = 0.0;
+    return ms;
+  }
+
+private:
+  double sync_ms_ = 0.0;
+};
+
+PhysicsWorld::PhysicsWorld(const PhysicsOptions& options) : options_(options) {}
+
+PhysicsWorld::~PhysicsWorld() {
+  Stop();
+}
+
+int PhysicsWorld::AddBox(const glm::vec3& half_extents, float mass, const glm::vec3& position,
+                         const glm::quat& rotation) {
+  if (thread_.joinable()) {
+    SPDLOG_ERROR("PhysicsWorld::AddBox must be called before Start.");
+    return -1;
+  }
+  int instance = mass > 0.0f ? static_cast<int>(dynamic_count_++) : -1;
+  boxes_.push_back({ half_extents, mass, position, rotation, instance });
+  return instance;
+}
+
+bool PhysicsWorld::Start() {
+  if (thread_.joinable()) {
+    return true;
+  }
+  quit_ = false;
+  init_done_ = false;
+  thread_ = std::thread(&PhysicsWorld::ThreadLoop, this);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return init_done_; });
+  if (!init_ok_) {
+    lock.unlock();
+    Stop();
+    return false;
+  }
+  return true;
+}
+
+void PhysicsWorld::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  request_cv_.notify_one();
+  thread_.join();
+}
+
+void PhysicsWorld::Step(double delta_time, float* transforms) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    step_delta_ = delta_time;
+    step_target_ = transforms;
+    step_pending_ = true;
+  }
+  request_cv_.notify_one();
+}
+
+void PhysicsWorld::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return !step_pending_; });
+}
+
+void PhysicsWorld::ThreadLoop() {
+  bool ok = CreateWorld();
+  std::unique_lock<std::mutex> lock(mutex_);
+  init_ok_ = ok;
+  init_done_ = true;
+  done_cv_.notify_all();
+
+  while (ok) {
+    request_cv_.wait(lock, [this] { return step_pending_ || quit_; });
+    if (quit_) {
+      break;
+    }
+    lock.unlock();
+    RunStep(step_delta_, step_target_);
+    lock.lock();
+    step_pending_ = false;
+    done_cv_.notify_all();
+  }
+  lock.unlock();
+  DestroyWorld();
+}
+
+bool PhysicsWorld::CreateWorld() {
+  // 调度器要在创建多线程世界之前设置
+  btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+  if (scheduler != nullptr) {
+    scheduler_.reset(scheduler);
+    if (options_.solver_threads > 0) {
+      scheduler->setNumThreads(options_.solver_threads);
+    }
+  } else {
+    SPDLOG_WARN("Bullet was built without BULLET2_MULTITHREADING, physics runs single-threaded.");
+    scheduler = btGetSequentialTaskScheduler();
+  }
+  btSetTaskScheduler(scheduler);
+  solver_threads_ = scheduler->getNumThreads();
+
+  btDefaultCollisionConstructionInfo construction_info;
+  construction_info.m_defaultMaxPersistentManifoldPoolSize = static_cast<int>(boxes_.size()) * 4 + 1024;
+  construction_info.m_defaultMaxCollisionAlgorithmPoolSize = static_cast<int>(boxes_.size()) * 4 + 1024;
+  collision_config_ = std::make_unique<btDefaultCollisionConfiguration>(construction_info);
+  dispatcher_ = std::make_unique<btCollisionDispatcherMt>(collision_config_.get());
+  broadphase_ = std::make_unique<btDbvtBroadphase>();
+  solver_pool_ = std::make_unique<btConstraintSolverPoolMt>(solver_threads_);
+  solver_ = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+  world_ = std::make_unique<TimedWorld>(dispatcher_.get(), broadphase_.get(), solver_pool_.get(), solver_.get(),
+                                        collision_config_.get());
+  world_->setGravity(btVector3(options_.gravity.x, options_.gravity.y, options_.gravity.z));
+  // 实例缓冲是轮换使用的多块内存，休眠的刚体也要每次写入
+  world_->setSynchronizeAllMotionStates(true);
+
+  for (const BoxDesc& box : boxes_) {
+    shapes_.push_back(std::make_unique<btBoxShape>(btVector3(box.half_extents.x, box.half_extents.y,
+                                                             box.half_extents.z)));
+    btCollisionShape* shape = shapes_.back().get();
+
+    btTransform start;
+    start.setOrigin(btVector3(box.position.x, box.position.y, box.position.z));
+    start.setRotation(btQuaternion(box.rotation.x, box.rotation.y, box.rotation.z, box.rotation.w));
+
+    btVector3 inertia(0.0f, 0.0f, 0.0f);
+    btMotionState* motion_state = nullptr;
+    if (box.instance >= 0) {
+      shape->calculateLocalInertia(box.mass, inertia);
+      motion_states_.push_back(std::make_unique<InstanceMotionState>(start, &transforms_, box.instance));
+      motion_state = motion_states_.back().get();
+    }
+    btRigidBody::btRigidBodyConstructionInfo info(box.mass, motion_state, shape, inertia);
+    info.m_startWorldTransform = start;
+    bodies_.push_back(std::make_unique<btRigidBody>(info));
+    world_->addRigidBody(bodies_.back().get());
+  }
+  SPDLOG_INFO("Physics world: {} bodies ({} dynamic), {} solver threads.", boxes_.size(), dynamic_count_,
+              solver_threads_);
+  return true;
+}
+
+void PhysicsWorld::DestroyWorld() {
+  if (world_ != nullptr) {
+    for (const auto& body : bodies_) {
+      world_->removeRigidBody(body.get());
+    }
+  }
+  bodies_.clear();
+  motion_states_.clear();
+  shapes_.clear();
+  world_.reset();
+  solver_.reset();
+  solver_pool_.reset();
+  broadphase_.reset();
+  dispatcher_.reset();
+  collision_config_.reset();
+  btSetTaskScheduler(btGetSequentialTaskScheduler());
+  scheduler_.reset();
+}
+
+void PhysicsWorld::RunStep(double delta_time, float* transforms) {
+  PROFILE_SCOPE("PhysicsStep");
+  transforms_ = transforms;
+  double start = NowMs();
+  int substeps = world_->stepSimulation(static_cast<btScalar>(delta_time), options_.max_substeps,
+                                        static_cast<btScalar>(options_.fixed_step));
+  stats_.substeps = substeps;
+  stats_.step_ms = NowMs() - start;
+  stats_.sync_ms = world_->TakeSyncMs();
+}
+
+}  // namespace utils
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+class btBroadphaseInterface;
+class btCollisionDispatcher;
+class btCollisionShape;
+class btConstraintSolver;
+class btConstraintSolverPoolMt;
+class btDefaultCollisionConfiguration;
+class btDiscreteDynamicsWorld;
+class btITaskScheduler;
+class btMotionState;
+class btRigidBody;
+
+namespace utils {
+
+struct PhysicsOptions {
+  // 固定步长（秒）和一次Step最多推进的步数
+  double fixed_step = 1.0 / 60.0;
+  int max_substeps = 4;
+  // Bullet任务调度器的线程数（包括物理线程自己），0为硬件线程数
+  int solver_threads = 0;
+  glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
+};
+
+struct PhysicsStats {
+  int substeps = 0;
+  // stepSimulation的总时间，包含sync_ms
+  double step_ms = 0.0;
+  // 把刚体变换写入实例缓冲的时间
+  double sync_ms = 0.0;
+};
+
+// Bullet刚体世界，在独立的物理线程上推进，碰撞检测和约束求解使用Bullet的多线程版本
+// （需要Bullet以BULLET2_MULTITHREADING编译，否则退化为单线程）。
+//
+// 每个动态刚体对应实例缓冲中的一个列主序mat4（下标即AddBox的返回值）。
+// Bullet同步运动状态时直接把插值后的变换写到Step传入的内存里（通常是持久映射的GL缓冲），
+// 不经过中间拷贝。用法：
+//   AddBox(...) ...; Start();
+//   每帧：Step(dt, 下一块实例内存); 渲染上一块; Wait();
+class PhysicsWorld {
+public:
+  explicit PhysicsWorld(const PhysicsOptions& options = PhysicsOptions());
+  ~PhysicsWorld();
+
+  PhysicsWorld(const PhysicsWorld&) = delete;
+  PhysicsWorld& operator=(const PhysicsWorld&) = delete;
+
+  // 只能在Start之前调用。mass为0时为静态刚体，不占实例，返回-1；否则返回实例下标
+  int AddBox(const glm::vec3& half_extents, float mass, const glm::vec3& position,
+             const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+
+  // 启动物理线程，Bullet对象都在该线程上创建、使用和销毁
+  bool Start();
+  void Stop();
+
+  // 异步推进delta_time秒（按固定步长，余下的时间用于插值），并把所有动态刚体的变换写入
+  // transforms（instance_count()个mat4）。Wait返回前不能读取transforms，也不能再次调用Step
+  void Step(double delta_time, float* transforms);
+  void Wait();
+
+  size_t instance_count() const {
+    return dynamic_count_;
+  }
+
+  // 最近一次完成的Step的统计，Wait之后读取
+  const PhysicsStats& stats() const {
+    return stats_;
+  }
+
+  int solver_threads() const {
+    return solver_threads_;
+  }
+
+private:
+  struct BoxDesc {
+    glm::vec3 half_extents;
+    float mass;
+    glm::vec3 position;
+    glm::quat rotation;
+    int instance;
+  };
+
+  class InstanceMotionState;
+  class TimedWorld;
+
+  void ThreadLoop();
+  bool CreateWorld();
+  void DestroyWorld();
+  void RunStep(double delta_time, float* transforms);
+
+private:
+  PhysicsOptions options_;
+  std::vector<BoxDesc> boxes_;
+  size_t dynamic_count_ = 0;
+  int solver_threads_ = 1;
+
+  // 以下Bullet对象只在物理线程上访问
+  std::unique_ptr<btDefaultCollisionConfiguration> collision_config_;
+  std::unique_ptr<btCollisionDispatcher> dispatcher_;
+  std::unique_ptr<btBroadphaseInterface> broadphase_;
+  std::unique_ptr<btConstraintSolverPoolMt> solver_pool_;
+  std::unique_ptr<btConstraintSolver> solver_;
+  std::unique_ptr<TimedWorld> world_;
+  std::unique_ptr<btITaskScheduler> scheduler_;
+  std::vector<std::unique_ptr<btCollisionShape>> shapes_;
+  std::vector<std::unique_ptr<InstanceMotionState>> motion_states_;
+  std::vector<std::unique_ptr<btRigidBody>> bodies_;
+  // 运动状态写入的目标，每次Step更新
+  float* transforms_ = nullptr;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable request_cv_;
+  std::condition_variable done_cv_;
+  bool step_pending_ = false;
+  bool quit_ = false;
+  bool init_done_ = false;
+  bool init_ok_ = false;
+  double step_delta_ = 0.0;
+  float* step_target_ = nullptr;
+  PhysicsStats stats_;
+};
+
+}  // namespace utils
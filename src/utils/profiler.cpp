@@ -0,0 +1,375 @@
+#include "utils/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "spdlog/spdlog.h"
+#include "utils/file_util.h"
+
+namespace utils {
+
+// 每个线程一个缓冲：打开的区间栈只由所属线程访问；结束的事件写入环形缓冲，所属线程推进write，
+// EndFrame读到write为止再推进read
+struct Profiler::ThreadBuffer {
+  uint32_t thread = 0;
+  // 线程已退出，可以交给新线程。在threads_mutex_下读写
+  bool released = false;
+  // 栈深度可能超过kMaxDepth，超出部分只计数不记录
+  uint32_t depth = 0;
+  ProfileEvent stack[kMaxDepth];
+
+  std::atomic<uint64_t> write{ 0 };
+  std::atomic<uint64_t> read{ 0 };
+  ProfileEvent events[kMaxThreadEvents];
+};
+
+namespace {
+
+bool EventLess(const ProfileEvent& a, const ProfileEvent& b) {
+  if (a.thread != b.thread) {
+    return a.thread < b.thread;
+  }
+  if (a.start_ns != b.start_ns) {
+    return a.start_ns < b.start_ns;
+  }
+  return a.depth < b.depth;
+}
+
+float ToMs(uint64_t ns) {
+  return static_cast<float>(static_cast<double>(ns) / 1e6);
+}
+
+}  // namespace
+
+Profiler& Profiler::Instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler() : cpu_history_(kHistorySize, 0.0f), gpu_history_(kHistorySize, 0.0f) {
+  NowNs();
+}
+
+// 单例在程序退出时析构，GL上下文通常已经不在了，查询对象由ReleaseGpu释放
+Profiler::~Profiler() = default;
+
+uint64_t Profiler::NowNs() {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point start = Clock::now();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer() {
+  // 线程退出时析构，把缓冲还给Profiler
+  struct Owner {
+    Profiler* profiler = nullptr;
+    ThreadBuffer* buffer = nullptr;
+
+    ~Owner() {
+      if (buffer != nullptr) {
+        profiler->ReleaseThreadBuffer(buffer);
+      }
+    }
+  };
+  thread_local Owner owner;
+  if (owner.buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (const auto& buffer : threads_) {
+      if (buffer->released) {
+        buffer->released = false;
+        owner.buffer = buffer.get();
+        break;
+      }
+    }
+    if (owner.buffer == nullptr) {
+      threads_.push_back(std::make_unique<ThreadBuffer>());
+      owner.buffer = threads_.back().get();
+      owner.buffer->thread = static_cast<uint32_t>(threads_.size() - 1);
+    }
+    owner.profiler = this;
+  }
+  return owner.buffer;
+}
+
+void Profiler::ReleaseThreadBuffer(ThreadBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(threads_mutex_);
+  buffer->depth = 0;
+  buffer->released = true;
+}
+
+const char* Profiler::InternName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(names_mutex_);
+  return names_.insert(name).first->c_str();
+}
+
+void Profiler::BeginCpu(const char* name) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (buffer->depth < kMaxDepth) {
+    ProfileEvent& event = buffer->stack[buffer->depth];
+    event.name = name;
+    event.start_ns = NowNs();
+    event.depth = buffer->depth;
+    event.thread = buffer->thread;
+  }
+  buffer->depth++;
+}
+
+void Profiler::EndCpu() {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (buffer->depth == 0) {
+    return;
+  }
+  buffer->depth--;
+  if (buffer->depth >= kMaxDepth || !in_frame_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  uint64_t write = buffer->write.load(std::memory_order_relaxed);
+  if (write - buffer->read.load(std::memory_order_acquire) == kMaxThreadEvents) {
+    return;
+  }
+  ProfileEvent& event = buffer->events[write % kMaxThreadEvents];
+  event = buffer->stack[buffer->depth];
+  event.end_ns = NowNs();
+  buffer->write.store(write + 1, std::memory_order_release);
+}
+
+void Profiler::BeginFrame() {
+  ResolveGpuFrames();
+
+  frame_start_ns_ = NowNs();
+  in_frame_.store(true, std::memory_order_relaxed);
+
+  GpuFrameSlot& slot = gpu_slots_[frame_index_ % kGpuFrameLatency];
+  if (slot.pending) {
+    // 已经过了kGpuFrameLatency帧结果还没出来，丢弃这一帧，查询对象直接复用
+    SPDLOG_WARN("GPU profiler results for frame {} dropped.", slot.frame_index);
+  }
+  slot.markers.clear();
+  slot.used_queries = 0;
+  slot.frame_index = frame_index_;
+  slot.pending = false;
+  gpu_stack_.clear();
+}
+
+void Profiler::EndFrame() {
+  if (!in_frame_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  in_frame_.store(false, std::memory_order_relaxed);
+
+  cpu_frame_.index = frame_index_;
+  cpu_frame_.start_ns = frame_start_ns_;
+  cpu_frame_.end_ns = NowNs();
+  cpu_frame_.events.clear();
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (const auto& buffer : threads_) {
+      uint64_t read = buffer->read.load(std::memory_order_relaxed);
+      uint64_t write = buffer->write.load(std::memory_order_acquire);
+      for (; read < write; read++) {
+        cpu_frame_.events.push_back(buffer->events[read % kMaxThreadEvents]);
+      }
+      buffer->read.store(read, std::memory_order_release);
+    }
+  }
+  std::sort(cpu_frame_.events.begin(), cpu_frame_.events.end(), EventLess);
+  PushHistory(&cpu_history_, &cpu_history_offset_, ToMs(cpu_frame_.end_ns - cpu_frame_.start_ns));
+
+  if (capturing_) {
+    capture_events_.insert(capture_events_.end(), cpu_frame_.events.begin(), cpu_frame_.events.end());
+  }
+
+  GpuFrameSlot& slot = gpu_slots_[frame_index_ % kGpuFrameLatency];
+  // 没有闭合的GPU区间不要
+  while (!gpu_stack_.empty()) {
+    slot.markers.resize(gpu_stack_.back());
+    gpu_stack_.pop_back();
+  }
+  slot.pending = !slot.markers.empty();
+
+  frame_index_++;
+}
+
+GLuint Profiler::NextGpuQuery(GpuFrameSlot* slot, uint32_t* index) {
+  if (slot->used_queries == slot->queries.size()) {
+    size_t old_size = slot->queries.size();
+    slot->queries.resize(std::max<size_t>(16, old_size * 2));
+    glGenQueries(static_cast<GLsizei>(slot->queries.size() - old_size), slot->queries.data() + old_size);
+  }
+  *index = slot->used_queries++;
+  return slot->queries[*index];
+}
+
+void Profiler::BeginGpu(const char* name) {
+  if (!gpu_initialized_) {
+    gpu_initialized_ = true;
+    gpu_supported_ = GLAD_GL_VERSION_3_3 != 0;
+    if (gpu_supported_) {
+      // 用当前GPU时间戳对齐两个时钟，误差是一次同步调用的时间
+      GLint64 gpu_now = 0;
+      glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+      gpu_offset_ns_ = static_cast<int64_t>(gpu_now) - static_cast<int64_t>(NowNs());
+    } else {
+      SPDLOG_WARN("GL timer queries are not supported, GPU profiling disabled.");
+    }
+  }
+  if (!gpu_supported_ || !in_frame_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // 用时间戳而不是GL_TIME_ELAPSED，因为后者不能嵌套
+  GpuFrameSlot& slot = gpu_slots_[frame_index_ % kGpuFrameLatency];
+  GpuMarker marker;
+  marker.name = name;
+  marker.depth = static_cast<uint32_t>(gpu_stack_.size());
+  glQueryCounter(NextGpuQuery(&slot, &marker.begin_query), GL_TIMESTAMP);
+  marker.end_query = marker.begin_query;
+  gpu_stack_.push_back(slot.markers.size());
+  slot.markers.push_back(marker);
+}
+
+void Profiler::EndGpu() {
+  if (gpu_stack_.empty()) {
+    return;
+  }
+  GpuFrameSlot& slot = gpu_slots_[frame_index_ % kGpuFrameLatency];
+  GpuMarker& marker = slot.markers[gpu_stack_.back()];
+  gpu_stack_.pop_back();
+  glQueryCounter(NextGpuQuery(&slot, &marker.end_query), GL_TIMESTAMP);
+}
+
+void Profiler::ResolveGpuFrames() {
+  resolved_gpu_count_ = 0;
+  if (!gpu_supported_) {
+    return;
+  }
+
+  // 按帧顺序读取，GPU按顺序完成，遇到第一个还没完成的帧就停下
+  uint64_t first = frame_index_ > kGpuFrameLatency ? frame_index_ - kGpuFrameLatency : 0;
+  for (uint64_t frame = first; frame < frame_index_; frame++) {
+    GpuFrameSlot& slot = gpu_slots_[frame % kGpuFrameLatency];
+    if (!slot.pending || slot.frame_index != frame) {
+      continue;
+    }
+
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(slot.queries[slot.used_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+      break;
+    }
+
+    timestamps_.resize(slot.used_queries);
+    for (uint32_t q = 0; q < slot.used_queries; q++) {
+      glGetQueryObjectui64v(slot.queries[q], GL_QUERY_RESULT, &timestamps_[q]);
+    }
+
+    gpu_frame_.index = slot.frame_index;
+    gpu_frame_.events.clear();
+    uint64_t total_ns = 0;
+    for (const GpuMarker& marker : slot.markers) {
+      ProfileEvent event;
+      event.name = marker.name;
+      event.start_ns = static_cast<uint64_t>(static_cast<int64_t>(timestamps_[marker.begin_query]) -
+                                             gpu_offset_ns_);
+      event.end_ns = static_cast<uint64_t>(static_cast<int64_t>(timestamps_[marker.end_query]) - gpu_offset_ns_);
+      event.end_ns = std::max(event.end_ns, event.start_ns);
+      event.depth = marker.depth;
+      event.thread = kGpuThread;
+      gpu_frame_.events.push_back(event);
+      if (marker.depth == 0) {
+        total_ns += event.end_ns - event.start_ns;
+      }
+    }
+    std::sort(gpu_frame_.events.begin(), gpu_frame_.events.end(), EventLess);
+    gpu_frame_.start_ns = gpu_frame_.events.front().start_ns;
+    gpu_frame_.end_ns = gpu_frame_.events.front().end_ns;
+    for (const ProfileEvent& event : gpu_frame_.events) {
+      gpu_frame_.end_ns = std::max(gpu_frame_.end_ns, event.end_ns);
+    }
+    PushHistory(&gpu_history_, &gpu_history_offset_, ToMs(total_ns));
+    if (resolved_gpu_count_ == resolved_gpu_frames_.size()) {
+      resolved_gpu_frames_.emplace_back();
+    }
+    resolved_gpu_frames_[resolved_gpu_count_++] = gpu_frame_;
+
+    if (capturing_) {
+      capture_events_.insert(capture_events_.end(), gpu_frame_.events.begin(), gpu_frame_.events.end());
+    }
+    slot.pending = false;
+  }
+}
+
+void Profiler::ReleaseGpu() {
+  for (GpuFrameSlot& slot : gpu_slots_) {
+    if (!slot.queries.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+    }
+    slot = GpuFrameSlot();
+  }
+  gpu_stack_.clear();
+  gpu_initialized_ = false;
+  gpu_supported_ = false;
+}
+
+void Profiler::PushHistory(std::vector<float>* history, size_t* offset, float value) {
+  (*history)[*offset] = value;
+  *offset = (*offset + 1) % history->size();
+}
+
+void Profiler::StartCapture() {
+  capture_events_.clear();
+  capturing_ = true;
+}
+
+bool Profiler::StopCapture(const std::string& path) {
+  capturing_ = false;
+  bool result = WriteChromeTrace(path, capture_events_);
+  capture_events_.clear();
+  return result;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    SPDLOG_ERROR("Failed to open trace file: {}", path);
+    return false;
+  }
+
+  // 完整事件（ph为X），时间单位为微秒；GPU单独一个线程
+  std::vector<uint32_t> threads;
+  fprintf(file, "{\"traceEvents\":[\n");
+  for (size_t i = 0; i < events.size(); i++) {
+    const ProfileEvent& event = events[i];
+    uint32_t tid = event.thread == kGpuThread ? 0 : event.thread + 1;
+    if (std::find(threads.begin(), threads.end(), tid) == threads.end()) {
+      threads.push_back(tid);
+    }
+    fprintf(file, "{\"name\":");
+    WriteJsonString(file, event.name != nullptr ? event.name : "");
+    fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+            event.thread == kGpuThread ? "gpu" : "cpu", tid, static_cast<double>(event.start_ns) / 1e3,
+            static_cast<double>(event.end_ns - event.start_ns) / 1e3);
+  }
+  std::sort(threads.begin(), threads.end());
+  for (size_t i = 0; i < threads.size(); i++) {
+    uint32_t tid = threads[i];
+    std::string name = tid == 0 ? "GPU" : "CPU " + std::to_string(tid - 1);
+    fprintf(file,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n"
+            "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"sort_index\":%u}},\n",
+            tid, name.c_str(), tid, tid);
+  }
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"LearnOpenGL\"}}\n");
+  fprintf(file, "]}\n");
+
+  bool ok = ferror(file) == 0;
+  fclose(file);
+  if (!ok) {
+    SPDLOG_ERROR("Failed to write trace file: {}", path);
+  }
+  return ok;
+}
+
+}  // namespace utils
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace utils {
+
+// 一个计时区间，时间为相对Profiler创建时刻的纳秒
+struct ProfileEvent {
+  // 必须是生命周期足够长的字符串（通常是字面量）
+  const char* name = nullptr;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  uint32_t depth = 0;
+  // CPU事件为线程序号，GPU事件为kGpuThread
+  uint32_t thread = 0;
+};
+
+// 一帧的结果，事件按线程、开始时间排序
+struct ProfileFrame {
+  uint64_t index = 0;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  std::vector<ProfileEvent> events;
+};
+
+// 帧分析器：CPU标记由任意线程记录，GPU标记用时间戳查询（只能在GL线程调用）。
+// GPU查询按帧放在环形缓冲中，结果在之后的帧里查询到可用时才读取，不会等待GPU。
+//
+// 一般通过PROFILE_SCOPE / GPU_PROFILE_SCOPE宏使用，未定义UTILS_PROFILER时宏为空。
+//
+// CPU事件只在BeginFrame和EndFrame之间记录，不调用PROFILE_BEGIN_FRAME的程序不会积累事件。
+// 每个线程一个固定容量的环形缓冲（单生产者单消费者，无锁、不分配），满了丢弃新事件。
+// 线程退出后缓冲交给之后新建的线程复用，缓冲个数等于同时存在过的最多线程数，随Profiler一起释放
+class Profiler {
+public:
+  static constexpr uint32_t kGpuThread = 0xffffffffu;
+  // 每个线程一帧内最多的CPU事件数和区间嵌套深度，超出的丢弃
+  static constexpr size_t kMaxThreadEvents = 4096;
+  static constexpr size_t kMaxDepth = 64;
+  // 同时在途的GPU帧数
+  static constexpr size_t kGpuFrameLatency = 4;
+  static constexpr size_t kHistorySize = 240;
+
+  static Profiler& Instance();
+
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // 运行时开关，关闭后标记只有一次原子读
+  void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // BeginFrame读回已完成的GPU查询；EndFrame收集各线程的CPU事件。GL线程调用
+  void BeginFrame();
+  void EndFrame();
+
+  void BeginCpu(const char* name);
+  void EndCpu();
+
+  // 返回与Profiler同生命周期的同名字符串，用于运行时生成的区间名（如RenderGraph的pass名）。加锁查表，
+  // 应在创建名字时调用一次并保存结果，不要在每个区间里调用
+  const char* InternName(const std::string& name);
+
+  // 需要GL 3.3的时间戳查询，不支持时什么也不做
+  void BeginGpu(const char* name);
+  void EndGpu();
+
+  // 释放查询对象，必须在GL上下文销毁前调用
+  void ReleaseGpu();
+
+  // 最近一个完整的帧
+  const ProfileFrame& cpu_frame() const {
+    return cpu_frame_;
+  }
+
+  const ProfileFrame& gpu_frame() const {
+    return gpu_frame_;
+  }
+
+  // 最近一次BeginFrame中读回的GPU帧（按帧顺序），GPU落后较多时一次可能读回多帧
+  size_t resolved_gpu_frame_count() const {
+    return resolved_gpu_count_;
+  }
+
+  const ProfileFrame& resolved_gpu_frame(size_t i) const {
+    return resolved_gpu_frames_[i];
+  }
+
+  // 滚动历史（毫秒），offset为最旧一项的位置，可直接传给ImGui::PlotLines
+  const std::vector<float>& cpu_history() const {
+    return cpu_history_;
+  }
+
+  const std::vector<float>& gpu_history() const {
+    return gpu_history_;
+  }
+
+  size_t cpu_history_offset() const {
+    return cpu_history_offset_;
+  }
+
+  size_t gpu_history_offset() const {
+    return gpu_history_offset_;
+  }
+
+  // 采集期间的所有事件导出为Chrome trace_event JSON（chrome://tracing或Perfetto打开）
+  void StartCapture();
+  bool StopCapture(const std::string& path);
+
+  bool capturing() const {
+    return capturing_;
+  }
+
+  static bool WriteChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events);
+
+  static uint64_t NowNs();
+
+private:
+  struct ThreadBuffer;
+
+  struct GpuMarker {
+    const char* name;
+    uint32_t depth;
+    uint32_t begin_query;
+    uint32_t end_query;
+  };
+
+  struct GpuFrameSlot {
+    std::vector<GLuint> queries;
+    std::vector<GpuMarker> markers;
+    uint32_t used_queries = 0;
+    uint64_t frame_index = 0;
+    bool pending = false;
+  };
+
+  Profiler();
+
+  ThreadBuffer* GetThreadBuffer();
+  void ReleaseThreadBuffer(ThreadBuffer* buffer);
+  GLuint NextGpuQuery(GpuFrameSlot* slot, uint32_t* index);
+  void ResolveGpuFrames();
+  static void PushHistory(std::vector<float>* history, size_t* offset, float value);
+
+private:
+  std::atomic<bool> enabled_{ true };
+  uint64_t frame_index_ = 0;
+  uint64_t frame_start_ns_ = 0;
+  // 其它线程在EndCpu里读取
+  std::atomic<bool> in_frame_{ false };
+
+  std::mutex threads_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+
+  // 节点容器，元素地址不变
+  std::mutex names_mutex_;
+  std::unordered_set<std::string> names_;
+
+  // GPU时间戳与CPU时钟的偏移，第一次使用GPU标记时测量
+  bool gpu_supported_ = false;
+  bool gpu_initialized_ = false;
+  int64_t gpu_offset_ns_ = 0;
+  GpuFrameSlot gpu_slots_[kGpuFrameLatency];
+  std::vector<size_t> gpu_stack_;
+
+  ProfileFrame cpu_frame_;
+  ProfileFrame gpu_frame_;
+  // 只增不减，元素的events在各帧之间复用，稳定状态下读回不再分配内存
+  std::vector<ProfileFrame> resolved_gpu_frames_;
+  size_t resolved_gpu_count_ = 0;
+  std::vector<GLuint64> timestamps_;
+  std::vector<float> cpu_history_;
+  std::vector<float> gpu_history_;
+  size_t cpu_history_offset_ = 0;
+  size_t gpu_history_offset_ = 0;
+
+  bool capturing_ = false;
+  std::vector<ProfileEvent> capture_events_;
+};
+
+// RAII的CPU区间
+class ProfileScope {
+public:
+  explicit ProfileScope(const char* name) : active_(Profiler::Instance().enabled()) {
+    if (active_) {
+      Profiler::Instance().BeginCpu(name);
+    }
+  }
+
+  ~ProfileScope() {
+    if (active_) {
+      Profiler::Instance().EndCpu();
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  bool active_;
+};
+
+// RAII的GPU区间，同时记录CPU区间
+class GpuProfileScope {
+public:
+  explicit GpuProfileScope(const char* name) : active_(Profiler::Instance().enabled()) {
+    if (active_) {
+      Profiler::Instance().BeginCpu(name);
+      Profiler::Instance().BeginGpu(name);
+    }
+  }
+
+  ~GpuProfileScope() {
+    if (active_) {
+      Profiler::Instance().EndGpu();
+      Profiler::Instance().EndCpu();
+    }
+  }
+
+  GpuProfileScope(const GpuProfileScope&) = delete;
+  GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+  bool active_;
+};
+
+}  // namespace utils
+
+#define UTILS_PROFILE_CONCAT_INNER(a, b) a##b
+#define UTILS_PROFILE_CONCAT(a, b) UTILS_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef UTILS_PROFILER
+#define PROFILE_SCOPE(name) ::utils::ProfileScope UTILS_PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define GPU_PROFILE_SCOPE(name) ::utils::GpuProfileScope UTILS_PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+#define PROFILE_BEGIN_FRAME() ::utils::Profiler::Instance().BeginFrame()
+#define PROFILE_END_FRAME() ::utils::Profiler::Instance().EndFrame()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define GPU_PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_BEGIN_FRAME() ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#endif
@@ -0,0 +1,141 @@
+#include "utils/profiler_overlay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "imgui/imgui.h"
+
+namespace utils {
+
+namespace {
+
+// 同一父节点下同名的区间合并显示
+struct ProfileNode {
+  const char* name = nullptr;
+  double ms = 0.0;
+  int calls = 0;
+  std::vector<ProfileNode> children;
+};
+
+// events按线程、开始时间排序，每个线程生成一棵树
+std::vector<ProfileNode> BuildTrees(const std::vector<ProfileEvent>& events, std::vector<uint32_t>* threads) {
+  std::vector<ProfileNode> roots;
+  std::vector<ProfileNode*> path;
+  for (size_t i = 0; i < events.size(); i++) {
+    const ProfileEvent& event = events[i];
+    if (i == 0 || event.thread != events[i - 1].thread) {
+      roots.emplace_back();
+      threads->push_back(event.thread);
+      path.clear();
+      path.push_back(&roots.back());
+    }
+    // 区间开始于上一帧时深度可能不连续，挂到最近的祖先上
+    size_t depth = std::min<size_t>(event.depth, path.size() - 1);
+    path.resize(depth + 1);
+
+    ProfileNode* parent = path.back();
+    auto it = std::find_if(parent->children.begin(), parent->children.end(), [&event](const ProfileNode& node) {
+      return node.name == event.name || strcmp(node.name, event.name) == 0;
+    });
+    if (it == parent->children.end()) {
+      parent->children.emplace_back();
+      it = parent->children.end() - 1;
+      it->name = event.name;
+    }
+    it->ms += static_cast<double>(event.end_ns - event.start_ns) / 1e6;
+    it->calls++;
+    path.push_back(&*it);
+  }
+  return roots;
+}
+
+void DrawNode(const ProfileNode& node) {
+  ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
+  if (node.children.empty()) {
+    flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+  }
+  bool open = ImGui::TreeNodeEx(&node, flags, "%s", node.name);
+  ImGui::SameLine(ImGui::GetWindowWidth() * 0.6f);
+  if (node.calls > 1) {
+    ImGui::Text("%7.3f ms x%d", node.ms, node.calls);
+  } else {
+    ImGui::Text("%7.3f ms", node.ms);
+  }
+  if (open && !node.children.empty()) {
+    for (const ProfileNode& child : node.children) {
+      DrawNode(child);
+    }
+    ImGui::TreePop();
+  }
+}
+
+void DrawHistory(const char* label, const std::vector<float>& history, size_t offset) {
+  float max_ms = 0.0f;
+  float sum_ms = 0.0f;
+  for (float ms : history) {
+    max_ms = std::max(max_ms, ms);
+    sum_ms += ms;
+  }
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "avg %.2f ms  max %.2f ms", sum_ms / history.size(), max_ms);
+  ImGui::PlotLines(label, history.data(), static_cast<int>(history.size()), static_cast<int>(offset), overlay, 0.0f,
+                   std::max(max_ms * 1.1f, 1.0f), ImVec2(0.0f, 60.0f));
+}
+
+void DrawFrame(const char* label, const ProfileFrame& frame) {
+  std::vector<uint32_t> threads;
+  std::vector<ProfileNode> roots = BuildTrees(frame.events, &threads);
+  for (size_t i = 0; i < roots.size(); i++) {
+    ImGui::PushID(static_cast<int>(threads[i]));
+    bool open = false;
+    if (threads[i] == Profiler::kGpuThread) {
+      open = ImGui::TreeNodeEx(label, ImGuiTreeNodeFlags_DefaultOpen, "%s", label);
+    } else {
+      open = ImGui::TreeNodeEx(label, ImGuiTreeNodeFlags_DefaultOpen, "%s thread %u", label, threads[i]);
+    }
+    if (open) {
+      for (const ProfileNode& node : roots[i].children) {
+        DrawNode(node);
+      }
+      ImGui::TreePop();
+    }
+    ImGui::PopID();
+  }
+}
+
+}  // namespace
+
+void DrawProfilerWindow(Profiler& profiler, const std::string& trace_path, bool* open) {
+  if (!ImGui::Begin("Profiler", open)) {
+    ImGui::End();
+    return;
+  }
+
+  bool enabled = profiler.enabled();
+  if (ImGui::Checkbox("Enabled", &enabled)) {
+    profiler.set_enabled(enabled);
+  }
+  ImGui::SameLine();
+  if (!profiler.capturing()) {
+    if (ImGui::Button("Start trace")) {
+      profiler.StartCapture();
+    }
+  } else if (ImGui::Button("Stop trace")) {
+    profiler.StopCapture(trace_path);
+  }
+  ImGui::SameLine();
+  ImGui::TextUnformatted(trace_path.c_str());
+
+  DrawHistory("CPU", profiler.cpu_history(), profiler.cpu_history_offset());
+  DrawHistory("GPU", profiler.gpu_history(), profiler.gpu_history_offset());
+
+  ImGui::Separator();
+  DrawFrame("CPU", profiler.cpu_frame());
+  DrawFrame("GPU", profiler.gpu_frame());
+
+  ImGui::End();
+}
+
+}  // namespace utils
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "utils/profiler.h"
+
+namespace utils {
+
+// ImGui窗口：CPU/GPU帧时间曲线、最近一帧的层级耗时，以及开始/停止Chrome trace采集。
+// 必须在ImGui::NewFrame和ImGui::Render之间调用
+void DrawProfilerWindow(Profiler& profiler, const std::string& trace_path, bool* open = nullptr);
+
+}  // namespace utils
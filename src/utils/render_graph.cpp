@@ -0,0 +1,484 @@
+#include "utils/render_graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <sstream>
+
+#include "spdlog/spdlog.h"
+#include "utils/gl_util.h"
+#include "utils/profiler.h"
+
+namespace utils {
+
+namespace {
+
+size_t TextureBytes(const RenderGraphTextureDesc& desc) {
+  return static_cast<size_t>(desc.width) * desc.height * TextureBytesPerPixel(desc.format);
+}
+
+}  // namespace
+
+GLuint RenderPassContext::texture(RenderGraphTexture handle) const {
+  return graph_->ResolveTexture(handle);
+}
+
+const RenderGraphTextureDesc& RenderPassContext::desc(RenderGraphTexture handle) const {
+  return graph_->resources_[handle.resource].desc;
+}
+
+RenderGraph::~RenderGraph() {
+  ReleaseTextures();
+}
+
+void RenderGraph::Reset() {
+  resources_.clear();
+  passes_.clear();
+  order_.clear();
+  physical_descs_.clear();
+  physical_textures_.clear();
+  stats_ = RenderGraphStats();
+  compiled_ = false;
+}
+
+RenderGraphTexture RenderGraph::CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc) {
+  Resource resource;
+  resource.name = name;
+  resource.desc = desc;
+  resource.writers.push_back(-1);
+  resources_.push_back(resource);
+  compiled_ = false;
+  return {static_cast<uint32_t>(resources_.size() - 1), 0};
+}
+
+RenderGraphTexture RenderGraph::ImportTexture(const std::string& name, const RenderGraphTextureDesc& desc,
+                                              GLuint texture) {
+  RenderGraphTexture handle = CreateTexture(name, desc);
+  resources_[handle.resource].imported = true;
+  resources_[handle.resource].imported_texture = texture;
+  return handle;
+}
+
+int RenderGraph::AddPass(const std::string& name, RenderPassFunc execute) {
+  Pass pass;
+  pass.name = name;
+  pass.profile_name = Profiler::Instance().InternName(name);
+  pass.execute = std::move(execute);
+  passes_.push_back(std::move(pass));
+  compiled_ = false;
+  return static_cast<int>(passes_.size() - 1);
+}
+
+void RenderGraph::Read(int pass, RenderGraphTexture texture) {
+  if (pass < 0 || pass >= static_cast<int>(passes_.size()) || !ValidHandle(texture)) {
+    SPDLOG_ERROR("Invalid read of texture {} by pass {}", texture.resource, pass);
+    return;
+  }
+  passes_[pass].reads.push_back(texture);
+  compiled_ = false;
+}
+
+RenderGraphTexture RenderGraph::Write(int pass, RenderGraphTexture texture) {
+  if (pass < 0 || pass >= static_cast<int>(passes_.size()) || !ValidHandle(texture)) {
+    SPDLOG_ERROR("Invalid write of texture {} by pass {}", texture.resource, pass);
+    return {};
+  }
+  Resource& resource = resources_[texture.resource];
+  // 只能在最新版本上写，否则两个写入者的先后无法确定
+  if (texture.version + 1 != resource.writers.size()) {
+    SPDLOG_ERROR("Pass {} writes stale version {} of {}", passes_[pass].name, texture.version, resource.name);
+    return {};
+  }
+  resource.writers.push_back(pass);
+  RenderGraphTexture written{texture.resource, texture.version + 1};
+  passes_[pass].writes.push_back(written);
+  compiled_ = false;
+  return written;
+}
+
+void RenderGraph::SetSideEffect(int pass) {
+  passes_[pass].side_effect = true;
+  compiled_ = false;
+}
+
+bool RenderGraph::ValidHandle(RenderGraphTexture handle) const {
+  return handle.valid() && handle.resource < resources_.size() &&
+         handle.version < resources_[handle.resource].writers.size();
+}
+
+bool RenderGraph::Compile() {
+  PROFILE_SCOPE("RenderGraph::Compile");
+  compiled_ = false;
+  order_.clear();
+  physical_descs_.clear();
+  stats_ = RenderGraphStats();
+  auto pass_count = static_cast<int>(passes_.size());
+  stats_.pass_count = passes_.size();
+
+  // 数据依赖：读取者依赖该版本的写入者，写入者依赖上一版本的写入者
+  std::vector<std::vector<int>> producers(pass_count);
+  for (int pass = 0; pass < pass_count; pass++) {
+    for (const RenderGraphTexture& read : passes_[pass].reads) {
+      int producer = resources_[read.resource].writers[read.version];
+      if (producer >= 0 && producer != pass) {
+        producers[pass].push_back(producer);
+      }
+    }
+    for (const RenderGraphTexture& write : passes_[pass].writes) {
+      int producer = resources_[write.resource].writers[write.version - 1];
+      if (producer >= 0 && producer != pass) {
+        producers[pass].push_back(producer);
+      }
+    }
+  }
+
+  // 从有副作用的pass反向遍历数据依赖，没有被访问到的pass被剔除
+  std::vector<bool> alive(pass_count, false);
+  std::vector<int> stack;
+  for (int pass = 0; pass < pass_count; pass++) {
+    bool root = passes_[pass].side_effect;
+    for (const RenderGraphTexture& write : passes_[pass].writes) {
+      root = root || resources_[write.resource].imported;
+    }
+    if (root) {
+      alive[pass] = true;
+      stack.push_back(pass);
+    }
+  }
+  while (!stack.empty()) {
+    int pass = stack.back();
+    stack.pop_back();
+    for (int producer : producers[pass]) {
+      if (!alive[producer]) {
+        alive[producer] = true;
+        stack.push_back(producer);
+      }
+    }
+  }
+  for (int pass = 0; pass < pass_count; pass++) {
+    passes_[pass].culled = !alive[pass];
+    stats_.culled_passes += alive[pass] ? 0 : 1;
+  }
+
+  // 边：数据依赖，以及读取旧版本的pass必须在下一版本的写入者之前执行
+  std::vector<std::vector<int>> successors(pass_count);
+  std::vector<int> in_degree(pass_count, 0);
+  auto add_edge = [&](int from, int to) {
+    if (alive[from] && alive[to] && from != to) {
+      successors[from].push_back(to);
+      in_degree[to]++;
+    }
+  };
+  for (int pass = 0; pass < pass_count; pass++) {
+    for (int producer : producers[pass]) {
+      add_edge(producer, pass);
+    }
+    for (const RenderGraphTexture& read : passes_[pass].reads) {
+      const Resource& resource = resources_[read.resource];
+      if (read.version + 1 < resource.writers.size()) {
+        add_edge(pass, resource.writers[read.version + 1]);
+      }
+    }
+  }
+
+  // 拓扑排序，可以执行的pass中先执行添加得早的
+  std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+  int alive_count = 0;
+  for (int pass = 0; pass < pass_count; pass++) {
+    if (alive[pass]) {
+      alive_count++;
+      if (in_degree[pass] == 0) {
+        ready.push(pass);
+      }
+    }
+  }
+  while (!ready.empty()) {
+    int pass = ready.top();
+    ready.pop();
+    order_.push_back(pass);
+    for (int successor : successors[pass]) {
+      if (--in_degree[successor] == 0) {
+        ready.push(successor);
+      }
+    }
+  }
+  if (static_cast<int>(order_.size()) != alive_count) {
+    SPDLOG_ERROR("Render graph has a cycle: {} of {} passes ordered", order_.size(), alive_count);
+    order_.clear();
+    return false;
+  }
+
+  // 生命周期：在执行顺序中第一次和最后一次被用到的位置
+  for (Resource& resource : resources_) {
+    resource.first_use = static_cast<int>(order_.size());
+    resource.last_use = -1;
+    resource.physical = -1;
+  }
+  for (int position = 0; position < static_cast<int>(order_.size()); position++) {
+    const Pass& pass = passes_[order_[position]];
+    for (const auto* handles : {&pass.reads, &pass.writes}) {
+      for (const RenderGraphTexture& handle : *handles) {
+        Resource& resource = resources_[handle.resource];
+        resource.first_use = std::min(resource.first_use, position);
+        resource.last_use = std::max(resource.last_use, position);
+      }
+    }
+  }
+
+  // 按第一次使用的顺序分配，描述相同且上一个使用者已经结束的实际纹理直接复用
+  std::vector<uint32_t> transients;
+  for (uint32_t i = 0; i < resources_.size(); i++) {
+    if (!resources_[i].imported && resources_[i].first_use <= resources_[i].last_use) {
+      transients.push_back(i);
+    }
+  }
+  std::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+    return resources_[a].first_use < resources_[b].first_use;
+  });
+  std::vector<int> physical_last_use;
+  for (uint32_t index : transients) {
+    Resource& resource = resources_[index];
+    int best = -1;
+    if (aliasing_) {
+      for (int physical = 0; physical < static_cast<int>(physical_descs_.size()); physical++) {
+        if (physical_descs_[physical] == resource.desc && physical_last_use[physical] < resource.first_use &&
+            (best < 0 || physical_last_use[physical] > physical_last_use[best])) {
+          best = physical;
+        }
+      }
+    }
+    if (best < 0) {
+      best = static_cast<int>(physical_descs_.size());
+      physical_descs_.push_back(resource.desc);
+      physical_last_use.push_back(-1);
+      stats_.bytes_with_aliasing += TextureBytes(resource.desc);
+    }
+    resource.physical = best;
+    physical_last_use[best] = resource.last_use;
+    stats_.bytes_without_aliasing += TextureBytes(resource.desc);
+  }
+  stats_.transient_textures = transients.size();
+  stats_.physical_textures = physical_descs_.size();
+
+  // 同时存活的纹理大小之和的最大值，是任何复用方式的下界
+  std::vector<int64_t> live_delta(order_.size() + 1, 0);
+  for (uint32_t index : transients) {
+    const Resource& resource = resources_[index];
+    live_delta[resource.first_use] += static_cast<int64_t>(TextureBytes(resource.desc));
+    live_delta[resource.last_use + 1] -= static_cast<int64_t>(TextureBytes(resource.desc));
+  }
+  int64_t live_bytes = 0;
+  for (int64_t delta : live_delta) {
+    live_bytes += delta;
+    stats_.peak_live_bytes = std::max(stats_.peak_live_bytes, static_cast<size_t>(live_bytes));
+  }
+
+  compiled_ = true;
+  return true;
+}
+
+void RenderGraph::Execute() {
+  PROFILE_SCOPE("RenderGraph::Execute");
+  if (!compiled_) {
+    SPDLOG_ERROR("Render graph must be compiled before execution.");
+    return;
+  }
+  for (PooledTexture& pooled : texture_pool_) {
+    pooled.in_use = false;
+  }
+  physical_textures_.clear();
+  for (const RenderGraphTextureDesc& desc : physical_descs_) {
+    physical_textures_.push_back(AcquireTexture(desc));
+  }
+
+  GLint output_framebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output_framebuffer);
+  RenderPassContext context(this);
+  for (int index : order_) {
+    const Pass& pass = passes_[index];
+    PROFILE_SCOPE(pass.profile_name);
+    std::vector<GLuint> colors;
+    GLuint depth = 0;
+    bool depth_stencil = false;
+    bool to_output = false;
+    for (const RenderGraphTexture& write : pass.writes) {
+      const Resource& resource = resources_[write.resource];
+      GLuint texture = ResolveTexture(write);
+      if (resource.imported && texture == 0) {
+        to_output = true;
+      } else if (IsDepthFormat(resource.desc.format)) {
+        depth = texture;
+        depth_stencil = resource.desc.format == GL_DEPTH24_STENCIL8 || resource.desc.format == GL_DEPTH32F_STENCIL8;
+      } else {
+        colors.push_back(texture);
+      }
+    }
+    if (to_output) {
+      glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output_framebuffer));
+    } else if (!pass.writes.empty()) {
+      glBindFramebuffer(GL_FRAMEBUFFER, GetFramebuffer(colors, depth, depth_stencil));
+    }
+    if (!pass.writes.empty()) {
+      const RenderGraphTextureDesc& desc = resources_[pass.writes.front().resource].desc;
+      glViewport(0, 0, desc.width, desc.height);
+    }
+    if (pass.execute) {
+      pass.execute(context);
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(output_framebuffer));
+
+  // 删除长时间没有用到的纹理，以及引用它们的帧缓冲
+  for (size_t i = 0; i < texture_pool_.size();) {
+    PooledTexture& pooled = texture_pool_[i];
+    if (!pooled.in_use && frame_ - pooled.last_used_frame > kMaxIdleFrames) {
+      GLuint texture = pooled.texture;
+      for (size_t j = 0; j < framebuffers_.size();) {
+        const std::vector<GLuint>& attachments = framebuffers_[j].attachments;
+        if (std::find(attachments.begin(), attachments.end(), texture) != attachments.end()) {
+          glDeleteFramebuffers(1, &framebuffers_[j].framebuffer);
+          framebuffers_[j] = framebuffers_.back();
+          framebuffers_.pop_back();
+        } else {
+          j++;
+        }
+      }
+      glDeleteTextures(1, &texture);
+      pooled = texture_pool_.back();
+      texture_pool_.pop_back();
+    } else {
+      i++;
+    }
+  }
+  frame_++;
+}
+
+void RenderGraph::ReleaseTextures() {
+  for (CachedFramebuffer& cached : framebuffers_) {
+    glDeleteFramebuffers(1, &cached.framebuffer);
+  }
+  framebuffers_.clear();
+  for (PooledTexture& pooled : texture_pool_) {
+    glDeleteTextures(1, &pooled.texture);
+  }
+  texture_pool_.clear();
+  physical_textures_.clear();
+}
+
+GLuint RenderGraph::AcquireTexture(const RenderGraphTextureDesc& desc) {
+  for (PooledTexture& pooled : texture_pool_) {
+    if (!pooled.in_use && pooled.desc == desc) {
+      pooled.in_use = true;
+      pooled.last_used_frame = frame_;
+      return pooled.texture;
+    }
+  }
+
+  PooledTexture pooled;
+  pooled.desc = desc;
+  pooled.in_use = true;
+  pooled.last_used_frame = frame_;
+  glGenTextures(1, &pooled.texture);
+  glBindTexture(GL_TEXTURE_2D, pooled.texture);
+  GLenum format = GL_RGBA;
+  GLenum type = GL_FLOAT;
+  TextureUploadFormat(desc.format, &format, &type);
+  glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(desc.format), desc.width, desc.height, 0, format, type, nullptr);
+  GLint filter = IsDepthFormat(desc.format) ? GL_NEAREST : GL_LINEAR;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  texture_pool_.push_back(pooled);
+  return pooled.texture;
+}
+
+GLuint RenderGraph::GetFramebuffer(const std::vector<GLuint>& colors, GLuint depth, bool depth_stencil) {
+  std::vector<GLuint> attachments = colors;
+  attachments.push_back(depth);
+  for (const CachedFramebuffer& cached : framebuffers_) {
+    if (cached.attachments == attachments) {
+      return cached.framebuffer;
+    }
+  }
+
+  CachedFramebuffer cached;
+  cached.attachments = attachments;
+  glGenFramebuffers(1, &cached.framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, cached.framebuffer);
+  std::vector<GLenum> draw_buffers;
+  for (size_t i = 0; i < colors.size(); i++) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i), GL_TEXTURE_2D, colors[i], 0);
+    draw_buffers.push_back(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+  }
+  if (depth != 0) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, depth_stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                           GL_TEXTURE_2D, depth, 0);
+  }
+  if (draw_buffers.empty()) {
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  } else {
+    glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+  }
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    SPDLOG_ERROR("Render graph framebuffer is incomplete: {:#x}", status);
+  }
+  framebuffers_.push_back(cached);
+  return cached.framebuffer;
+}
+
+GLuint RenderGraph::ResolveTexture(RenderGraphTexture handle) const {
+  if (!ValidHandle(handle)) {
+    return 0;
+  }
+  const Resource& resource = resources_[handle.resource];
+  if (resource.imported) {
+    return resource.imported_texture;
+  }
+  if (resource.physical < 0 || resource.physical >= static_cast<int>(physical_textures_.size())) {
+    return 0;
+  }
+  return physical_textures_[resource.physical];
+}
+
+std::string RenderGraph::Describe() const {
+  std::ostringstream out;
+  out << "passes (" << order_.size() << " executed, " << stats_.culled_passes << " culled):\n";
+  for (size_t position = 0; position < order_.size(); position++) {
+    const Pass& pass = passes_[order_[position]];
+    out << "  " << position << ": " << pass.name << " reads [";
+    for (size_t i = 0; i < pass.reads.size(); i++) {
+      out << (i > 0 ? ", " : "") << resources_[pass.reads[i].resource].name << "#" << pass.reads[i].version;
+    }
+    out << "] writes [";
+    for (size_t i = 0; i < pass.writes.size(); i++) {
+      out << (i > 0 ? ", " : "") << resources_[pass.writes[i].resource].name << "#" << pass.writes[i].version;
+    }
+    out << "]\n";
+  }
+  for (const Pass& pass : passes_) {
+    if (pass.culled) {
+      out << "  culled: " << pass.name << "\n";
+    }
+  }
+  out << "textures:\n";
+  for (const Resource& resource : resources_) {
+    out << "  " << resource.name << " " << resource.desc.width << "x" << resource.desc.height << " ";
+    if (resource.imported) {
+      out << "imported\n";
+    } else if (resource.physical < 0) {
+      out << "unused\n";
+    } else {
+      out << "-> physical " << resource.physical << " [" << resource.first_use << ", " << resource.last_use << "]\n";
+    }
+  }
+  out << "transient memory: " << stats_.bytes_without_aliasing / 1024 << " KB without aliasing, "
+      << stats_.bytes_with_aliasing / 1024 << " KB with aliasing (" << stats_.transient_textures << " -> "
+      << stats_.physical_textures << " textures), peak live " << stats_.peak_live_bytes / 1024 << " KB";
+  return out.str();
+}
+
+}  // namespace utils
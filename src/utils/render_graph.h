@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace utils {
+
+struct RenderGraphTextureDesc {
+  int width = 0;
+  int height = 0;
+  GLenum format = GL_RGBA8;
+
+  bool operator==(const RenderGraphTextureDesc& other) const {
+    return width == other.width && height == other.height && format == other.format;
+  }
+};
+
+// 纹理的某个版本：每次Write产生一个新版本，Read读取指定版本，依赖关系由版本决定
+struct RenderGraphTexture {
+  static constexpr uint32_t kInvalid = 0xffffffffu;
+
+  uint32_t resource = kInvalid;
+  uint32_t version = 0;
+
+  bool valid() const {
+    return resource != kInvalid;
+  }
+};
+
+struct RenderGraphStats {
+  size_t pass_count = 0;
+  size_t culled_passes = 0;
+  // 被保留的pass用到的临时纹理数量，以及实际分配的纹理数量
+  size_t transient_textures = 0;
+  size_t physical_textures = 0;
+  // 每个临时纹理单独分配时的总大小、按生命周期复用后的总大小、任意时刻同时存活的纹理大小之和的最大值
+  size_t bytes_without_aliasing = 0;
+  size_t bytes_with_aliasing = 0;
+  size_t peak_live_bytes = 0;
+};
+
+class RenderGraph;
+
+// pass执行时查询纹理对象
+class RenderPassContext {
+public:
+  GLuint texture(RenderGraphTexture handle) const;
+  const RenderGraphTextureDesc& desc(RenderGraphTexture handle) const;
+
+private:
+  friend class RenderGraph;
+
+  explicit RenderPassContext(const RenderGraph* graph) : graph_(graph) {}
+
+  const RenderGraph* graph_;
+};
+
+using RenderPassFunc = std::function<void(const RenderPassContext& context)>;
+
+// 每帧声明pass及其读写的纹理，Compile后Execute：
+//   1. 剔除结果没有被有副作用的pass（写外部纹理或SetSideEffect）用到的pass；
+//   2. 按依赖排序，没有依赖关系的pass保持添加顺序；
+//   3. 给临时纹理分配实际的纹理，生命周期不重叠且描述相同的临时纹理共用一个纹理对象；
+//   4. 纹理对象在帧之间保留在池中复用，长时间不用的才删除。
+// GL没有显存级的别名，复用以纹理对象为粒度，所以只有描述相同的纹理才能共用。
+// Compile不调用GL，可以在没有上下文时测试；Execute需要在GL线程调用。
+class RenderGraph {
+public:
+  static constexpr uint64_t kMaxIdleFrames = 120;
+
+  RenderGraph() = default;
+  ~RenderGraph();
+
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  // 清空pass和纹理声明，池中的纹理对象保留
+  void Reset();
+
+  RenderGraphTexture CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+
+  // 外部纹理不参与分配，texture为0表示Execute开始时绑定的帧缓冲（通常是默认帧缓冲）
+  RenderGraphTexture ImportTexture(const std::string& name, const RenderGraphTextureDesc& desc, GLuint texture);
+
+  // 返回pass序号
+  int AddPass(const std::string& name, RenderPassFunc execute);
+
+  void Read(int pass, RenderGraphTexture texture);
+
+  // 写入纹理的最新版本，返回新版本。pass执行时写入的纹理作为帧缓冲附件绑定
+  RenderGraphTexture Write(int pass, RenderGraphTexture texture);
+
+  void SetSideEffect(int pass);
+
+  // 为false时每个临时纹理单独分配，用于对比
+  void set_aliasing(bool aliasing) {
+    aliasing_ = aliasing;
+  }
+
+  // 有环或非法的声明时返回false
+  bool Compile();
+  void Execute();
+
+  // 删除池中的纹理和帧缓冲，必须在GL上下文销毁前调用
+  void ReleaseTextures();
+
+  const RenderGraphStats& stats() const {
+    return stats_;
+  }
+
+  // 保留的pass的执行顺序
+  const std::vector<int>& order() const {
+    return order_;
+  }
+
+  size_t pass_count() const {
+    return passes_.size();
+  }
+
+  size_t resource_count() const {
+    return resources_.size();
+  }
+
+  const std::string& pass_name(int pass) const {
+    return passes_[pass].name;
+  }
+
+  bool culled(int pass) const {
+    return passes_[pass].culled;
+  }
+
+  // 临时纹理分配到的纹理序号，没有用到或外部纹理为-1
+  int physical_index(uint32_t resource) const {
+    return resources_[resource].physical;
+  }
+
+  // 在order()中第一次和最后一次被用到的位置，没有用到时first > last
+  int first_use(uint32_t resource) const {
+    return resources_[resource].first_use;
+  }
+
+  int last_use(uint32_t resource) const {
+    return resources_[resource].last_use;
+  }
+
+  // 编译结果的文字描述，用于调试
+  std::string Describe() const;
+
+private:
+  struct Resource {
+    std::string name;
+    RenderGraphTextureDesc desc;
+    bool imported = false;
+    GLuint imported_texture = 0;
+    // writers[v]为产生版本v的pass，版本0没有写入者
+    std::vector<int> writers;
+    int first_use = 0;
+    int last_use = -1;
+    int physical = -1;
+  };
+
+  struct Pass {
+    std::string name;
+    // Profiler::InternName的结果，passes_每帧重建，区间事件不能指向name
+    const char* profile_name = nullptr;
+    RenderPassFunc execute;
+    std::vector<RenderGraphTexture> reads;
+    std::vector<RenderGraphTexture> writes;
+    bool side_effect = false;
+    bool culled = false;
+  };
+
+  // 实际的纹理对象，按描述复用
+  struct PooledTexture {
+    RenderGraphTextureDesc desc;
+    GLuint texture = 0;
+    bool in_use = false;
+    uint64_t last_used_frame = 0;
+  };
+
+  struct CachedFramebuffer {
+    std::vector<GLuint> attachments;
+    GLuint framebuffer = 0;
+  };
+
+  bool ValidHandle(RenderGraphTexture handle) const;
+  GLuint AcquireTexture(const RenderGraphTextureDesc& desc);
+  GLuint GetFramebuffer(const std::vector<GLuint>& colors, GLuint depth, bool depth_stencil);
+  GLuint ResolveTexture(RenderGraphTexture handle) const;
+
+private:
+  friend class RenderPassContext;
+
+  std::vector<Resource> resources_;
+  std::vector<Pass> passes_;
+  std::vector<int> order_;
+  // 每个实际纹理的描述，以及Execute时取得的纹理对象
+  std::vector<RenderGraphTextureDesc> physical_descs_;
+  std::vector<GLuint> physical_textures_;
+  RenderGraphStats stats_;
+  bool aliasing_ = true;
+  bool compiled_ = false;
+
+  std::vector<PooledTexture> texture_pool_;
+  std::vector<CachedFramebuffer> framebuffers_;
+  uint64_t frame_ = 0;
+};
+
+}  // namespace utils
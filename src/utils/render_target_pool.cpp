@@ -0,0 +1,143 @@
+#include "utils/render_target_pool.h"
+
+#include "spdlog/spdlog.h"
+#include "utils/gl_util.h"
+#include "utils/metrics.h"
+
+namespace utils {
+
+RenderTargetPool::~RenderTargetPool() {
+  Clear();
+}
+
+RenderTarget* RenderTargetPool::Acquire(const RenderTargetDesc& desc) {
+  for (Entry& entry : entries_) {
+    if (!entry.in_use && entry.target->desc == desc) {
+      entry.in_use = true;
+      entry.last_used_frame = frame_;
+      stats_.reused++;
+      return entry.target;
+    }
+  }
+
+  auto* target = new RenderTarget();
+  target->desc = desc;
+  if (!Create(target)) {
+    Destroy(target);
+    delete target;
+    return nullptr;
+  }
+  Entry entry;
+  entry.target = target;
+  entry.in_use = true;
+  entry.last_used_frame = frame_;
+  entries_.push_back(entry);
+  stats_.created++;
+  stats_.live = entries_.size();
+  stats_.bytes += Bytes(desc);
+  RenderMetrics::Get().texture_memory_bytes.Add(static_cast<int64_t>(Bytes(desc)));
+  return target;
+}
+
+void RenderTargetPool::Release(RenderTarget* target) {
+  for (Entry& entry : entries_) {
+    if (entry.target == target) {
+      entry.in_use = false;
+      entry.last_used_frame = frame_;
+      return;
+    }
+  }
+  SPDLOG_ERROR("Render target does not belong to this pool.");
+}
+
+void RenderTargetPool::EndFrame() {
+  for (size_t i = 0; i < entries_.size();) {
+    Entry& entry = entries_[i];
+    if (!entry.in_use && frame_ - entry.last_used_frame > kMaxIdleFrames) {
+      stats_.bytes -= Bytes(entry.target->desc);
+      RenderMetrics::Get().texture_memory_bytes.Add(-static_cast<int64_t>(Bytes(entry.target->desc)));
+      stats_.evicted++;
+      Destroy(entry.target);
+      delete entry.target;
+      entry = entries_.back();
+      entries_.pop_back();
+    } else {
+      i++;
+    }
+  }
+  stats_.live = entries_.size();
+  frame_++;
+}
+
+void RenderTargetPool::Clear() {
+  for (Entry& entry : entries_) {
+    Destroy(entry.target);
+    delete entry.target;
+  }
+  entries_.clear();
+  RenderMetrics::Get().texture_memory_bytes.Add(-static_cast<int64_t>(stats_.bytes));
+  stats_.live = 0;
+  stats_.bytes = 0;
+}
+
+bool RenderTargetPool::Create(RenderTarget* target) {
+  const RenderTargetDesc& desc = target->desc;
+  GLint previous_framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+  glGenFramebuffers(1, &target->framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+  if (desc.color_format != 0) {
+    glGenTextures(1, &target->color_texture);
+    glBindTexture(GL_TEXTURE_2D, target->color_texture);
+    GLenum format = GL_RGBA;
+    GLenum type = GL_FLOAT;
+    TextureUploadFormat(desc.color_format, &format, &type);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(desc.color_format), desc.width, desc.height, 0, format, type,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->color_texture, 0);
+  } else {
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
+  if (desc.depth_format != 0) {
+    glGenRenderbuffers(1, &target->depth_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->depth_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, desc.depth_format, desc.width, desc.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    bool has_stencil = desc.depth_format == GL_DEPTH24_STENCIL8 || desc.depth_format == GL_DEPTH32F_STENCIL8;
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, has_stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, target->depth_buffer);
+  }
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    SPDLOG_ERROR("Render target {}x{} is incomplete: {:#x}", desc.width, desc.height, status);
+    return false;
+  }
+  return true;
+}
+
+void RenderTargetPool::Destroy(RenderTarget* target) {
+  if (target->framebuffer != 0) {
+    glDeleteFramebuffers(1, &target->framebuffer);
+  }
+  if (target->color_texture != 0) {
+    glDeleteTextures(1, &target->color_texture);
+  }
+  if (target->depth_buffer != 0) {
+    glDeleteRenderbuffers(1, &target->depth_buffer);
+  }
+  *target = RenderTarget();
+}
+
+size_t RenderTargetPool::Bytes(const RenderTargetDesc& desc) {
+  size_t pixels = static_cast<size_t>(desc.width) * desc.height;
+  return pixels * (TextureBytesPerPixel(desc.color_format) + TextureBytesPerPixel(desc.depth_format));
+}
+
+}  // namespace utils
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace utils {
+
+// 格式为0表示没有该附件
+struct RenderTargetDesc {
+  int width = 0;
+  int height = 0;
+  GLenum color_format = GL_RGBA8;
+  GLenum depth_format = GL_DEPTH24_STENCIL8;
+
+  bool operator==(const RenderTargetDesc& other) const {
+    return width == other.width && height == other.height && color_format == other.color_format &&
+           depth_format == other.depth_format;
+  }
+};
+
+// 颜色附件是纹理（可以采样），深度附件是渲染缓冲
+struct RenderTarget {
+  RenderTargetDesc desc;
+  GLuint framebuffer = 0;
+  GLuint color_texture = 0;
+  GLuint depth_buffer = 0;
+};
+
+struct RenderTargetPoolStats {
+  uint64_t created = 0;
+  uint64_t reused = 0;
+  uint64_t evicted = 0;
+  size_t live = 0;
+  size_t bytes = 0;
+};
+
+// 按描述复用的渲染目标池。Release后的目标留在池中，相同描述的Acquire直接复用；
+// 连续kMaxIdleFrames帧没有被用到的空闲目标在EndFrame中删除。只能在GL线程使用。
+class RenderTargetPool {
+public:
+  static constexpr uint64_t kMaxIdleFrames = 120;
+
+  RenderTargetPool() = default;
+  ~RenderTargetPool();
+
+  RenderTargetPool(const RenderTargetPool&) = delete;
+  RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+  // 返回的指针在Release之前有效，创建失败时返回nullptr
+  RenderTarget* Acquire(const RenderTargetDesc& desc);
+  void Release(RenderTarget* target);
+
+  void EndFrame();
+
+  // 删除所有目标，必须在GL上下文销毁前调用
+  void Clear();
+
+  const RenderTargetPoolStats& stats() const {
+    return stats_;
+  }
+
+private:
+  struct Entry {
+    RenderTarget* target = nullptr;
+    bool in_use = false;
+    uint64_t last_used_frame = 0;
+  };
+
+  static bool Create(RenderTarget* target);
+  static void Destroy(RenderTarget* target);
+  static size_t Bytes(const RenderTargetDesc& desc);
+
+private:
+  std::vector<Entry> entries_;
+  uint64_t frame_ = 0;
+  RenderTargetPoolStats stats_;
+};
+
+}  // namespace utils
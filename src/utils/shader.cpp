@@ -1,15 +1,85 @@
 #include "utils/shader.h"
 
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+
 #include "spdlog/spdlog.h"
 #include "utils/file_util.h"
+#include "utils/metrics.h"
 
 namespace utils {
 
 namespace {
 
+constexpr int kMaxIncludeDepth = 16;
+
+double NowMs() {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+}
+
+std::vector<std::string>& IncludeDirectories() {
+  static std::vector<std::string> directories;
+  return directories;
+}
+
+std::string FindInclude(const std::string& including_path, const std::string& name) {
+  std::filesystem::path relative = std::filesystem::path(including_path).parent_path() / name;
+  if (std::filesystem::exists(relative)) {
+    return relative.string();
+  }
+  for (const std::string& directory : IncludeDirectories()) {
+    std::filesystem::path candidate = std::filesystem::path(directory) / name;
+    if (std::filesystem::exists(candidate)) {
+      return candidate.string();
+    }
+  }
+  return std::string();
+}
+
+// 逐行展开 #include "file"，被引入的文件中也可以再引入
+bool ExpandIncludes(const std::string& path, const std::string& source, int depth, std::string* output) {
+  if (depth > kMaxIncludeDepth) {
+    SPDLOG_ERROR("Shader includes nested too deeply: {}", path);
+    return false;
+  }
+  std::istringstream lines(source);
+  std::string line;
+  while (std::getline(lines, line)) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+      *output += line;
+      *output += '\n';
+      continue;
+    }
+    size_t open = line.find('"', start);
+    size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+    if (close == std::string::npos) {
+      SPDLOG_ERROR("Invalid include in {}: {}", path, line);
+      return false;
+    }
+    std::string name = line.substr(open + 1, close - open - 1);
+    std::string include_path = FindInclude(path, name);
+    std::string include_source = include_path.empty() ? std::string() : utils::ReadFile(include_path);
+    if (include_source.empty()) {
+      SPDLOG_ERROR("Failed to include {} from {}", name, path);
+      return false;
+    }
+    if (!ExpandIncludes(include_path, include_source, depth + 1, output)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 GLuint LoadShader(const std::string& shader_path, GLenum shader_type) {
-  std::string shader_source = utils::ReadFile(shader_path);
-  if (shader_source.empty()) {
+  std::string file_source = utils::ReadFile(shader_path);
+  if (file_source.empty()) {
+    return 0;
+  }
+  std::string shader_source;
+  if (!ExpandIncludes(shader_path, file_source, 0, &shader_source)) {
     return 0;
   }
 
@@ -17,10 +87,12 @@ GLuint LoadShader(const std::string& shader_path, GLenum shader_type) {
   const char* source = shader_source.c_str();
   glShaderSource(shader, 1, &source, nullptr);
   glCompileShader(shader);
+  RenderMetrics::Get().shader_compiles.Add();
 
   GLint error_code = 0;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &error_code);
   if (error_code == GL_FALSE) {
+    RenderMetrics::Get().shader_compile_failures.Add();
     char error_msg[512] = { 0 };
     glGetShaderInfoLog(shader, 512, nullptr, error_msg);
     SPDLOG_ERROR("Failed to compile shader: {}. Error: {}", shader_path, error_msg);
@@ -34,12 +106,11 @@ GLuint LoadShader(const std::string& shader_path, GLenum shader_type) {
 }  // namespace
 
 Shader::~Shader() {
-  if (program_ != 0) {
-    glDeleteProgram(program_);
-  }
+  DeleteProgram();
 }
 
 bool Shader::Compile(const std::string& vertex_shader_path, const std::string& fragment_shader_path) {
+  double start_ms = NowMs();
   GLuint vertex_shader = LoadShader(vertex_shader_path, GL_VERTEX_SHADER);
   if (vertex_shader == 0) {
     return false;
@@ -47,16 +118,40 @@ bool Shader::Compile(const std::string& vertex_shader_path, const std::string& f
 
   GLuint fragment_shader = LoadShader(fragment_shader_path, GL_FRAGMENT_SHADER);
   if (fragment_shader == 0) {
+    glDeleteShader(vertex_shader);
     return false;
   }
 
+  GLuint shaders[] = { vertex_shader, fragment_shader };
+  bool result = Link(shaders, 2, vertex_shader_path);
+  RenderMetrics::Get().shader_compile_ms.Observe(NowMs() - start_ms);
+  return result;
+}
+
+bool Shader::CompileCompute(const std::string& compute_shader_path) {
+  double start_ms = NowMs();
+  GLuint compute_shader = LoadShader(compute_shader_path, GL_COMPUTE_SHADER);
+  if (compute_shader == 0) {
+    return false;
+  }
+
+  bool result = Link(&compute_shader, 1, compute_shader_path);
+  RenderMetrics::Get().shader_compile_ms.Observe(NowMs() - start_ms);
+  return result;
+}
+
+bool Shader::Link(const GLuint* shaders, int count, const std::string& label) {
+  DeleteProgram();
+
   program_ = glCreateProgram();
-  glAttachShader(program_, vertex_shader);
-  glAttachShader(program_, fragment_shader);
+  for (int i = 0; i < count; i++) {
+    glAttachShader(program_, shaders[i]);
+  }
   glLinkProgram(program_);
 
-  glDeleteShader(vertex_shader);
-  glDeleteShader(fragment_shader);
+  for (int i = 0; i < count; i++) {
+    glDeleteShader(shaders[i]);
+  }
 
   GLint error_code = 0;
   glGetProgramiv(program_, GL_LINK_STATUS, &error_code);
@@ -64,63 +159,87 @@ bool Shader::Compile(const std::string& vertex_shader_path, const std::string& f
     char error_msg[512] = { 0 };
     glGetProgramInfoLog(program_, 512, nullptr, error_msg);
     SPDLOG_ERROR("Failed to create program. Error: {}", error_msg);
+    RenderMetrics::Get().shader_compile_failures.Add();
     glDeleteProgram(program_);
+    program_ = 0;
     return false;
   }
 
+  if (resources_ != nullptr) {
+    handle_ = resources_->Adopt<GpuResourceType::kProgram>(program_, label);
+  }
   return true;
 }
 
+void Shader::DeleteProgram() {
+  if (handle_.valid()) {
+    resources_->Destroy(handle_);
+    handle_ = ProgramHandle();
+  } else if (program_ != 0) {
+    glDeleteProgram(program_);
+  }
+  program_ = 0;
+}
+
 void Shader::Use() const {
   glUseProgram(program_);
+  RenderMetrics::Get().state_changes.Add();
+}
+
+void Shader::AddIncludeDirectory(const std::string& directory) {
+  IncludeDirectories().push_back(directory);
+}
+
+void Shader::Dispatch(GLuint group_x, GLuint group_y, GLuint group_z) const {
+  glDispatchCompute(group_x, group_y, group_z);
 }
 
-void Shader::SetBool(const std::string& name, bool value) const {
-  glUniform1i(glGetUniformLocation(program_, name.c_str()), value ? 1 : 0);
+void Shader::SetBool(const char* name, bool value) const {
+  glUniform1i(glGetUniformLocation(program_, name), value ? 1 : 0);
 }
 
-void Shader::SetInt(const std::string& name, int value) const {
-  glUniform1i(glGetUniformLocation(program_, name.c_str()), value);
+void Shader::SetInt(const char* name, int value) const {
+  glUniform1i(glGetUniformLocation(program_, name), value);
 }
 
-void Shader::SetFloat(const std::string& name, float value) const {
-  glUniform1f(glGetUniformLocation(program_, name.c_str()), value);
+void Shader::SetFloat(const char* name, float value) const {
+  glUniform1f(glGetUniformLocation(program_, name), value);
 }
 
-void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
-  glUniform2fv(glGetUniformLocation(program_, name.c_str()), 1, &value[0]);
+void Shader::SetVec2(const char* name, const glm::vec2& value) const {
+  glUniform2fv(glGetUniformLocation(program_, name), 1, &value[0]);
 }
 
-void Shader::SetVec2(const std::string& name, float x, float y) const {
-  glUniform2f(glGetUniformLocation(program_, name.c_str()), x, y);
+void Shader::SetVec2(const char* name, float x, float y) const {
+  glUniform2f(glGetUniformLocation(program_, name), x, y);
 }
 
-void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
-  glUniform3fv(glGetUniformLocation(program_, name.c_str()), 1, &value[0]);
+void Shader::SetVec3(const char* name, const glm::vec3& value) const {
+  glUniform3fv(glGetUniformLocation(program_, name), 1, &value[0]);
 }
 
-void Shader::SetVec3(const std::string& name, float x, float y, float z) const {
-  glUniform3f(glGetUniformLocation(program_, name.c_str()), x, y, z);
+void Shader::SetVec3(const char* name, float x, float y, float z) const {
+  glUniform3f(glGetUniformLocation(program_, name), x, y, z);
 }
 
-void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
-  glUniform4fv(glGetUniformLocation(program_, name.c_str()), 1, &value[0]);
+void Shader::SetVec4(const char* name, const glm::vec4& value) const {
+  glUniform4fv(glGetUniformLocation(program_, name), 1, &value[0]);
 }
 
-void Shader::SetVec4(const std::string& name, float x, float y, float z, float w) const {
-  glUniform4f(glGetUniformLocation(program_, name.c_str()), x, y, z, w);
+void Shader::SetVec4(const char* name, float x, float y, float z, float w) const {
+  glUniform4f(glGetUniformLocation(program_, name), x, y, z, w);
 }
 
-void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const {
-  glUniformMatrix2fv(glGetUniformLocation(program_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::SetMat2(const char* name, const glm::mat2& mat) const {
+  glUniformMatrix2fv(glGetUniformLocation(program_, name), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const {
-  glUniformMatrix3fv(glGetUniformLocation(program_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::SetMat3(const char* name, const glm::mat3& mat) const {
+  glUniformMatrix3fv(glGetUniformLocation(program_, name), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const {
-  glUniformMatrix4fv(glGetUniformLocation(program_, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::SetMat4(const char* name, const glm::mat4& mat) const {
+  glUniformMatrix4fv(glGetUniformLocation(program_, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 }  // namespace utils
@@ -1,38 +1,61 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "glad/glad.h"
 #include "glm/glm.hpp"
+#include "utils/gpu_resources.h"
 
 namespace utils {
 
 class Shader {
 public:
   Shader() = default;
+  // 程序交给resources管理，析构时只登记销毁，可以在任何线程析构。resources必须比Shader活得久
+  explicit Shader(GpuResources* resources) : resources_(resources) {}
   ~Shader();
 
+  Shader(const Shader&) = delete;
+  Shader& operator=(const Shader&) = delete;
+
+  // 着色器源码中可以用 #include "file" 引入其它文件：先相对当前文件查找，再依次查找AddIncludeDirectory添加的目录
   bool Compile(const std::string& vertex_shader_path, const std::string& fragment_shader_path);
 
+  // 计算着色器，需要GL 4.3
+  bool CompileCompute(const std::string& compute_shader_path);
+
   void Use() const;
 
-  void SetBool(const std::string& name, bool value) const;
-  void SetInt(const std::string& name, int value) const;
-  void SetFloat(const std::string& name, float value) const;
+  static void AddIncludeDirectory(const std::string& directory);
+
+  // 调用前需要先Use
+  void Dispatch(GLuint group_x, GLuint group_y = 1, GLuint group_z = 1) const;
 
-  void SetVec2(const std::string& name, const glm::vec2& value) const;
-  void SetVec2(const std::string& name, float x, float y) const;
+  // 名字直接传给glGetUniformLocation，不构造std::string，每帧设置uniform不产生堆分配
+  void SetBool(const char* name, bool value) const;
+  void SetInt(const char* name, int value) const;
+  void SetFloat(const char* name, float value) const;
 
-  void SetVec3(const std::string& name, const glm::vec3& value) const;
-  void SetVec3(const std::string& name, float x, float y, float z) const;
+  void SetVec2(const char* name, const glm::vec2& value) const;
+  void SetVec2(const char* name, float x, float y) const;
 
-  void SetVec4(const std::string& name, const glm::vec4& value) const;
-  void SetVec4(const std::string& name, float x, float y, float z, float w) const;
+  void SetVec3(const char* name, const glm::vec3& value) const;
+  void SetVec3(const char* name, float x, float y, float z) const;
 
-  void SetMat2(const std::string& name, const glm::mat2& mat) const;
-  void SetMat3(const std::string& name, const glm::mat3& mat) const;
-  void SetMat4(const std::string& name, const glm::mat4& mat) const;
+  void SetVec4(const char* name, const glm::vec4& value) const;
+  void SetVec4(const char* name, float x, float y, float z, float w) const;
+
+  void SetMat2(const char* name, const glm::mat2& mat) const;
+  void SetMat3(const char* name, const glm::mat3& mat) const;
+  void SetMat4(const char* name, const glm::mat4& mat) const;
+
+private:
+  bool Link(const GLuint* shaders, int count, const std::string& label);
+  void DeleteProgram();
 
 private:
+  GpuResources* resources_ = nullptr;
+  ProgramHandle handle_;
   GLuint program_ = 0;
 };
 
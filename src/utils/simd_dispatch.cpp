@@ -0,0 +1,14 @@
+#include "utils/simd_dispatch.h"
+
+namespace utils {
+
+bool HasAvx2() {
+#ifdef UTILS_SIMD_AVX2
+  static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+}  // namespace utils
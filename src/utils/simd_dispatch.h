@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// SSE2在x86-64上总是可用，直接按编译选项打开
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTILS_SIMD_SSE 1
+#endif
+
+// AVX2实现用target属性单独编译，运行时用HasAvx2()检测CPU后才调用，不需要全局打开-mavx2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define UTILS_SIMD_AVX2 1
+#define UTILS_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace utils {
+
+// CPU是否支持AVX2和POPCNT，只检测一次；没有编译AVX2实现时总是返回false
+bool HasAvx2();
+
+// mask不能为0
+inline int CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+}  // namespace utils
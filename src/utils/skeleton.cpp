@@ -0,0 +1,96 @@
+#include "utils/skeleton.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace utils {
+
+int Skeleton::FindJoint(const std::string& name) const {
+  for (size_t i = 0; i < joint_names.size(); i++) {
+    if (joint_names[i] == name) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void QuantizeWeights(const uint32_t* joints, const float* weights, int count, SkinnedVertex* vertex) {
+  int order[kMaxJointInfluences] = {};
+  int kept = 0;
+  // 插入排序，保留权重最大的几个
+  for (int i = 0; i < count; i++) {
+    if (!(weights[i] > 0.0f)) {
+      continue;
+    }
+    int slot = std::min(kept, kMaxJointInfluences - 1);
+    if (kept == kMaxJointInfluences && weights[i] <= weights[order[slot]]) {
+      continue;
+    }
+    while (slot > 0 && weights[order[slot - 1]] < weights[i]) {
+      order[slot] = order[slot - 1];
+      slot--;
+    }
+    order[slot] = i;
+    kept = std::min(kept + 1, kMaxJointInfluences);
+  }
+
+  std::fill(vertex->joints, vertex->joints + kMaxJointInfluences, 0);
+  std::fill(vertex->weights, vertex->weights + kMaxJointInfluences, 0);
+  if (kept == 0) {
+    vertex->weights[0] = 255;
+    return;
+  }
+  float total = 0.0f;
+  for (int i = 0; i < kept; i++) {
+    total += weights[order[i]];
+  }
+  int sum = 0;
+  for (int i = 0; i < kept; i++) {
+    vertex->joints[i] = static_cast<uint8_t>(joints[order[i]]);
+    vertex->weights[i] = static_cast<uint8_t>(std::lround(weights[order[i]] / total * 255.0f));
+    sum += vertex->weights[i];
+  }
+  vertex->weights[0] = static_cast<uint8_t>(vertex->weights[0] + 255 - sum);
+}
+
+void BlendPoses(const TrsArrays& a, const TrsArrays& b, float weight, TrsArrays* out) {
+  size_t count = a.size();
+  out->Resize(count);
+  float wa = 1.0f - weight;
+  for (size_t i = 0; i < count; i++) {
+    out->position_x[i] = a.position_x[i] * wa + b.position_x[i] * weight;
+    out->position_y[i] = a.position_y[i] * wa + b.position_y[i] * weight;
+    out->position_z[i] = a.position_z[i] * wa + b.position_z[i] * weight;
+    out->scale_x[i] = a.scale_x[i] * wa + b.scale_x[i] * weight;
+    out->scale_y[i] = a.scale_y[i] * wa + b.scale_y[i] * weight;
+    out->scale_z[i] = a.scale_z[i] * wa + b.scale_z[i] * weight;
+
+    float dot = a.rotation_x[i] * b.rotation_x[i] + a.rotation_y[i] * b.rotation_y[i] +
+                a.rotation_z[i] * b.rotation_z[i] + a.rotation_w[i] * b.rotation_w[i];
+    float wb = dot < 0.0f ? -weight : weight;
+    float x = a.rotation_x[i] * wa + b.rotation_x[i] * wb;
+    float y = a.rotation_y[i] * wa + b.rotation_y[i] * wb;
+    float z = a.rotation_z[i] * wa + b.rotation_z[i] * wb;
+    float w = a.rotation_w[i] * wa + b.rotation_w[i] * wb;
+    float inv_length = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+    out->rotation_x[i] = x * inv_length;
+    out->rotation_y[i] = y * inv_length;
+    out->rotation_z[i] = z * inv_length;
+    out->rotation_w[i] = w * inv_length;
+  }
+}
+
+void ComputeSkinningMatrices(const Skeleton& skeleton, const TrsArrays& pose, Matrix3x4* models,
+                             Matrix3x4* skinning) {
+  ComposeModelMatrices(pose, models);
+  size_t count = skeleton.joint_count();
+  for (size_t i = 0; i < count; i++) {
+    int parent = skeleton.parents[i];
+    if (parent >= 0) {
+      MultiplyAffine(models[parent], models[i], &models[i]);
+    }
+    MultiplyAffine(models[i], skeleton.inverse_bind[i], &skinning[i]);
+  }
+}
+
+}  // namespace utils
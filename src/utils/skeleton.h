@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "utils/transform_batch.h"
+
+namespace utils {
+
+// 顶点的关节下标是uint8，一个骨架最多256个关节
+constexpr size_t kMaxJoints = 256;
+constexpr int kMaxJointInfluences = 4;
+
+// 关节按父关节在前的顺序排列（parents[i] < i），根关节的父关节为-1
+struct Skeleton {
+  std::vector<std::string> joint_names;
+  std::vector<int16_t> parents;
+  // 模型空间到关节空间，即绑定姿势下关节模型矩阵的逆
+  std::vector<Matrix3x4> inverse_bind;
+  // 绑定姿势的局部TRS，动画中没有轨道的关节保持这个姿势
+  TrsArrays bind_pose;
+
+  size_t joint_count() const {
+    return parents.size();
+  }
+
+  // 没有找到时返回-1
+  int FindJoint(const std::string& name) const;
+};
+
+// 蒙皮顶点，48字节
+struct SkinnedVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 uv;
+  uint8_t joints[kMaxJointInfluences];
+  // unorm8，四个权重之和正好是255
+  uint8_t weights[kMaxJointInfluences];
+};
+
+struct SkinnedMeshData {
+  std::vector<SkinnedVertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// 取权重最大的kMaxJointInfluences个影响（count可以更多），归一化后量化为unorm8，
+// 舍入误差加到最大的权重上。count为0时绑定到关节0
+void QuantizeWeights(const uint32_t* joints, const float* weights, int count, SkinnedVertex* vertex);
+
+// out = a和b按weight混合（0为a，1为b），旋转用nlerp并取最短路径。out可以是a或b
+void BlendPoses(const TrsArrays& a, const TrsArrays& b, float weight, TrsArrays* out);
+
+// pose为每个关节的局部TRS。models[i]为关节i的模型矩阵，skinning[i] = models[i] * inverse_bind[i]，
+// 两个数组的容量至少为关节数量。局部矩阵用ComposeModelMatrices批量计算
+void ComputeSkinningMatrices(const Skeleton& skeleton, const TrsArrays& pose, Matrix3x4* models,
+                             Matrix3x4* skinning);
+
+}  // namespace utils
@@ -0,0 +1,181 @@
+#include "utils/skinning.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "spdlog/spdlog.h"
+#include "utils/metrics.h"
+
+namespace utils {
+
+namespace {
+
+struct SkinningScratch {
+  TrsArrays pose;
+  TrsArrays blend;
+  std::vector<Matrix3x4> models;
+};
+
+SkinningScratch& ThreadScratch() {
+  thread_local SkinningScratch scratch;
+  return scratch;
+}
+
+}  // namespace
+
+CrowdAnimator::CrowdAnimator() {
+  func_ = [this](size_t begin, size_t end) { UpdateRange(begin, end); };
+}
+
+void CrowdAnimator::Update(const Skeleton& skeleton, const std::vector<AnimationClip>& clips,
+                           const AnimationInstance* instances, size_t count, ThreadPool* pool,
+                           Matrix3x4* skinning) {
+  skeleton_ = &skeleton;
+  clips_ = &clips;
+  instances_ = instances;
+  skinning_ = skinning;
+  if (pool != nullptr) {
+    pool->ParallelFor(count, kGrain, func_);
+  } else {
+    UpdateRange(0, count);
+  }
+}
+
+void CrowdAnimator::UpdateRange(size_t begin, size_t end) const {
+  SkinningScratch& scratch = ThreadScratch();
+  size_t joints = skeleton_->joint_count();
+  scratch.models.resize(joints);
+  int clip_count = static_cast<int>(clips_->size());
+  for (size_t i = begin; i < end; i++) {
+    const AnimationInstance& instance = instances_[i];
+    const TrsArrays* pose = &skeleton_->bind_pose;
+    if (instance.clip >= 0 && instance.clip < clip_count) {
+      (*clips_)[instance.clip].Sample(instance.time, &scratch.pose);
+      pose = &scratch.pose;
+    }
+    if (instance.blend_clip >= 0 && instance.blend_clip < clip_count && instance.blend_weight > 0.0f) {
+      (*clips_)[instance.blend_clip].Sample(instance.blend_time, &scratch.blend);
+      BlendPoses(*pose, scratch.blend, instance.blend_weight, &scratch.pose);
+      pose = &scratch.pose;
+    }
+    ComputeSkinningMatrices(*skeleton_, *pose, scratch.models.data(), skinning_ + i * joints);
+  }
+}
+
+SkinningBuffer::~SkinningBuffer() {
+  Release();
+}
+
+bool SkinningBuffer::Init(size_t max_matrices) {
+  Release();
+  GLint max_texels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+  if (max_matrices == 0 || max_matrices * 3 > static_cast<size_t>(max_texels)) {
+    SPDLOG_ERROR("Cannot store {} skinning matrices in a texture buffer (max {} texels)", max_matrices, max_texels);
+    return false;
+  }
+  capacity_ = max_matrices;
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+  glBufferData(GL_TEXTURE_BUFFER, capacity_ * sizeof(Matrix3x4), nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &texture_);
+  glBindTexture(GL_TEXTURE_BUFFER, texture_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer_);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  return true;
+}
+
+void SkinningBuffer::Release() {
+  if (texture_ != 0) {
+    glDeleteTextures(1, &texture_);
+    texture_ = 0;
+  }
+  if (buffer_ != 0) {
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+  }
+  capacity_ = 0;
+}
+
+void SkinningBuffer::Upload(const Matrix3x4* matrices, size_t count) {
+  if (count > capacity_) {
+    SPDLOG_WARN("Uploading {} skinning matrices into a buffer of {}", count, capacity_);
+    count = capacity_;
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+  glBufferData(GL_TEXTURE_BUFFER, capacity_ * sizeof(Matrix3x4), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof(Matrix3x4), matrices);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  RenderMetrics::Get().buffer_upload_bytes.Add(count * sizeof(Matrix3x4));
+}
+
+void SkinningBuffer::Bind(GLuint unit) const {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_BUFFER, texture_);
+  RenderMetrics::Get().state_changes.Add();
+}
+
+SkinnedMesh::~SkinnedMesh() {
+  Release();
+}
+
+bool SkinnedMesh::Init(const SkinnedMeshData& data) {
+  Release();
+  if (data.vertices.empty() || data.indices.empty()) {
+    SPDLOG_ERROR("Skinned mesh has no geometry.");
+    return false;
+  }
+  index_count_ = static_cast<GLsizei>(data.indices.size());
+
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_);
+  glGenBuffers(1, &ebo_);
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(SkinnedVertex), data.vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(uint32_t), data.indices.data(),
+               GL_STATIC_DRAW);
+  RenderMetrics::Get().buffer_upload_bytes.Add(data.vertices.size() * sizeof(SkinnedVertex) +
+                                               data.indices.size() * sizeof(uint32_t));
+
+  GLsizei stride = sizeof(SkinnedVertex);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, position));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, normal));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, uv));
+  glEnableVertexAttribArray(3);
+  glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(SkinnedVertex, joints));
+  glEnableVertexAttribArray(4);
+  glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(SkinnedVertex, weights));
+  glBindVertexArray(0);
+  return true;
+}
+
+void SkinnedMesh::Release() {
+  if (vao_ != 0) {
+    glDeleteVertexArrays(1, &vao_);
+    vao_ = 0;
+  }
+  if (vbo_ != 0) {
+    glDeleteBuffers(1, &vbo_);
+    vbo_ = 0;
+  }
+  if (ebo_ != 0) {
+    glDeleteBuffers(1, &ebo_);
+    ebo_ = 0;
+  }
+  index_count_ = 0;
+}
+
+void SkinnedMesh::DrawInstanced(GLsizei instance_count) const {
+  glBindVertexArray(vao_);
+  glDrawElementsInstanced(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, nullptr, instance_count);
+  RenderMetrics::Get().draw_calls.Add();
+}
+
+}  // namespace utils
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glad/glad.h"
+#include "utils/animation_clip.h"
+#include "utils/skeleton.h"
+#include "utils/thread_pool.h"
+#include "utils/transform_batch.h"
+
+namespace utils {
+
+// 一个角色的播放状态。blend_clip为-1时只播放clip
+struct AnimationInstance {
+  int clip = 0;
+  float time = 0.0f;
+  int blend_clip = -1;
+  float blend_time = 0.0f;
+  // 0为clip，1为blend_clip
+  float blend_weight = 0.0f;
+};
+
+// 对一组共用骨架的角色采样、混合并计算蒙皮矩阵。
+// 每个线程用自己的临时姿势，稳定状态下Update不分配内存
+class CrowdAnimator {
+public:
+  // 每个任务处理的角色数
+  static constexpr size_t kGrain = 16;
+
+  CrowdAnimator();
+
+  // skinning按角色连续存放，每个角色skeleton.joint_count()个矩阵。pool为空时在调用线程完成
+  void Update(const Skeleton& skeleton, const std::vector<AnimationClip>& clips, const AnimationInstance* instances,
+              size_t count, ThreadPool* pool, Matrix3x4* skinning);
+
+private:
+  void UpdateRange(size_t begin, size_t end) const;
+
+private:
+  ThreadPool::RangeFunc func_;
+  const Skeleton* skeleton_ = nullptr;
+  const std::vector<AnimationClip>* clips_ = nullptr;
+  const AnimationInstance* instances_ = nullptr;
+  Matrix3x4* skinning_ = nullptr;
+};
+
+// 蒙皮矩阵放在纹理缓冲中（GL_RGBA32F，每个矩阵3个纹素），容量不受UBO大小的限制：
+// 1000个64关节的角色每帧约3MB。着色器用res/shaders/skinning.glsl读取
+class SkinningBuffer {
+public:
+  SkinningBuffer() = default;
+  ~SkinningBuffer();
+
+  SkinningBuffer(const SkinningBuffer&) = delete;
+  SkinningBuffer& operator=(const SkinningBuffer&) = delete;
+
+  bool Init(size_t max_matrices);
+  void Release();
+
+  // 每次上传前重新分配缓冲存储（orphan），不等待GPU读完上一帧的数据
+  void Upload(const Matrix3x4* matrices, size_t count);
+
+  void Bind(GLuint unit) const;
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+private:
+  GLuint buffer_ = 0;
+  GLuint texture_ = 0;
+  size_t capacity_ = 0;
+};
+
+// SkinnedMeshData的顶点和索引缓冲。属性：0位置，1法线，2纹理坐标，3关节下标（uvec4），4权重（vec4）。
+// 实例数据由调用者在同一个VAO上设置（属性5起）
+class SkinnedMesh {
+public:
+  static constexpr GLuint kFirstInstanceAttribute = 5;
+
+  SkinnedMesh() = default;
+  ~SkinnedMesh();
+
+  SkinnedMesh(const SkinnedMesh&) = delete;
+  SkinnedMesh& operator=(const SkinnedMesh&) = delete;
+
+  bool Init(const SkinnedMeshData& data);
+  void Release();
+
+  void DrawInstanced(GLsizei instance_count) const;
+
+  GLuint vao() const {
+    return vao_;
+  }
+
+private:
+  GLuint vao_ = 0;
+  GLuint vbo_ = 0;
+  GLuint ebo_ = 0;
+  GLsizei index_count_ = 0;
+};
+
+}  // namespace utils
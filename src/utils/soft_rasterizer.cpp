@@ -0,0 +1,609 @@
+#include "utils/soft_rasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "spdlog/spdlog.h"
+#include "utils/gl_util.h"
+#include "utils/profiler.h"
+#include "utils/simd_dispatch.h"
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kSubpixelBits = 4;
+constexpr int kSubpixelScale = 1 << kSubpixelBits;
+// 裁剪时x、y只裁到视口的两倍，范围内的三角形直接光栅化，保证亚像素坐标和边函数的增量不会溢出
+constexpr float kGuardBand = 2.0f;
+// 一行中的边函数从这个范围内的值开始累加，一个分块内的增量不会让它溢出，也不会改变符号
+constexpr int64_t kEdgeClamp = int64_t(1) << 30;
+constexpr size_t kVertexGrain = 4096;
+constexpr size_t kSetupGrain = 2048;
+
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint32_t PackColor(const glm::vec4& color) {
+  uint32_t packed = 0;
+  for (int i = 0; i < 4; i++) {
+    auto value = static_cast<uint32_t>(std::lround(std::clamp(color[i], 0.0f, 1.0f) * 255.0f));
+    packed |= value << (i * 8);
+  }
+  return packed;
+}
+
+int64_t FloorDiv(int64_t value, int64_t divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+struct ClipVertex {
+  glm::vec4 position;
+  glm::vec2 tex_coord;
+};
+
+// 平面的有向距离，大于等于0在内侧。0为近平面，1为远平面，2~5为保护带的左右下上
+float PlaneDistance(const glm::vec4& p, int plane, float guard_band) {
+  switch (plane) {
+    case 0:
+      return p.z + p.w;
+    case 1:
+      return p.w - p.z;
+    case 2:
+      return p.x + guard_band * p.w;
+    case 3:
+      return guard_band * p.w - p.x;
+    case 4:
+      return p.y + guard_band * p.w;
+    default:
+      return guard_band * p.w - p.y;
+  }
+}
+
+uint32_t Outcode(const glm::vec4& p, float guard_band) {
+  uint32_t code = 0;
+  for (int plane = 0; plane < 6; plane++) {
+    code |= PlaneDistance(p, plane, guard_band) < 0.0f ? 1u << plane : 0u;
+  }
+  return code;
+}
+
+// Sutherland-Hodgman，输入多边形最多3 + 6个顶点
+int ClipPolygon(ClipVertex* vertices, int count, uint32_t planes) {
+  ClipVertex buffer[9];
+  for (int plane = 0; plane < 6 && count > 0; plane++) {
+    if ((planes & (1u << plane)) == 0) {
+      continue;
+    }
+    int out_count = 0;
+    for (int i = 0; i < count; i++) {
+      const ClipVertex& a = vertices[i];
+      const ClipVertex& b = vertices[(i + 1) % count];
+      float da = PlaneDistance(a.position, plane, kGuardBand);
+      float db = PlaneDistance(b.position, plane, kGuardBand);
+      if (da >= 0.0f) {
+        buffer[out_count++] = a;
+      }
+      if ((da >= 0.0f) != (db >= 0.0f)) {
+        float t = da / (da - db);
+        buffer[out_count].position = a.position + (b.position - a.position) * t;
+        buffer[out_count].tex_coord = a.tex_coord + (b.tex_coord - a.tex_coord) * t;
+        out_count++;
+      }
+    }
+    std::copy(buffer, buffer + out_count, vertices);
+    count = out_count;
+  }
+  return count;
+}
+
+// 双线性过滤，纹理坐标按GL_REPEAT环绕，结果各分量在[0, 255]
+glm::vec4 SampleBilinear(const SoftTexture& texture, float u, float v) {
+  float x = u * static_cast<float>(texture.width) - 0.5f;
+  float y = v * static_cast<float>(texture.height) - 0.5f;
+  float x_floor = std::floor(x);
+  float y_floor = std::floor(y);
+  float fx = x - x_floor;
+  float fy = y - y_floor;
+  auto wrap = [](float value, int size) {
+    float wrapped = value - static_cast<float>(size) * std::floor(value / static_cast<float>(size));
+    return std::clamp(static_cast<int>(wrapped), 0, size - 1);
+  };
+  int x0 = wrap(x_floor, texture.width);
+  int y0 = wrap(y_floor, texture.height);
+  int x1 = x0 + 1 == texture.width ? 0 : x0 + 1;
+  int y1 = y0 + 1 == texture.height ? 0 : y0 + 1;
+  auto texel = [&texture](int tx, int ty) {
+    uint32_t packed = texture.texels[static_cast<size_t>(ty) * texture.width + tx];
+    return glm::vec4(static_cast<float>(packed & 0xff), static_cast<float>((packed >> 8) & 0xff),
+                     static_cast<float>((packed >> 16) & 0xff), static_cast<float>(packed >> 24));
+  };
+  glm::vec4 c00 = texel(x0, y0);
+  glm::vec4 c10 = texel(x1, y0);
+  glm::vec4 c01 = texel(x0, y1);
+  glm::vec4 c11 = texel(x1, y1);
+  glm::vec4 top = c00 + (c10 - c00) * fx;
+  glm::vec4 bottom = c01 + (c11 - c01) * fx;
+  return top + (bottom - top) * fy;
+}
+
+struct TileRect {
+  int min_x;
+  int min_y;
+  int max_x;
+  int max_y;
+};
+
+void RasterizeScalar(const SoftRasterizer::Triangle& triangle, const SoftMaterial& material, const TileRect& rect,
+                     int stride, uint32_t* color, float* depth) {
+  const float(*attributes)[3] = triangle.attributes;
+  for (int y = rect.min_y; y <= rect.max_y; y++) {
+    for (int x = rect.min_x; x <= rect.max_x; x++) {
+      bool covered = true;
+      for (int i = 0; i < 3; i++) {
+        covered = covered && triangle.edge_origin[i] + int64_t(triangle.edge_dx[i]) * x +
+                             int64_t(triangle.edge_dy[i]) * y >= 0;
+      }
+      if (!covered) {
+        continue;
+      }
+      auto fx = static_cast<float>(x);
+      auto fy = static_cast<float>(y);
+      float z = attributes[0][0] + attributes[0][1] * fx + attributes[0][2] * fy;
+      size_t index = static_cast<size_t>(y) * stride + x;
+      if (!(z < depth[index])) {
+        continue;
+      }
+      float one_over_w = attributes[1][0] + attributes[1][1] * fx + attributes[1][2] * fy;
+      float w = 1.0f / one_over_w;
+      float u = (attributes[2][0] + attributes[2][1] * fx + attributes[2][2] * fy) * w;
+      float v = (attributes[3][0] + attributes[3][1] * fx + attributes[3][2] * fy) * w;
+      glm::vec4 a = SampleBilinear(*material.texture1, u, v);
+      glm::vec4 b = SampleBilinear(*material.texture2, u, v);
+      glm::vec4 result = a + (b - a) * material.mix;
+      uint32_t packed = 0;
+      for (int i = 0; i < 4; i++) {
+        packed |= static_cast<uint32_t>(std::lrint(std::clamp(result[i], 0.0f, 255.0f))) << (i * 8);
+      }
+      depth[index] = z;
+      color[index] = packed;
+    }
+  }
+}
+
+#ifdef UTILS_SIMD_AVX2
+
+struct TexelsAvx2 {
+  __m256 channels[4];
+};
+
+UTILS_TARGET_AVX2 inline TexelsAvx2 UnpackAvx2(__m256i packed) {
+  __m256i byte_mask = _mm256_set1_epi32(0xff);
+  TexelsAvx2 texels;
+  texels.channels[0] = _mm256_cvtepi32_ps(_mm256_and_si256(packed, byte_mask));
+  texels.channels[1] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(packed, 8), byte_mask));
+  texels.channels[2] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(packed, 16), byte_mask));
+  texels.channels[3] = _mm256_cvtepi32_ps(_mm256_srli_epi32(packed, 24));
+  return texels;
+}
+
+UTILS_TARGET_AVX2 inline __m256i WrapAvx2(__m256 value, int size) {
+  __m256 fsize = _mm256_set1_ps(static_cast<float>(size));
+  __m256 wrapped = _mm256_sub_ps(value, _mm256_mul_ps(fsize, _mm256_floor_ps(_mm256_div_ps(value, fsize))));
+  // NaN转成整数后为INT_MIN，截断后下标总是有效
+  __m256i index = _mm256_cvttps_epi32(wrapped);
+  return _mm256_min_epi32(_mm256_max_epi32(index, _mm256_setzero_si256()), _mm256_set1_epi32(size - 1));
+}
+
+// 与SampleBilinear的计算顺序相同，8个像素一起采样
+UTILS_TARGET_AVX2 TexelsAvx2 SampleBilinearAvx2(const SoftTexture& texture, __m256 u, __m256 v) {
+  __m256 half = _mm256_set1_ps(0.5f);
+  __m256 x = _mm256_sub_ps(_mm256_mul_ps(u, _mm256_set1_ps(static_cast<float>(texture.width))), half);
+  __m256 y = _mm256_sub_ps(_mm256_mul_ps(v, _mm256_set1_ps(static_cast<float>(texture.height))), half);
+  __m256 x_floor = _mm256_floor_ps(x);
+  __m256 y_floor = _mm256_floor_ps(y);
+  __m256 fx = _mm256_sub_ps(x, x_floor);
+  __m256 fy = _mm256_sub_ps(y, y_floor);
+  __m256i x0 = WrapAvx2(x_floor, texture.width);
+  __m256i y0 = WrapAvx2(y_floor, texture.height);
+  __m256i one = _mm256_set1_epi32(1);
+  __m256i x1 = _mm256_add_epi32(x0, one);
+  __m256i y1 = _mm256_add_epi32(y0, one);
+  x1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(x1, _mm256_set1_epi32(texture.width)), x1);
+  y1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(y1, _mm256_set1_epi32(texture.height)), y1);
+  __m256i width = _mm256_set1_epi32(texture.width);
+  __m256i row0 = _mm256_mullo_epi32(y0, width);
+  __m256i row1 = _mm256_mullo_epi32(y1, width);
+  const auto* base = reinterpret_cast<const int*>(texture.texels.data());
+  TexelsAvx2 c00 = UnpackAvx2(_mm256_i32gather_epi32(base, _mm256_add_epi32(row0, x0), 4));
+  TexelsAvx2 c10 = UnpackAvx2(_mm256_i32gather_epi32(base, _mm256_add_epi32(row0, x1), 4));
+  TexelsAvx2 c01 = UnpackAvx2(_mm256_i32gather_epi32(base, _mm256_add_epi32(row1, x0), 4));
+  TexelsAvx2 c11 = UnpackAvx2(_mm256_i32gather_epi32(base, _mm256_add_epi32(row1, x1), 4));
+  TexelsAvx2 result;
+  for (int i = 0; i < 4; i++) {
+    __m256 top = _mm256_add_ps(c00.channels[i], _mm256_mul_ps(_mm256_sub_ps(c10.channels[i], c00.channels[i]), fx));
+    __m256 bottom =
+        _mm256_add_ps(c01.channels[i], _mm256_mul_ps(_mm256_sub_ps(c11.channels[i], c01.channels[i]), fx));
+    result.channels[i] = _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), fy));
+  }
+  return result;
+}
+
+// 每次处理一行中对齐的8个像素：三个边函数的符号位或在一起判断覆盖，再做深度测试和着色
+UTILS_TARGET_AVX2 void RasterizeAvx2(const SoftRasterizer::Triangle& triangle, const SoftMaterial& material,
+                                     const TileRect& rect, int stride, uint32_t* color, float* depth) {
+  const float(*attributes)[3] = triangle.attributes;
+  __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256 float_lanes = _mm256_cvtepi32_ps(lanes);
+  __m256i edge_lanes[3];
+  __m256i edge_steps[3];
+  for (int i = 0; i < 3; i++) {
+    edge_lanes[i] = _mm256_mullo_epi32(_mm256_set1_epi32(triangle.edge_dx[i]), lanes);
+    edge_steps[i] = _mm256_set1_epi32(triangle.edge_dx[i] * 8);
+  }
+  __m256 attribute_lanes[4];
+  __m256 attribute_steps[4];
+  for (int i = 0; i < 4; i++) {
+    attribute_lanes[i] = _mm256_mul_ps(_mm256_set1_ps(attributes[i][1]), float_lanes);
+    attribute_steps[i] = _mm256_set1_ps(attributes[i][1] * 8.0f);
+  }
+  __m256 mix = _mm256_set1_ps(material.mix);
+  __m256 max_channel = _mm256_set1_ps(255.0f);
+  __m256i minus_one = _mm256_set1_epi32(-1);
+
+  int start_x = rect.min_x & ~7;
+  for (int y = rect.min_y; y <= rect.max_y; y++) {
+    __m256i edges[3];
+    for (int i = 0; i < 3; i++) {
+      int64_t row = triangle.edge_origin[i] + int64_t(triangle.edge_dx[i]) * start_x + int64_t(triangle.edge_dy[i]) * y;
+      row = std::clamp(row, -kEdgeClamp, kEdgeClamp);
+      edges[i] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(row)), edge_lanes[i]);
+    }
+    __m256 values[4];
+    for (int i = 0; i < 4; i++) {
+      float row = attributes[i][0] + attributes[i][1] * static_cast<float>(start_x) +
+                  attributes[i][2] * static_cast<float>(y);
+      values[i] = _mm256_add_ps(_mm256_set1_ps(row), attribute_lanes[i]);
+    }
+    size_t row_offset = static_cast<size_t>(y) * stride;
+    for (int x = start_x; x <= rect.max_x; x += 8) {
+      __m256i sign = _mm256_or_si256(_mm256_or_si256(edges[0], edges[1]), edges[2]);
+      __m256i mask = _mm256_and_si256(_mm256_cmpgt_epi32(sign, minus_one),
+                                      _mm256_cmpgt_epi32(_mm256_set1_epi32(rect.max_x - x + 1), lanes));
+      if (!_mm256_testz_si256(mask, mask)) {
+        float* depth_row = depth + row_offset + x;
+        __m256 old_depth = _mm256_loadu_ps(depth_row);
+        __m256 z = values[0];
+        mask = _mm256_and_si256(mask, _mm256_castps_si256(_mm256_cmp_ps(z, old_depth, _CMP_LT_OQ)));
+        if (!_mm256_testz_si256(mask, mask)) {
+          __m256 float_mask = _mm256_castsi256_ps(mask);
+          _mm256_storeu_ps(depth_row, _mm256_blendv_ps(old_depth, z, float_mask));
+
+          __m256 w = _mm256_div_ps(_mm256_set1_ps(1.0f), values[1]);
+          __m256 u = _mm256_mul_ps(values[2], w);
+          __m256 v = _mm256_mul_ps(values[3], w);
+          TexelsAvx2 a = SampleBilinearAvx2(*material.texture1, u, v);
+          TexelsAvx2 b = SampleBilinearAvx2(*material.texture2, u, v);
+          __m256i packed = _mm256_setzero_si256();
+          for (int i = 0; i < 4; i++) {
+            __m256 channel = _mm256_add_ps(a.channels[i], _mm256_mul_ps(_mm256_sub_ps(b.channels[i], a.channels[i]), mix));
+            channel = _mm256_min_ps(_mm256_max_ps(channel, _mm256_setzero_ps()), max_channel);
+            packed = _mm256_or_si256(packed, _mm256_slli_epi32(_mm256_cvtps_epi32(channel), i * 8));
+          }
+          auto* color_row = reinterpret_cast<__m256i*>(color + row_offset + x);
+          __m256i old_color = _mm256_loadu_si256(color_row);
+          _mm256_storeu_si256(color_row, _mm256_blendv_epi8(old_color, packed, mask));
+        }
+      }
+      for (int i = 0; i < 3; i++) {
+        edges[i] = _mm256_add_epi32(edges[i], edge_steps[i]);
+      }
+      for (int i = 0; i < 4; i++) {
+        values[i] = _mm256_add_ps(values[i], attribute_steps[i]);
+      }
+    }
+  }
+}
+
+#endif  // UTILS_SIMD_AVX2
+
+}  // namespace
+
+RasterKernel BestRasterKernel() {
+#ifdef UTILS_SIMD_AVX2
+  if (HasAvx2()) {
+    return RasterKernel::kAvx2;
+  }
+#endif
+  return RasterKernel::kScalar;
+}
+
+const char* RasterKernelName(RasterKernel kernel) {
+  switch (kernel) {
+    case RasterKernel::kScalar:
+      return "scalar";
+    case RasterKernel::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+bool LoadSoftTexture(const std::string& image_path, bool flip_y, SoftTexture* texture) {
+  std::vector<uint8_t> rgba;
+  if (!LoadImageRgba(image_path, flip_y, &texture->width, &texture->height, &rgba)) {
+    return false;
+  }
+  texture->texels.resize(static_cast<size_t>(texture->width) * texture->height);
+  std::memcpy(texture->texels.data(), rgba.data(), rgba.size());
+  return true;
+}
+
+bool SoftRasterizer::Init(int width, int height, ThreadPool* pool) {
+  if (width <= 0 || height <= 0 || width > kMaxSize || height > kMaxSize) {
+    SPDLOG_ERROR("Invalid software framebuffer size {}x{}", width, height);
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  stride_ = (width + 7) & ~7;
+  tiles_x_ = (width + kTileSize - 1) / kTileSize;
+  tiles_y_ = (height + kTileSize - 1) / kTileSize;
+  color_.assign(static_cast<size_t>(stride_) * height, 0);
+  depth_.assign(static_cast<size_t>(stride_) * height, 1.0f);
+  pool_ = pool;
+  return true;
+}
+
+void SoftRasterizer::BeginFrame(const glm::vec4& clear_color) {
+  clear_color_ = PackColor(clear_color);
+  commands_.clear();
+  materials_.clear();
+}
+
+void SoftRasterizer::Draw(const std::vector<SoftVertex>& vertices, const std::vector<uint32_t>& indices,
+                          const glm::mat4& mvp, const SoftMaterial& material) {
+  if (material.texture1 == nullptr || material.texture2 == nullptr) {
+    SPDLOG_ERROR("Software material needs two textures.");
+    return;
+  }
+  materials_.push_back(material);
+  commands_.push_back({&vertices, &indices, mvp, static_cast<uint32_t>(materials_.size() - 1)});
+}
+
+void SoftRasterizer::EndFrame() {
+  PROFILE_SCOPE("SoftRasterizer::EndFrame");
+  stats_ = SoftRasterStats();
+  auto parallel_for = [this](size_t count, size_t grain, const ThreadPool::RangeFunc& func) {
+    if (pool_ != nullptr) {
+      pool_->ParallelFor(count, grain, func);
+    } else if (count > 0) {
+      func(0, count);
+    }
+  };
+
+  auto setup_start = Clock::now();
+  // 顶点变换：每个顶点只变换一次，三角形设置时按索引读取
+  vertex_offsets_.assign(1, 0);
+  triangle_offsets_.assign(1, 0);
+  for (const DrawCommand& command : commands_) {
+    vertex_offsets_.push_back(vertex_offsets_.back() + command.vertices->size());
+    triangle_offsets_.push_back(triangle_offsets_.back() + command.indices->size() / 3);
+  }
+  clip_positions_.resize(vertex_offsets_.back());
+  for (size_t i = 0; i < commands_.size(); i++) {
+    const DrawCommand& command = commands_[i];
+    glm::vec4* out = clip_positions_.data() + vertex_offsets_[i];
+    parallel_for(command.vertices->size(), kVertexGrain, [&command, out](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; v++) {
+        out[v] = command.mvp * glm::vec4((*command.vertices)[v].position, 1.0f);
+      }
+    });
+  }
+
+  // 三角形按编号分块设置和分箱，每块的结果单独保存，光栅化时按块的顺序读取就是提交顺序
+  size_t triangle_count = triangle_offsets_.back();
+  size_t chunk_count = (triangle_count + kSetupGrain - 1) / kSetupGrain;
+  if (bins_.size() < chunk_count) {
+    bins_.resize(chunk_count);
+  }
+  size_t tile_count = static_cast<size_t>(tiles_x_) * tiles_y_;
+  for (size_t i = 0; i < chunk_count; i++) {
+    bins_[i].triangles.clear();
+    bins_[i].tiles.resize(tile_count);
+    for (std::vector<uint32_t>& tile : bins_[i].tiles) {
+      tile.clear();
+    }
+    bins_[i].clipped = 0;
+  }
+  chunk_count_ = chunk_count;
+  parallel_for(chunk_count, 1, [this, triangle_count](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; chunk++) {
+      SetupTriangles(chunk * kSetupGrain, std::min((chunk + 1) * kSetupGrain, triangle_count), &bins_[chunk]);
+    }
+  });
+  for (size_t i = 0; i < chunk_count; i++) {
+    stats_.triangles += bins_[i].triangles.size();
+    stats_.clipped_triangles += bins_[i].clipped;
+    for (const std::vector<uint32_t>& tile : bins_[i].tiles) {
+      stats_.bin_entries += tile.size();
+    }
+  }
+  stats_.setup_ms = ElapsedMs(setup_start);
+
+  auto raster_start = Clock::now();
+  parallel_for(tile_count, 1, [this](size_t begin, size_t end) {
+    for (size_t tile = begin; tile < end; tile++) {
+      RasterizeTile(static_cast<int>(tile));
+    }
+  });
+  stats_.raster_ms = ElapsedMs(raster_start);
+}
+
+void SoftRasterizer::SetupTriangles(size_t begin, size_t end, BinContext* context) const {
+  size_t command_index = std::upper_bound(triangle_offsets_.begin(), triangle_offsets_.end(), begin) -
+                         triangle_offsets_.begin() - 1;
+  for (size_t triangle = begin; triangle < end; triangle++) {
+    while (triangle >= triangle_offsets_[command_index + 1]) {
+      command_index++;
+    }
+    const DrawCommand& command = commands_[command_index];
+    const uint32_t* indices = command.indices->data() + (triangle - triangle_offsets_[command_index]) * 3;
+    const glm::vec4* positions = clip_positions_.data() + vertex_offsets_[command_index];
+
+    ClipVertex vertices[9];
+    uint32_t outcodes[3];
+    for (int i = 0; i < 3; i++) {
+      vertices[i].position = positions[indices[i]];
+      vertices[i].tex_coord = (*command.vertices)[indices[i]].tex_coord;
+      outcodes[i] = Outcode(vertices[i].position, kGuardBand);
+    }
+    // 三个顶点都在同一个平面外侧时整个三角形不可见
+    if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0) {
+      continue;
+    }
+    uint32_t crossed = outcodes[0] | outcodes[1] | outcodes[2];
+    int count = 3;
+    if (crossed != 0) {
+      count = ClipPolygon(vertices, count, crossed);
+      context->clipped++;
+    }
+    for (int i = 1; i + 1 < count; i++) {
+      glm::vec4 clip[3] = {vertices[0].position, vertices[i].position, vertices[i + 1].position};
+      glm::vec2 tex_coord[3] = {vertices[0].tex_coord, vertices[i].tex_coord, vertices[i + 1].tex_coord};
+      SetupTriangle(clip, tex_coord, command.material, context);
+    }
+  }
+}
+
+void SoftRasterizer::SetupTriangle(const glm::vec4 clip[3], const glm::vec2 tex_coord[3], uint32_t material,
+                                   BinContext* context) const {
+  // 视口变换后吸附到亚像素网格
+  int64_t sx[3];
+  int64_t sy[3];
+  double values[4][3];
+  for (int i = 0; i < 3; i++) {
+    double one_over_w = 1.0 / clip[i].w;
+    double x = (clip[i].x * one_over_w * 0.5 + 0.5) * width_;
+    double y = (clip[i].y * one_over_w * 0.5 + 0.5) * height_;
+    sx[i] = std::llround(x * kSubpixelScale);
+    sy[i] = std::llround(y * kSubpixelScale);
+    values[0][i] = clip[i].z * one_over_w * 0.5 + 0.5;
+    values[1][i] = one_over_w;
+    values[2][i] = tex_coord[i].x * one_over_w;
+    values[3][i] = tex_coord[i].y * one_over_w;
+  }
+  int64_t area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+  if (area == 0) {
+    return;
+  }
+  // 没有背面剔除，顺时针的三角形交换两个顶点
+  int order[3] = {0, 1, 2};
+  if (area < 0) {
+    std::swap(order[1], order[2]);
+    area = -area;
+  }
+
+  Triangle triangle;
+  int64_t min_x = std::min({sx[0], sx[1], sx[2]});
+  int64_t min_y = std::min({sy[0], sy[1], sy[2]});
+  int64_t max_x = std::max({sx[0], sx[1], sx[2]});
+  int64_t max_y = std::max({sy[0], sy[1], sy[2]});
+  constexpr int64_t kHalf = kSubpixelScale / 2;
+  triangle.min_x = static_cast<int>(std::max<int64_t>(-FloorDiv(-(min_x - kHalf), kSubpixelScale), 0));
+  triangle.min_y = static_cast<int>(std::max<int64_t>(-FloorDiv(-(min_y - kHalf), kSubpixelScale), 0));
+  triangle.max_x = static_cast<int>(std::min<int64_t>(FloorDiv(max_x - kHalf, kSubpixelScale), width_ - 1));
+  triangle.max_y = static_cast<int>(std::min<int64_t>(FloorDiv(max_y - kHalf, kSubpixelScale), height_ - 1));
+  if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+    return;
+  }
+
+  // 边a->b：E(p) = (b - a) x (p - a)，逆时针时内部为正。左上规则：上边和左边上的像素算覆盖，其余边不算
+  for (int i = 0; i < 3; i++) {
+    int a = order[i];
+    int b = order[(i + 1) % 3];
+    int64_t dx = sx[b] - sx[a];
+    int64_t dy = sy[b] - sy[a];
+    bool top_left = dy < 0 || (dy == 0 && dx < 0);
+    triangle.edge_origin[i] = dx * (kHalf - sy[a]) - dy * (kHalf - sx[a]) - (top_left ? 0 : 1);
+    triangle.edge_dx[i] = static_cast<int32_t>(-dy * kSubpixelScale);
+    triangle.edge_dy[i] = static_cast<int32_t>(dx * kSubpixelScale);
+  }
+
+  // 插值量在屏幕空间是线性的，求出关于像素坐标的平面方程，原点为像素(0, 0)的中心
+  double x0 = static_cast<double>(sx[0]) / kSubpixelScale;
+  double y0 = static_cast<double>(sy[0]) / kSubpixelScale;
+  double x1 = static_cast<double>(sx[1]) / kSubpixelScale - x0;
+  double y1 = static_cast<double>(sy[1]) / kSubpixelScale - y0;
+  double x2 = static_cast<double>(sx[2]) / kSubpixelScale - x0;
+  double y2 = static_cast<double>(sy[2]) / kSubpixelScale - y0;
+  double det = x1 * y2 - x2 * y1;
+  for (int i = 0; i < 4; i++) {
+    double d1 = values[i][1] - values[i][0];
+    double d2 = values[i][2] - values[i][0];
+    double ddx = (d1 * y2 - d2 * y1) / det;
+    double ddy = (d2 * x1 - d1 * x2) / det;
+    triangle.attributes[i][0] = static_cast<float>(values[i][0] + ddx * (0.5 - x0) + ddy * (0.5 - y0));
+    triangle.attributes[i][1] = static_cast<float>(ddx);
+    triangle.attributes[i][2] = static_cast<float>(ddy);
+  }
+  triangle.material = material;
+
+  auto index = static_cast<uint32_t>(context->triangles.size());
+  context->triangles.push_back(triangle);
+  for (int ty = triangle.min_y / kTileSize; ty <= triangle.max_y / kTileSize; ty++) {
+    for (int tx = triangle.min_x / kTileSize; tx <= triangle.max_x / kTileSize; tx++) {
+      context->tiles[static_cast<size_t>(ty) * tiles_x_ + tx].push_back(index);
+    }
+  }
+}
+
+void SoftRasterizer::RasterizeTile(int tile) {
+  TileRect tile_rect;
+  tile_rect.min_x = (tile % tiles_x_) * kTileSize;
+  tile_rect.min_y = (tile / tiles_x_) * kTileSize;
+  tile_rect.max_x = std::min(tile_rect.min_x + kTileSize, width_) - 1;
+  tile_rect.max_y = std::min(tile_rect.min_y + kTileSize, height_) - 1;
+
+  // 清屏也在分块中做，分块的数据在光栅化前已经在缓存里
+  for (int y = tile_rect.min_y; y <= tile_rect.max_y; y++) {
+    size_t offset = static_cast<size_t>(y) * stride_;
+    std::fill(color_.begin() + offset + tile_rect.min_x, color_.begin() + offset + tile_rect.max_x + 1, clear_color_);
+    std::fill(depth_.begin() + offset + tile_rect.min_x, depth_.begin() + offset + tile_rect.max_x + 1, 1.0f);
+  }
+
+  for (size_t chunk = 0; chunk < chunk_count_; chunk++) {
+    const BinContext& bin = bins_[chunk];
+    for (uint32_t index : bin.tiles[tile]) {
+      const Triangle& triangle = bin.triangles[index];
+      TileRect rect;
+      rect.min_x = std::max(tile_rect.min_x, triangle.min_x);
+      rect.min_y = std::max(tile_rect.min_y, triangle.min_y);
+      rect.max_x = std::min(tile_rect.max_x, triangle.max_x);
+      rect.max_y = std::min(tile_rect.max_y, triangle.max_y);
+      const SoftMaterial& material = materials_[triangle.material];
+#ifdef UTILS_SIMD_AVX2
+      if (kernel_ == RasterKernel::kAvx2 && HasAvx2()) {
+        RasterizeAvx2(triangle, material, rect, stride_, color_.data(), depth_.data());
+        continue;
+      }
+#endif
+      RasterizeScalar(triangle, material, rect, stride_, color_.data(), depth_.data());
+    }
+  }
+}
+
+void SoftRasterizer::ReadPixels(std::vector<uint8_t>* rgba) const {
+  rgba->resize(static_cast<size_t>(width_) * height_ * 4);
+  for (int y = 0; y < height_; y++) {
+    std::memcpy(rgba->data() + static_cast<size_t>(y) * width_ * 4, color_.data() + static_cast<size_t>(y) * stride_,
+                static_cast<size_t>(width_) * 4);
+  }
+}
+
+}  // namespace utils
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace utils {
+
+class ThreadPool;
+
+enum class RasterKernel {
+  kScalar,
+  kAvx2,
+};
+
+// CPU不支持AVX2时返回kScalar
+RasterKernel BestRasterKernel();
+const char* RasterKernelName(RasterKernel kernel);
+
+// RGBA8纹理，第0行在底部（与GL的纹理坐标一致），环绕方式为GL_REPEAT
+struct SoftTexture {
+  int width = 0;
+  int height = 0;
+  std::vector<uint32_t> texels;
+};
+
+// 与LoadTexture相同的加载方式，统一转成RGBA
+bool LoadSoftTexture(const std::string& image_path, bool flip_y, SoftTexture* texture);
+
+struct SoftVertex {
+  glm::vec3 position;
+  glm::vec2 tex_coord;
+};
+
+// 对应1.3fps_camera.fs：mix(texture(texture1, uv), texture(texture2, uv), mix)，双线性过滤
+struct SoftMaterial {
+  const SoftTexture* texture1 = nullptr;
+  const SoftTexture* texture2 = nullptr;
+  float mix = 0.2f;
+};
+
+struct SoftRasterStats {
+  size_t triangles = 0;
+  size_t clipped_triangles = 0;
+  // 三角形在分块中出现的总次数
+  size_t bin_entries = 0;
+  double setup_ms = 0.0;
+  double raster_ms = 0.0;
+};
+
+// 分块的软件光栅化，渲染结果与GL的1.3fps_camera一致：
+//   1. Draw只记录绘制命令；
+//   2. EndFrame中并行做顶点变换、裁剪和三角形设置，按覆盖的屏幕分块放入各线程自己的列表；
+//   3. 各分块并行光栅化，每个分块按提交顺序处理列表中的三角形，不需要加锁。
+// 边函数用4位亚像素精度的整数，遵循左上填充规则，相邻三角形的公共边不会重复或遗漏像素。
+// 深度测试为GL_LESS，深度范围[0, 1]。颜色缓冲第0行在底部，与glReadPixels的结果一致。
+class SoftRasterizer {
+public:
+  static constexpr int kTileSize = 64;
+  // 边函数在32位整数中计算，限制了帧缓冲的最大尺寸
+  static constexpr int kMaxSize = 4096;
+
+  // 屏幕空间的三角形，顶点按逆时针排列。边函数在像素(0, 0)中心的值已经加上填充规则的偏置，
+  // 所有边的值都大于等于0时像素被覆盖。插值量z、1/w、u/w、v/w在屏幕空间是线性的，
+  // 每个保存为像素(0, 0)中心的值和x、y方向的增量
+  struct Triangle {
+    int64_t edge_origin[3];
+    int32_t edge_dx[3];
+    int32_t edge_dy[3];
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+    float inv_area;
+    float attributes[4][3];
+    uint32_t material;
+  };
+
+  SoftRasterizer() = default;
+
+  SoftRasterizer(const SoftRasterizer&) = delete;
+  SoftRasterizer& operator=(const SoftRasterizer&) = delete;
+
+  // pool为空时在调用线程上执行
+  bool Init(int width, int height, ThreadPool* pool = nullptr);
+
+  void set_kernel(RasterKernel kernel) {
+    kernel_ = kernel;
+  }
+
+  // clear_color为RGBA，各分量[0, 1]
+  void BeginFrame(const glm::vec4& clear_color);
+
+  // 顶点和材质在EndFrame之前必须保持有效
+  void Draw(const std::vector<SoftVertex>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& mvp,
+            const SoftMaterial& material);
+
+  void EndFrame();
+
+  int width() const {
+    return width_;
+  }
+
+  int height() const {
+    return height_;
+  }
+
+  // 按行紧密排列的RGBA8，第0行在底部
+  void ReadPixels(std::vector<uint8_t>* rgba) const;
+
+  const SoftRasterStats& stats() const {
+    return stats_;
+  }
+
+private:
+  struct DrawCommand {
+    const std::vector<SoftVertex>* vertices;
+    const std::vector<uint32_t>* indices;
+    glm::mat4 mvp;
+    uint32_t material;
+  };
+
+  // 一块三角形的设置结果：三角形和每个分块中的三角形下标
+  struct BinContext {
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> tiles;
+    size_t clipped = 0;
+  };
+
+  void SetupTriangles(size_t begin, size_t end, BinContext* context) const;
+  void SetupTriangle(const glm::vec4 clip[3], const glm::vec2 tex_coord[3], uint32_t material,
+                     BinContext* context) const;
+  void RasterizeTile(int tile);
+
+private:
+  int width_ = 0;
+  int height_ = 0;
+  // 行跨度按8个像素对齐，AVX2每次处理一行中的8个像素
+  int stride_ = 0;
+  int tiles_x_ = 0;
+  int tiles_y_ = 0;
+  std::vector<uint32_t> color_;
+  std::vector<float> depth_;
+
+  ThreadPool* pool_ = nullptr;
+  RasterKernel kernel_ = BestRasterKernel();
+
+  uint32_t clear_color_ = 0;
+  std::vector<DrawCommand> commands_;
+  std::vector<SoftMaterial> materials_;
+  // 所有绘制的顶点和三角形按提交顺序编号，offsets[i]为第i个绘制的第一个顶点或三角形
+  std::vector<size_t> vertex_offsets_;
+  std::vector<size_t> triangle_offsets_;
+  std::vector<glm::vec4> clip_positions_;
+  // 三角形按编号分块设置，bins_[i]为第i块的结果，光栅化时按块的顺序处理，保持提交顺序
+  std::vector<BinContext> bins_;
+  size_t chunk_count_ = 0;
+  SoftRasterStats stats_;
+};
+
+}  // namespace utils
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+#include "utils/job_system.h"
+
+namespace utils {
+
+// 数据并行的简单接口，内部是work stealing的JobSystem，调用线程也参与计算。
+// 任务内部可以再次调用ParallelFor，也可以通过jobs()提交其它任务。
+class ThreadPool {
+public:
+  using RangeFunc = JobSystem::RangeFunc;
+
+  // thread_count包含调用线程，为0时使用硬件线程数。
+  explicit ThreadPool(unsigned thread_count = 0) : jobs_(thread_count) {}
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned thread_count() const {
+    return jobs_.thread_count();
+  }
+
+  // 把[0, count)切成grain大小的块并行执行func(begin, end)，全部完成后返回。
+  // 块的起点是grain的整数倍，调用方可以用begin / grain作为块号
+  void ParallelFor(size_t count, size_t grain, const RangeFunc& func) {
+    jobs_.ParallelForFixed(count, grain, func);
+  }
+
+  JobSystem& jobs() {
+    return jobs_;
+  }
+
+private:
+  JobSystem jobs_;
+};
+
+}  // namespace utils
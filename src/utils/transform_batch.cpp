@@ -0,0 +1,565 @@
+#include "utils/transform_batch.h"
+
+#include <cmath>
+
+#include "utils/simd_dispatch.h"
+
+namespace utils {
+
+void TrsArrays::Resize(size_t count) {
+  position_x.resize(count);
+  position_y.resize(count);
+  position_z.resize(count);
+  rotation_x.resize(count);
+  rotation_y.resize(count);
+  rotation_z.resize(count);
+  rotation_w.resize(count);
+  scale_x.resize(count);
+  scale_y.resize(count);
+  scale_z.resize(count);
+}
+
+void TrsArrays::Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+  position_x[index] = position.x;
+  position_y[index] = position.y;
+  position_z[index] = position.z;
+  rotation_x[index] = rotation.x;
+  rotation_y[index] = rotation.y;
+  rotation_z[index] = rotation.z;
+  rotation_w[index] = rotation.w;
+  scale_x[index] = scale.x;
+  scale_y[index] = scale.y;
+  scale_z[index] = scale.z;
+}
+
+namespace {
+
+// m[c][r]为第c列第r行，第3列是平移，省略固定为0 0 0 1的第3行。
+// 与TransformHierarchy的ComposeTrs计算顺序相同
+inline void ComposeScalar(const TrsArrays& trs, size_t i, float m[4][3]) {
+  float x = trs.rotation_x[i];
+  float y = trs.rotation_y[i];
+  float z = trs.rotation_z[i];
+  float w = trs.rotation_w[i];
+  float xx = x * x;
+  float yy = y * y;
+  float zz = z * z;
+  float xy = x * y;
+  float xz = x * z;
+  float yz = y * z;
+  float wx = w * x;
+  float wy = w * y;
+  float wz = w * z;
+  float sx = trs.scale_x[i];
+  float sy = trs.scale_y[i];
+  float sz = trs.scale_z[i];
+
+  m[0][0] = (1.0f - 2.0f * (yy + zz)) * sx;
+  m[0][1] = 2.0f * (xy + wz) * sx;
+  m[0][2] = 2.0f * (xz - wy) * sx;
+  m[1][0] = 2.0f * (xy - wz) * sy;
+  m[1][1] = (1.0f - 2.0f * (xx + zz)) * sy;
+  m[1][2] = 2.0f * (yz + wx) * sy;
+  m[2][0] = 2.0f * (xz + wy) * sz;
+  m[2][1] = 2.0f * (yz - wx) * sz;
+  m[2][2] = (1.0f - 2.0f * (xx + yy)) * sz;
+  m[3][0] = trs.position_x[i];
+  m[3][1] = trs.position_y[i];
+  m[3][2] = trs.position_z[i];
+}
+
+void ModelsScalar(const TrsArrays& trs, size_t begin, size_t end, glm::mat4* models) {
+  for (size_t i = begin; i < end; i++) {
+    float m[4][3];
+    ComposeScalar(trs, i, m);
+    for (int c = 0; c < 4; c++) {
+      models[i][c] = glm::vec4(m[c][0], m[c][1], m[c][2], c == 3 ? 1.0f : 0.0f);
+    }
+  }
+}
+
+void Models3x4Scalar(const TrsArrays& trs, size_t begin, size_t end, Matrix3x4* models) {
+  for (size_t i = begin; i < end; i++) {
+    float m[4][3];
+    ComposeScalar(trs, i, m);
+    for (int r = 0; r < 3; r++) {
+      models[i].rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+    }
+  }
+}
+
+// 模型矩阵的第3行是0 0 0 1，每个元素只需要3次（平移列4次）乘加
+void MvpScalar(const TrsArrays& trs, const glm::mat4& vp, size_t begin, size_t end, glm::mat4* mvps) {
+  for (size_t i = begin; i < end; i++) {
+    float m[4][3];
+    ComposeScalar(trs, i, m);
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++) {
+        float value = vp[0][r] * m[c][0] + vp[1][r] * m[c][1] + vp[2][r] * m[c][2];
+        if (c == 3) {
+          value += vp[3][r];
+        }
+        mvps[i][c][r] = value;
+      }
+    }
+  }
+}
+
+void BoundsScalar(const TrsArrays& trs, const AabbArrays& local, size_t begin, size_t end, AabbArrays* world) {
+  float* centers[3] = { world->center_x.data(), world->center_y.data(), world->center_z.data() };
+  float* extents[3] = { world->extent_x.data(), world->extent_y.data(), world->extent_z.data() };
+  for (size_t i = begin; i < end; i++) {
+    float m[4][3];
+    ComposeScalar(trs, i, m);
+    float cx = local.center_x[i];
+    float cy = local.center_y[i];
+    float cz = local.center_z[i];
+    float ex = local.extent_x[i];
+    float ey = local.extent_y[i];
+    float ez = local.extent_z[i];
+    for (int r = 0; r < 3; r++) {
+      centers[r][i] = m[0][r] * cx + m[1][r] * cy + m[2][r] * cz + m[3][r];
+      extents[r][i] = std::abs(m[0][r]) * ex + std::abs(m[1][r]) * ey + std::abs(m[2][r]) * ez;
+    }
+  }
+}
+
+#ifdef UTILS_SIMD_SSE
+
+// 每次4个物体，每个寄存器是4个物体的同一个矩阵元素
+inline void ComposeSse(const TrsArrays& trs, size_t i, __m128 m[4][3]) {
+  __m128 x = _mm_loadu_ps(&trs.rotation_x[i]);
+  __m128 y = _mm_loadu_ps(&trs.rotation_y[i]);
+  __m128 z = _mm_loadu_ps(&trs.rotation_z[i]);
+  __m128 w = _mm_loadu_ps(&trs.rotation_w[i]);
+  __m128 xx = _mm_mul_ps(x, x);
+  __m128 yy = _mm_mul_ps(y, y);
+  __m128 zz = _mm_mul_ps(z, z);
+  __m128 xy = _mm_mul_ps(x, y);
+  __m128 xz = _mm_mul_ps(x, z);
+  __m128 yz = _mm_mul_ps(y, z);
+  __m128 wx = _mm_mul_ps(w, x);
+  __m128 wy = _mm_mul_ps(w, y);
+  __m128 wz = _mm_mul_ps(w, z);
+  __m128 sx = _mm_loadu_ps(&trs.scale_x[i]);
+  __m128 sy = _mm_loadu_ps(&trs.scale_y[i]);
+  __m128 sz = _mm_loadu_ps(&trs.scale_z[i]);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+
+  m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+  m[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+  m[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+  m[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+  m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+  m[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+  m[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+  m[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+  m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+  m[3][0] = _mm_loadu_ps(&trs.position_x[i]);
+  m[3][1] = _mm_loadu_ps(&trs.position_y[i]);
+  m[3][2] = _mm_loadu_ps(&trs.position_z[i]);
+}
+
+// 第k个物体的(a[k], b[k], c[k], d[k])写到out + k * stride
+inline void StoreTransposedSse(__m128 a, __m128 b, __m128 c, __m128 d, float* out, size_t stride) {
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+  _mm_storeu_ps(out, a);
+  _mm_storeu_ps(out + stride, b);
+  _mm_storeu_ps(out + 2 * stride, c);
+  _mm_storeu_ps(out + 3 * stride, d);
+}
+
+void ModelsSse(const TrsArrays& trs, glm::mat4* models) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(3);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 m[4][3];
+    ComposeSse(trs, i, m);
+    float* out = &models[i][0][0];
+    for (int c = 0; c < 4; c++) {
+      StoreTransposedSse(m[c][0], m[c][1], m[c][2], c == 3 ? one : zero, out + c * 4, 16);
+    }
+  }
+  ModelsScalar(trs, simd_end, count, models);
+}
+
+void Models3x4Sse(const TrsArrays& trs, Matrix3x4* models) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(3);
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 m[4][3];
+    ComposeSse(trs, i, m);
+    float* out = &models[i].rows[0].x;
+    for (int r = 0; r < 3; r++) {
+      StoreTransposedSse(m[0][r], m[1][r], m[2][r], m[3][r], out + r * 4, 12);
+    }
+  }
+  Models3x4Scalar(trs, simd_end, count, models);
+}
+
+void MvpSse(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(3);
+  __m128 vp[4][4];
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      vp[c][r] = _mm_set1_ps(view_projection[c][r]);
+    }
+  }
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 m[4][3];
+    ComposeSse(trs, i, m);
+    float* out = &mvps[i][0][0];
+    for (int c = 0; c < 4; c++) {
+      __m128 column[4];
+      for (int r = 0; r < 4; r++) {
+        column[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vp[0][r], m[c][0]), _mm_mul_ps(vp[1][r], m[c][1])),
+                               _mm_mul_ps(vp[2][r], m[c][2]));
+        if (c == 3) {
+          column[r] = _mm_add_ps(column[r], vp[3][r]);
+        }
+      }
+      StoreTransposedSse(column[0], column[1], column[2], column[3], out + c * 4, 16);
+    }
+  }
+  MvpScalar(trs, view_projection, simd_end, count, mvps);
+}
+
+void BoundsSse(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(3);
+  float* centers[3] = { world->center_x.data(), world->center_y.data(), world->center_z.data() };
+  float* extents[3] = { world->extent_x.data(), world->extent_y.data(), world->extent_z.data() };
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  for (size_t i = 0; i < simd_end; i += 4) {
+    __m128 m[4][3];
+    ComposeSse(trs, i, m);
+    __m128 cx = _mm_loadu_ps(&local.center_x[i]);
+    __m128 cy = _mm_loadu_ps(&local.center_y[i]);
+    __m128 cz = _mm_loadu_ps(&local.center_z[i]);
+    __m128 ex = _mm_loadu_ps(&local.extent_x[i]);
+    __m128 ey = _mm_loadu_ps(&local.extent_y[i]);
+    __m128 ez = _mm_loadu_ps(&local.extent_z[i]);
+    for (int r = 0; r < 3; r++) {
+      __m128 center = _mm_add_ps(
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][r], cx), _mm_mul_ps(m[1][r], cy)), _mm_mul_ps(m[2][r], cz)),
+          m[3][r]);
+      __m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m[0][r], abs_mask), ex),
+                                            _mm_mul_ps(_mm_and_ps(m[1][r], abs_mask), ey)),
+                                 _mm_mul_ps(_mm_and_ps(m[2][r], abs_mask), ez));
+      _mm_storeu_ps(centers[r] + i, center);
+      _mm_storeu_ps(extents[r] + i, extent);
+    }
+  }
+  BoundsScalar(trs, local, simd_end, count, world);
+}
+
+#endif  // UTILS_SIMD_SSE
+
+#ifdef UTILS_SIMD_AVX2
+
+// 每次8个物体，与SSE实现相同，只是寄存器宽一倍
+UTILS_TARGET_AVX2 inline void ComposeAvx2(const TrsArrays& trs, size_t i, __m256 m[4][3]) {
+  __m256 x = _mm256_loadu_ps(&trs.rotation_x[i]);
+  __m256 y = _mm256_loadu_ps(&trs.rotation_y[i]);
+  __m256 z = _mm256_loadu_ps(&trs.rotation_z[i]);
+  __m256 w = _mm256_loadu_ps(&trs.rotation_w[i]);
+  __m256 xx = _mm256_mul_ps(x, x);
+  __m256 yy = _mm256_mul_ps(y, y);
+  __m256 zz = _mm256_mul_ps(z, z);
+  __m256 xy = _mm256_mul_ps(x, y);
+  __m256 xz = _mm256_mul_ps(x, z);
+  __m256 yz = _mm256_mul_ps(y, z);
+  __m256 wx = _mm256_mul_ps(w, x);
+  __m256 wy = _mm256_mul_ps(w, y);
+  __m256 wz = _mm256_mul_ps(w, z);
+  __m256 sx = _mm256_loadu_ps(&trs.scale_x[i]);
+  __m256 sy = _mm256_loadu_ps(&trs.scale_y[i]);
+  __m256 sz = _mm256_loadu_ps(&trs.scale_z[i]);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+
+  m[0][0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+  m[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+  m[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+  m[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+  m[1][1] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+  m[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+  m[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+  m[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+  m[2][2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+  m[3][0] = _mm256_loadu_ps(&trs.position_x[i]);
+  m[3][1] = _mm256_loadu_ps(&trs.position_y[i]);
+  m[3][2] = _mm256_loadu_ps(&trs.position_z[i]);
+}
+
+// 在每个128位半边内做4x4转置：低半边是物体0-3，高半边是物体4-7
+UTILS_TARGET_AVX2 inline void StoreTransposedAvx2(__m256 a, __m256 b, __m256 c, __m256 d, float* out,
+                                                  size_t stride) {
+  __m256 ab_low = _mm256_unpacklo_ps(a, b);
+  __m256 ab_high = _mm256_unpackhi_ps(a, b);
+  __m256 cd_low = _mm256_unpacklo_ps(c, d);
+  __m256 cd_high = _mm256_unpackhi_ps(c, d);
+  __m256 v0 = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 v1 = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 v2 = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 v3 = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(3, 2, 3, 2));
+  _mm_storeu_ps(out, _mm256_castps256_ps128(v0));
+  _mm_storeu_ps(out + stride, _mm256_castps256_ps128(v1));
+  _mm_storeu_ps(out + 2 * stride, _mm256_castps256_ps128(v2));
+  _mm_storeu_ps(out + 3 * stride, _mm256_castps256_ps128(v3));
+  _mm_storeu_ps(out + 4 * stride, _mm256_extractf128_ps(v0, 1));
+  _mm_storeu_ps(out + 5 * stride, _mm256_extractf128_ps(v1, 1));
+  _mm_storeu_ps(out + 6 * stride, _mm256_extractf128_ps(v2, 1));
+  _mm_storeu_ps(out + 7 * stride, _mm256_extractf128_ps(v3, 1));
+}
+
+UTILS_TARGET_AVX2 void ModelsAvx2(const TrsArrays& trs, glm::mat4* models) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(7);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 m[4][3];
+    ComposeAvx2(trs, i, m);
+    float* out = &models[i][0][0];
+    for (int c = 0; c < 4; c++) {
+      StoreTransposedAvx2(m[c][0], m[c][1], m[c][2], c == 3 ? one : zero, out + c * 4, 16);
+    }
+  }
+  ModelsScalar(trs, simd_end, count, models);
+}
+
+UTILS_TARGET_AVX2 void Models3x4Avx2(const TrsArrays& trs, Matrix3x4* models) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(7);
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 m[4][3];
+    ComposeAvx2(trs, i, m);
+    float* out = &models[i].rows[0].x;
+    for (int r = 0; r < 3; r++) {
+      StoreTransposedAvx2(m[0][r], m[1][r], m[2][r], m[3][r], out + r * 4, 12);
+    }
+  }
+  Models3x4Scalar(trs, simd_end, count, models);
+}
+
+UTILS_TARGET_AVX2 void MvpAvx2(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(7);
+  __m256 vp[4][4];
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      vp[c][r] = _mm256_set1_ps(view_projection[c][r]);
+    }
+  }
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 m[4][3];
+    ComposeAvx2(trs, i, m);
+    float* out = &mvps[i][0][0];
+    for (int c = 0; c < 4; c++) {
+      __m256 column[4];
+      for (int r = 0; r < 4; r++) {
+        column[r] = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(vp[0][r], m[c][0]), _mm256_mul_ps(vp[1][r], m[c][1])),
+            _mm256_mul_ps(vp[2][r], m[c][2]));
+        if (c == 3) {
+          column[r] = _mm256_add_ps(column[r], vp[3][r]);
+        }
+      }
+      StoreTransposedAvx2(column[0], column[1], column[2], column[3], out + c * 4, 16);
+    }
+  }
+  MvpScalar(trs, view_projection, simd_end, count, mvps);
+}
+
+UTILS_TARGET_AVX2 void BoundsAvx2(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world) {
+  size_t count = trs.size();
+  size_t simd_end = count & ~size_t(7);
+  float* centers[3] = { world->center_x.data(), world->center_y.data(), world->center_z.data() };
+  float* extents[3] = { world->extent_x.data(), world->extent_y.data(), world->extent_z.data() };
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  for (size_t i = 0; i < simd_end; i += 8) {
+    __m256 m[4][3];
+    ComposeAvx2(trs, i, m);
+    __m256 cx = _mm256_loadu_ps(&local.center_x[i]);
+    __m256 cy = _mm256_loadu_ps(&local.center_y[i]);
+    __m256 cz = _mm256_loadu_ps(&local.center_z[i]);
+    __m256 ex = _mm256_loadu_ps(&local.extent_x[i]);
+    __m256 ey = _mm256_loadu_ps(&local.extent_y[i]);
+    __m256 ez = _mm256_loadu_ps(&local.extent_z[i]);
+    for (int r = 0; r < 3; r++) {
+      __m256 center = _mm256_add_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0][r], cx), _mm256_mul_ps(m[1][r], cy)),
+                        _mm256_mul_ps(m[2][r], cz)),
+          m[3][r]);
+      __m256 extent = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_and_ps(m[0][r], abs_mask), ex),
+                                                  _mm256_mul_ps(_mm256_and_ps(m[1][r], abs_mask), ey)),
+                                    _mm256_mul_ps(_mm256_and_ps(m[2][r], abs_mask), ez));
+      _mm256_storeu_ps(centers[r] + i, center);
+      _mm256_storeu_ps(extents[r] + i, extent);
+    }
+  }
+  BoundsScalar(trs, local, simd_end, count, world);
+}
+
+#endif  // UTILS_SIMD_AVX2
+
+TransformKernel Supported(TransformKernel kernel) {
+#ifdef UTILS_SIMD_AVX2
+  if (kernel == TransformKernel::kAvx2 && !HasAvx2()) {
+    kernel = TransformKernel::kSse;
+  }
+#else
+  if (kernel == TransformKernel::kAvx2) {
+    kernel = TransformKernel::kSse;
+  }
+#endif
+#ifndef UTILS_SIMD_SSE
+  if (kernel == TransformKernel::kSse) {
+    kernel = TransformKernel::kScalar;
+  }
+#endif
+  return kernel;
+}
+
+}  // namespace
+
+TransformKernel BestTransformKernel() {
+  return Supported(TransformKernel::kAvx2);
+}
+
+const char* TransformKernelName(TransformKernel kernel) {
+  switch (kernel) {
+    case TransformKernel::kScalar:
+      return "scalar";
+    case TransformKernel::kSse:
+      return "sse";
+    case TransformKernel::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void ComposeModelMatrices(const TrsArrays& trs, glm::mat4* models) {
+  ComposeModelMatrices(trs, models, BestTransformKernel());
+}
+
+void ComposeModelMatrices(const TrsArrays& trs, Matrix3x4* models) {
+  ComposeModelMatrices(trs, models, BestTransformKernel());
+}
+
+void ComposeMvpMatrices(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps) {
+  ComposeMvpMatrices(trs, view_projection, mvps, BestTransformKernel());
+}
+
+void TransformBounds(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world) {
+  TransformBounds(trs, local, world, BestTransformKernel());
+}
+
+// 每一行是a的这一行对b的四行（第四行为0 0 0 1）的线性组合
+void MultiplyAffine(const Matrix3x4& a, const Matrix3x4& b, Matrix3x4* out) {
+#ifdef UTILS_SIMD_SSE
+  __m128 b0 = _mm_loadu_ps(&b.rows[0].x);
+  __m128 b1 = _mm_loadu_ps(&b.rows[1].x);
+  __m128 b2 = _mm_loadu_ps(&b.rows[2].x);
+  const __m128 b3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  __m128 rows[3];
+  for (int r = 0; r < 3; r++) {
+    __m128 row = _mm_loadu_ps(&a.rows[r].x);
+    rows[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0),
+                                    _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1)),
+                         _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2),
+                                    _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3)));
+  }
+  for (int r = 0; r < 3; r++) {
+    _mm_storeu_ps(&out->rows[r].x, rows[r]);
+  }
+#else
+  Matrix3x4 result;
+  for (int r = 0; r < 3; r++) {
+    const glm::vec4& row = a.rows[r];
+    result.rows[r] = row.x * b.rows[0] + row.y * b.rows[1] + row.z * b.rows[2] + glm::vec4(0.0f, 0.0f, 0.0f, row.w);
+  }
+  *out = result;
+#endif
+}
+
+void ComposeModelMatrices(const TrsArrays& trs, glm::mat4* models, TransformKernel kernel) {
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case TransformKernel::kAvx2:
+      ModelsAvx2(trs, models);
+      break;
+#endif
+#ifdef UTILS_SIMD_SSE
+    case TransformKernel::kSse:
+      ModelsSse(trs, models);
+      break;
+#endif
+    default:
+      ModelsScalar(trs, 0, trs.size(), models);
+      break;
+  }
+}
+
+void ComposeModelMatrices(const TrsArrays& trs, Matrix3x4* models, TransformKernel kernel) {
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case TransformKernel::kAvx2:
+      Models3x4Avx2(trs, models);
+      break;
+#endif
+#ifdef UTILS_SIMD_SSE
+    case TransformKernel::kSse:
+      Models3x4Sse(trs, models);
+      break;
+#endif
+    default:
+      Models3x4Scalar(trs, 0, trs.size(), models);
+      break;
+  }
+}
+
+void ComposeMvpMatrices(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps,
+                        TransformKernel kernel) {
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case TransformKernel::kAvx2:
+      MvpAvx2(trs, view_projection, mvps);
+      break;
+#endif
+#ifdef UTILS_SIMD_SSE
+    case TransformKernel::kSse:
+      MvpSse(trs, view_projection, mvps);
+      break;
+#endif
+    default:
+      MvpScalar(trs, view_projection, 0, trs.size(), mvps);
+      break;
+  }
+}
+
+void TransformBounds(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world, TransformKernel kernel) {
+  world->Resize(trs.size());
+  switch (Supported(kernel)) {
+#ifdef UTILS_SIMD_AVX2
+    case TransformKernel::kAvx2:
+      BoundsAvx2(trs, local, world);
+      break;
+#endif
+#ifdef UTILS_SIMD_SSE
+    case TransformKernel::kSse:
+      BoundsSse(trs, local, world);
+      break;
+#endif
+    default:
+      BoundsScalar(trs, local, 0, trs.size(), world);
+      break;
+  }
+}
+
+}  // namespace utils
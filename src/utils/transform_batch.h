@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "utils/frustum_cull.h"
+
+namespace utils {
+
+// SoA存储的平移、旋转（单位四元数）和缩放，一次处理多个物体
+struct TrsArrays {
+  std::vector<float> position_x;
+  std::vector<float> position_y;
+  std::vector<float> position_z;
+  std::vector<float> rotation_x;
+  std::vector<float> rotation_y;
+  std::vector<float> rotation_z;
+  std::vector<float> rotation_w;
+  std::vector<float> scale_x;
+  std::vector<float> scale_y;
+  std::vector<float> scale_z;
+
+  void Resize(size_t count);
+  void Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+  size_t size() const {
+    return position_x.size();
+  }
+};
+
+// 仿射矩阵的前三行（第四行固定为0 0 0 1），每个48字节，作为实例数据上传时比mat4少四分之一
+struct Matrix3x4 {
+  glm::vec4 rows[3];
+};
+
+enum class TransformKernel {
+  kScalar,
+  kSse,
+  kAvx2,
+};
+
+// 当前CPU支持的最快实现
+TransformKernel BestTransformKernel();
+const char* TransformKernelName(TransformKernel kernel);
+
+// 以下函数的输出数组容量至少为物体数量。矩阵为T * R * S，与TransformHierarchy的局部矩阵相同。
+// 各实现不使用FMA，计算顺序相同，结果逐位一致
+
+// models[i]为第i个物体的模型矩阵
+void ComposeModelMatrices(const TrsArrays& trs, glm::mat4* models);
+void ComposeModelMatrices(const TrsArrays& trs, Matrix3x4* models);
+
+// mvps[i] = view_projection * models[i]，不写出模型矩阵
+void ComposeMvpMatrices(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps);
+
+// 每个物体的局部包围盒变换到世界空间，等价于TransformAabb(local, model)。local与trs的数量相同，
+// world会被调整为物体数量
+void TransformBounds(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world);
+
+// out = a * b，两者都是仿射矩阵，out可以与a或b相同。用于按层级连接局部矩阵
+void MultiplyAffine(const Matrix3x4& a, const Matrix3x4& b, Matrix3x4* out);
+
+// 指定实现，用于测试和对比。CPU不支持时退回到可用的实现
+void ComposeModelMatrices(const TrsArrays& trs, glm::mat4* models, TransformKernel kernel);
+void ComposeModelMatrices(const TrsArrays& trs, Matrix3x4* models, TransformKernel kernel);
+void ComposeMvpMatrices(const TrsArrays& trs, const glm::mat4& view_projection, glm::mat4* mvps,
+                        TransformKernel kernel);
+void TransformBounds(const TrsArrays& trs, const AabbArrays& local, AabbArrays* world, TransformKernel kernel);
+
+}  // namespace utils
@@ -0,0 +1,345 @@
+#include "utils/transform_hierarchy.h"
+
+#include <algorithm>
+
+#include "utils/simd_dispatch.h"
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+namespace {
+
+inline void ComposeTrs(const glm::vec3& t, const glm::quat& r, const glm::vec3& s, glm::mat4* out) {
+  float xx = r.x * r.x;
+  float yy = r.y * r.y;
+  float zz = r.z * r.z;
+  float xy = r.x * r.y;
+  float xz = r.x * r.z;
+  float yz = r.y * r.z;
+  float wx = r.w * r.x;
+  float wy = r.w * r.y;
+  float wz = r.w * r.z;
+
+  glm::mat4& m = *out;
+  m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+  m[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+  m[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+  m[3] = glm::vec4(t, 1.0f);
+}
+
+// out = a * b，out不能和a、b重叠
+inline void MultiplyMatrix(const glm::mat4& a, const glm::mat4& b, glm::mat4* out) {
+#ifdef UTILS_SIMD_SSE
+  __m128 a0 = _mm_loadu_ps(&a[0][0]);
+  __m128 a1 = _mm_loadu_ps(&a[1][0]);
+  __m128 a2 = _mm_loadu_ps(&a[2][0]);
+  __m128 a3 = _mm_loadu_ps(&a[3][0]);
+  for (int i = 0; i < 4; i++) {
+    __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[i][0]));
+    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[i][1])));
+    r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[i][2])));
+    r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[i][3])));
+    _mm_storeu_ps(&(*out)[i][0], r);
+  }
+#else
+  *out = a * b;
+#endif
+}
+
+template <typename T>
+void Permute(const std::vector<uint32_t>& order, std::vector<T>* values) {
+  std::vector<T> permuted(values->size());
+  for (size_t i = 0; i < order.size(); i++) {
+    permuted[i] = (*values)[order[i]];
+  }
+  values->swap(permuted);
+}
+
+}  // namespace
+
+void TransformHierarchy::Reserve(size_t count) {
+  parent_.reserve(count);
+  subtree_end_.reserve(count);
+  translation_.reserve(count);
+  rotation_.reserve(count);
+  scale_.reserve(count);
+  local_.reserve(count);
+  world_.reserve(count);
+  local_dirty_.reserve(count);
+  node_of_.reserve(count);
+  index_.reserve(count);
+}
+
+void TransformHierarchy::Clear() {
+  parent_.clear();
+  subtree_end_.clear();
+  translation_.clear();
+  rotation_.clear();
+  scale_.clear();
+  local_.clear();
+  world_.clear();
+  local_dirty_.clear();
+  node_of_.clear();
+  index_.clear();
+  dirty_roots_.clear();
+  needs_reorder_ = false;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::AddNode(NodeId parent, const glm::vec3& translation,
+                                                       const glm::quat& rotation, const glm::vec3& scale) {
+  auto index = static_cast<uint32_t>(parent_.size());
+  auto node = static_cast<NodeId>(index_.size());
+
+  uint32_t parent_index = parent == kInvalidNode ? kInvalidNode : index_[parent];
+  if (parent_index != kInvalidNode && !needs_reorder_) {
+    // 父节点的子树正好在数组末尾时直接追加，否则等到Update时重新排序
+    if (subtree_end_[parent_index] == index) {
+      for (uint32_t i = parent_index; i != kInvalidNode; i = parent_[i]) {
+        subtree_end_[i] = index + 1;
+      }
+    } else {
+      needs_reorder_ = true;
+    }
+  }
+
+  parent_.push_back(parent_index);
+  subtree_end_.push_back(index + 1);
+  translation_.push_back(translation);
+  rotation_.push_back(rotation);
+  scale_.push_back(scale);
+  local_.emplace_back(1.0f);
+  world_.emplace_back(1.0f);
+  local_dirty_.push_back(0);
+  node_of_.push_back(node);
+  index_.push_back(index);
+
+  MarkDirty(index);
+  return node;
+}
+
+void TransformHierarchy::SetTranslation(NodeId node, const glm::vec3& translation) {
+  uint32_t index = index_[node];
+  translation_[index] = translation;
+  MarkDirty(index);
+}
+
+void TransformHierarchy::SetRotation(NodeId node, const glm::quat& rotation) {
+  uint32_t index = index_[node];
+  rotation_[index] = rotation;
+  MarkDirty(index);
+}
+
+void TransformHierarchy::SetScale(NodeId node, const glm::vec3& scale) {
+  uint32_t index = index_[node];
+  scale_[index] = scale;
+  MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocal(NodeId node, const glm::vec3& translation, const glm::quat& rotation,
+                                  const glm::vec3& scale) {
+  uint32_t index = index_[node];
+  translation_[index] = translation;
+  rotation_[index] = rotation;
+  scale_[index] = scale;
+  MarkDirty(index);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::parent(NodeId node) const {
+  uint32_t parent_index = parent_[index_[node]];
+  return parent_index == kInvalidNode ? kInvalidNode : node_of_[parent_index];
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index) {
+  // 同一个节点多次修改只需要记录一次
+  if (local_dirty_[index] == 0) {
+    local_dirty_[index] = 1;
+    dirty_roots_.push_back(index);
+  }
+}
+
+void TransformHierarchy::Update(ThreadPool* pool) {
+  if (needs_reorder_) {
+    Reorder();
+  }
+
+  if (dirty_roots_.empty()) {
+    return;
+  }
+
+  // 脏节点很多时直接扫描标记，比排序快
+  if (dirty_roots_.size() > parent_.size() / 16) {
+    dirty_roots_.clear();
+    for (uint32_t i = 0; i < parent_.size(); i++) {
+      if (local_dirty_[i] != 0) {
+        dirty_roots_.push_back(i);
+      }
+    }
+  } else {
+    std::sort(dirty_roots_.begin(), dirty_roots_.end());
+  }
+
+  // 去掉被其他脏节点子树包含的节点，剩下的子树互不相交
+  ranges_.clear();
+  uint32_t covered_end = 0;
+  for (uint32_t root : dirty_roots_) {
+    if (root < covered_end) {
+      continue;
+    }
+    covered_end = subtree_end_[root];
+    CollectRanges(root, covered_end, &ranges_);
+  }
+  dirty_roots_.clear();
+
+  if (pool == nullptr || ranges_.size() == 1) {
+    for (const Range& range : ranges_) {
+      UpdateRange(range.begin, range.end);
+    }
+    return;
+  }
+
+  pool->ParallelFor(ranges_.size(), 1, [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      UpdateRange(ranges_[i].begin, ranges_[i].end);
+    }
+  });
+}
+
+void TransformHierarchy::CollectRanges(uint32_t begin, uint32_t end, std::vector<Range>* ranges) {
+  // 子树太大时先串行算出根节点，再把它的子树按grain大小打包成相互独立的任务
+  std::vector<Range> pending;
+  pending.push_back({ begin, end });
+  while (!pending.empty()) {
+    Range range = pending.back();
+    pending.pop_back();
+
+    if (range.end - range.begin <= grain_size_) {
+      ranges->push_back(range);
+      continue;
+    }
+
+    UpdateRange(range.begin, range.begin + 1);
+
+    uint32_t batch_begin = range.begin + 1;
+    uint32_t child = batch_begin;
+    while (child < range.end) {
+      uint32_t child_end = subtree_end_[child];
+      if (child_end - child > grain_size_) {
+        if (batch_begin < child) {
+          ranges->push_back({ batch_begin, child });
+        }
+        pending.push_back({ child, child_end });
+        batch_begin = child_end;
+      } else if (child_end - batch_begin > grain_size_) {
+        if (batch_begin < child) {
+          ranges->push_back({ batch_begin, child });
+        }
+        batch_begin = child;
+      }
+      child = child_end;
+    }
+
+    if (batch_begin < range.end) {
+      ranges->push_back({ batch_begin, range.end });
+    }
+  }
+}
+
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end) {
+  for (uint32_t i = begin; i < end; i++) {
+    if (local_dirty_[i] != 0) {
+      ComposeTrs(translation_[i], rotation_[i], scale_[i], &local_[i]);
+      local_dirty_[i] = 0;
+    }
+
+    uint32_t parent_index = parent_[i];
+    if (parent_index == kInvalidNode) {
+      world_[i] = local_[i];
+    } else {
+      MultiplyMatrix(world_[parent_index], local_[i], &world_[i]);
+    }
+  }
+}
+
+void TransformHierarchy::Reorder() {
+  auto count = static_cast<uint32_t>(parent_.size());
+
+  // 以CSR形式建立子节点表
+  std::vector<uint32_t> child_offset(count + 1, 0);
+  for (uint32_t i = 0; i < count; i++) {
+    if (parent_[i] != kInvalidNode) {
+      child_offset[parent_[i] + 1]++;
+    }
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    child_offset[i + 1] += child_offset[i];
+  }
+
+  std::vector<uint32_t> children(count);
+  std::vector<uint32_t> cursor(child_offset.begin(), child_offset.end() - 1);
+  for (uint32_t i = 0; i < count; i++) {
+    if (parent_[i] != kInvalidNode) {
+      children[cursor[parent_[i]]++] = i;
+    }
+  }
+
+  // 深度优先遍历得到新的存储顺序，兄弟节点保持原有的相对顺序
+  std::vector<uint32_t> order;
+  order.reserve(count);
+  std::vector<uint32_t> stack;
+  for (uint32_t i = 0; i < count; i++) {
+    if (parent_[i] != kInvalidNode) {
+      continue;
+    }
+
+    stack.push_back(i);
+    while (!stack.empty()) {
+      uint32_t node = stack.back();
+      stack.pop_back();
+      order.push_back(node);
+      for (uint32_t c = child_offset[node + 1]; c > child_offset[node]; c--) {
+        stack.push_back(children[c - 1]);
+      }
+    }
+  }
+
+  std::vector<uint32_t> new_index(count);
+  for (uint32_t i = 0; i < count; i++) {
+    new_index[order[i]] = i;
+  }
+
+  Permute(order, &parent_);
+  Permute(order, &translation_);
+  Permute(order, &rotation_);
+  Permute(order, &scale_);
+  Permute(order, &local_);
+  Permute(order, &world_);
+  Permute(order, &local_dirty_);
+  Permute(order, &node_of_);
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (parent_[i] != kInvalidNode) {
+      parent_[i] = new_index[parent_[i]];
+    }
+    index_[node_of_[i]] = i;
+  }
+
+  for (uint32_t& root : dirty_roots_) {
+    root = new_index[root];
+  }
+
+  // 子节点在父节点之后，倒序遍历即可得到每棵子树的结束位置
+  subtree_end_.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    subtree_end_[i] = i + 1;
+  }
+  for (uint32_t i = count; i > 0; i--) {
+    uint32_t parent_index = parent_[i - 1];
+    if (parent_index != kInvalidNode) {
+      subtree_end_[parent_index] = std::max(subtree_end_[parent_index], subtree_end_[i - 1]);
+    }
+  }
+
+  needs_reorder_ = false;
+}
+
+}  // namespace utils
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace utils {
+
+class ThreadPool;
+
+// 场景变换层级，按SoA存储局部TRS和世界矩阵。
+// 节点按深度优先排列：父节点总在子节点前面，每棵子树在数组里是连续的一段。
+// 只有被修改过的子树会在Update时重新计算，互不相交的子树可以并行更新。
+class TransformHierarchy {
+public:
+  using NodeId = uint32_t;
+  static constexpr NodeId kInvalidNode = UINT32_MAX;
+
+  TransformHierarchy() = default;
+
+  void Reserve(size_t count);
+  void Clear();
+
+  // 父节点必须已经存在，kInvalidNode表示根节点。
+  NodeId AddNode(NodeId parent, const glm::vec3& translation = glm::vec3(0.0f),
+                 const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                 const glm::vec3& scale = glm::vec3(1.0f));
+
+  void SetTranslation(NodeId node, const glm::vec3& translation);
+  void SetRotation(NodeId node, const glm::quat& rotation);
+  void SetScale(NodeId node, const glm::vec3& scale);
+  void SetLocal(NodeId node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+  const glm::vec3& translation(NodeId node) const {
+    return translation_[index_[node]];
+  }
+
+  const glm::quat& rotation(NodeId node) const {
+    return rotation_[index_[node]];
+  }
+
+  const glm::vec3& scale(NodeId node) const {
+    return scale_[index_[node]];
+  }
+
+  NodeId parent(NodeId node) const;
+
+  // 返回最近一次Update后的世界矩阵。
+  const glm::mat4& world_matrix(NodeId node) const {
+    return world_[index_[node]];
+  }
+
+  size_t size() const {
+    return parent_.size();
+  }
+
+  // 按存储顺序（父节点在前）访问世界矩阵，便于直接上传到GPU。
+  const std::vector<glm::mat4>& world_matrices() const {
+    return world_;
+  }
+
+  NodeId node_at(size_t index) const {
+    return node_of_[index];
+  }
+
+  // 重新计算所有脏子树的局部矩阵和世界矩阵。pool为空时在调用线程上执行。
+  void Update(ThreadPool* pool = nullptr);
+
+  // 每个并行任务至少处理的节点数。
+  void set_grain_size(size_t grain) {
+    grain_size_ = grain;
+  }
+
+private:
+  struct Range {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  void MarkDirty(uint32_t index);
+  void Reorder();
+  void CollectRanges(uint32_t begin, uint32_t end, std::vector<Range>* ranges);
+  void UpdateRange(uint32_t begin, uint32_t end);
+
+private:
+  // 以下数组按存储下标访问
+  std::vector<uint32_t> parent_;
+  std::vector<uint32_t> subtree_end_;
+  std::vector<glm::vec3> translation_;
+  std::vector<glm::quat> rotation_;
+  std::vector<glm::vec3> scale_;
+  std::vector<glm::mat4> local_;
+  std::vector<glm::mat4> world_;
+  std::vector<uint8_t> local_dirty_;
+  std::vector<NodeId> node_of_;
+
+  // NodeId -> 存储下标，重排后NodeId保持不变
+  std::vector<uint32_t> index_;
+
+  std::vector<uint32_t> dirty_roots_;
+  std::vector<Range> ranges_;
+  bool needs_reorder_ = false;
+  size_t grain_size_ = 4096;
+};
+
+}  // namespace utils